@@ -1,8 +1,10 @@
 #include "interfaces/ipcsockets.h"
 #include "interfaces/spi.h"
+#include "interfaces/SoftwareFPGA.h"
 #include "interfaces/SensorsActuators.h"
 #include "logging/log.h"
 #include "utils/utils.h"
+#include <getopt.h>
 
 static IPCSocketConnection* communicationService;
 static Sensor* sensors;
@@ -313,8 +315,78 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
     return 0;
 }
 
+/* prints the available command line options */
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -s, --simulate              use the software FPGA instead of the SPI interface\n");
+    printf("    -t, --simulate-latency <ns> time every transfer of the software FPGA takes (default: 0)\n");
+    printf("    -l, --simulate-loopback <output:input,...>\n");
+    printf("                                connects output pins of the software FPGA to input pins\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+/* parses the command line options, returns 1 if the service should not be started */
+static int parseOptions(int argc, char* const argv[])
+{
+    static const struct option options[] = 
+    {
+        {"simulate",          no_argument,       NULL, 's'},
+        {"simulate-latency",  required_argument, NULL, 't'},
+        {"simulate-loopback", required_argument, NULL, 'l'},
+        {"help",              no_argument,       NULL, 'h'},
+        {NULL,                0,                 NULL, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "st:l:h", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+            {
+                setSPIBackend(&softwareFPGABackend);
+                break;
+            }
+
+            case 't':
+            {
+                char* end;
+                softwareFPGA.transferLatency = strtoull(optarg, &end, 10);
+                if (*end != 0)
+                {
+                    log_error("invalid latency: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'l':
+            {
+                if (parseSoftwareFPGALoopback(optarg))
+                {
+                    return 1;
+                }
+                break;
+            }
+
+            default:
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char const *argv[])
 {
+    if (parseOptions(argc, (char* const*)argv))
+    {
+        return -1;
+    }
+
     if(setupSPIInterface() < 0)
     {
         log_error("setup of SPI-interface failed");
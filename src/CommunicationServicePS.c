@@ -3,6 +3,8 @@
 
 #include "interfaces/ipcsockets.h"
 #include "interfaces/websockets.h"
+#include "interfaces/ExperimentImage.h"
+#include "interfaces/ExperimentPlugin.h"
 #include "utils/utils.h"
 #include "parsers/json.h"
 #include "logging/log.h"
@@ -200,9 +202,28 @@ static int handleWebsocketMessage(struct lws* wsi, char* message)
         case WebsocketCommandInitPS:
         {
             log_debug("received physical system initialization message from labserver");
-            unsigned char initializer = JSONGetObjectItem(msgJSON, "Initializer")->valueint;
+            /* an array of initializers is executed together, e.g. one per axis of a portal */
+            JSON* initializerJSON = JSONGetObjectItem(msgJSON, "Initializer");
+            if (initializerJSON == NULL)
+            {
+                log_error("initializer not included in physical system initialization message");
+                break;
+            }
+            unsigned int initializerCount = JSONIsArray(initializerJSON) ? JSONGetArraySize(initializerJSON) : 1;
+            unsigned char initializers[initializerCount + 1];
+            if (JSONIsArray(initializerJSON))
+            {
+                for (int i = 0; i < initializerCount; i++)
+                {
+                    initializers[i] = JSONGetArrayItem(initializerJSON, i)->valueint;
+                }
+            }
+            else
+            {
+                initializers[0] = initializerJSON->valueint;
+            }
             initializingPS = 1;
-            sendMessageIPC(initializationService, IPCMSGTYPE_STARTINITIALIZATION, &initializer, 1);
+            sendMessageIPC(initializationService, IPCMSGTYPE_STARTINITIALIZATION, initializers, initializerCount);
             break;
         }
         
@@ -432,6 +453,26 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
     return 0;
 }
 
+/*
+ *  checks whether the image written by goldi-image can be used instead of the experiment data, which is only the case
+ *  if it has been written from the current experiment data by a compatible goldi-image
+ *  path        -   the path of the image
+ *  sourceHash  -   the hash of the content of the experiment data
+ */
+static int isExperimentImageUpToDate(const char* path, unsigned long long sourceHash)
+{
+    ExperimentImageHeader header;
+    FILE* file = fopen(path, "rb");
+    int upToDate = file != NULL && fread(&header, sizeof(header), 1, file) == 1 &&
+                   !memcmp(header.magic, EXPERIMENT_IMAGE_MAGIC, sizeof(header.magic)) && header.version == EXPERIMENT_IMAGE_VERSION &&
+                   header.byteOrder == EXPERIMENT_IMAGE_BYTE_ORDER && header.sourceHash == sourceHash;
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    return upToDate;
+}
+
 int main(int argc, char const *argv[])
 {
     signal(SIGINT, signal_handler);
@@ -474,6 +515,8 @@ int main(int argc, char const *argv[])
 
     /* read experiment configuration file and initialize all services */
     //TODO change paths, add NULL and error handling
+    struct timespec bootStart;
+    clock_gettime(CLOCK_MONOTONIC, &bootStart);
     char* deviceConfigContent = readFile("/data/GOLDiServices/DeviceData.json", NULL);
     JSON* jsonDeviceConfig = JSONParse(deviceConfigContent);
     JSON* jsonDeviceID = JSONGetObjectItem(jsonDeviceConfig, "DeviceID");
@@ -489,6 +532,18 @@ int main(int argc, char const *argv[])
     char* experimentConfigContent = readFile(completeConfigPath, NULL);
     free(completeConfigPath);
 
+    /* the services load the precompiled image instead of parsing the experiment data if it is up to date */
+    char* imagePath = malloc(strlen(experimentType) + strlen(experimentsPath) + strlen(EXPERIMENT_IMAGE_NAME) + 2);
+    strcpy(imagePath, experimentsPath);
+    strcat(imagePath, experimentType);
+    strcat(imagePath, "/");
+    strcat(imagePath, EXPERIMENT_IMAGE_NAME);
+    unsigned int useImage = isExperimentImageUpToDate(imagePath, hashExperimentSections(&experimentConfigContent, 1));
+    if (!useImage)
+    {
+        log_info("%s is missing or outdated, the services parse the experiment data", imagePath);
+    }
+
     /* find fpga programming file and read content */ 
     char* fpgaSVFPath = malloc(strlen(experimentType) + strlen(experimentsPath) + strlen(FPGASVF_FILENAME) + 2);
     strcpy(fpgaSVFPath, experimentsPath);
@@ -521,15 +576,22 @@ int main(int argc, char const *argv[])
 
     /* initialize Protection Service */
     log_info("initializing Protection Service");
-    JSON* jsonProtectionInitMsg = JSONCreateObject();
-    JSONAddItemReferenceToObject(jsonProtectionInitMsg, "Sensors", jsonSensors);
-    JSONAddItemReferenceToObject(jsonProtectionInitMsg, "Actuators", jsonActuators);
-    JSONAddItemReferenceToObject(jsonProtectionInitMsg, "ProtectionRules", jsonProtection);
-    char* stringProtectionInitMsg = JSONPrint(jsonProtectionInitMsg);
-    sendMessageIPC(protectionService, IPCMSGTYPE_INITPROTECTIONSERVICE, stringProtectionInitMsg, strlen(stringProtectionInitMsg));
-
-    JSONDelete(jsonProtectionInitMsg);
-    free(stringProtectionInitMsg);
+    if (useImage)
+    {
+        sendMessageIPC(protectionService, IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE, imagePath, strlen(imagePath));
+    }
+    else
+    {
+        JSON* jsonProtectionInitMsg = JSONCreateObject();
+        JSONAddItemReferenceToObject(jsonProtectionInitMsg, "Sensors", jsonSensors);
+        JSONAddItemReferenceToObject(jsonProtectionInitMsg, "Actuators", jsonActuators);
+        JSONAddItemReferenceToObject(jsonProtectionInitMsg, "ProtectionRules", jsonProtection);
+        char* stringProtectionInitMsg = JSONPrint(jsonProtectionInitMsg);
+        sendMessageIPC(protectionService, IPCMSGTYPE_INITPROTECTIONSERVICE, stringProtectionInitMsg, strlen(stringProtectionInitMsg));
+
+        JSONDelete(jsonProtectionInitMsg);
+        free(stringProtectionInitMsg);
+    }
 
     log_info("waiting for Protection Service to finish initializing");
     while(!(ServiceInitializations.protectionService > 0))
@@ -545,15 +607,23 @@ int main(int argc, char const *argv[])
 
     /* initialize Initialization Service */
     log_info("initializing Initialization Service");
-    JSON* jsonInitializationInitMsg = JSONCreateObject();
-    JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Sensors", jsonSensors);
-    JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Actuators", jsonActuators);
-    JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Initializers", jsonInitializers);
-    char* stringInitializationInitMsg = JSONPrint(jsonInitializationInitMsg);
-    sendMessageIPC(initializationService, IPCMSGTYPE_INITINITIALIZATION, stringInitializationInitMsg, strlen(stringInitializationInitMsg));
-
-    JSONDelete(jsonInitializationInitMsg);
-    free(stringInitializationInitMsg);
+    if (useImage)
+    {
+        sendMessageIPC(initializationService, IPCMSGTYPE_INITINITIALIZATIONIMAGE, imagePath, strlen(imagePath));
+    }
+    else
+    {
+        JSON* jsonInitializationInitMsg = JSONCreateObject();
+        JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Sensors", jsonSensors);
+        JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Actuators", jsonActuators);
+        JSONAddItemReferenceToObject(jsonInitializationInitMsg, "Initializers", jsonInitializers);
+        char* stringInitializationInitMsg = JSONPrint(jsonInitializationInitMsg);
+        sendMessageIPC(initializationService, IPCMSGTYPE_INITINITIALIZATION, stringInitializationInitMsg, strlen(stringInitializationInitMsg));
+
+        JSONDelete(jsonInitializationInitMsg);
+        free(stringInitializationInitMsg);
+    }
+    free(imagePath);
 
     log_info("waiting for Initialization Service to finish initializing");
     while(!(ServiceInitializations.initializationService > 0))
@@ -591,6 +661,11 @@ int main(int argc, char const *argv[])
     }
     log_info("the Webcam Service was initialized successfully");
 
+    struct timespec bootEnd;
+    clock_gettime(CLOCK_MONOTONIC, &bootEnd);
+    log_info("all services were initialized %s in %.1f ms", useImage ? "from the experiment image" : "from the experiment data",
+             (bootEnd.tv_sec - bootStart.tv_sec) * 1e3 + (bootEnd.tv_nsec - bootStart.tv_nsec) / 1e6);
+
     /* prepare experiment data for Labserver and Control Unit */
     JSON* jsonSensor = NULL;
     JSONArrayForEach(jsonSensor, jsonSensors)
@@ -4,70 +4,342 @@
 #include "interfaces/SensorsActuators.h"
 #include "utils/utils.h"
 #include "interfaces/ipcsockets.h"
+#include "interfaces/ExperimentPlugin.h"
+#include "interfaces/ExperimentImage.h"
 #include "logging/log.h"
+#include <getopt.h>
 
 static IPCSocketConnection* communicationService;
 Sensor* sensors;
 Actuator* actuators;
 Variable* variables;
 StateMachine* stateMachines;
+ExpressionStore* expressionStore;
+ExperimentPluginHandle* plugin;
+static const char* pluginDirectory = EXPERIMENT_PLUGIN_DIRECTORY;
 unsigned int sensorCount;
 unsigned int actuatorCount;
 unsigned int stateMachineCount;
-StateMachineExecution execution = {NULL, 0};
+StateMachineExecution execution;
 
-ActuatorDataPacket StateMachineOutputToActuatorDataPacket(StateMachineOutput output)
+/*
+ *  the actuator frames of an initialization, assembled from the serialized packets of the state outputs
+ *  stopPackets         -   the serialized packet with the stop value of every actuator, NULL for the actuators
+ *                          that can not be serialized, which are never sent
+ *  stopPacketLengths   -   the length of every stop packet
+ *  sentValues          -   the value of every actuator sent last, NULL if it was not sent since the start
+ *  buffer              -   large enough for a frame with the longest packet of every actuator
+ */
+typedef struct
 {
-    ActuatorDataPacket packet = {output.actuatorID, output.type, output.value};
-    return packet;
+    char**          stopPackets;
+    unsigned int*   stopPacketLengths;
+    const char**    sentValues;
+    char*           buffer;
+} ActuatorFrames;
+
+static ActuatorFrames frames;
+
+static void destroyActuatorFrames(void)
+{
+    for (int i = 0; i < actuatorCount && frames.stopPackets != NULL; i++)
+    {
+        free(frames.stopPackets[i]);
+    }
+    free(frames.stopPackets);
+    free(frames.stopPacketLengths);
+    free(frames.sentValues);
+    free(frames.buffer);
+    frames = (ActuatorFrames){NULL, NULL, NULL, NULL};
 }
 
-int startInitialization(void)
+/*
+ *  serializes the stop values and the outputs of all states once, so a transition only copies the packets of
+ *  the changed actuators into the preallocated buffer. Only binary actuators can be serialized, the other
+ *  actuators are left out of the frames.
+ *  returns 1 on error
+ */
+static int prepareActuatorFrames(void)
 {
-    pthread_t executionThread;
-    int result = 0;
-    char* currentState = execution.stateMachine->activeState->name;
-    pthread_create(&executionThread, NULL, &executeStateMachine, &execution);
-    while(!execution.stopped)
+    destroyActuatorFrames();
+    if (prepareStateMachineOutputs(stateMachines, stateMachineCount, actuators, actuatorCount))
+    {
+        return 1;
+    }
+    frames.stopPackets = calloc(actuatorCount + 1, sizeof(*frames.stopPackets));
+    frames.stopPacketLengths = malloc(sizeof(*frames.stopPacketLengths) * (actuatorCount + 1));
+    frames.sentValues = calloc(actuatorCount + 1, sizeof(*frames.sentValues));
+    if (frames.stopPackets == NULL || frames.stopPacketLengths == NULL || frames.sentValues == NULL)
     {
-        if (strcmp(currentState, execution.stateMachine->activeState->name) != 0)
+        log_error("initialization: malloc error %s", strerror(errno));
+        return 1;
+    }
+
+    /* every actuator is sent at most once per frame, so its longest packet and a comma are reserved */
+    unsigned int longestPackets[actuatorCount + 1];
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        frames.stopPackets[i] = serializeActuatorDataPacket((ActuatorDataPacket){actuators[i].actuatorID, actuators[i].type, actuators[i].stopValue});
+        if (frames.stopPackets[i] == NULL)
+        {
+            log_debug("initialization: actuator %s can not be serialized, it is not sent", actuators[i].actuatorID);
+        }
+        frames.stopPacketLengths[i] = frames.stopPackets[i] == NULL ? 0 : strlen(frames.stopPackets[i]);
+        longestPackets[i] = frames.stopPacketLengths[i];
+    }
+    for (int i = 0; i < stateMachineCount; i++)
+    {
+        for (int j = 0; j < stateMachines[i].statesCount; j++)
         {
-            StateMachineOutput* outputs = execution.stateMachine->activeState->outputs;
-            unsigned int outputsCount = execution.stateMachine->activeState->outputCount;
-            JSON* actuatorDataMsgJSON = JSONCreateObject();
-            JSON* actuatorDataJSON = JSONCreateArray();
-            for (int i = 0; i < actuatorCount; i++)
+            for (int k = 0; k < stateMachines[i].states[j].outputCount; k++)
             {
-                ActuatorDataPacket packet = {actuators[i].actuatorID, actuators[i].type, actuators[i].stopValue};
-                JSON* packetJSON = ActuatorDataPacketToJSON(packet);
-                JSONAddItemToArray(actuatorDataJSON, packetJSON);
+                StateMachineOutput* output = &stateMachines[i].states[j].outputs[k];
+                if (output->packetLength > longestPackets[output->actuatorIndex])
+                {
+                    longestPackets[output->actuatorIndex] = output->packetLength;
+                }
             }
-            for (int i = 0; i < outputsCount; i++)
+        }
+    }
+    unsigned int capacity = 2;
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        capacity += longestPackets[i] + 1;
+    }
+    frames.buffer = malloc(capacity);
+    if (frames.buffer == NULL)
+    {
+        log_error("initialization: malloc error %s", strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  merges the outputs of the active states of all executed state machines, actuators without an output keep
+ *  their stop value. If two state machines set different values for the same actuator the actuator gets its
+ *  stop value instead. Only the actuators whose value differs from the one sent last are sent.
+ *  activeStates    -   the index of the active state of every executed state machine
+ *  returns 1 if the outputs of two state machines conflict
+ */
+static int sendMergedOutputs(const unsigned int* activeStates)
+{
+    int conflict = 0;
+    const char* values[actuatorCount + 1];
+    const char* packets[actuatorCount + 1];
+    unsigned int packetLengths[actuatorCount + 1];
+    int owners[actuatorCount + 1];
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        values[i] = actuators[i].stopValue;
+        packets[i] = frames.stopPackets[i];
+        packetLengths[i] = frames.stopPacketLengths[i];
+        owners[i] = -1;
+    }
+    for (int i = 0; i < execution.stateMachineCount; i++)
+    {
+        StateMachine* stateMachine = execution.stateMachines[i];
+        StateMachineState* state = &stateMachine->states[activeStates[i]];
+        for (int k = 0; k < state->outputCount; k++)
+        {
+            StateMachineOutput* output = &state->outputs[k];
+            unsigned int index = output->actuatorIndex;
+            if (output->packet == NULL)
+            {
+                continue;
+            }
+            if (owners[index] == -1)
+            {
+                values[index] = output->value;
+                packets[index] = output->packet;
+                packetLengths[index] = output->packetLength;
+                owners[index] = i;
+            }
+            else if (values[index] != actuators[index].stopValue &&
+                     memcmp(values[index], output->value, getValueSizeOfActuatorType(actuators[index].type)))
             {
-                ActuatorDataPacket packet = StateMachineOutputToActuatorDataPacket(outputs[i]);
-                JSON* packetJSON = ActuatorDataPacketToJSON(packet);
-                JSONReplaceItemInObject(actuatorDataJSON, packetJSON->string, packetJSON);
+                log_error("initialization: %s and %s set different values for %s", execution.stateMachines[owners[index]]->name, stateMachine->name, actuators[index].actuatorID);
+                values[index] = actuators[index].stopValue;
+                packets[index] = frames.stopPackets[index];
+                packetLengths[index] = frames.stopPacketLengths[index];
+                conflict = 1;
             }
-            JSONAddItemToObject(actuatorDataMsgJSON, "ActuatorData", actuatorDataJSON);
-            char* actuatorDataMsg = JSONPrint(actuatorDataMsgJSON);
-            sendMessageIPC(communicationService, IPCMSGTYPE_ACTUATORDATA, actuatorDataMsg, strlen(actuatorDataMsg));
-            JSONDelete(actuatorDataMsgJSON);
-            free(actuatorDataMsg);
-            currentState = execution.stateMachine->activeState->name;
         }
     }
-    pthread_join(executionThread, &result);
+
+    unsigned int length = 0;
+    unsigned int packetCount = 0;
+    frames.buffer[length++] = '[';
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        if (packets[i] == NULL || (frames.sentValues[i] != NULL && !memcmp(frames.sentValues[i], values[i], getValueSizeOfActuatorType(actuators[i].type))))
+        {
+            continue;
+        }
+        if (packetCount++ > 0)
+        {
+            frames.buffer[length++] = ',';
+        }
+        memcpy(frames.buffer + length, packets[i], packetLengths[i]);
+        length += packetLengths[i];
+        frames.sentValues[i] = values[i];
+    }
+    frames.buffer[length++] = ']';
+    if (packetCount > 0)
+    {
+        sendMessageIPC(communicationService, IPCMSGTYPE_ACTUATORDATA, frames.buffer, length);
+    }
+    return conflict;
+}
+
+/*
+ *  executes the state machines selected by startStateMachineExecution together in one thread and sends the
+ *  merged outputs of their active states whenever one of them changes, both threads sleep until the sensor
+ *  data or an active state changes. Conflicting outputs stop the initialization.
+ */
+int startInitialization(void)
+{
+    unsigned int activeStates[execution.stateMachineCount + 1];
+    for (int i = 0; i < execution.stateMachineCount; i++)
+    {
+        activeStates[i] = execution.stateMachines[i]->activeState - execution.stateMachines[i]->states;
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        frames.sentValues[i] = NULL;
+    }
+    int conflict = 0;
+    pthread_t executionThread;
+    pthread_create(&executionThread, NULL, &executeStateMachine, &execution);
+    while (waitForStateMachineTransitions(&execution, activeStates))
+    {
+        if (sendMergedOutputs(activeStates) && !conflict)
+        {
+            conflict = 1;
+            stopStateMachineExecution(&execution);
+        }
+    }
+    pthread_join(executionThread, NULL);
+    int result = conflict ? 0 : execution.result;
     char* resultString = serializeInt(result);
     sendMessageIPC(communicationService, IPCMSGTYPE_INITIALIZATIONFINISHED, resultString, 4);
     free(resultString);
     return result;
 }
 
+/*
+ *  lets the state machines use the plugin compiled from the experiment with the given hash instead of their
+ *  transition functions, returns 1 if there is no matching plugin
+ */
+static int loadInitializationPlugin(unsigned long long experimentHash)
+{
+    plugin = findExperimentPlugin(pluginDirectory, ExperimentPartInitialization, experimentHash);
+    if (plugin == NULL)
+    {
+        return 1;
+    }
+    unsigned int matches = plugin->plugin->sensorCount == sensorCount && plugin->plugin->actuatorCount == actuatorCount &&
+                           plugin->plugin->stateMachineCount == stateMachineCount;
+    for (int i = 0; i < stateMachineCount && matches; i++)
+    {
+        matches = !strcmp(plugin->plugin->stateMachineNames[i], stateMachines[i].name) && plugin->plugin->stateCounts[i] == stateMachines[i].statesCount;
+    }
+    if (!matches)
+    {
+        log_error("initialization: plugin %s does not match the parsed experiment", plugin->path);
+        closeExperimentPlugin(plugin);
+        plugin = NULL;
+        return 1;
+    }
+
+    char* sensorValues[sensorCount + 1];
+    char* actuatorValues[actuatorCount + 1];
+    for (int i = 0; i < sensorCount; i++)
+    {
+        sensorValues[i] = sensors[i].value;
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        actuatorValues[i] = actuators[i].value;
+    }
+    plugin->plugin->bindProcessImage(sensorValues, actuatorValues);
+    for (int i = 0; i < stateMachineCount; i++)
+    {
+        stateMachines[i].compiledNextStates = plugin->plugin->nextStates;
+        stateMachines[i].compiledIndex = i;
+    }
+    return 0;
+}
+
+/* creates the variables of the transition functions, all sensors followed by all actuators */
+static int createVariables(void)
+{
+    variables = malloc(sizeof(*variables) * (sensorCount+actuatorCount+1));
+    if (variables == NULL)
+    {
+        log_error("initialization: malloc error %s", strerror(errno));
+        return 1;
+    }
+    for (int i = 0; i < sensorCount; i++)
+    {
+        OperandType operandType;
+        if (sensors[i].type == SensorTypeBinary)
+        {
+            operandType = OperandTypeBinary;
+        }
+        else
+        {
+            operandType = OperandTypeNumber;
+        }
+        variables[i] = (Variable){operandType, sensors[i].sensorID, sensors[i].value, getValueSizeOfSensorType(sensors[i].type)};
+    }
+    for (int i = sensorCount; i < (sensorCount + actuatorCount); i++)
+    {
+        int k = i-sensorCount;
+        variables[i] = (Variable){actuators[k].type, actuators[k].actuatorID, actuators[k].value, getValueSizeOfActuatorType(actuators[k].type)};
+        printActuatorData(actuators[k]);   // TODO add debugging flag
+    }
+    return 0;
+}
+
+/*
+ *  prepares the parsed or loaded state machines for their execution
+ *  experimentHash  -   the hash of the experiment, used to find a plugin compiled by goldi-compile
+ */
+static int prepareStateMachines(unsigned long long experimentHash)
+{
+    for (int i = 0; i < stateMachineCount; i++)
+    {
+        printStateMachineInfo(&stateMachines[i]);   // TODO add debugging flag
+    }
+    log_debug("initialization: transition functions use %d shared nodes instead of %d", expressionStore->nodeCount, expressionStore->requestedNodes);
+
+    /* a plugin compiled from the same experiment replaces the transition functions */
+    if (pluginDirectory != NULL)
+    {
+        if (loadInitializationPlugin(experimentHash))
+        {
+            log_info("initialization: no compiled plugin matches the experiment, using the interpreter");
+        }
+        else
+        {
+            log_info("initialization: using the compiled plugin %s", plugin->path);
+        }
+    }
+
+    if (prepareActuatorFrames())
+    {
+        log_error("initialization: the actuator frames could not be prepared");
+        return 1;
+    }
+    return 0;
+}
+
 static int messageHandlerIPC(IPCSocketConnection* ipcsc)
 {
     while(ipcsc->open)
     {
-        if(hasMessages(ipcsc))
+        if(waitForMessages(ipcsc, IPC_WAIT_TIMEOUT))
         {
             Message msg = receiveMessageIPC(ipcsc);
             //log_debug("\nMESSAGE TYPE:    %d\nMESSAGE LENGTH:  %d\nMESSAGE CONTENT: %s", msg.type, msg.length, msg.content);
@@ -153,32 +425,10 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                         free(result);
                         break;
                     }
-                    else
-                    {
-                        variables = malloc(sizeof(*variables) * (sensorCount+actuatorCount));
-                        for (int i = 0; i < sensorCount; i++)
-                        {
-                            OperandType operandType;
-                            if (sensors[i].type == SensorTypeBinary)
-                            {
-                                operandType = OperandTypeBinary;
-                            }
-                            else
-                            {
-                                operandType = OperandTypeNumber;
-                            }
-                            variables[i] = (Variable){operandType, sensors[i].sensorID, sensors[i].value, getValueSizeOfSensorType(sensors[i].type)};
-                        }
-                        for (int i = sensorCount; i < (sensorCount + actuatorCount); i++)
-                        {
-                            int k = i-sensorCount;
-                            variables[k] = (Variable){actuators[k].type, actuators[k].actuatorID, actuators[k].value, getValueSizeOfActuatorType(actuators[k].type)};
-                            printActuatorData(actuators[k]);   // TODO add debugging flag
-                        }
-                    }
 
                     log_debug("initialization: parsing state machines of initializers");
-                    stateMachines = parseStateMachines(stringInitializers, strlen(stringInitializers), variables, sensorCount+actuatorCount, &stateMachineCount);
+                    expressionStore = createVariables() ? NULL : createExpressionStore();
+                    stateMachines = expressionStore == NULL ? NULL : parseStateMachines(stringInitializers, strlen(stringInitializers), variables, sensorCount+actuatorCount, expressionStore, &stateMachineCount);
                     if (stateMachines == NULL)
                     {
                         log_error("initialization: state machines of initializers could not be parsed successfully");
@@ -187,12 +437,14 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                         free(result);
                         break;
                     }
-                    else
+
+                    char* sections[] = {stringSensors, stringActuators, stringInitializers};
+                    if (prepareStateMachines(hashExperimentSections(sections, 3)))
                     {
-                        for (int i = 0; i < stateMachineCount; i++)
-                        {
-                            printStateMachineInfo(&stateMachines[i]);   // TODO add debugging flag
-                        }
+                        char* result = serializeInt(0);
+                        sendMessageIPC(ipcsc, IPCMSGTYPE_INITINITALIZATIONSERVICEFINISHED, result, 4);
+                        free(result);
+                        break;
                     }
 
                     log_debug("initialization: sending result to Communication Service");
@@ -207,6 +459,34 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                     break;
                 }
 
+                case IPCMSGTYPE_INITINITIALIZATIONIMAGE:
+                {
+                    /* the message contains the path of an image written by goldi-image, nothing has to be parsed */
+                    log_debug("initialization: starting initialization from experiment image %s", msg.content);
+                    ExperimentImage* image = openExperimentImage(msg.content);
+                    sensors = image == NULL ? NULL : createImageSensors(image, &sensorCount);
+                    actuators = sensors == NULL ? NULL : createImageActuators(image, &actuatorCount);
+                    expressionStore = actuators == NULL || createVariables() ? NULL : createExpressionStore();
+                    stateMachines = expressionStore == NULL ? NULL : loadStateMachines(image, variables, sensorCount+actuatorCount, expressionStore, &stateMachineCount);
+                    unsigned long long experimentHash = image == NULL ? 0 : image->header->initializationHash;
+                    /* everything has been copied out of the image, so it can be replaced by an update while running */
+                    closeExperimentImage(image);
+                    if (stateMachines == NULL || prepareStateMachines(experimentHash))
+                    {
+                        log_error("initialization: the experiment image could not be loaded successfully");
+                        char* result = serializeInt(0);
+                        sendMessageIPC(ipcsc, IPCMSGTYPE_INITINITALIZATIONSERVICEFINISHED, result, 4);
+                        free(result);
+                        break;
+                    }
+
+                    log_debug("initialization: sending result to Communication Service");
+                    char* result = serializeInt(1);
+                    sendMessageIPC(ipcsc, IPCMSGTYPE_INITINITALIZATIONSERVICEFINISHED, result, 4);
+                    free(result);
+                    break;
+                }
+
                 case IPCMSGTYPE_SENSORDATA:
                 {
                     log_debug("receiving new sensor data");
@@ -218,12 +498,17 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                     }
                     else
                     {
+                        /* the values are not changed during an update, afterwards the execution is woken up */
+                        beginStateMachineInputUpdate(&execution);
                         for (int i = 0; i < newSensorDataCount; i++)
                         {
                             Sensor* sensor = getSensorWithID(sensors, sensorDataPackets[i].sensorID, sensorCount);
-                            sensor->value = sensorDataPackets[i].value;
+                            /* the transition functions are bound to the address of the value, so it is updated in place */
+                            memcpy(sensor->value, sensorDataPackets[i].value, getValueSizeOfSensorType(sensor->type));
+                            free(sensorDataPackets[i].value);
                             free(sensorDataPackets[i].sensorID);
                         }
+                        endStateMachineInputUpdate(&execution);
                     }
                     free(sensorDataPackets);
                     break;
@@ -232,8 +517,34 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                 case IPCMSGTYPE_STARTINITIALIZATION:
                 {
                     log_debug("starting initialization of physical system");
-                    execution.stopped = 0;
-                    execution.stateMachine = &stateMachines[msg.content[0]];
+                    /* every byte of the message selects one initializer, all of them are executed together */
+                    StateMachine* selected[stateMachineCount + 1];
+                    unsigned int selectedCount = 0;
+                    for (int i = 0; i < msg.length; i++)
+                    {
+                        unsigned char index = msg.content[i];
+                        if (index >= stateMachineCount)
+                        {
+                            log_error("initialization: there is no initializer %u", index);
+                            continue;
+                        }
+                        unsigned int duplicate = 0;
+                        for (int k = 0; k < selectedCount; k++)
+                        {
+                            duplicate |= selected[k] == &stateMachines[index];
+                        }
+                        if (!duplicate)
+                        {
+                            selected[selectedCount++] = &stateMachines[index];
+                        }
+                    }
+                    if (selectedCount == 0 || frames.buffer == NULL || startStateMachineExecution(&execution, selected, selectedCount))
+                    {
+                        char* result = serializeInt(0);
+                        sendMessageIPC(ipcsc, IPCMSGTYPE_INITIALIZATIONFINISHED, result, 4);
+                        free(result);
+                        break;
+                    }
                     pthread_t initializationThread;
                     pthread_create(&initializationThread, NULL, &startInitialization, NULL);
                     break;
@@ -242,7 +553,7 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                 case IPCMSGTYPE_STOPINITIALIZATION:
                 {
                     log_debug("stopping initialization of physical system");
-                    execution.stopped = 1;
+                    stopStateMachineExecution(&execution);
                     break;
                 }
 
@@ -276,8 +587,65 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
     return 0;
 }
 
+/* prints the available command line options */
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -p, --plugin-dir <dir>      directory searched for compiled experiments (default: %s)\n", EXPERIMENT_PLUGIN_DIRECTORY);
+    printf("    -i, --interpreter           never use a compiled experiment\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+/* parses the command line options, returns 1 if the service should not be started */
+static int parseOptions(int argc, char* const argv[])
+{
+    static const struct option options[] = 
+    {
+        {"plugin-dir",  required_argument, NULL, 'p'},
+        {"interpreter", no_argument,       NULL, 'i'},
+        {"help",        no_argument,       NULL, 'h'},
+        {NULL,          0,                 NULL, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "p:ih", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+            {
+                pluginDirectory = optarg;
+                break;
+            }
+
+            case 'i':
+            {
+                pluginDirectory = NULL;
+                break;
+            }
+
+            default:
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char const *argv[])
 {
+    if (parseOptions(argc, (char* const*)argv))
+    {
+        return -1;
+    }
+
+    if (initStateMachineExecution(&execution))
+    {
+        return -1;
+    }
+
     int fd = createIPCSocket(INITIALIZATION_SERVICE);
     communicationService = acceptIPCConnection(fd, messageHandlerIPC);
     if (communicationService == NULL)
@@ -291,6 +659,10 @@ int main(int argc, char const *argv[])
     destroySensors(sensors, sensorCount);
     destroyActuators(actuators, actuatorCount);
     destroyStateMachines(stateMachines, stateMachineCount);
+    destroyExpressionStore(expressionStore);
+    closeExperimentPlugin(plugin);
+    destroyStateMachineExecution(&execution);
+    destroyActuatorFrames();
     free(variables);
     return 0;
 }
\ No newline at end of file
@@ -4,10 +4,12 @@
 
 #include "interfaces/ipcsockets.h"
 #include "programmer/goldi-programmer.h"
+#include "interfaces/SoftwareFPGA.h"
 #include "logging/log.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <getopt.h>
 
 static IPCSocketConnection* communicationService;
 
@@ -155,8 +157,52 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
     return 0;
 }
 
+/* prints the available command line options */
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -s, --simulate              program the software FPGA instead of the JTAG interface\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+/* parses the command line options, returns 1 if the service should not be started */
+static int parseOptions(int argc, char* const argv[])
+{
+    static const struct option options[] = 
+    {
+        {"simulate",    no_argument,    NULL, 's'},
+        {"help",        no_argument,    NULL, 'h'},
+        {NULL,          0,              NULL, 0}
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "sh", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+            {
+                setGPIOBackend(&softwareFPGAGPIOBackend);
+                break;
+            }
+
+            default:
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char const *argv[])
 {
+    if (parseOptions(argc, (char* const*)argv))
+    {
+        return -1;
+    }
+
     int fd = createIPCSocket(PROGRAMMING_SERVICE);
     communicationService = acceptIPCConnection(fd, messageHandlerIPC);
     if (communicationService == NULL)
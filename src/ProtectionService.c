@@ -1,13 +1,40 @@
+#define _GNU_SOURCE                         // ppoll for the deadlines of the fault monitor
 #define SENSOR_PREFIX 'x'
 #define ACTUATOR_PREFIX 'y'
 #define EXTENDED_SENSORS_ACTUATORS
 
 #include "interfaces/ipcsockets.h"
 #include "interfaces/spi.h"
+#include "interfaces/SoftwareFPGA.h"
 #include "interfaces/SensorsActuators.h"
 #include "utils/utils.h"
 #include "logging/log.h"
 #include "parsers/BooleanExpressionParser.h"
+#include "parsers/BooleanExpressionCompiler.h"
+#include "parsers/BooleanExpressionOptimizer.h"
+#include "parsers/BitRuleEngine.h"
+#include "parsers/BDDRuleEngine.h"
+#include "parsers/DependencyIndex.h"
+#include "parsers/ExpressionStore.h"
+#include "interfaces/ExperimentPlugin.h"
+#include "interfaces/ExperimentImage.h"
+#include "interfaces/ProcessImage.h"
+#include "utils/CycleTimer.h"
+#include "utils/TimerWheel.h"
+#include "utils/RealTime.h"
+#include "utils/CycleProfile.h"
+#include "utils/AllocationCounter.h"
+#include <getopt.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <signal.h>
+
+#define PROTECTION_CYCLE_PERIOD 1000        // the default period of the control loop in us
+#define PROTECTION_REPORT_INTERVAL 10       // the default interval of the cycle time reports in s
+#define DELAY_FAULT_TIMEOUT 10000           // the time a delay based fault has to resolve in us
+#define DELAY_FAULT_TICK 100                // the resolution of the deadlines of the delay based faults in us
+#define PROTECTION_REALTIME_HEAP (8 << 20)  // the heap prefaulted in the real-time mode in bytes
+#define PROTECTION_REALTIME_STACK (512 << 10)   // the stack prefaulted in the real-time mode in bytes
 
 /* all possible error types */
 typedef enum
@@ -17,40 +44,100 @@ typedef enum
     INFRASTRUCTURE_ERROR
 } ErrorType;
 
+/* all engines that can be used to evaluate the Protectionrules */
+typedef enum
+{
+    RULE_ENGINE_BITPARALLEL,
+    RULE_ENGINE_INCREMENTAL,
+    RULE_ENGINE_DAG,
+    RULE_ENGINE_BYTECODE,
+    RULE_ENGINE_BDD,
+    RULE_ENGINE_PLUGIN
+} RuleEngineType;
+
+/* the phases of a cycle of the control loop, each one has a histogram in the cycle profile */
+typedef enum
+{
+    PHASE_SENSOR_READ,
+    PHASE_SENSOR_SEND,
+    PHASE_ACTUATOR_ADOPT,
+    PHASE_RULE_EVALUATION,
+    PHASE_RULE_HANDLING,
+    PHASE_ACTUATOR_WRITE,
+    PHASE_SNAPSHOT,
+    PHASE_COUNT
+} CyclePhase;
+
+static const char* const cyclePhaseNames[PHASE_COUNT] =
+{
+    "sensor read", "sensor send", "actuator adopt", "rule evaluation", "rule handling", "actuator write", "snapshot"
+};
+
 /*
  *  Protectionrules can be checked to test if faults/errors have occured 
- *  expression      -   this is evaluated during the main loop, an error has occurred 
- *                      when the expression evaluates to 1
+ *  expression      -   the parsed expression of the Protectionrule
+ *  program         -   the compiled expression, this is evaluated during the main loop, an error
+ *                      has occurred when it evaluates to 1
+ *  shared          -   the root of the expression inside of the expression store (only used by RULE_ENGINE_DAG)
  *  errorType       -   the type of the error
  *  errorMessage    -   a string containing a descriptive error Message
  *  errorCode       -   the internal code of the error
+ *  result          -   the result of the last evaluation (only used by RULE_ENGINE_DAG and RULE_ENGINE_BYTECODE)
  */
 typedef struct
 {
-    BooleanExpression*  expression;
-    ErrorType           errorType;
-    char*               errorMessage;
-    int                 errorCode;
+    BooleanExpression*          expression;
+    CompiledBooleanExpression*  program;
+    SharedExpression*           shared;
+    ErrorType                   errorType;
+    char*                       errorMessage;
+    int                         errorCode;
+    int                         result;
 } Protectionrule;
 
-/* a struct containing all the Protectionrules and their count */
+/*
+ *  a struct containing all the Protectionrules, their count and the engine used to evaluate them
+ *  engineType      -   the selected engine, only the data of this engine is created
+ *  selectedType    -   the engine selected by the options, engineType is reset to it by a reinitialization
+ *  bitEngine       -   evaluates all rules at once over the packed binary variables
+ *  dependencies    -   evaluates only the rules whose variables changed since the last cycle
+ *  expressions     -   shares identical subexpressions between the rules, each is evaluated once per cycle
+ *  bddEngine       -   walks the decision diagram of the disjunction of all rules, the single rules only if it is true
+ *  plugin          -   the rules compiled by goldi-compile, replaces the selected engine if it matches the experiment
+ *  pluginResults   -   the results of the last evaluation of the plugin
+ */
 struct 
 {
-    Protectionrule* rules;
-    int             count;
+    Protectionrule*         rules;
+    int                     count;
+    RuleEngineType          engineType;
+    RuleEngineType          selectedType;
+    BitRuleEngine*          bitEngine;
+    DependencyIndex*        dependencies;
+    ExpressionStore*        expressions;
+    BDDRuleEngine*          bddEngine;
+    ExperimentPluginHandle* plugin;
+    unsigned char*          pluginResults;
 } Protectionrules;
 
 /*
  *  DelayBasedFault struct to keep track of a specific delay based fault
  *  rule        -   the associated Protectionrule which is checked continously and at the end
- *  thread      -   the associated thread where the DelayBasedFault is handled in
- *  isActive    -   indicates whether the thread is still active
+ *  program     -   the rule bound to the snapshot of the fault monitor instead of the process image
+ *  requested   -   set by the control loop to the first epoch of the snapshot that shows the fault, 0 if the
+ *                  fault has not been triggered since the monitor took the last request
+ *  firstEpoch  -   the first epoch of the snapshot the rule is checked on
+ *  deadline    -   the timer of the fault monitor, expires if the fault has not been resolved in time
+ *  isActive    -   indicates whether the fault is monitored
  */
 typedef struct
 {
-    Protectionrule* rule;
-    pthread_t       thread;
-    unsigned int    isActive:1;
+    Protectionrule*             rule;
+    CompiledBooleanExpression*  program;
+    atomic_uint                 requested;
+    unsigned int                firstEpoch;
+    Timer                       deadline;
+    unsigned int                isActive:1;
 } DelayBasedFault;
 
 /* a struct containing all the possible DelayBasedFaults and their maximum count */
@@ -60,6 +147,63 @@ struct
     unsigned int        maxCount;
 } delayBasedFaults;
 
+/*
+ *  the monitor of all DelayBasedFaults, a single thread that is woken by the control loop when a fault has
+ *  been triggered or the process image changed while faults are monitored, and at the deadline of a fault
+ *  thread      -   the monitor thread
+ *  mutex       -   protects the faults and the wheel against a reinitialization
+ *  event       -   the eventfd signaled by the control loop
+ *  running     -   cleared to stop the monitor thread
+ *  wheel       -   the deadlines of the monitored faults
+ *  values      -   the snapshot of the process image the rules are checked on
+ *  epoch       -   the epoch of values
+ *  monitored   -   the amount of monitored faults, read by the control loop
+ */
+static struct
+{
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    int             event;
+    unsigned int    running;
+    TimerWheel      wheel;
+    char*           values;
+    unsigned int    epoch;
+    atomic_uint     monitored;
+} faultMonitor = {.mutex = PTHREAD_MUTEX_INITIALIZER, .event = -1};
+
+/*
+ *  the sensor data messages, assembled from the serialized packets of the changed sensors
+ *  packets         -   the serialized packets of every sensor, one with the value 0 followed by one with the value 1,
+ *                      NULL for sensors that can not be serialized
+ *  packetLengths   -   the length of every packet
+ *  buffer          -   large enough for a message with the longest packet of every sensor
+ */
+typedef struct
+{
+    char**          packets;
+    unsigned int*   packetLengths;
+    char*           buffer;
+} SensorDataFrames;
+
+static const char sensorDataPrefix[] = "{\"SensorData\":[";
+
+/*
+ *  pauses the control loop while a reinitialization replaces the experiment
+ *  mutex       -   protects paused and running
+ *  changed     -   signaled when the control loop has paused and when the pause has been ended
+ *  requested   -   set while a pause is requested, checked by the control loop at the start of every cycle
+ *  paused      -   set while the control loop waits for the end of the pause
+ *  running     -   set once the control loop is about to start, before that there is nothing to wait for
+ */
+static struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  changed;
+    atomic_uint     requested;
+    unsigned int    paused;
+    unsigned int    running;
+} controlLoopPause = {.mutex = PTHREAD_MUTEX_INITIALIZER, .changed = PTHREAD_COND_INITIALIZER};
+
 /* global variables needed for execution */
 static IPCSocketConnection* communicationService;   // the IPC-socket to the Communication Service
 static Sensor* sensors;                             // here all of our sensor data is saved
@@ -69,7 +213,28 @@ static unsigned int sensorCount;                    // the amount of sensors
 static unsigned int actuatorCount;                  // the amount of actuators
 static unsigned int stoppedPS = 1;                  // indicates whether the physical system has been stopped
 static pthread_mutex_t mutexSPI;                    // used to coordinate spi access
-static volatile unsigned int initialized = 0;       // used to indicate whether the service has been initialized
+static ProcessImage* processImage;                  // contains the values of all sensors and actuators
+static unsigned int bulkSPI = 0;                    // transfers all sensors and the changed actuators in one frame per cycle
+static SPIFrame* spiFrame;                          // the frame of every cycle, NULL unless bulkSPI is set
+static SPIFrame* stopFrame;                         // writes the stop value of every actuator, as one frame if bulkSPI is set
+static pthread_mutex_t mutexStop = PTHREAD_MUTEX_INITIALIZER;   // keeps the control loop from writing actuators after a stop
+static unsigned int restageActuators = 0;           // set on start, the next write includes every actuator
+static SensorDataFrames sensorDataFrames;           // used to send the changed sensors without any allocation
+static unsigned int checkAllocations = 0;           // aborts if the control loop allocates without a triggered rule
+static unsigned int initialized = 0;                // used to indicate whether the service has been initialized
+static pthread_mutex_t mutexInitialized = PTHREAD_MUTEX_INITIALIZER;    // protects initialized
+static pthread_cond_t initializedCondition = PTHREAD_COND_INITIALIZER;  // signaled once the service has been initialized
+static unsigned long long cyclePeriod = PROTECTION_CYCLE_PERIOD;        // the period of the control loop in us
+static unsigned long long reportInterval = PROTECTION_REPORT_INTERVAL;  // the interval of the cycle time reports in s, 0 for none
+static const char* pluginDirectory = EXPERIMENT_PLUGIN_DIRECTORY;   // searched for compiled experiments, NULL to always interpret
+static RealTimeParameters realTime = {0, -1, PROTECTION_REALTIME_HEAP, PROTECTION_REALTIME_STACK};    // the control loop runs in real-time if a priority is set
+static CycleProfile* cycleProfile;                  // the durations of the phases of the control loop
+static CycleProfile* stopProfile;                   // the time from the trigger of a rule until the stop values have been transferred
+static CycleProfile* requestedStopProfile;          // the same for the stops requested by the Communication Service or a reinitialization
+static pthread_mutex_t mutexRequestedStops = PTHREAD_MUTEX_INITIALIZER;   // lets the report thread reset requestedStopProfile
+static CycleProfile* ruleProfile;                   // the evaluation time of every rule followed by the handling time of every rule
+static unsigned int profileRules = 0;               // measures the evaluation time of every rule, only done by the engines evaluating rule by rule
+static volatile sig_atomic_t profileDumpRequested = 0;  // set by SIGUSR2, the message handler logs the profiles
 
 /*
  * the sigint handler, can also be used for cleanup after execution 
@@ -80,6 +245,12 @@ static void sigint_handler(int sig)
     exit(0);
 }
 
+/* the SIGUSR2 handler, the profiles are logged by the message handler as logging is not async-signal-safe */
+static void sigusr2_handler(int sig)
+{
+    profileDumpRequested = 1;
+}
+
 /*
  *  can be used to print out the information of a Protectionrule
  *  rule    -   the Protectionrule to be printed 
@@ -92,28 +263,79 @@ void printProtectionRule(Protectionrule rule)
     printf("ErrorCode: %d\n", rule.errorCode);
 }
 
+/* evaluates the compiled program of a Protectionrule, used by the DependencyIndex */
+static int evaluateProtectionRuleProgram(void* context, unsigned int rule)
+{
+    return evaluateCompiledBooleanExpression(Protectionrules.rules[rule].program);
+}
+
+/* logs which rules can never trigger and which rules only trigger together with other rules */
+static void logBDDRuleAnalysis(BDDRuleEngine* engine)
+{
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        if (engine->status[i] == BDDRuleNeverTriggered)
+        {
+            log_info("parse protection: rule with error code %d can never trigger", Protectionrules.rules[i].errorCode);
+        }
+        else if (engine->status[i] == BDDRuleRedundant)
+        {
+            log_info("parse protection: rule with error code %d only triggers together with other rules", Protectionrules.rules[i].errorCode);
+        }
+    }
+    log_info("parse protection: %d rules over %u inputs use %u diagram nodes, %u never trigger, %u are redundant", Protectionrules.count,
+             engine->inputCount, engine->nodeCount, engine->neverTriggered, engine->redundant);
+}
+
 /*
- *  used to parse the Protectionrules given by the Communication Service as a JSON-formatted string
- *  protectionString    -   the JSON-formatted string containing all Protectionrules 
+ *  loads the plugin compiled from the experiment with the given hash and binds it to the sensor and actuator values,
+ *  returns 1 if there is no matching plugin
  */
-int parseProtectionRules(char *protectionString)
+static int loadProtectionPlugin(unsigned long long experimentHash)
 {
-    JSON* protectionRulesJSON = JSONParse(protectionString);
-    if (protectionRulesJSON == NULL)
+    ExperimentPluginHandle* plugin = findExperimentPlugin(pluginDirectory, ExperimentPartProtection, experimentHash);
+    if (plugin == NULL)
     {
-        log_error("parse protection: protection could not be accessed in json");
         return 1;
     }
-
-    Protectionrules.count = JSONGetArraySize(protectionRulesJSON);
-    Protectionrules.rules = malloc(sizeof(*Protectionrules.rules)*Protectionrules.count);
-    if (Protectionrules.rules == NULL)
+    if (plugin->plugin->sensorCount != sensorCount || plugin->plugin->actuatorCount != actuatorCount || plugin->plugin->ruleCount != Protectionrules.count)
+    {
+        log_error("parse protection: plugin %s does not match the parsed experiment", plugin->path);
+        closeExperimentPlugin(plugin);
+        return 1;
+    }
+    Protectionrules.pluginResults = calloc(Protectionrules.count + 1, sizeof(*Protectionrules.pluginResults));
+    if (Protectionrules.pluginResults == NULL)
     {
         log_error("parse protection: malloc error %s", strerror(errno));
+        closeExperimentPlugin(plugin);
         return 1;
     }
 
-    Variable* variables = malloc(sizeof(*variables)*(sensorCount+actuatorCount));
+    char* sensorValues[sensorCount + 1];
+    char* actuatorValues[actuatorCount + 1];
+    for (int i = 0; i < sensorCount; i++)
+    {
+        sensorValues[i] = sensors[i].value;
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        actuatorValues[i] = actuators[i].value;
+    }
+    plugin->plugin->bindProcessImage(sensorValues, actuatorValues);
+    Protectionrules.plugin = plugin;
+    return 0;
+}
+
+/* creates the variables of the Protectionrules, all sensors followed by all actuators */
+static Variable* createRuleVariables(void)
+{
+    Variable* variables = malloc(sizeof(*variables)*(sensorCount+actuatorCount+1));
+    if (variables == NULL)
+    {
+        log_error("parse protection: malloc error %s", strerror(errno));
+        return NULL;
+    }
     for (int i = 0; i < sensorCount; i++)
     {
         OperandType operandType;
@@ -141,6 +363,188 @@ int parseProtectionRules(char *protectionString)
         }
         variables[i] = (Variable){operandType, actuators[k].actuatorID, actuators[k].value, getValueSizeOfActuatorType(actuators[k].type)};
     }
+    return variables;
+}
+
+/*
+ *  sets up a single Protectionrule from its optimized expression
+ *  rule                -   the Protectionrule to be set up
+ *  expression          -   the optimized expression, owned by the rule afterwards
+ *  expressionString    -   the expression as written in the experiment data, decides the type of the error
+ *  errorMessage        -   the message of the error, copied into the rule
+ *  errorCode           -   the internal code of the error
+ */
+static int setProtectionRule(Protectionrule* rule, BooleanExpression* expression, const char* expressionString, const char* errorMessage, int errorCode)
+{
+    rule->expression = expression;
+    if (rule->expression != NULL && rule->expression->type == BoolExprCONSTANT)
+    {
+        log_info("parse protection: expression %s is constant", expressionString);
+    }
+    rule->program = compileBooleanExpression(rule->expression);
+    rule->shared = NULL;
+    if (rule->program == NULL)
+    {
+        log_error("parse protection: expression %s could not be compiled", expressionString);
+        return 1;
+    }
+
+    /* find out what kind of fault/error the protection rule would trigger */
+    if (strchr(expressionString, SENSOR_PREFIX) != NULL)
+    {
+        if (strchr(expressionString, ACTUATOR_PREFIX) != NULL)
+        {
+            rule->errorType = DELAY_ERROR;
+        }
+        else
+        {
+            rule->errorType = INFRASTRUCTURE_ERROR;
+        }
+    }
+    else if (strchr(expressionString, ACTUATOR_PREFIX) != NULL)
+    {
+        rule->errorType = USER_ERROR;
+    }
+    else
+    {
+        //TODO error handling: handle incorrect syntax of protectionRule
+    }
+
+    rule->errorMessage = malloc(strlen(errorMessage)+1);
+    if (rule->errorMessage == NULL)
+    {
+        log_error("parse protection: malloc error %s", strerror(errno));
+        return 1;
+    }
+    memcpy(rule->errorMessage, errorMessage, strlen(errorMessage)+1);
+    rule->errorCode = errorCode;
+    return 0;
+}
+
+/*
+ *  loads a plugin compiled from the experiment and prepares the selected engine for evaluating the Protectionrules
+ *  variables       -   the variables the rules are bound to, see createRuleVariables
+ *  experimentHash  -   the hash of the experiment, used to find a plugin compiled by goldi-compile
+ */
+static int prepareProtectionRules(Variable* variables, unsigned long long experimentHash)
+{
+    /* a plugin compiled from the same experiment replaces the selected engine */
+    if (pluginDirectory != NULL)
+    {
+        if (loadProtectionPlugin(experimentHash))
+        {
+            log_info("parse protection: no compiled plugin matches the experiment, using the interpreter");
+        }
+        else
+        {
+            log_info("parse protection: using the compiled plugin %s", Protectionrules.plugin->path);
+            Protectionrules.engineType = RULE_ENGINE_PLUGIN;
+        }
+    }
+
+    /* prepare the selected engine for evaluating the rules */
+    BooleanExpression* expressions[Protectionrules.count + 1];
+    CompiledBooleanExpression* programs[Protectionrules.count + 1];
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        expressions[i] = Protectionrules.rules[i].expression;
+        programs[i] = Protectionrules.rules[i].program;
+    }
+    int engineCreated = 1;
+    switch (Protectionrules.engineType)
+    {
+        case RULE_ENGINE_BITPARALLEL:
+            Protectionrules.bitEngine = createBitRuleEngine(expressions, programs, Protectionrules.count, variables, sensorCount+actuatorCount);
+            engineCreated = Protectionrules.bitEngine != NULL;
+            break;
+
+        case RULE_ENGINE_INCREMENTAL:
+            Protectionrules.dependencies = createDependencyIndex(expressions, Protectionrules.count, variables, sensorCount+actuatorCount,
+                                                                 evaluateProtectionRuleProgram, NULL);
+            engineCreated = Protectionrules.dependencies != NULL;
+            break;
+
+        case RULE_ENGINE_DAG:
+            Protectionrules.expressions = createExpressionStore();
+            engineCreated = Protectionrules.expressions != NULL;
+            for (int i = 0; i < Protectionrules.count && engineCreated; i++)
+            {
+                Protectionrules.rules[i].shared = internBooleanExpression(Protectionrules.expressions, expressions[i]);
+                engineCreated = Protectionrules.rules[i].shared != NULL;
+            }
+            if (engineCreated)
+            {
+                log_info("parse protection: %d rules use %d shared nodes instead of %d", Protectionrules.count,
+                         Protectionrules.expressions->nodeCount, Protectionrules.expressions->requestedNodes);
+            }
+            break;
+
+        case RULE_ENGINE_BDD:
+            Protectionrules.bddEngine = createBDDRuleEngine(expressions, Protectionrules.count);
+            if (Protectionrules.bddEngine != NULL)
+            {
+                logBDDRuleAnalysis(Protectionrules.bddEngine);
+            }
+            else
+            {
+                /* every rule is compiled anyway, so the bytecode can always replace the diagrams */
+                log_info("parse protection: the rules can not be converted to binary decision diagrams, using the bytecode");
+                Protectionrules.engineType = RULE_ENGINE_BYTECODE;
+            }
+            break;
+
+        default:
+            break;
+    }
+    if (!engineCreated)
+    {
+        log_error("parse protection: rule engine could not be created");
+        return 1;
+    }
+
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        printProtectionRule(Protectionrules.rules[i]);  //TODO add debugging flag
+    }
+
+    return 0;
+}
+
+/*
+ *  used to parse the Protectionrules given by the Communication Service as a JSON-formatted string
+ *  protectionString    -   the JSON-formatted string containing all Protectionrules 
+ *  experimentHash      -   the hash of the experiment, used to find a plugin compiled by goldi-compile
+ */
+int parseProtectionRules(char *protectionString, unsigned long long experimentHash)
+{
+    JSON* protectionRulesJSON = JSONParse(protectionString);
+    if (protectionRulesJSON == NULL)
+    {
+        log_error("parse protection: protection could not be accessed in json");
+        return 1;
+    }
+
+    Protectionrules.count = JSONGetArraySize(protectionRulesJSON);
+    Protectionrules.rules = calloc(Protectionrules.count + 1, sizeof(*Protectionrules.rules));
+    if (Protectionrules.rules == NULL)
+    {
+        log_error("parse protection: malloc error %s", strerror(errno));
+        return 1;
+    }
+
+    Variable* variables = createRuleVariables();
+    if (variables == NULL)
+    {
+        return 1;
+    }
+
+    /* the names of all variables are hashed once and shared by all rules */
+    SymbolTable* symbols = createSymbolTable(variables, sensorCount+actuatorCount);
+    if (symbols == NULL)
+    {
+        free(variables);
+        return 1;
+    }
 
     JSON* protectionRuleJSON = NULL;
     int currentIndex = 0;
@@ -150,99 +554,975 @@ int parseProtectionRules(char *protectionString)
         JSON* errorMessageJSON = JSONGetObjectItem(protectionRuleJSON, "ErrorMessage");
         JSON* errorCodeJSON = JSONGetObjectItem(protectionRuleJSON, "ErrorCode");
         char* expressionString = expressionJSON->valuestring;
-        Protectionrules.rules[currentIndex].expression = parseBooleanExpression(expressionString, strlen(expressionString), variables, sensorCount+actuatorCount);
-        
-        /* find out what kind of fault/error the protection rule would trigger */
-        if (strchr(expressionString, SENSOR_PREFIX) != NULL)
+        BooleanExpressionParseError parseError;
+        BooleanExpression* expression = parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError);
+        if (expression == NULL)
+        {
+            log_error("parse protection: expression %s could not be parsed: %s at position %u", expressionString, parseError.message, parseError.position);
+            return 1;
+        }
+        if (setProtectionRule(&Protectionrules.rules[currentIndex], optimizeBooleanExpression(expression), expressionString,
+                              errorMessageJSON->valuestring, errorCodeJSON->valueint))
+        {
+            return 1;
+        }
+        currentIndex++;
+    }
+    destroySymbolTable(symbols);
+    JSONDelete(protectionRulesJSON);
+
+    int result = prepareProtectionRules(variables, experimentHash);
+    free(variables);
+    return result;
+}
+
+/*
+ *  creates the Protectionrules of an experiment image written by goldi-image, the expressions of the image are
+ *  already optimized, so they are only bound to the sensors and actuators and compiled
+ *  image   -   the mapped image, the sensors and actuators have to be created from the same image
+ */
+int loadProtectionRules(const ExperimentImage* image)
+{
+    const ImageRule* imageRules = getImageSection(image, image->header->rules);
+    Protectionrules.count = image->header->rules.count;
+    Protectionrules.rules = calloc(Protectionrules.count + 1, sizeof(*Protectionrules.rules));
+    Variable* variables = Protectionrules.rules == NULL ? NULL : createRuleVariables();
+    if (variables == NULL)
+    {
+        log_error("parse protection: the rules of the image could not be created");
+        return 1;
+    }
+
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        const char* expressionString = getImageString(image, imageRules[i].source, 0);
+        const char* errorMessage = getImageString(image, imageRules[i].errorMessage, 0);
+        BooleanExpression* expression = createImageExpression(image, imageRules[i].expression, variables, sensorCount+actuatorCount);
+        if (expressionString == NULL || errorMessage == NULL || expression == NULL)
+        {
+            log_error("parse protection: rule %d of the image is invalid", i);
+            destroyBooleanExpression(expression);
+            free(variables);
+            return 1;
+        }
+        if (setProtectionRule(&Protectionrules.rules[i], expression, expressionString, errorMessage, imageRules[i].errorCode))
         {
-            if (strchr(expressionString, ACTUATOR_PREFIX) != NULL)
+            free(variables);
+            return 1;
+        }
+    }
+
+    int result = prepareProtectionRules(variables, image->header->protectionHash);
+    free(variables);
+    return result;
+}
+
+/* frees the Protectionrules and the data of their engine, also of rules that have only been created in part */
+static void destroyProtectionRules(void)
+{
+    for (int i = 0; i < Protectionrules.count && Protectionrules.rules != NULL; i++)
+    {
+        destroyBooleanExpression(Protectionrules.rules[i].expression);
+        destroyCompiledBooleanExpression(Protectionrules.rules[i].program);
+        free(Protectionrules.rules[i].errorMessage);
+    }
+    free(Protectionrules.rules);
+    destroyBitRuleEngine(Protectionrules.bitEngine);
+    destroyDependencyIndex(Protectionrules.dependencies);
+    destroyExpressionStore(Protectionrules.expressions);
+    destroyBDDRuleEngine(Protectionrules.bddEngine);
+    closeExperimentPlugin(Protectionrules.plugin);
+    free(Protectionrules.pluginResults);
+    Protectionrules.rules = NULL;
+    Protectionrules.count = 0;
+    Protectionrules.engineType = Protectionrules.selectedType;
+    Protectionrules.bitEngine = NULL;
+    Protectionrules.dependencies = NULL;
+    Protectionrules.expressions = NULL;
+    Protectionrules.bddEngine = NULL;
+    Protectionrules.plugin = NULL;
+    Protectionrules.pluginResults = NULL;
+}
+
+/* stops monitoring all DelayBasedFaults and frees them, the caller has to hold the mutex of the fault monitor */
+static void destroyDelayBasedFaults(void)
+{
+    for (int i = 0; i < delayBasedFaults.maxCount; i++)
+    {
+        removeTimer(&faultMonitor.wheel, &delayBasedFaults.faults[i].deadline);
+        destroyCompiledBooleanExpression(delayBasedFaults.faults[i].program);
+    }
+    atomic_store(&faultMonitor.monitored, 0);
+    free(delayBasedFaults.faults);
+    free(faultMonitor.values);
+    delayBasedFaults.faults = NULL;
+    delayBasedFaults.maxCount = 0;
+    faultMonitor.values = NULL;
+    faultMonitor.epoch = 0;
+}
+
+/*
+ *  creates a DelayBasedFault for every Protectionrule of the type DELAY_ERROR, the caller has to hold the mutex of
+ *  the fault monitor
+ */
+static void prepareDelayBasedFaults(void)
+{
+    delayBasedFaults.maxCount = 0;
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        if (Protectionrules.rules[i].errorType == DELAY_ERROR)
+        {
+            delayBasedFaults.maxCount++;
+        }
+    }
+    delayBasedFaults.faults = calloc(delayBasedFaults.maxCount + 1, sizeof(*delayBasedFaults.faults));
+    faultMonitor.values = malloc(processImage->size + 1);
+    if (delayBasedFaults.faults == NULL || faultMonitor.values == NULL)
+    {
+        log_error("the delay based faults can not be monitored: malloc error %s", strerror(errno));
+        free(delayBasedFaults.faults);
+        delayBasedFaults.faults = NULL;
+        delayBasedFaults.maxCount = 0;
+        return;
+    }
+    unsigned int currentFaultIndex = 0;
+    for (int i = 0; i < Protectionrules.count; i++)
+    {
+        if (Protectionrules.rules[i].errorType == DELAY_ERROR)
+        {
+            DelayBasedFault* fault = &delayBasedFaults.faults[currentFaultIndex++];
+            fault->isActive = 0;
+            fault->rule = &Protectionrules.rules[i];
+            atomic_init(&fault->requested, 0);
+            fault->deadline.context = fault;
+            /* the monitor checks the rule on snapshots of the process image, never on the values of the control loop */
+            fault->program = rebindCompiledBooleanExpression(fault->rule->program, processImage->values, processImage->size, faultMonitor.values);
+            if (fault->program == NULL)
             {
-                Protectionrules.rules[currentIndex].errorType = DELAY_ERROR;
+                log_error("the delay based fault %d can not be monitored", fault->rule->errorCode);
             }
-            else
+        }
+    }
+}
+
+/* evaluates all Protectionrules with the selected engine, returns the amount of triggered rules */
+static unsigned int evaluateProtectionRules(void)
+{
+    unsigned int triggeredRules = 0;
+    switch (Protectionrules.engineType)
+    {
+        case RULE_ENGINE_BITPARALLEL:
+            return evaluateBitRuleEngine(Protectionrules.bitEngine);
+
+        case RULE_ENGINE_INCREMENTAL:
+            updateDependencyIndex(Protectionrules.dependencies);
+            for (int i = 0; i < Protectionrules.count; i++)
             {
-                Protectionrules.rules[currentIndex].errorType = INFRASTRUCTURE_ERROR;
+                triggeredRules += getCachedResult(Protectionrules.dependencies, i) != 0;
             }
+            return triggeredRules;
+
+        case RULE_ENGINE_PLUGIN:
+            return Protectionrules.plugin->plugin->evaluateProtectionRules(Protectionrules.pluginResults);
+
+        case RULE_ENGINE_BDD:
+            return evaluateBDDRuleEngine(Protectionrules.bddEngine);
+
+        case RULE_ENGINE_DAG:
+            advanceExpressionStoreEpoch(Protectionrules.expressions);
+            for (int i = 0; i < Protectionrules.count; i++)
+            {
+                unsigned long long start = profileRules ? getMonotonicTime() : 0;
+                Protectionrules.rules[i].result = evaluateSharedExpression(Protectionrules.expressions, Protectionrules.rules[i].shared);
+                triggeredRules += Protectionrules.rules[i].result != 0;
+                if (profileRules)
+                {
+                    addProfileDuration(ruleProfile, i, getMonotonicTime() - start);
+                }
+            }
+            return triggeredRules;
+
+        default:
+            for (int i = 0; i < Protectionrules.count; i++)
+            {
+                unsigned long long start = profileRules ? getMonotonicTime() : 0;
+                Protectionrules.rules[i].result = evaluateCompiledBooleanExpression(Protectionrules.rules[i].program);
+                triggeredRules += Protectionrules.rules[i].result != 0;
+                if (profileRules)
+                {
+                    addProfileDuration(ruleProfile, i, getMonotonicTime() - start);
+                }
+            }
+            return triggeredRules;
+    }
+}
+
+/* returns whether the given Protectionrule triggered during the last call of evaluateProtectionRules */
+static unsigned int isProtectionRuleTriggered(int rule)
+{
+    switch (Protectionrules.engineType)
+    {
+        case RULE_ENGINE_BITPARALLEL:
+            return isRuleTriggered(Protectionrules.bitEngine, rule);
+
+        case RULE_ENGINE_INCREMENTAL:
+            return getCachedResult(Protectionrules.dependencies, rule) != 0;
+
+        case RULE_ENGINE_PLUGIN:
+            return Protectionrules.pluginResults[rule];
+
+        case RULE_ENGINE_BDD:
+            return isBDDRuleTriggered(Protectionrules.bddEngine, rule);
+
+        default:
+            return Protectionrules.rules[rule].result != 0;
+    }
+}
+
+/* logs how many rule evaluations the incremental engine has skipped and the dag engine has shared so far */
+static void logRuleEngineStatistics(void)
+{
+    if (Protectionrules.engineType == RULE_ENGINE_DAG && Protectionrules.expressions != NULL)
+    {
+        ExpressionStore* store = Protectionrules.expressions;
+        log_info("rule engine: %llu node evaluations, %llu answered by shared results", store->evaluations, store->memoHits);
+    }
+    if (Protectionrules.engineType == RULE_ENGINE_INCREMENTAL && Protectionrules.dependencies != NULL)
+    {
+        DependencyIndex* index = Protectionrules.dependencies;
+        log_info("rule engine: %llu cycles, %llu evaluations, %llu skipped evaluations (%.2f skipped per cycle)",
+                 index->updates, index->evaluations, index->skippedEvaluations,
+                 index->updates > 0 ? (double)index->skippedEvaluations / index->updates : 0.0);
+    }
+}
+
+/* used to start the physical system */
+static void startPhysicalSystem(void)
+{
+    log_info("physical system started");
+    //TODO maybe add check for protectionrules
+    pthread_mutex_lock(&mutexStop);
+    restageActuators = 1;
+    stoppedPS = 0;
+    pthread_mutex_unlock(&mutexStop);
+}
+
+/*
+ *  used to stop the physical system, all stop values are written by the precomputed stop frame, in one transfer
+ *  with bulkSPI or one transfer per actuator otherwise
+ *  returns the time the stop values have been transferred
+ */
+static unsigned long long stopPhysicalSystem(void)
+{
+    /* the writes of the control loop that started before the stop must never be sent after the stop values */
+    pthread_mutex_lock(&mutexStop);
+    stoppedPS = 1;
+    if (spiFrame != NULL)
+    {
+        clearSPIFrameWrites(spiFrame);
+        transferSPIFrame(stopFrame, &mutexSPI);
+    }
+    else if (stopFrame != NULL)
+    {
+        transferSPIFrameCommands(stopFrame, &mutexSPI);
+    }
+    pthread_mutex_unlock(&mutexStop);
+    unsigned long long stopped = getMonotonicTime();
+
+    /* the control loop adopts the stop values at the start of the next cycle */
+    if (processImage != NULL)
+    {
+        char* update = beginActuatorUpdate(processImage);
+        for (int i = 0; i < actuatorCount; i++)
+        {
+            memcpy(getActuatorUpdateValue(processImage, update, i), actuators[i].stopValue, getValueSizeOfActuatorType(actuators[i].type));
+        }
+        publishActuatorUpdate(processImage);
+    }
+
+    /* logging may block, so it is done after the stop values have been written */
+    log_info("physical system stopped");
+    logRuleEngineStatistics();
+    return stopped;
+}
+
+/* stops the physical system outside of the control loop, the stop latency is recorded by requestedStopProfile */
+static void stopPhysicalSystemOnRequest(void)
+{
+    unsigned long long requested = getMonotonicTime();
+    unsigned long long stopped = stopPhysicalSystem();
+    pthread_mutex_lock(&mutexRequestedStops);
+    addProfileDuration(requestedStopProfile, 0, stopped - requested);
+    commitCycleProfile(requestedStopProfile);
+    pthread_mutex_unlock(&mutexRequestedStops);
+}
+
+/*
+ *  hands a triggered DelayBasedFault to the fault monitor, called by the control loop. Neither allocates nor
+ *  blocks, a fault that is monitored already is not restarted.
+ */
+static void requestDelayBasedFaultMonitoring(DelayBasedFault* fault)
+{
+    /* the snapshot of the current cycle is the first one that shows the fault */
+    unsigned int epoch = atomic_load_explicit(&processImage->snapshotSequence, memory_order_relaxed) / 2 + 1;
+    atomic_store_explicit(&fault->requested, epoch, memory_order_release);
+    eventfd_write(faultMonitor.event, 1);
+}
+
+/* stops monitoring a fault, the monitor has to hold its mutex */
+static void finishDelayBasedFault(DelayBasedFault* fault)
+{
+    removeTimer(&faultMonitor.wheel, &fault->deadline);
+    fault->isActive = 0;
+    atomic_fetch_sub(&faultMonitor.monitored, 1);
+}
+
+/* returns 1 if the fault is still shown by the snapshot of the fault monitor */
+static unsigned int isDelayBasedFaultPending(DelayBasedFault* fault)
+{
+    return faultMonitor.epoch < fault->firstEpoch || fault->program == NULL || evaluateCompiledBooleanExpression(fault->program);
+}
+
+/*
+ *  called at the deadline of a DelayBasedFault, if the fault has not been resolved an error message is sent to
+ *  the Communication Service
+ */
+static void expireDelayBasedFault(Timer* timer, void* context)
+{
+    DelayBasedFault* fault = context;
+    faultMonitor.epoch = readProcessImageSnapshot(processImage, faultMonitor.values);
+    unsigned int pending = isDelayBasedFaultPending(fault);
+    finishDelayBasedFault(fault);
+    if (!pending)
+    {
+        log_debug("delay based fault resolved");
+        return;
+    }
+    log_error("delay based error occured, sending message");
+    JSON* delayBasedErrorJSON = JSONCreateObject();
+    JSONAddNumberToObject(delayBasedErrorJSON, "ErrorCode", fault->rule->errorCode);
+    char* delayBasedError = JSONPrint(delayBasedErrorJSON);
+    sendMessageIPC(communicationService, IPCMSGTYPE_DELAYBASEDERROR, delayBasedError, strlen(delayBasedError));
+
+    JSONDelete(delayBasedErrorJSON);
+    free(delayBasedError);
+}
+
+/* starts monitoring the faults requested by the control loop, the monitor has to hold its mutex */
+static void takeDelayBasedFaultRequests(unsigned long long now)
+{
+    for (int i = 0; i < delayBasedFaults.maxCount; i++)
+    {
+        DelayBasedFault* fault = &delayBasedFaults.faults[i];
+        unsigned int epoch = atomic_exchange_explicit(&fault->requested, 0, memory_order_acquire);
+        if (epoch != 0 && !fault->isActive)
+        {
+            log_debug("monitoring delay fault %d", fault->rule->errorCode);
+            fault->isActive = 1;
+            fault->firstEpoch = epoch;
+            atomic_fetch_add(&faultMonitor.monitored, 1);
+            addTimer(&faultMonitor.wheel, &fault->deadline, now + DELAY_FAULT_TIMEOUT * 1000ULL);
         }
-        else if (strchr(expressionString, ACTUATOR_PREFIX) != NULL)
+    }
+}
+
+/* checks all monitored faults on the latest snapshot if it is a new one, the monitor has to hold its mutex */
+static void checkDelayBasedFaults(void)
+{
+    unsigned int epoch = readProcessImageSnapshot(processImage, faultMonitor.values);
+    if (epoch == faultMonitor.epoch)
+    {
+        return;
+    }
+    faultMonitor.epoch = epoch;
+    for (int i = 0; i < delayBasedFaults.maxCount; i++)
+    {
+        DelayBasedFault* fault = &delayBasedFaults.faults[i];
+        if (fault->isActive && !isDelayBasedFaultPending(fault))
         {
-            Protectionrules.rules[currentIndex].errorType = USER_ERROR;
+            log_debug("delay based fault resolved");
+            finishDelayBasedFault(fault);
         }
-        else
+    }
+}
+
+/*
+ *  the fault monitor thread, it sleeps until the control loop signals a triggered fault or a change of the process
+ *  image, or until the next deadline. Every monitored fault is checked on each new snapshot and resolved as soon
+ *  as its rule is false, a fault still pending at its deadline is reported to the Communication Service.
+ */
+static void* monitorDelayBasedFaults(void* arg)
+{
+    pthread_mutex_lock(&faultMonitor.mutex);
+    while (faultMonitor.running)
+    {
+        unsigned long long next = getNextTimerWheelTick(&faultMonitor.wheel);
+        unsigned long long deadline = faultMonitor.wheel.start + next * faultMonitor.wheel.tickLength;
+        pthread_mutex_unlock(&faultMonitor.mutex);
+
+        struct timespec timeout = {0, 0};
+        unsigned long long now = getMonotonicTime();
+        if (next != 0 && deadline > now)
         {
-            //TODO error handling: handle incorrect syntax of protectionRule
+            timeout.tv_sec = (deadline - now) / 1000000000ULL;
+            timeout.tv_nsec = (deadline - now) % 1000000000ULL;
         }
+        struct pollfd event = {faultMonitor.event, POLLIN, 0};
+        ppoll(&event, 1, next == 0 ? NULL : &timeout, NULL);
+        eventfd_t events;
+        eventfd_read(faultMonitor.event, &events);
 
-        Protectionrules.rules[currentIndex].errorMessage = malloc(strlen(errorMessageJSON->valuestring)+1);
-        if (Protectionrules.rules[currentIndex].errorMessage == NULL)
+        pthread_mutex_lock(&faultMonitor.mutex);
+        now = getMonotonicTime();
+        takeDelayBasedFaultRequests(now);
+        if (atomic_load(&faultMonitor.monitored) > 0)
         {
-            log_error("parse protection: malloc error %s", strerror(errno));
-            return 1;
+            checkDelayBasedFaults();
         }
-        memcpy(Protectionrules.rules[currentIndex].errorMessage, errorMessageJSON->valuestring, strlen(errorMessageJSON->valuestring)+1);
-        Protectionrules.rules[currentIndex].errorCode = errorCodeJSON->valueint;
-        currentIndex++;
+        advanceTimerWheel(&faultMonitor.wheel, now, expireDelayBasedFault);
     }
+    pthread_mutex_unlock(&faultMonitor.mutex);
+    return NULL;
+}
 
-    free(variables);
+/* starts the fault monitor thread, returns 1 on error */
+static int startDelayBasedFaultMonitor(void)
+{
+    faultMonitor.event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (faultMonitor.event < 0)
+    {
+        log_error("the fault monitor could not be started: eventfd error %s", strerror(errno));
+        return 1;
+    }
+    initTimerWheel(&faultMonitor.wheel, getMonotonicTime(), DELAY_FAULT_TICK * 1000ULL);
+    atomic_init(&faultMonitor.monitored, 0);
+    faultMonitor.running = 1;
+    if (pthread_create(&faultMonitor.thread, NULL, &monitorDelayBasedFaults, NULL))
+    {
+        log_error("the fault monitor could not be started");
+        close(faultMonitor.event);
+        faultMonitor.event = -1;
+        return 1;
+    }
+    return 0;
+}
 
-    JSONDelete(protectionRulesJSON);
+static void stopDelayBasedFaultMonitor(void)
+{
+    pthread_mutex_lock(&faultMonitor.mutex);
+    faultMonitor.running = 0;
+    pthread_mutex_unlock(&faultMonitor.mutex);
+    eventfd_write(faultMonitor.event, 1);
+    pthread_join(faultMonitor.thread, NULL);
+    close(faultMonitor.event);
+    faultMonitor.event = -1;
+}
 
-    for (int i = 0; i < Protectionrules.count; i++)
+/*
+ *  creates the histograms of the evaluation and the handling of every Protectionrule, has to be done after the
+ *  rules have been loaded during a reinitialization
+ */
+static void prepareRuleProfile(void)
+{
+    destroyCycleProfile(ruleProfile);
+    ruleProfile = NULL;
+    char** names = calloc(Protectionrules.count * 2 + 1, sizeof(*names));
+    unsigned int created = 0;
+    for (int i = 0; names != NULL && i < Protectionrules.count * 2; i++)
+    {
+        const Protectionrule* rule = &Protectionrules.rules[i % Protectionrules.count];
+        if (asprintf(&names[i], "rule %d (error %d) %s", i % Protectionrules.count, rule->errorCode, i < Protectionrules.count ? "evaluation" : "handling") < 0)
+        {
+            names[i] = NULL;
+            break;
+        }
+        created++;
+    }
+    if (names != NULL && created == Protectionrules.count * 2)
+    {
+        ruleProfile = createCycleProfile((const char* const*)names, created);
+    }
+    if (ruleProfile == NULL)
+    {
+        log_error("initialization: the rules can not be profiled");
+        profileRules = 0;
+    }
+    else if (profileRules && Protectionrules.engineType != RULE_ENGINE_BYTECODE && Protectionrules.engineType != RULE_ENGINE_DAG)
+    {
+        log_info("initialization: the rule engine evaluates all rules at once, only the handling of the rules is profiled");
+    }
+    for (int i = 0; i < created; i++)
+    {
+        free(names[i]);
+    }
+    free(names);
+}
+
+/* logs the percentiles of every phase of the control loop, of the stops and of every evaluated or handled rule */
+static void logProfiles(void)
+{
+    CycleProfile* profiles[] = {cycleProfile, stopProfile, requestedStopProfile, ruleProfile};
+    for (int i = 0; i < sizeof(profiles) / sizeof(*profiles); i++)
+    {
+        if (profiles[i] != NULL)
+        {
+            logCycleProfile(profiles[i], "protection");
+        }
+    }
+}
+
+/* returns a JSON array with the percentiles of every histogram of the given profiles with recorded durations in us */
+static JSON* profileToJSON(CycleProfile* const* profiles, unsigned int profileCount, LatencyHistogram* copy)
+{
+    JSON* histograms = JSONCreateArray();
+    for (int j = 0; j < profileCount; j++)
+    {
+        CycleProfile* profile = profiles[j];
+        for (int i = 0; profile != NULL && i < profile->count; i++)
+        {
+            readProfileHistogram(profile, i, copy);
+            if (copy->count == 0)
+            {
+                continue;
+            }
+            JSON* histogram = JSONCreateObject();
+            JSONAddStringToObject(histogram, "Name", profile->names[i]);
+            JSONAddNumberToObject(histogram, "Count", copy->count);
+            JSONAddNumberToObject(histogram, "Mean", copy->sum / 1e3 / copy->count);
+            JSONAddNumberToObject(histogram, "P50", getLatencyPercentile(copy, 50) / 1e3);
+            JSONAddNumberToObject(histogram, "P90", getLatencyPercentile(copy, 90) / 1e3);
+            JSONAddNumberToObject(histogram, "P99", getLatencyPercentile(copy, 99) / 1e3);
+            JSONAddNumberToObject(histogram, "P99.9", getLatencyPercentile(copy, 99.9) / 1e3);
+            JSONAddNumberToObject(histogram, "Max", copy->max / 1e3);
+            JSONAddItemToArray(histograms, histogram);
+        }
+    }
+    return histograms;
+}
+
+/*
+ *  answers a profile request with the percentiles of the phases and rules in us:
+ *  {"Phases":[{"Name":"sensor read","Count":..,"Mean":..,"P50":..,"P90":..,"P99":..,"P99.9":..,"Max":..},...],
+ *   "Stops":[{"Name":"stop latency",...},{"Name":"requested stop latency",...}],"Rules":[...]}
+ *  the histograms are reset afterwards if the request contains "reset"
+ */
+static void sendProfiles(IPCSocketConnection* ipcsc, const Message* request)
+{
+    LatencyHistogram* copy = malloc(sizeof(*copy));
+    if (copy == NULL)
+    {
+        log_error("profile: malloc error %s", strerror(errno));
+        return;
+    }
+    JSON* profileJSON = JSONCreateObject();
+    JSONAddItemToObject(profileJSON, "Phases", profileToJSON(&cycleProfile, 1, copy));
+    JSONAddItemToObject(profileJSON, "Stops", profileToJSON((CycleProfile* const[]){stopProfile, requestedStopProfile}, 2, copy));
+    JSONAddItemToObject(profileJSON, "Rules", profileToJSON(&ruleProfile, 1, copy));
+    char* profile = JSONPrint(profileJSON);
+    sendMessageIPC(ipcsc, IPCMSGTYPE_PROTECTIONPROFILE, profile, strlen(profile));
+    JSONDelete(profileJSON);
+    free(profile);
+    free(copy);
+
+    if (request->length >= 5 && !strncmp(request->content, "reset", 5))
+    {
+        CycleProfile* profiles[] = {cycleProfile, stopProfile, requestedStopProfile, ruleProfile};
+        for (int i = 0; i < sizeof(profiles) / sizeof(*profiles); i++)
+        {
+            if (profiles[i] != NULL)
+            {
+                requestCycleProfileReset(profiles[i]);
+            }
+        }
+    }
+}
+
+static void destroySensorDataFrames(void)
+{
+    for (int i = 0; i < sensorCount * 2 && sensorDataFrames.packets != NULL; i++)
+    {
+        free(sensorDataFrames.packets[i]);
+    }
+    free(sensorDataFrames.packets);
+    free(sensorDataFrames.packetLengths);
+    free(sensorDataFrames.buffer);
+    sensorDataFrames = (SensorDataFrames){NULL, NULL, NULL};
+}
+
+/*
+ *  moves the values of the sensors and actuators into the process image and serializes the packets of every
+ *  possible sensor value once, has to be done before the protection rules are bound to the values
+ *  returns 1 on error
+ */
+static int prepareProcessImage(void)
+{
+    processImage = createProcessImage(sensors, sensorCount, incomingActuators, actuatorCount);
+    pthread_mutex_lock(&mutexStop);
+    stopFrame = createSPIStopFrame(incomingActuators, actuatorCount);
+    spiFrame = bulkSPI ? createSPIFrame(sensors, sensorCount, incomingActuators, actuatorCount) : NULL;
+    if (stopFrame == NULL || (bulkSPI && spiFrame == NULL))
+    {
+        destroySPIFrame(spiFrame);
+        destroySPIFrame(stopFrame);
+        spiFrame = NULL;
+        stopFrame = NULL;
+    }
+    pthread_mutex_unlock(&mutexStop);
+    if (stopFrame == NULL)
+    {
+        log_error("initialization: the SPI frames could not be created");
+        return 1;
+    }
+    sensorDataFrames.packets = calloc(sensorCount * 2 + 1, sizeof(*sensorDataFrames.packets));
+    sensorDataFrames.packetLengths = calloc(sensorCount * 2 + 1, sizeof(*sensorDataFrames.packetLengths));
+    if (processImage == NULL || sensorDataFrames.packets == NULL || sensorDataFrames.packetLengths == NULL)
+    {
+        log_error("initialization: the process image could not be created");
+        return 1;
+    }
+
+    /* every sensor is sent at most once per message, so its longest packet and a comma are reserved */
+    unsigned int capacity = sizeof(sensorDataPrefix) + 2;
+    for (int i = 0; i < sensorCount; i++)
+    {
+        unsigned int longestPacket = 0;
+        for (char value = 0; value < 2; value++)
+        {
+            char* packet = serializeSensorDataPacket((SensorDataPacket){sensors[i].sensorID, sensors[i].type, &value});
+            sensorDataFrames.packets[i * 2 + value] = packet;
+            sensorDataFrames.packetLengths[i * 2 + value] = packet == NULL ? 0 : strlen(packet);
+            if (sensorDataFrames.packetLengths[i * 2 + value] > longestPacket)
+            {
+                longestPacket = sensorDataFrames.packetLengths[i * 2 + value];
+            }
+        }
+        capacity += longestPacket + 1;
+    }
+    sensorDataFrames.buffer = malloc(capacity);
+    if (sensorDataFrames.buffer == NULL)
+    {
+        log_error("initialization: malloc error %s", strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/* copies the actuators once their values have been moved into the process image, returns 1 on error */
+static int prepareActuators(void)
+{
+    actuators = malloc(sizeof(*actuators)*(actuatorCount+1));
+    if (actuators == NULL)
+    {
+        log_error("initialization: malloc error %s", strerror(errno));
+        return 1;
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        actuators[i] = incomingActuators[i];
+    }
+    return 0;
+}
+
+/*
+ *  destroys everything created by an initialization, the process image is destroyed against the sensors and
+ *  actuators it has been created from before they are freed. The control loop has to be paused and the caller
+ *  has to hold the mutex of the fault monitor.
+ */
+static void destroyExperiment(void)
+{
+    destroyDelayBasedFaults();
+    destroyCycleProfile(ruleProfile);
+    ruleProfile = NULL;
+    destroyProtectionRules();
+    destroySensorDataFrames();
+    pthread_mutex_lock(&mutexStop);
+    stoppedPS = 1;
+    destroySPIFrame(spiFrame);
+    destroySPIFrame(stopFrame);
+    spiFrame = NULL;
+    stopFrame = NULL;
+    pthread_mutex_unlock(&mutexStop);
+    destroyProcessImage(processImage, sensors, incomingActuators);
+    destroySensors(sensors, sensors == NULL ? 0 : sensorCount);
+    destroyActuators(incomingActuators, incomingActuators == NULL ? 0 : actuatorCount);
+    free(actuators);
+    processImage = NULL;
+    sensors = NULL;
+    incomingActuators = NULL;
+    actuators = NULL;
+    sensorCount = 0;
+    actuatorCount = 0;
+}
+
+/*
+ *  reads all sensors and writes the actuators staged in the last cycle with one transfer, unless the physical
+ *  system has been stopped since
+ */
+static void transferSPIFrameUnlessStopped(void)
+{
+    pthread_mutex_lock(&mutexStop);
+    if (stoppedPS)
+    {
+        clearSPIFrameWrites(spiFrame);
+    }
+    else
+    {
+        transferSPIFrame(spiFrame, &mutexSPI);
+    }
+    pthread_mutex_unlock(&mutexStop);
+}
+
+/*
+ *  writes the actuators changed since the last cycle, unless the physical system has been stopped. The first write
+ *  after a start includes every actuator. With bulkSPI the writes are staged into the frame of the next cycle,
+ *  otherwise every actuator is written with its own transfer.
+ */
+static void writeChangedActuators(void)
+{
+    pthread_mutex_lock(&mutexStop);
+    commitActuatorChanges(processImage);
+    if (!stoppedPS)
+    {
+        unsigned int count = restageActuators ? actuatorCount : processImage->changedActuatorCount;
+        for (int i = 0; i < count; i++)
+        {
+            Actuator* actuator = &actuators[restageActuators ? i : processImage->changedActuators[i]];
+            if (spiFrame != NULL)
+            {
+                stageSPIFrameWrite(spiFrame, actuator);
+            }
+            else
+            {
+                SPIWriteActuator(actuator, &mutexSPI);
+            }
+        }
+        restageActuators = 0;
+    }
+    pthread_mutex_unlock(&mutexStop);
+}
+
+/* sends the sensors changed at the last commit of the process image to the Communication Service */
+static void sendChangedSensors(void)
+{
+    unsigned int length = sizeof(sensorDataPrefix) - 1;
+    unsigned int packetCount = 0;
+    memcpy(sensorDataFrames.buffer, sensorDataPrefix, length);
+    for (int i = 0; i < processImage->changedSensorCount; i++)
+    {
+        unsigned int sensor = processImage->changedSensors[i];
+        unsigned int packet = sensor * 2 + (sensors[sensor].value[0] != 0);
+        if (sensorDataFrames.packets[packet] == NULL)
+        {
+            continue;
+        }
+        if (packetCount++ > 0)
+        {
+            sensorDataFrames.buffer[length++] = ',';
+        }
+        memcpy(sensorDataFrames.buffer + length, sensorDataFrames.packets[packet], sensorDataFrames.packetLengths[packet]);
+        length += sensorDataFrames.packetLengths[packet];
+    }
+    sensorDataFrames.buffer[length++] = ']';
+    sensorDataFrames.buffer[length++] = '}';
+    if (packetCount > 0)
+    {
+        sendMessageIPC(communicationService, IPCMSGTYPE_SENSORDATA, sensorDataFrames.buffer, length);
+    }
+}
+
+/*
+ *  the report thread, logs the cycle statistics and the stop latencies of the control loop every reportInterval
+ *  seconds and resets them. The control loop only records them, they are copied and formatted here.
+ *  arg -   the CycleTimer of the control loop
+ */
+static void* reportControlLoop(void* arg)
+{
+    CycleTimer* cycleTimer = arg;
+    while (1)
+    {
+        sleep(reportInterval);
+        logCycleStatistics(cycleTimer, "protection");
+        requestCycleStatisticsReset(cycleTimer);
+        logCycleProfile(stopProfile, "protection");
+        logCycleProfile(requestedStopProfile, "protection");
+        requestCycleProfileReset(stopProfile);
+        /* the requested stops are rare, so the reset is applied right away instead of by the next stop */
+        pthread_mutex_lock(&mutexRequestedStops);
+        requestCycleProfileReset(requestedStopProfile);
+        commitCycleProfile(requestedStopProfile);
+        pthread_mutex_unlock(&mutexRequestedStops);
+    }
+    return NULL;
+}
+
+/* marks the service as initialized and wakes up the control loop */
+static void setInitialized(void)
+{
+    pthread_mutex_lock(&mutexInitialized);
+    initialized = 1;
+    pthread_cond_signal(&initializedCondition);
+    pthread_mutex_unlock(&mutexInitialized);
+}
+
+/* requests a pause of the control loop and waits until it has finished its current cycle */
+static void pauseControlLoop(void)
+{
+    pthread_mutex_lock(&controlLoopPause.mutex);
+    atomic_store(&controlLoopPause.requested, 1);
+    while (controlLoopPause.running && !controlLoopPause.paused)
+    {
+        pthread_cond_wait(&controlLoopPause.changed, &controlLoopPause.mutex);
+    }
+    pthread_mutex_unlock(&controlLoopPause.mutex);
+}
+
+static void resumeControlLoop(void)
+{
+    pthread_mutex_lock(&controlLoopPause.mutex);
+    atomic_store(&controlLoopPause.requested, 0);
+    pthread_cond_broadcast(&controlLoopPause.changed);
+    pthread_mutex_unlock(&controlLoopPause.mutex);
+}
+
+/* called by the control loop at the start of a cycle if a pause has been requested, blocks until it is resumed */
+static void waitWhileControlLoopPaused(void)
+{
+    pthread_mutex_lock(&controlLoopPause.mutex);
+    controlLoopPause.paused = 1;
+    pthread_cond_broadcast(&controlLoopPause.changed);
+    while (atomic_load(&controlLoopPause.requested))
     {
-        printProtectionRule(Protectionrules.rules[i]);  //TODO add debugging flag
+        pthread_cond_wait(&controlLoopPause.changed, &controlLoopPause.mutex);
     }
-
-    return 0;
+    controlLoopPause.paused = 0;
+    pthread_mutex_unlock(&controlLoopPause.mutex);
 }
 
-/* used to start the physical system */
-static void startPhysicalSystem(void)
+/*
+ *  pauses the control loop and the fault monitor and destroys the current experiment, a running physical system
+ *  is stopped first. Nothing of the old experiment is used until endReinitialization.
+ */
+static void beginReinitialization(void)
 {
-    log_info("physical system started");
-    //TODO maybe add check for protectionrules
-    stoppedPS = 0;
+    pauseControlLoop();
+    pthread_mutex_lock(&faultMonitor.mutex);
+    if (!stoppedPS)
+    {
+        stopPhysicalSystemOnRequest();
+    }
+    destroyExperiment();
 }
 
-/* used to stop the physical system */
-static void stopPhysicalSystem(void)
+/*
+ *  resumes the fault monitor and, if the new experiment has been initialized, the control loop, which stays
+ *  paused after a failed initialization
+ *  success -   whether the new experiment has been initialized
+ */
+static void endReinitialization(unsigned int success)
 {
-    log_info("physical system stopped");
-    stoppedPS = 1;
-    for (int i = 0; i < actuatorCount; i++)
+    pthread_mutex_unlock(&faultMonitor.mutex);
+    if (success)
     {
-        memcpy(actuators[i].value, actuators[i].stopValue, getValueSizeOfActuatorType(actuators[i].type));
-        SPIWriteActuator(&actuators[i], &mutexSPI);
+        setInitialized();
+        resumeControlLoop();
     }
 }
 
 /*
- *  the handler for DelayBasedFaults, it checks periodically for 10 seconds if the fault has resolved 
- *  and stops if so. If the fault has not been resolved after 10 seconds an error message will be send
- *  to the Communication Service
- *  fault   -   the DelayBasedFault to be handled 
+ *  creates the sensors, actuators and Protectionrules of the JSON-formatted initialization message of the
+ *  Communication Service, returns 1 on error
  */
-static void handleDelayBasedFault(DelayBasedFault* fault)
+static int initializeExperiment(const char* content)
 {
-    for (int i = 0; i < 100; i++)
+    log_debug("initialization: parsing message content to json");
+    JSON* msgJSON = JSONParse(content);
+    if (msgJSON == NULL)
+    {
+        log_error("initialization: IPC message could not be parsed to JSON");
+        return 1;
+    }
+    log_debug("initialization: converting sensors, actuators and protection json to strings");
+    JSON* sensorsJSON = JSONGetObjectItem(msgJSON, "Sensors");
+    JSON* actuatorsJSON = JSONGetObjectItem(msgJSON, "Actuators");
+    JSON* protectionRulesJSON = JSONGetObjectItem(msgJSON, "ProtectionRules");
+    char* stringSensors = sensorsJSON == NULL ? NULL : JSONPrint(sensorsJSON);
+    char* stringActuators = actuatorsJSON == NULL ? NULL : JSONPrint(actuatorsJSON);
+    char* stringProtectionRules = protectionRulesJSON == NULL ? NULL : JSONPrint(protectionRulesJSON);
+    JSONDelete(msgJSON);
+    if (stringSensors == NULL || stringActuators == NULL || stringProtectionRules == NULL)
+    {
+        log_error("initialization: sensors, actuators or protection not included in message json");
+        free(stringSensors);
+        free(stringActuators);
+        free(stringProtectionRules);
+        return 1;
+    }
+
+    /* identifies the experiment for plugins compiled by goldi-compile */
+    char* sections[] = {stringSensors, stringActuators, stringProtectionRules};
+    unsigned long long experimentHash = hashExperimentSections(sections, 3);
+
+    log_debug("initialization: parsing sensors and actuators");
+    sensors = parseSensors(stringSensors, strlen(stringSensors), &sensorCount);
+    incomingActuators = sensors == NULL ? NULL : parseActuators(stringActuators, strlen(stringActuators), &actuatorCount, sensorCount);
+    free(stringSensors);
+    free(stringActuators);
+    int result = 1;
+    if (sensors == NULL)
+    {
+        log_error("initialization: sensors could not be parsed successfully");
+    }
+    else if (incomingActuators == NULL)
     {
-        usleep(100);
-        if (!evaluateBooleanExpression(fault->rule->expression))
+        log_error("initialization: actuators could not be parsed successfully");
+    }
+    else if (!prepareProcessImage() && !prepareActuators())
+    {
+        for (int i = 0; i < sensorCount; i++)
         {
-            log_debug("delay based fault resolved");
-            fault->isActive = 0;
-            return;
+            printSensorData(sensors[i]);  //TODO add debugging flag
+        }
+        for (int i = 0; i < actuatorCount; i++)
+        {
+            printActuatorData(actuators[i]);  //TODO add debugging flag
+        }
+
+        log_debug("initialization: parsing protection");
+        result = parseProtectionRules(stringProtectionRules, experimentHash);
+        if (result)
+        {
+            log_error("initialization: protection could not be parsed successfully");
         }
     }
-    log_error("delay based error occured, sending message");
-    fault->isActive = 0;
-    JSON* delayBasedErrorJSON = JSONCreateObject();
-    JSONAddNumberToObject(delayBasedErrorJSON, "ErrorCode", fault->rule->errorCode);
-    char* delayBasedError = JSONPrint(delayBasedErrorJSON);
-    sendMessageIPC(communicationService, IPCMSGTYPE_DELAYBASEDERROR, delayBasedError, strlen(delayBasedError));
+    free(stringProtectionRules);
+    return result;
+}
 
-    JSONDelete(delayBasedErrorJSON);
-    free(delayBasedError);
+/*
+ *  creates the sensors, actuators and Protectionrules of an image written by goldi-image, nothing has to be
+ *  parsed, returns 1 on error
+ *  path    -   the path of the image
+ */
+static int initializeExperimentImage(const char* path)
+{
+    ExperimentImage* image = openExperimentImage(path);
+    sensors = image == NULL ? NULL : createImageSensors(image, &sensorCount);
+    incomingActuators = sensors == NULL ? NULL : createImageActuators(image, &actuatorCount);
+    if (incomingActuators == NULL || prepareProcessImage() || prepareActuators())
+    {
+        log_error("initialization: sensors and actuators of the image could not be created");
+        closeExperimentImage(image);
+        return 1;
+    }
+
+    int result = loadProtectionRules(image);
+    if (result)
+    {
+        log_error("initialization: protection could not be loaded from the image");
+    }
+    /* everything has been copied out of the image, so it can be replaced by an update while running */
+    closeExperimentImage(image);
+    return result;
 }
 
 /*
@@ -253,7 +1533,12 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
 {
     while(ipcsc->open)
     {
-        if(hasMessages(ipcsc))
+        if (profileDumpRequested)
+        {
+            profileDumpRequested = 0;
+            logProfiles();
+        }
+        if(waitForMessages(ipcsc, IPC_WAIT_TIMEOUT))
         {
             log_debug("receiving IPC message");
             Message msg = receiveMessageIPC(ipcsc);
@@ -261,133 +1546,24 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
             switch (msg.type)
             {
                 case IPCMSGTYPE_INITPROTECTIONSERVICE:
+                case IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE:
                 {
-                    log_debug("initialization: starting initialization");
-                    log_debug("initialization: parsing message content to json");
-                    JSON* msgJSON = JSONParse(msg.content);
-                    if (msgJSON == NULL)
-                    {
-                        log_error("initialization: IPC message could not be parsed to JSON");
-                        break;
-                    }
-                    log_debug("initialization: parsing sensors as json from message json");
-                    JSON* sensorsJSON = JSONGetObjectItem(msgJSON, "Sensors");
-                    if (sensorsJSON == NULL)
-                    {
-                        log_error("initialization: sensors not included in message json");
-                        break;
-                    }
-                    log_debug("initialization: parsing actuators as json from message json");
-                    JSON* actuatorsJSON = JSONGetObjectItem(msgJSON, "Actuators");
-                    if (actuatorsJSON == NULL)
-                    {
-                        log_error("initialization: actuators not included in message json");
-                        break;
-                    }
-                    log_debug("initialization: parsing protection as json from message json");
-                    JSON* protectionRulesJSON = JSONGetObjectItem(msgJSON, "ProtectionRules");
-                    if (protectionRulesJSON == NULL)
-                    {
-                        log_error("initialization: protection not included in message json");
-                        break;
-                    }
-                    log_debug("initialization: converting sensors json to string");
-                    char* stringSensors = JSONPrint(sensorsJSON);
-                    if (stringSensors == NULL)
-                    {
-                        log_error("initialization: sensors json could not be parsed to string");
-                        break;
-                    }
-                    log_debug("initialization: converting actuators json to string");
-                    char* stringActuators = JSONPrint(actuatorsJSON);
-                    if (stringActuators == NULL)
-                    {
-                        log_error("initialization: actuators json could not be parsed to string");
-                        break;
-                    }
-                    log_debug("initialization: converting protection json to string");
-                    char* stringProtectionRules = JSONPrint(protectionRulesJSON);
-                    if (stringProtectionRules == NULL)
-                    {
-                        log_error("initialization: protection json could not be parsed to string");
-                        break;
-                    }
-
-                    JSONDelete(msgJSON);
-
-                    log_debug("initialization: parsing sensors");
-                    sensors = parseSensors(stringSensors, strlen(stringSensors), &sensorCount);
-                    free(stringSensors);
-                    if (sensors == NULL)
-                    {
-                        log_error("initialization: sensors could not be parsed successfully");
-                        char* result = serializeInt(0);
-                        sendMessageIPC(communicationService, IPCMSGTYPE_INITPROTECTIONFINISHED, result, 4);
-                        free(result);
-                        break;
-                    }
-                    else
-                    {
-                        for (int i = 0; i < sensorCount; i++)
-                        {
-                            printSensorData(sensors[i]);  //TODO add debugging flag
-                        }
-                    }
-
-                    log_debug("initialization: parsing actuators");
-                    incomingActuators = parseActuators(stringActuators, strlen(stringActuators), &actuatorCount, sensorCount);
-                    if (incomingActuators == NULL)
-                    {
-                        log_error("initialization: actuators could not be parsed successfully");
-                        char* result = serializeInt(0);
-                        sendMessageIPC(communicationService, IPCMSGTYPE_INITPROTECTIONFINISHED, result, 4);
-                        free(result);
-                        free(stringActuators);
-                        break;
-                    }
-                    actuators = malloc(sizeof(*actuators)*actuatorCount);
-                    for (int i = 0; i < actuatorCount; i++)
-                    {
-                        actuators[i] = incomingActuators[i];
-                        printActuatorData(actuators[i]);  //TODO add debugging flag
-                    }
-
-                    log_debug("initialization: parsing protection");
-                    if (parseProtectionRules(stringProtectionRules))
-                    {
-                        log_error("initialization: protection could not be parsed successfully");
-                        char* result = serializeInt(0);
-                        sendMessageIPC(communicationService, IPCMSGTYPE_INITPROTECTIONFINISHED, result, 4);
-                        free(result);
-                        free(stringProtectionRules);
-                        break;
-                    }
-                    free(stringProtectionRules);
-                    delayBasedFaults.maxCount = 0;
-                    for (int i = 0; i < Protectionrules.count; i++)
-                    {
-                        if (Protectionrules.rules[i].errorType == DELAY_ERROR)
-                        {
-                            delayBasedFaults.maxCount++;
-                        }
-                    }
-                    delayBasedFaults.faults = malloc(sizeof(*delayBasedFaults.faults)*delayBasedFaults.maxCount);
-                    unsigned int currentFaultIndex = 0;
-                    for (int i = 0; i < Protectionrules.count; i++)
+                    /* the message of an image only contains the path of an image written by goldi-image */
+                    log_debug("initialization: starting initialization%s%s", msg.type == IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE ?
+                              " from experiment image " : "", msg.type == IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE ? msg.content : "");
+                    beginReinitialization();
+                    int failed = msg.type == IPCMSGTYPE_INITPROTECTIONSERVICE ? initializeExperiment(msg.content) : initializeExperimentImage(msg.content);
+                    if (!failed)
                     {
-                        if (Protectionrules.rules[i].errorType == DELAY_ERROR)
-                        {
-                            delayBasedFaults.faults[currentFaultIndex].isActive = 0;
-                            delayBasedFaults.faults[currentFaultIndex].rule = &Protectionrules.rules[i];
-                            currentFaultIndex++;
-                        }
+                        prepareDelayBasedFaults();
+                        prepareRuleProfile();
                     }
 
                     log_debug("initialization: sending result to Communication Service");
-                    char* result = serializeInt(1);
+                    char* result = serializeInt(!failed);
                     sendMessageIPC(communicationService, IPCMSGTYPE_INITPROTECTIONFINISHED, result, 4);
                     free(result);
-                    initialized = 1;
+                    endReinitialization(!failed);
 
                     break;
                 }
@@ -400,17 +1576,23 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                     unsigned int userVariable = JSONGetObjectItem(msgJSON, "Variable")->valueint;   //the index of the virtual sensor (looking only at the virtual sensors)
                     long long value = JSONGetObjectItem(msgJSON, "State")->valueint;                //the new value of the virtual sensor
                     unsigned int virtualIndex = 0;                                                  //keeps track of the number of virtual sensors we have already seen
-                    for (int i = 0; i < sensorCount; i++)
+                    /* the value is handed to the control loop like the actuator values, it is adopted at the start of a cycle */
+                    char* update = processImage == NULL ? NULL : beginActuatorUpdate(processImage);
+                    for (int i = 0; i < sensorCount && update != NULL; i++)
                     {
                         if (sensors[i].isVirtual && virtualIndex == userVariable)
                         {
-                            sensors[i].value = value;
+                            getSensorUpdateValue(processImage, update, i)[0] = value;
                         }
                         else if (sensors[i].isVirtual)
                         {
                             virtualIndex++;
                         }
                     }
+                    if (update != NULL)
+                    {
+                        publishActuatorUpdate(processImage);
+                    }
                     JSONDelete(msgJSON);
                     break;
                 }
@@ -426,11 +1608,36 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                     }
                     else
                     {
-                        for (int i = 0; i < newActuatorDataCount; i++)
+                        /*
+                         * all actuators of a message are published at once, the control loop never sees a part of them.
+                         * A stop of the control loop waits for the update, so nothing may log or free until it is published.
+                         */
+                        char* update = processImage == NULL ? NULL : beginActuatorUpdate(processImage);
+                        for (int i = 0; i < newActuatorDataCount && update != NULL; i++)
                         {
                             Actuator* actuator = getActuatorWithID(incomingActuators, actuatorDataPackets[i].actuatorID, actuatorCount);
-                            log_debug("actuator value: %lld -> %lld", actuator->value, actuatorDataPackets[i].value);
-                            actuator->value = actuatorDataPackets[i].value;
+                            if (actuator != NULL)
+                            {
+                                memcpy(getActuatorUpdateValue(processImage, update, actuator - incomingActuators), actuatorDataPackets[i].value,
+                                       getValueSizeOfActuatorType(actuator->type));
+                            }
+                        }
+                        if (update != NULL)
+                        {
+                            publishActuatorUpdate(processImage);
+                        }
+                        else
+                        {
+                            log_error("received actuator data without an initialized experiment");
+                        }
+                        for (int i = 0; i < newActuatorDataCount; i++)
+                        {
+                            if (update != NULL && getActuatorWithID(incomingActuators, actuatorDataPackets[i].actuatorID, actuatorCount) == NULL)
+                            {
+                                log_error("received data of the unknown actuator %s", actuatorDataPackets[i].actuatorID);
+                            }
+                            log_debug("actuator value: %s -> %d", actuatorDataPackets[i].actuatorID, actuatorDataPackets[i].value[0]);
+                            free(actuatorDataPackets[i].value);
                             free(actuatorDataPackets[i].actuatorID);
                         }
                     }
@@ -448,7 +1655,7 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                 case IPCMSGTYPE_STOPPHYSICALSYSTEM:
                 {
                     log_debug("received stop signal for physical system");
-                    stopPhysicalSystem();
+                    stopPhysicalSystemOnRequest();
                     break;
                 }
 
@@ -478,6 +1685,12 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
                     break;
                 }
 
+                case IPCMSGTYPE_PROTECTIONPROFILE:
+                {
+                    sendProfiles(ipcsc, &msg);
+                    break;
+                }
+
                 case IPCMSGTYPE_INTERRUPTED:
                 {
                     ipcsc->open = 0;
@@ -508,8 +1721,220 @@ static int messageHandlerIPC(IPCSocketConnection* ipcsc)
     return 0;
 }
 
+/* prints the available command line options */
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -e, --rule-engine <engine>  engine used to evaluate the protection rules:\n");
+    printf("                                bitparallel (default), incremental, dag, bytecode, bdd\n");
+    printf("                                replaced by a plugin compiled from the experiment if there is one\n");
+    printf("    -p, --plugin-dir <dir>      directory searched for compiled experiments (default: %s)\n", EXPERIMENT_PLUGIN_DIRECTORY);
+    printf("    -i, --interpreter           never use a compiled experiment\n");
+    printf("    -c, --cycle-period <us>     period of the control loop (default: %d)\n", PROTECTION_CYCLE_PERIOD);
+    printf("    -r, --report-interval <s>   interval of the cycle time reports, 0 for none (default: %d)\n", PROTECTION_REPORT_INTERVAL);
+    printf("    -a, --check-allocations     abort if the control loop allocates memory without a triggered rule\n");
+    printf("    -b, --bulk-spi              read all sensors and write the changed actuators in one SPI transfer per cycle,\n");
+    printf("                                the FPGA has to accept several commands per chip select\n");
+    printf("    -s, --simulate              use the software FPGA instead of the SPI interface\n");
+    printf("    -t, --simulate-latency <ns> time every transfer of the software FPGA takes (default: 0)\n");
+    printf("    -l, --simulate-loopback <output:input,...>\n");
+    printf("                                connects output pins of the software FPGA to input pins\n");
+    printf("    -R, --realtime <priority>   run the control loop with SCHED_FIFO at the given priority (1-99) on its own core,\n");
+    printf("                                with locked and prefaulted memory\n");
+    printf("    -C, --cpu <core>            core of the control loop in the real-time mode (default: the last one)\n");
+    printf("    -P, --profile-rules         measure the evaluation time of every rule (bytecode and dag engines only),\n");
+    printf("                                the phases of the control loop and the handling of the rules are always measured\n");
+    printf("                                and logged on SIGUSR2\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+/* parses the command line options, returns 1 if the service should not be started */
+static int parseOptions(int argc, char* const argv[])
+{
+    static const struct option options[] = 
+    {
+        {"rule-engine",       required_argument, NULL, 'e'},
+        {"plugin-dir",        required_argument, NULL, 'p'},
+        {"interpreter",       no_argument,       NULL, 'i'},
+        {"cycle-period",      required_argument, NULL, 'c'},
+        {"report-interval",   required_argument, NULL, 'r'},
+        {"check-allocations", no_argument,       NULL, 'a'},
+        {"bulk-spi",          no_argument,       NULL, 'b'},
+        {"simulate",          no_argument,       NULL, 's'},
+        {"simulate-latency",  required_argument, NULL, 't'},
+        {"simulate-loopback", required_argument, NULL, 'l'},
+        {"realtime",          required_argument, NULL, 'R'},
+        {"cpu",               required_argument, NULL, 'C'},
+        {"profile-rules",     no_argument,       NULL, 'P'},
+        {"help",              no_argument,       NULL, 'h'},
+        {NULL,                0,                 NULL, 0}
+    };
+
+    Protectionrules.engineType = RULE_ENGINE_BITPARALLEL;
+    int option;
+    while ((option = getopt_long(argc, argv, "e:p:ic:r:abst:l:R:C:Ph", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'e':
+            {
+                if (!strcmp(optarg, "bitparallel"))
+                {
+                    Protectionrules.engineType = RULE_ENGINE_BITPARALLEL;
+                }
+                else if (!strcmp(optarg, "incremental"))
+                {
+                    Protectionrules.engineType = RULE_ENGINE_INCREMENTAL;
+                }
+                else if (!strcmp(optarg, "dag"))
+                {
+                    Protectionrules.engineType = RULE_ENGINE_DAG;
+                }
+                else if (!strcmp(optarg, "bytecode"))
+                {
+                    Protectionrules.engineType = RULE_ENGINE_BYTECODE;
+                }
+                else if (!strcmp(optarg, "bdd"))
+                {
+                    Protectionrules.engineType = RULE_ENGINE_BDD;
+                }
+                else
+                {
+                    log_error("unknown rule engine: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'p':
+            {
+                pluginDirectory = optarg;
+                break;
+            }
+
+            case 'i':
+            {
+                pluginDirectory = NULL;
+                break;
+            }
+
+            case 'c':
+            {
+                char* end;
+                cyclePeriod = strtoull(optarg, &end, 10);
+                if (*end != 0 || cyclePeriod == 0)
+                {
+                    log_error("invalid cycle period: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'a':
+            {
+                checkAllocations = 1;
+                break;
+            }
+
+            case 'b':
+            {
+                bulkSPI = 1;
+                break;
+            }
+
+            case 's':
+            {
+                setSPIBackend(&softwareFPGABackend);
+                break;
+            }
+
+            case 't':
+            {
+                char* end;
+                softwareFPGA.transferLatency = strtoull(optarg, &end, 10);
+                if (*end != 0)
+                {
+                    log_error("invalid latency: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'l':
+            {
+                if (parseSoftwareFPGALoopback(optarg))
+                {
+                    return 1;
+                }
+                break;
+            }
+
+            case 'P':
+            {
+                profileRules = 1;
+                break;
+            }
+
+            case 'R':
+            {
+                char* end;
+                realTime.priority = strtol(optarg, &end, 10);
+                if (*end != 0 || realTime.priority < 1 || realTime.priority > 99)
+                {
+                    log_error("invalid real-time priority: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'C':
+            {
+                char* end;
+                realTime.cpu = strtol(optarg, &end, 10);
+                if (*end != 0 || realTime.cpu < 0 || realTime.cpu > getLastCPU())
+                {
+                    log_error("invalid core: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'r':
+            {
+                char* end;
+                reportInterval = strtoull(optarg, &end, 10);
+                if (*end != 0)
+                {
+                    log_error("invalid report interval: %s", optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            default:
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char const *argv[])
 {
+    if (parseOptions(argc, (char* const*)argv))
+    {
+        return -1;
+    }
+    Protectionrules.selectedType = Protectionrules.engineType;
+
+    /* cJSON is a shared library, its allocations are only counted if it allocates through the counter */
+    if (checkAllocations)
+    {
+        countJSONAllocations();
+    }
+
     /* initialize the mutex and all needed sockets */
     pthread_mutex_init(&mutexSPI, NULL);
 
@@ -519,6 +1944,15 @@ int main(int argc, char const *argv[])
         return -1;
     }
 
+    signal(SIGUSR2, sigusr2_handler);
+
+    /* written by the message handler, so it has to exist before the first message */
+    requestedStopProfile = createCycleProfile((const char* const[]){"requested stop latency"}, 1);
+    if (requestedStopProfile == NULL)
+    {
+        return -1;
+    }
+
     int fd = createIPCSocket(PROTECTION_SERVICE);
     communicationService = acceptIPCConnection(fd, messageHandlerIPC);
     if (communicationService == NULL)
@@ -527,70 +1961,110 @@ int main(int argc, char const *argv[])
         return -1;
     }
 
-    while(!initialized);
+    pthread_mutex_lock(&mutexInitialized);
+    while (!initialized)
+    {
+        pthread_cond_wait(&initializedCondition, &mutexInitialized);
+    }
+    pthread_mutex_unlock(&mutexInitialized);
+
+    /* from now on a reinitialization waits for the control loop to pause at the start of a cycle */
+    pthread_mutex_lock(&controlLoopPause.mutex);
+    controlLoopPause.running = 1;
+    pthread_mutex_unlock(&controlLoopPause.mutex);
+
+    if (startDelayBasedFaultMonitor())
+    {
+        return -1;
+    }
+
+    /* the loop runs at a fixed period, the IPC messages are handled by the message handler in between */
+    CycleTimer* cycleTimer = createCycleTimer(cyclePeriod * 1000);
+    cycleProfile = createCycleProfile(cyclePhaseNames, PHASE_COUNT);
+    stopProfile = createCycleProfile((const char* const[]){"stop latency"}, 1);
+    if (cycleTimer == NULL || cycleProfile == NULL || stopProfile == NULL)
+    {
+        log_error("the control loop could not be started");
+        return -1;
+    }
+    /* created before the real-time mode is entered, so it does not inherit the priority of the control loop */
+    pthread_t reportThread;
+    if (reportInterval > 0 && pthread_create(&reportThread, NULL, &reportControlLoop, cycleTimer))
+    {
+        log_error("the reports of the control loop could not be started");
+        return -1;
+    }
+
+    /* only the control loop runs on its core, the IPC messages, delay based faults and reports are handled on the others */
+    if (realTime.priority > 0)
+    {
+        if (realTime.cpu < 0)
+        {
+            realTime.cpu = getLastCPU();
+        }
+        if (enterRealTimeMode(&realTime) || keepThreadOffCPU(communicationService->thread, realTime.cpu) ||
+            keepThreadOffCPU(faultMonitor.thread, realTime.cpu) || (reportInterval > 0 && keepThreadOffCPU(reportThread, realTime.cpu)))
+        {
+            log_error("the control loop could not be started in real-time");
+            return -1;
+        }
+    }
+    log_info("running the control loop every %llu us", cyclePeriod);
 
     while(1)
     {
-        //log_info("waiting for all messages to be read");
-        /* Read all IPC Messages and update CurrentActuator */
-        while (hasMessages(communicationService));
+        waitForNextCycle(cycleTimer);
+        if (atomic_load_explicit(&controlLoopPause.requested, memory_order_relaxed))
+        {
+            waitWhileControlLoopPaused();
+            /* the deadlines that passed during the pause are not missed, they are skipped and dropped with the statistics */
+            waitForNextCycle(cycleTimer);
+            requestCycleStatisticsReset(cycleTimer);
+        }
+        startProfilePhase(cycleProfile);
+        unsigned long long allocations = getThreadAllocations();
+        unsigned int triggeredRules = 0;
+        unsigned int imageChanged = 0;
 
         /* Poll the new sensor values and forward them to communication service if the value changed */
         if (!stoppedPS)
         {
-            //TODO check for NULL?
-            JSON* sensorDataMsgJSON = JSONCreateObject();
-            JSON* sensorDataJSON = JSONCreateArray();
-            for (int i = 0; i < sensorCount; i++)
+            if (spiFrame != NULL)
             {
-                unsigned int valueChanged = 0;
-                unsigned int valueSize = getValueSizeOfActuatorType(actuators[i].type);
-                char* oldValue = malloc(valueSize);
-                memcpy(oldValue, sensors[i].value, valueSize);
-
-                SPIReadSensor(&sensors[i], &mutexSPI);
-
-                for (int j = 0; j < valueSize; j++)
-                {
-                    if (oldValue[j] != sensors[i].value[j])
-                    {
-                        valueChanged = 1;
-                        break;
-                    }
-                }
-
-                if (valueChanged)
+                transferSPIFrameUnlessStopped();
+            }
+            else
+            {
+                for (int i = 0; i < sensorCount; i++)
                 {
-                    SensorDataPacket packet = (SensorDataPacket){sensors[i].sensorID, sensors[i].type, sensors[i].value};
-                    JSON* packetJSON = SensorDataPacketToJSON(packet);
-                    JSONAddItemToArray(sensorDataJSON, packetJSON);
+                    SPIReadSensor(&sensors[i], &mutexSPI);
                 }
             }
-            JSONAddItemToObject(sensorDataMsgJSON, "SensorData", sensorDataJSON);
-            if (JSONGetArraySize(sensorDataJSON) > 0)
+            endProfilePhase(cycleProfile, PHASE_SENSOR_READ);
+            imageChanged = commitSensorChanges(processImage) > 0;
+            if (imageChanged)
             {
-                char* sensorDataMsg = JSONPrint(sensorDataMsgJSON);
-                sendMessageIPC(communicationService, IPCMSGTYPE_SENSORDATA, sensorDataMsg, strlen(sensorDataMsg));
-                free(sensorDataMsg);
+                sendChangedSensors();
             }
-            JSONDelete(sensorDataMsgJSON);
+            endProfilePhase(cycleProfile, PHASE_SENSOR_SEND);
         }
 
-        for (int i = 0; i < actuatorCount; i++)
-        {
-            actuators[i] = incomingActuators[i];
-        }
+        /* the actuator and user variable values received since the last cycle, always a complete set */
+        imageChanged |= adoptActuatorUpdate(processImage);
+        endProfilePhase(cycleProfile, PHASE_ACTUATOR_ADOPT);
 
         if (!stoppedPS)
         {
             /* Check the Protection rules */
-            for (int i = 0; i < Protectionrules.count; i++)
+            triggeredRules = evaluateProtectionRules();
+            unsigned long long handlingStart = endProfilePhase(cycleProfile, PHASE_RULE_EVALUATION);
+            for (int i = 0; i < Protectionrules.count && triggeredRules > 0; i++)
             {
-                if (evaluateBooleanExpression(Protectionrules.rules[i].expression))
+                if (isProtectionRuleTriggered(i))
                 {
                     if (!stoppedPS)
                     {
-                        stopPhysicalSystem();
+                        addProfileDuration(stopProfile, 0, stopPhysicalSystem() - handlingStart);
                     }
                     switch (Protectionrules.rules[i].errorType)
                     {
@@ -601,16 +2075,7 @@ int main(int argc, char const *argv[])
                             {
                                 if (delayBasedFaults.faults[j].rule->errorCode == Protectionrules.rules[i].errorCode)
                                 {
-                                    if (delayBasedFaults.faults[j].isActive)
-                                    {
-                                        break;
-                                    }
-                                    else
-                                    {
-                                        log_debug("creating thread for monitoring delay fault");
-                                        pthread_create(&delayBasedFaults.faults[j].thread, NULL, &handleDelayBasedFault, &delayBasedFaults.faults[j]);
-                                        pthread_detach(delayBasedFaults.faults[j].thread);
-                                    }
+                                    requestDelayBasedFaultMonitoring(&delayBasedFaults.faults[j]);
                                 }
                             }
 
@@ -661,29 +2126,53 @@ int main(int argc, char const *argv[])
                             break;
                         }
                     }
+                    unsigned long long handlingEnd = getMonotonicTime();
+                    addProfileDuration(ruleProfile, Protectionrules.count + i, handlingEnd - handlingStart);
+                    handlingStart = handlingEnd;
                 }
             }
-
-            /* Send the CurrentActuator values to the FPGA */
-            for (int i = 0; i < actuatorCount; i++)
+            /* only cycles with triggered rules are counted, the others would hide them in the percentiles */
+            if (triggeredRules > 0)
             {
-                SPIWriteActuator(&actuators[i], &mutexSPI);
+                endProfilePhase(cycleProfile, PHASE_RULE_HANDLING);
             }
+
+            /* Send the changed actuator values to the FPGA, with the frame of the next cycle in bulk mode */
+            writeChangedActuators();
+            endProfilePhase(cycleProfile, PHASE_ACTUATOR_WRITE);
+            /* replaced by a reinitialization, which is only done while the control loop is paused */
+            commitCycleProfile(ruleProfile);
+        }
+        publishProcessImageSnapshot(processImage);
+        /* the monitored delay based faults may have been resolved by the changes of this cycle */
+        if (imageChanged && atomic_load_explicit(&faultMonitor.monitored, memory_order_relaxed) > 0)
+        {
+            eventfd_write(faultMonitor.event, 1);
+        }
+        endProfilePhase(cycleProfile, PHASE_SNAPSHOT);
+        endCycle(cycleTimer);
+        commitCycleProfile(cycleProfile);
+        commitCycleProfile(stopProfile);
+
+        /* only cycles that handled a triggered rule may allocate */
+        if (checkAllocations && triggeredRules == 0 && getThreadAllocations() != allocations)
+        {
+            log_fatal("the control loop allocated memory %llu times in cycle %llu", getThreadAllocations() - allocations, cycleTimer->statistics.cycles);
+            abort();
         }
     }
     
     /* cleanup */
     log_info("execution finished, cleaning up");
-    for (int i = 0; i < Protectionrules.count; i++)
-    {
-        destroyBooleanExpression(Protectionrules.rules[i].expression);
-        free(Protectionrules.rules[i].errorMessage);
-        free(Protectionrules.rules);
-    }
-    destroySensors(sensors, sensorCount);
-    destroyActuators(incomingActuators, actuatorCount);
+    destroyCycleTimer(cycleTimer);
+    destroyCycleProfile(cycleProfile);
+    destroyCycleProfile(stopProfile);
+    destroyCycleProfile(requestedStopProfile);
+    stopDelayBasedFaultMonitor();
+    pthread_mutex_lock(&faultMonitor.mutex);
+    destroyExperiment();
+    pthread_mutex_unlock(&faultMonitor.mutex);
     pthread_mutex_destroy(&mutexSPI);
-    free(actuators);
     closeSPIInterface();
     closeIPCConnection(communicationService);
     return 0;
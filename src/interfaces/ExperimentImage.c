@@ -0,0 +1,330 @@
+#include "ExperimentImage.h"
+#include "../logging/log.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/* checks that a section of records with the given size lies inside of the image and is aligned */
+static int checkImageSection(const char* name, ImageRange range, size_t recordSize, size_t imageSize)
+{
+    if (range.offset % 8 != 0 || range.offset > imageSize || (imageSize - range.offset) / recordSize < range.count)
+    {
+        log_error("ExperimentImage: the section %s lies outside of the image", name);
+        return 1;
+    }
+    return 0;
+}
+
+/* checks the header of a mapped image, returns 1 if the image was not written by a compatible goldi-image */
+static int checkExperimentImage(const ExperimentImage* image)
+{
+    const ExperimentImageHeader* header = image->header;
+    if (image->size < sizeof(*header) || memcmp(header->magic, EXPERIMENT_IMAGE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        log_error("ExperimentImage: the file is no experiment image");
+        return 1;
+    }
+    if (header->version != EXPERIMENT_IMAGE_VERSION || header->byteOrder != EXPERIMENT_IMAGE_BYTE_ORDER)
+    {
+        log_error("ExperimentImage: the image has version %u, version %u is needed", header->version, EXPERIMENT_IMAGE_VERSION);
+        return 1;
+    }
+    if (header->size != image->size)
+    {
+        log_error("ExperimentImage: the image is truncated");
+        return 1;
+    }
+    if (checkImageSection("sensors", header->sensors, sizeof(ImageSensor), image->size) ||
+        checkImageSection("actuators", header->actuators, sizeof(ImageActuator), image->size) ||
+        checkImageSection("rules", header->rules, sizeof(ImageRule), image->size) ||
+        checkImageSection("state machines", header->stateMachines, sizeof(ImageStateMachine), image->size) ||
+        checkImageSection("states", header->states, sizeof(ImageState), image->size) ||
+        checkImageSection("outputs", header->outputs, sizeof(ImageOutput), image->size) ||
+        checkImageSection("nodes", header->nodes, sizeof(ImageExpressionNode), image->size) ||
+        checkImageSection("table inputs", header->tableInputs, sizeof(uint32_t), image->size) ||
+        checkImageSection("tables", header->tables, sizeof(uint16_t), image->size) ||
+        checkImageSection("strings", header->strings, 1, image->size))
+    {
+        return 1;
+    }
+    if (header->strings.count == 0 || image->data[header->strings.offset + header->strings.count - 1] != 0)
+    {
+        log_error("ExperimentImage: the strings of the image are not terminated");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  maps the experiment image at the given path read-only and checks its header and sections
+ *  returns NULL if the image does not exist or is invalid
+ */
+ExperimentImage* openExperimentImage(const char* path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        log_error("ExperimentImage: %s could not be opened: %s", path, strerror(errno));
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(fd, &status) < 0 || status.st_size == 0)
+    {
+        log_error("ExperimentImage: %s is empty", path);
+        close(fd);
+        return NULL;
+    }
+    void* data = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        log_error("ExperimentImage: %s could not be mapped: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    ExperimentImage* image = malloc(sizeof(*image));
+    if (image == NULL)
+    {
+        log_error("ExperimentImage: malloc error %s", strerror(errno));
+        munmap(data, status.st_size);
+        return NULL;
+    }
+    *image = (ExperimentImage){data, status.st_size, data};
+    if (checkExperimentImage(image))
+    {
+        log_error("ExperimentImage: %s can not be used", path);
+        closeExperimentImage(image);
+        return NULL;
+    }
+    return image;
+}
+
+void closeExperimentImage(ExperimentImage* image)
+{
+    if (image == NULL)
+    {
+        return;
+    }
+    munmap((void*)image->data, image->size);
+    free(image);
+}
+
+/* returns the first record of a section checked by openExperimentImage */
+const void* getImageSection(const ExperimentImage* image, ImageRange range)
+{
+    return image->data + range.offset;
+}
+
+/* returns the first record of a range inside of the given section, NULL if it does not lie inside of it */
+const void* getImageRecords(const ExperimentImage* image, ImageRange section, ImageRange range, size_t recordSize)
+{
+    if (range.offset > section.count || section.count - range.offset < range.count)
+    {
+        return NULL;
+    }
+    return image->data + section.offset + range.offset * recordSize;
+}
+
+/*
+ *  returns the string (or value with the given size) at the given offset inside of the strings,
+ *  NULL if it does not lie inside of them
+ */
+const char* getImageString(const ExperimentImage* image, uint32_t offset, uint32_t size)
+{
+    const ImageRange strings = image->header->strings;
+    if (offset >= strings.count || strings.count - offset < size)
+    {
+        return NULL;
+    }
+    return image->data + strings.offset + offset;
+}
+
+/* returns a copy of a string of the image, NULL if it is invalid */
+static char* copyImageString(const ExperimentImage* image, uint32_t offset)
+{
+    const char* string = getImageString(image, offset, 0);
+    char* copy = string == NULL ? NULL : malloc(strlen(string) + 1);
+    if (copy != NULL)
+    {
+        strcpy(copy, string);
+    }
+    return copy;
+}
+
+/* returns a copy of a value of the image, NULL if it is invalid */
+static char* copyImageValue(const ExperimentImage* image, uint32_t offset, unsigned int size)
+{
+    const char* value = getImageString(image, offset, size);
+    char* copy = value == NULL ? NULL : malloc(size > 0 ? size : 1);
+    if (copy != NULL)
+    {
+        memcpy(copy, value, size);
+    }
+    return copy;
+}
+
+/* creates the sensors of the image like parseSensors, all values are 0 */
+Sensor* createImageSensors(const ExperimentImage* image, unsigned int* sensorCount)
+{
+    const ImageSensor* imageSensors = getImageSection(image, image->header->sensors);
+    *sensorCount = image->header->sensors.count;
+    Sensor* sensors = calloc(*sensorCount + 1, sizeof(*sensors));
+    if (sensors == NULL)
+    {
+        log_error("ExperimentImage: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    for (int i = 0; i < *sensorCount; i++)
+    {
+        sensors[i].sensorID = copyImageString(image, imageSensors[i].id);
+        sensors[i].type = imageSensors[i].type;
+        sensors[i].pinMapping = imageSensors[i].pinMapping;
+        sensors[i].isVirtual = imageSensors[i].isVirtual;
+        sensors[i].value = calloc(getValueSizeOfSensorType(sensors[i].type) + 1, 1);
+        if (sensors[i].sensorID == NULL || sensors[i].value == NULL)
+        {
+            log_error("ExperimentImage: sensor %d could not be created", i);
+            destroySensors(sensors, i + 1);
+            return NULL;
+        }
+    }
+    return sensors;
+}
+
+/* creates the actuators of the image like parseActuators, all values are 0 */
+Actuator* createImageActuators(const ExperimentImage* image, unsigned int* actuatorCount)
+{
+    const ImageActuator* imageActuators = getImageSection(image, image->header->actuators);
+    *actuatorCount = image->header->actuators.count;
+    Actuator* actuators = calloc(*actuatorCount + 1, sizeof(*actuators));
+    if (actuators == NULL)
+    {
+        log_error("ExperimentImage: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    for (int i = 0; i < *actuatorCount; i++)
+    {
+        unsigned int valueSize = getValueSizeOfActuatorType(imageActuators[i].type);
+        actuators[i].actuatorID = copyImageString(image, imageActuators[i].id);
+        actuators[i].type = imageActuators[i].type;
+        actuators[i].pinMapping = imageActuators[i].pinMapping;
+        actuators[i].value = calloc(valueSize + 1, 1);
+        actuators[i].stopValue = copyImageValue(image, imageActuators[i].stopValue, valueSize);
+        if (actuators[i].actuatorID == NULL || actuators[i].value == NULL || actuators[i].stopValue == NULL)
+        {
+            log_error("ExperimentImage: actuator %d could not be created", i);
+            destroyActuators(actuators, i + 1);
+            return NULL;
+        }
+    }
+    return actuators;
+}
+
+/* returns the children a node of the given type has to have, see ImageExpressionNode */
+static uint32_t getImageNodeChildren(uint32_t type)
+{
+    switch (type)
+    {
+        case BoolExprCONSTANT:
+        case BoolExprVARIABLE:
+            return 0;
+
+        case BoolExprNOT:
+            return 1;
+
+        default:
+            return 3;
+    }
+}
+
+/* creates the node at *next and all of its children, returns NULL if the nodes are invalid */
+static BooleanExpression* createImageExpressionNode(const ExperimentImage* image, const ImageExpressionNode* nodes, unsigned int nodeCount,
+                                                    unsigned int* next, Variable* variables, unsigned int variablesCount)
+{
+    if (*next >= nodeCount)
+    {
+        log_error("ExperimentImage: an expression ends unexpectedly");
+        return NULL;
+    }
+    const ImageExpressionNode* node = &nodes[(*next)++];
+    if (node->type > BoolExprVARIABLE || node->children != getImageNodeChildren(node->type))
+    {
+        log_error("ExperimentImage: an expression node has the wrong operands");
+        return NULL;
+    }
+    BooleanExpression* expression = malloc(sizeof(*expression));
+    if (expression == NULL)
+    {
+        log_error("ExperimentImage: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    *expression = (BooleanExpression){node->type, NULL, NULL, NULL, NULL, NULL, node->valueSize, node->operandType, node->resultType};
+
+    int valid = 1;
+    if (node->type == BoolExprVARIABLE)
+    {
+        valid = node->operand < variablesCount;
+        if (valid)
+        {
+            expression->name = variables[node->operand].name;
+            expression->value = (char*)variables[node->operand].value;
+            expression->valueSize = variables[node->operand].valueSize;
+        }
+    }
+    else if (node->operand != EXPERIMENT_IMAGE_NONE)
+    {
+        expression->value = copyImageValue(image, node->operand, node->valueSize);
+        valid = expression->value != NULL;
+    }
+    if (valid && (node->children & 1))
+    {
+        expression->leftside = createImageExpressionNode(image, nodes, nodeCount, next, variables, variablesCount);
+        valid = expression->leftside != NULL;
+        if (valid)
+        {
+            expression->leftside->parent = expression;
+        }
+    }
+    if (valid && (node->children & 2))
+    {
+        expression->rightside = createImageExpressionNode(image, nodes, nodeCount, next, variables, variablesCount);
+        valid = expression->rightside != NULL;
+        if (valid)
+        {
+            expression->rightside->parent = expression;
+        }
+    }
+    if (!valid)
+    {
+        log_error("ExperimentImage: an expression node is invalid");
+        destroyBooleanExpression(expression);
+        return NULL;
+    }
+    return expression;
+}
+
+/*
+ *  creates an expression of the image, its variables are bound to the values of the given variables in the
+ *  order of the image. Returns NULL for missing or invalid expressions.
+ */
+BooleanExpression* createImageExpression(const ExperimentImage* image, ImageExpression expression, Variable* variables, unsigned int variablesCount)
+{
+    const ImageExpressionNode* first = getImageRecords(image, image->header->nodes, expression, sizeof(*first));
+    if (expression.count == 0 || first == NULL)
+    {
+        return NULL;
+    }
+    unsigned int next = 0;
+    BooleanExpression* result = createImageExpressionNode(image, first, expression.count, &next, variables, variablesCount);
+    if (result != NULL && next != expression.count)
+    {
+        log_error("ExperimentImage: an expression has unused nodes");
+        destroyBooleanExpression(result);
+        return NULL;
+    }
+    return result;
+}
\ No newline at end of file
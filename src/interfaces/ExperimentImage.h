@@ -0,0 +1,172 @@
+#ifndef EXPERIMENTIMAGE_H
+#define EXPERIMENTIMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorsActuators.h"
+#include "../parsers/BooleanExpressionParser.h"
+
+#define EXPERIMENT_IMAGE_MAGIC "GOLDiIMG"
+#define EXPERIMENT_IMAGE_VERSION 2
+#define EXPERIMENT_IMAGE_BYTE_ORDER 0x01020304u
+#define EXPERIMENT_IMAGE_NAME "ExperimentData.img"
+
+/* marks a missing offset, e.g. a state machine without a next state table */
+#define EXPERIMENT_IMAGE_NONE 0xFFFFFFFFu
+
+/*
+ *  The binary image of an experiment written by goldi-image. Every reference inside of the image is an offset
+ *  (from the start of the image or of the section it points into), so the image can be mapped at any address.
+ *  All names and values are stored in the string section, variables are referenced by their index: the
+ *  sensors first, followed by the actuators and (inside of transition functions) the states of the state machine.
+ */
+
+/*
+ *  a section of the image or a range of records inside of a section
+ *  offset  -   sections: the offset of the first record from the start of the image,
+ *              ranges inside of a section: the index of the first record
+ *  count   -   the amount of records (bytes for the string section)
+ */
+typedef struct
+{
+    uint32_t    offset;
+    uint32_t    count;
+} ImageRange;
+
+/*
+ *  sourceHash          -   hashExperimentSections of the complete ExperimentData.json the image was written from
+ *  protectionHash      -   hashExperimentSections of the Sensors, Actuators and ProtectionRules (see ExperimentPlugin.h)
+ *  initializationHash  -   hashExperimentSections of the Sensors, Actuators and Initializers
+ *  size                -   the size of the image in bytes
+ */
+typedef struct
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    byteOrder;
+    uint32_t    size;
+    uint32_t    reserved;
+    uint64_t    sourceHash;
+    uint64_t    protectionHash;
+    uint64_t    initializationHash;
+    ImageRange  sensors;
+    ImageRange  actuators;
+    ImageRange  rules;
+    ImageRange  stateMachines;
+    ImageRange  states;
+    ImageRange  outputs;
+    ImageRange  nodes;
+    ImageRange  tableInputs;
+    ImageRange  tables;
+    ImageRange  strings;
+} ExperimentImageHeader;
+
+typedef struct
+{
+    uint32_t    id;
+    uint32_t    type;
+    uint32_t    pinMapping;
+    uint32_t    isVirtual;
+} ImageSensor;
+
+/* stopValue   -   the offset of the stop value (getValueSizeOfActuatorType bytes) inside of the strings */
+typedef struct
+{
+    uint32_t    id;
+    uint32_t    type;
+    uint32_t    pinMapping;
+    uint32_t    stopValue;
+} ImageActuator;
+
+/*
+ *  a node of an expression, the nodes of an expression are stored in preorder
+ *  operand     -   variables: the index of the variable, all others: the offset of the value inside of the
+ *                  strings or EXPERIMENT_IMAGE_NONE
+ *  children    -   bit 0 is set if the node has a left side, bit 1 if it has a right side
+ */
+typedef struct
+{
+    uint32_t    type;
+    uint32_t    operandType;
+    uint32_t    resultType;
+    uint32_t    valueSize;
+    uint32_t    operand;
+    uint32_t    children;
+} ImageExpressionNode;
+
+/* the nodes of an expression, an empty range stands for a missing expression */
+typedef ImageRange ImageExpression;
+
+/*
+ *  expression      -   the optimized expression of the rule
+ *  source          -   the expression as written in the experiment data
+ */
+typedef struct
+{
+    ImageExpression expression;
+    uint32_t        source;
+    uint32_t        errorMessage;
+    int32_t         errorCode;
+    uint32_t        reserved;
+} ImageRule;
+
+/*
+ *  states          -   the states of the state machine inside of the state section
+ *  startState      -   the index of the start state inside of the state machine, EXPERIMENT_IMAGE_NONE if missing
+ *  endState        -   the index of the end state inside of the state machine, EXPERIMENT_IMAGE_NONE if missing
+ *  tableInputs     -   the variable indexes of the inputs of the next state table inside of the table input section
+ *  table           -   the index of the first entry of the next state table inside of the table section,
+ *                      EXPERIMENT_IMAGE_NONE if the state machine has no table. Entries may be
+ *                      STATEMACHINE_TABLE_NO_STATE (see StateMachine.h)
+ */
+typedef struct
+{
+    uint32_t    name;
+    ImageRange  states;
+    uint32_t    startState;
+    uint32_t    endState;
+    ImageRange  tableInputs;
+    uint32_t    table;
+    uint32_t    reserved;
+} ImageStateMachine;
+
+/* outputs  -   the outputs of the state inside of the output section */
+typedef struct
+{
+    uint32_t        name;
+    ImageExpression transitionFunction;
+    ImageRange      outputs;
+} ImageState;
+
+/* value    -   the offset of the value (getValueSizeOfActuatorType bytes) inside of the strings */
+typedef struct
+{
+    uint32_t    actuatorID;
+    uint32_t    type;
+    uint32_t    value;
+    uint32_t    reserved;
+} ImageOutput;
+
+/*
+ *  a mapped image, all sections have been checked to lie inside of the image
+ *  data    -   the mapped image
+ *  size    -   the size of the mapping
+ *  header  -   the header at the start of the image
+ */
+typedef struct
+{
+    const char*                     data;
+    size_t                          size;
+    const ExperimentImageHeader*    header;
+} ExperimentImage;
+
+ExperimentImage* openExperimentImage(const char* path);
+void closeExperimentImage(ExperimentImage* image);
+const void* getImageSection(const ExperimentImage* image, ImageRange range);
+const void* getImageRecords(const ExperimentImage* image, ImageRange section, ImageRange range, size_t recordSize);
+const char* getImageString(const ExperimentImage* image, uint32_t offset, uint32_t size);
+Sensor* createImageSensors(const ExperimentImage* image, unsigned int* sensorCount);
+Actuator* createImageActuators(const ExperimentImage* image, unsigned int* actuatorCount);
+BooleanExpression* createImageExpression(const ExperimentImage* image, ImageExpression expression, Variable* variables, unsigned int variablesCount);
+
+#endif
\ No newline at end of file
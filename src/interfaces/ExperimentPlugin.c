@@ -0,0 +1,100 @@
+#include "ExperimentPlugin.h"
+#include "../logging/log.h"
+#include <dlfcn.h>
+#include <glob.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/*
+ *  FNV-1a (64 bit) over the given JSON-formatted sections, every section is terminated by its null byte
+ *  so moving content from one section to the next changes the hash
+ */
+unsigned long long hashExperimentSections(char* const* sections, unsigned int sectionCount)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (unsigned int i = 0; i < sectionCount; i++)
+    {
+        const unsigned char* current = (const unsigned char*)sections[i];
+        do
+        {
+            hash ^= *current;
+            hash *= 1099511628211ull;
+        } while (*current++ != 0);
+    }
+    return hash;
+}
+
+/* loads the plugin at the given path, returns NULL if it is no compatible plugin for the given hash */
+static ExperimentPluginHandle* openExperimentPlugin(const char* path, ExperimentPart part, unsigned long long hash)
+{
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL)
+    {
+        log_error("experiment plugin: %s could not be loaded: %s", path, dlerror());
+        return NULL;
+    }
+    const ExperimentPlugin* plugin = dlsym(handle, EXPERIMENT_PLUGIN_SYMBOL);
+    if (plugin == NULL || plugin->abiVersion != EXPERIMENT_PLUGIN_ABI_VERSION)
+    {
+        log_error("experiment plugin: %s is no compatible plugin", path);
+        dlclose(handle);
+        return NULL;
+    }
+    unsigned long long pluginHash = part == ExperimentPartProtection ? plugin->protectionHash : plugin->initializationHash;
+    if (pluginHash != hash)
+    {
+        dlclose(handle);
+        return NULL;
+    }
+
+    ExperimentPluginHandle* pluginHandle = malloc(sizeof(*pluginHandle));
+    char* pathCopy = malloc(strlen(path) + 1);
+    if (pluginHandle == NULL || pathCopy == NULL)
+    {
+        log_error("experiment plugin: malloc error %s", strerror(errno));
+        free(pluginHandle);
+        free(pathCopy);
+        dlclose(handle);
+        return NULL;
+    }
+    strcpy(pathCopy, path);
+    *pluginHandle = (ExperimentPluginHandle){handle, plugin, pathCopy};
+    return pluginHandle;
+}
+
+/*
+ *  searches <directory>/<experiment>/EXPERIMENT_PLUGIN_NAME for a plugin that was compiled from the
+ *  experiment data with the given hash
+ *  returns NULL if there is no matching plugin, the caller should use the interpreter in that case
+ */
+ExperimentPluginHandle* findExperimentPlugin(const char* directory, ExperimentPart part, unsigned long long hash)
+{
+    char pattern[strlen(directory) + sizeof("/*/" EXPERIMENT_PLUGIN_NAME)];
+    strcpy(pattern, directory);
+    strcat(pattern, "/*/" EXPERIMENT_PLUGIN_NAME);
+
+    glob_t paths;
+    if (glob(pattern, 0, NULL, &paths) != 0)
+    {
+        return NULL;
+    }
+    ExperimentPluginHandle* plugin = NULL;
+    for (size_t i = 0; i < paths.gl_pathc && plugin == NULL; i++)
+    {
+        plugin = openExperimentPlugin(paths.gl_pathv[i], part, hash);
+    }
+    globfree(&paths);
+    return plugin;
+}
+
+void closeExperimentPlugin(ExperimentPluginHandle* plugin)
+{
+    if (plugin == NULL)
+    {
+        return;
+    }
+    dlclose(plugin->handle);
+    free(plugin->path);
+    free(plugin);
+}
\ No newline at end of file
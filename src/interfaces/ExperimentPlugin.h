@@ -0,0 +1,69 @@
+#ifndef EXPERIMENTPLUGIN_H
+#define EXPERIMENTPLUGIN_H
+
+#define EXPERIMENT_PLUGIN_ABI_VERSION 1
+#define EXPERIMENT_PLUGIN_SYMBOL "goldiExperimentPlugin"
+#define EXPERIMENT_PLUGIN_NAME "ExperimentData.so"
+#define EXPERIMENT_PLUGIN_DIRECTORY "/etc/GOLDiServices/experiments"
+#define EXPERIMENT_PLUGIN_MAX_STATES 64
+
+/* the parts of an experiment a plugin can be used for, each is identified by its own hash */
+typedef enum
+{
+    ExperimentPartProtection,
+    ExperimentPartInitialization
+} ExperimentPart;
+
+/*
+ *  The interface of an experiment compiled by goldi-compile, exported by the shared object under the
+ *  name EXPERIMENT_PLUGIN_SYMBOL
+ *  abiVersion              -   EXPERIMENT_PLUGIN_ABI_VERSION of the goldi-compile that generated the plugin
+ *  protectionHash          -   hashExperimentSections of the Sensors, Actuators and ProtectionRules
+ *  initializationHash      -   hashExperimentSections of the Sensors, Actuators and Initializers
+ *  sensorCount             -   the amount of sensors, in the order of the experiment data
+ *  actuatorCount           -   the amount of actuators, in the order of the experiment data
+ *  ruleCount               -   the amount of protection rules
+ *  stateMachineCount       -   the amount of initializers
+ *  stateMachineNames       -   the name of every initializer
+ *  stateCounts             -   the amount of states of every initializer
+ *  bindProcessImage        -   stores the addresses of the sensor and actuator values, has to be called
+ *                              before any evaluation
+ *  evaluateProtectionRules -   writes the result of every rule into results, returns the amount of
+ *                              triggered rules
+ *  nextStates              -   returns the states of the given initializer that are active after the
+ *                              given states, bit i stands for the state with index i
+ */
+typedef struct
+{
+    unsigned int        abiVersion;
+    unsigned long long  protectionHash;
+    unsigned long long  initializationHash;
+    unsigned int        sensorCount;
+    unsigned int        actuatorCount;
+    unsigned int        ruleCount;
+    unsigned int        stateMachineCount;
+    const char* const*  stateMachineNames;
+    const unsigned int* stateCounts;
+    void                (*bindProcessImage)(char* const* sensorValues, char* const* actuatorValues);
+    unsigned int        (*evaluateProtectionRules)(unsigned char* results);
+    unsigned long long  (*nextStates)(unsigned int stateMachine, unsigned long long activeStates);
+} ExperimentPlugin;
+
+/*
+ *  a loaded plugin
+ *  handle  -   the handle returned by dlopen
+ *  plugin  -   the interface exported by the plugin
+ *  path    -   the path of the shared object
+ */
+typedef struct
+{
+    void*                   handle;
+    const ExperimentPlugin* plugin;
+    char*                   path;
+} ExperimentPluginHandle;
+
+unsigned long long hashExperimentSections(char* const* sections, unsigned int sectionCount);
+ExperimentPluginHandle* findExperimentPlugin(const char* directory, ExperimentPart part, unsigned long long hash);
+void closeExperimentPlugin(ExperimentPluginHandle* plugin);
+
+#endif
\ No newline at end of file
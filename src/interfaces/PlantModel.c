@@ -0,0 +1,247 @@
+#include "PlantModel.h"
+#include "../logging/log.h"
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* returns the value of the binary sensor with the given id, NULL if there is none */
+static char* getSensorValue(Sensor* sensors, unsigned int sensorCount, const JSON* idJSON)
+{
+    if (idJSON == NULL || !JSONIsString(idJSON))
+    {
+        return NULL;
+    }
+    Sensor* sensor = getSensorWithID(sensors, idJSON->valuestring, sensorCount);
+    if (sensor == NULL || sensor->type != SensorTypeBinary)
+    {
+        log_error("PlantModel: %s is not a binary sensor", idJSON->valuestring);
+        return NULL;
+    }
+    return sensor->value;
+}
+
+/* returns the value of the binary actuator with the given id, NULL if there is none */
+static const char* getActuatorValue(Actuator* actuators, unsigned int actuatorCount, const JSON* idJSON)
+{
+    if (idJSON == NULL || !JSONIsString(idJSON))
+    {
+        return NULL;
+    }
+    Actuator* actuator = getActuatorWithID(actuators, idJSON->valuestring, actuatorCount);
+    if (actuator == NULL || actuator->type != ActuatorTypeBinary)
+    {
+        log_error("PlantModel: %s is not a binary actuator", idJSON->valuestring);
+        return NULL;
+    }
+    return actuator->value;
+}
+
+/* returns the number with the given name or the default value if the object has none */
+static double getNumber(const JSON* object, const char* name, double defaultValue)
+{
+    const JSON* numberJSON = JSONGetObjectItem(object, name);
+    return numberJSON != NULL && JSONIsNumber(numberJSON) ? JSONGetNumberValue(numberJSON) : defaultValue;
+}
+
+/* parses a single axis, returns 1 if it refers to unknown sensors or actuators */
+static int parsePlantAxis(PlantAxis* axis, const JSON* axisJSON, Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    const JSON* nameJSON = JSONGetObjectItem(axisJSON, "Name");
+    axis->name = malloc(nameJSON != NULL && JSONIsString(nameJSON) ? strlen(nameJSON->valuestring) + 1 : 1);
+    if (axis->name == NULL)
+    {
+        log_error("PlantModel: malloc error %s", strerror(errno));
+        return 1;
+    }
+    strcpy(axis->name, nameJSON != NULL && JSONIsString(nameJSON) ? nameJSON->valuestring : "");
+    axis->length = getNumber(axisJSON, "Length", 0);
+    axis->speed = getNumber(axisJSON, "Speed", 0);
+    axis->start = getNumber(axisJSON, "Start", 0);
+    axis->positionScale = getNumber(axisJSON, "PositionScale", 1);
+    if (axis->length <= 0 || axis->speed <= 0 || axis->start < 0 || axis->start > axis->length)
+    {
+        log_error("PlantModel: axis %s needs a positive length and speed and a start inside of the axis", axis->name);
+        return 1;
+    }
+    axis->increase = getActuatorValue(actuators, actuatorCount, JSONGetObjectItem(axisJSON, "Increase"));
+    axis->decrease = getActuatorValue(actuators, actuatorCount, JSONGetObjectItem(axisJSON, "Decrease"));
+    if (axis->increase == NULL || axis->decrease == NULL)
+    {
+        log_error("PlantModel: axis %s needs an actuator to increase and one to decrease its position", axis->name);
+        return 1;
+    }
+
+    const JSON* windowsJSON = JSONGetObjectItem(axisJSON, "Sensors");
+    axis->windowCount = windowsJSON == NULL ? 0 : JSONGetArraySize(windowsJSON);
+    axis->windows = malloc(sizeof(*axis->windows) * (axis->windowCount > 0 ? axis->windowCount : 1));
+    if (axis->windows == NULL)
+    {
+        log_error("PlantModel: malloc error %s", strerror(errno));
+        return 1;
+    }
+    for (int i = 0; i < axis->windowCount; i++)
+    {
+        const JSON* windowJSON = JSONGetArrayItem(windowsJSON, i);
+        axis->windows[i].value = getSensorValue(sensors, sensorCount, JSONGetObjectItem(windowJSON, "SensorID"));
+        axis->windows[i].from = getNumber(windowJSON, "From", 0);
+        axis->windows[i].to = getNumber(windowJSON, "To", axis->length);
+        if (axis->windows[i].value == NULL)
+        {
+            log_error("PlantModel: sensor %d of axis %s is invalid", i, axis->name);
+            return 1;
+        }
+    }
+
+    const JSON* bitsJSON = JSONGetObjectItem(axisJSON, "PositionBits");
+    axis->positionBitCount = bitsJSON == NULL ? 0 : JSONGetArraySize(bitsJSON);
+    axis->positionBits = malloc(sizeof(*axis->positionBits) * (axis->positionBitCount > 0 ? axis->positionBitCount : 1));
+    if (axis->positionBits == NULL)
+    {
+        log_error("PlantModel: malloc error %s", strerror(errno));
+        return 1;
+    }
+    if (axis->positionBitCount > 64)
+    {
+        log_error("PlantModel: the encoder of axis %s has more than 64 bits", axis->name);
+        return 1;
+    }
+    for (int i = 0; i < axis->positionBitCount; i++)
+    {
+        axis->positionBits[i] = getSensorValue(sensors, sensorCount, JSONGetArrayItem(bitsJSON, i));
+        if (axis->positionBits[i] == NULL)
+        {
+            log_error("PlantModel: encoder bit %d of axis %s is invalid", i, axis->name);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  parses a plant model, every axis is an object like
+ *  {"Name": "X", "Length": 1000, "Speed": 50, "Start": 500, "Increase": "y0", "Decrease": "y1",
+ *   "Sensors": [{"SensorID": "x1", "From": 0, "To": 5}], "PositionBits": ["x10", ...], "PositionScale": 10}
+ *  inside of the array "Axes". The model writes the values of the given sensors and reads the given actuators.
+ *  returns NULL if the model is invalid
+ */
+PlantModel* parsePlantModel(char* string, unsigned int length, Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    JSON* json = JSONParseWithLength(string, length);
+    const JSON* axesJSON = json == NULL ? NULL : JSONGetObjectItem(json, "Axes");
+    if (axesJSON == NULL || !JSONIsArray(axesJSON))
+    {
+        log_error("PlantModel: the model has no array of axes");
+        JSONDelete(json);
+        return NULL;
+    }
+    PlantModel* model = calloc(1, sizeof(*model));
+    if (model == NULL)
+    {
+        log_error("PlantModel: malloc error %s", strerror(errno));
+        JSONDelete(json);
+        return NULL;
+    }
+    model->axisCount = JSONGetArraySize(axesJSON);
+    model->axes = calloc(model->axisCount > 0 ? model->axisCount : 1, sizeof(*model->axes));
+    if (model->axes == NULL)
+    {
+        log_error("PlantModel: malloc error %s", strerror(errno));
+        destroyPlantModel(model);
+        JSONDelete(json);
+        return NULL;
+    }
+    for (int i = 0; i < model->axisCount; i++)
+    {
+        if (parsePlantAxis(&model->axes[i], JSONGetArrayItem(axesJSON, i), sensors, sensorCount, actuators, actuatorCount))
+        {
+            destroyPlantModel(model);
+            JSONDelete(json);
+            return NULL;
+        }
+    }
+    JSONDelete(json);
+    resetPlantModel(model);
+    return model;
+}
+
+/* writes the sensors of an axis, returns 1 if any of them changed */
+static unsigned int updateAxisSensors(PlantAxis* axis)
+{
+    unsigned int changed = 0;
+    for (int i = 0; i < axis->windowCount; i++)
+    {
+        char value = axis->position >= axis->windows[i].from && axis->position <= axis->windows[i].to;
+        changed |= axis->windows[i].value[0] != value;
+        axis->windows[i].value[0] = value;
+    }
+    unsigned long long counts = (unsigned long long)(axis->position * axis->positionScale + 0.5);
+    for (int i = 0; i < axis->positionBitCount; i++)
+    {
+        char value = (counts >> (axis->positionBitCount - 1 - i)) & 1;
+        changed |= axis->positionBits[i][0] != value;
+        axis->positionBits[i][0] = value;
+    }
+    return changed;
+}
+
+/* moves every axis to its start position */
+void resetPlantModel(PlantModel* model)
+{
+    for (int i = 0; i < model->axisCount; i++)
+    {
+        setPlantAxisPosition(model, i, model->axes[i].start);
+    }
+    model->movingAxes = 0;
+}
+
+/* moves an axis to the given position (limited to the axis) and updates its sensors */
+void setPlantAxisPosition(PlantModel* model, unsigned int axis, double position)
+{
+    PlantAxis* plantAxis = &model->axes[axis];
+    plantAxis->position = position < 0 ? 0 : position > plantAxis->length ? plantAxis->length : position;
+    updateAxisSensors(plantAxis);
+}
+
+/*
+ *  moves every axis according to its actuators for the given time and updates the sensors
+ *  returns 1 if any sensor changed
+ */
+unsigned int stepPlantModel(PlantModel* model, double seconds)
+{
+    unsigned int changed = 0;
+    model->movingAxes = 0;
+    for (int i = 0; i < model->axisCount; i++)
+    {
+        PlantAxis* axis = &model->axes[i];
+        int direction = (axis->increase[0] != 0) - (axis->decrease[0] != 0);
+        if (axis->increase[0] != 0 && axis->decrease[0] != 0)
+        {
+            model->opposingDrives++;
+        }
+        double position = axis->position + direction * axis->speed * seconds;
+        position = position < 0 ? 0 : position > axis->length ? axis->length : position;
+        if (position != axis->position)
+        {
+            model->movingAxes++;
+            axis->position = position;
+            changed |= updateAxisSensors(axis);
+        }
+    }
+    return changed;
+}
+
+void destroyPlantModel(PlantModel* model)
+{
+    if (model == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < model->axisCount && model->axes != NULL; i++)
+    {
+        free(model->axes[i].name);
+        free(model->axes[i].windows);
+        free(model->axes[i].positionBits);
+    }
+    free(model->axes);
+    free(model);
+}
\ No newline at end of file
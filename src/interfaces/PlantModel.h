@@ -0,0 +1,72 @@
+#ifndef PLANTMODEL_H
+#define PLANTMODEL_H
+
+#include "SensorsActuators.h"
+
+/*
+ *  A binary sensor which is 1 while the position of its axis is inside of a window
+ *  value   -   the value of the sensor
+ *  from    -   the lowest position of the window
+ *  to      -   the highest position of the window
+ */
+typedef struct
+{
+    char*   value;
+    double  from;
+    double  to;
+} PlantSensorWindow;
+
+/*
+ *  An axis driven by two binary actuators at a constant speed, it stops at both ends and if both or none of
+ *  its actuators are set
+ *  name                -   the name of the axis
+ *  length              -   the highest position, the lowest is 0
+ *  speed               -   the travel speed in positions per second
+ *  start               -   the position after resetPlantModel
+ *  position            -   the current position
+ *  increase            -   the value of the actuator which drives the axis towards length
+ *  decrease            -   the value of the actuator which drives the axis towards 0
+ *  windows             -   the sensors which depend on the position
+ *  windowCount         -   the amount of windows
+ *  positionBits        -   the sensors of an absolute encoder, the most significant bit first
+ *  positionBitCount    -   the amount of bits of the encoder
+ *  positionScale       -   the encoder counts per position
+ */
+typedef struct
+{
+    char*               name;
+    double              length;
+    double              speed;
+    double              start;
+    double              position;
+    const char*         increase;
+    const char*         decrease;
+    PlantSensorWindow*  windows;
+    unsigned int        windowCount;
+    char**              positionBits;
+    unsigned int        positionBitCount;
+    double              positionScale;
+} PlantAxis;
+
+/*
+ *  A discrete-time model of a physical system which maps the actuators to the sensors
+ *  axes            -   all axes
+ *  axisCount       -   the amount of axes
+ *  movingAxes      -   the amount of axes that moved during the last step
+ *  opposingDrives  -   the amount of steps so far in which both actuators of an axis were set
+ */
+typedef struct
+{
+    PlantAxis*          axes;
+    unsigned int        axisCount;
+    unsigned int        movingAxes;
+    unsigned long long  opposingDrives;
+} PlantModel;
+
+PlantModel* parsePlantModel(char* string, unsigned int length, Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount);
+void resetPlantModel(PlantModel* model);
+void setPlantAxisPosition(PlantModel* model, unsigned int axis, double position);
+unsigned int stepPlantModel(PlantModel* model, double seconds);
+void destroyPlantModel(PlantModel* model);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "ProcessImage.h"
+#include "../logging/log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* every value gets at least one byte, values of more than one byte are aligned to 8 bytes */
+static unsigned int getProcessImageSlot(unsigned int offset, unsigned int valueSize)
+{
+    return valueSize > 1 ? (offset + 7) & ~7u : offset;
+}
+
+/*
+ *  moves the values of the given sensors and actuators into a new process image, the values are kept
+ *  returns NULL on error, the values are not moved in this case
+ */
+ProcessImage* createProcessImage(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    ProcessImage* image = calloc(1, sizeof(*image));
+    unsigned int count = sensorCount + actuatorCount;
+    if (image == NULL)
+    {
+        log_error("ProcessImage: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    /* a writer holding the mutex while the control loop stops the physical system runs at the priority of the loop */
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&image->updateMutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    atomic_init(&image->publishedSequence, 0);
+    atomic_init(&image->snapshotSequence, 0);
+    image->sensorCount = sensorCount;
+    image->actuatorCount = actuatorCount;
+    image->offsets = malloc(sizeof(*image->offsets) * (count + 1));
+    image->valueSizes = malloc(sizeof(*image->valueSizes) * (count + 1));
+    image->originalValues = malloc(sizeof(*image->originalValues) * (count + 1));
+    image->changedSensors = malloc(sizeof(*image->changedSensors) * (sensorCount + 1));
+    image->changedActuators = malloc(sizeof(*image->changedActuators) * (actuatorCount + 1));
+    image->sensorWrites = calloc(sensorCount + 1, sizeof(*image->sensorWrites));
+    image->publishedWrites = calloc(sensorCount + 1, sizeof(*image->publishedWrites));
+    if (image->offsets == NULL || image->valueSizes == NULL || image->originalValues == NULL || image->changedSensors == NULL ||
+        image->changedActuators == NULL || image->sensorWrites == NULL || image->publishedWrites == NULL)
+    {
+        log_error("ProcessImage: malloc error %s", strerror(errno));
+        destroyProcessImage(image, NULL, NULL);
+        return NULL;
+    }
+
+    unsigned int offset = 0;
+    for (int i = 0; i < count; i++)
+    {
+        image->valueSizes[i] = i < sensorCount ? getValueSizeOfSensorType(sensors[i].type) : getValueSizeOfActuatorType(actuators[i - sensorCount].type);
+        image->offsets[i] = getProcessImageSlot(offset, image->valueSizes[i]);
+        offset = image->offsets[i] + (image->valueSizes[i] > 0 ? image->valueSizes[i] : 1);
+        if (i + 1 == sensorCount)
+        {
+            image->sensorSize = offset;
+        }
+    }
+    image->size = offset;
+    image->values = calloc(image->size + 1, 1);
+    image->previous = calloc(image->size + 1, 1);
+    image->update = calloc(image->size + 1, 1);
+    image->published = calloc(image->size + 1, 1);
+    image->snapshot = calloc(image->size + 1, 1);
+    if (image->values == NULL || image->previous == NULL || image->update == NULL || image->published == NULL || image->snapshot == NULL)
+    {
+        log_error("ProcessImage: malloc error %s", strerror(errno));
+        destroyProcessImage(image, NULL, NULL);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        char** value = i < sensorCount ? &sensors[i].value : &actuators[i - sensorCount].value;
+        memcpy(image->values + image->offsets[i], *value, image->valueSizes[i]);
+        image->originalValues[i] = *value;
+        *value = image->values + image->offsets[i];
+    }
+    memcpy(image->previous, image->values, image->size);
+    memcpy(image->update, image->values, image->size);
+    memcpy(image->published, image->values, image->size);
+    memcpy(image->snapshot, image->values, image->size);
+    return image;
+}
+
+/*
+ *  compares the values of the sensors with the ones of the last commit, the indexes of the changed sensors
+ *  are written to changedSensors. Afterwards the current values become the ones of the last commit.
+ *  returns the amount of changed sensors
+ */
+unsigned int commitSensorChanges(ProcessImage* image)
+{
+    image->changedSensorCount = 0;
+    if (!memcmp(image->values, image->previous, image->sensorSize))
+    {
+        return 0;
+    }
+    for (int i = 0; i < image->sensorCount; i++)
+    {
+        if (memcmp(image->values + image->offsets[i], image->previous + image->offsets[i], image->valueSizes[i]))
+        {
+            image->changedSensors[image->changedSensorCount++] = i;
+        }
+    }
+    memcpy(image->previous, image->values, image->sensorSize);
+    return image->changedSensorCount;
+}
+
+/*
+ *  like commitSensorChanges for the actuators, the indexes are relative to the first actuator and written to
+ *  changedActuators. Used to write only the actuators that changed since the last write.
+ *  returns the amount of changed actuators
+ */
+unsigned int commitActuatorChanges(ProcessImage* image)
+{
+    image->changedActuatorCount = 0;
+    if (!memcmp(image->values + image->sensorSize, image->previous + image->sensorSize, image->size - image->sensorSize))
+    {
+        return 0;
+    }
+    for (int i = 0; i < image->actuatorCount; i++)
+    {
+        unsigned int offset = image->offsets[image->sensorCount + i];
+        if (memcmp(image->values + offset, image->previous + offset, image->valueSizes[image->sensorCount + i]))
+        {
+            image->changedActuators[image->changedActuatorCount++] = i;
+        }
+    }
+    memcpy(image->previous + image->sensorSize, image->values + image->sensorSize, image->size - image->sensorSize);
+    return image->changedActuatorCount;
+}
+
+/*
+ *  starts a new set of actuator values, called by the other threads and by the control loop to publish the stop
+ *  values, see updateMutex. The returned buffer contains the last published values, it may be modified until
+ *  publishActuatorUpdate is called. The values of sensors set by the user (the virtual sensors) can be written
+ *  by the same update.
+ */
+char* beginActuatorUpdate(ProcessImage* image)
+{
+    pthread_mutex_lock(&image->updateMutex);
+    return image->update;
+}
+
+/* returns the value of the given actuator inside of an update */
+char* getActuatorUpdateValue(ProcessImage* image, char* update, unsigned int actuator)
+{
+    return update + image->offsets[image->sensorCount + actuator];
+}
+
+/*
+ *  returns the value of the given sensor inside of an update and marks it as written, unlike the actuators only
+ *  the written sensors are adopted by the control loop
+ */
+char* getSensorUpdateValue(ProcessImage* image, char* update, unsigned int sensor)
+{
+    /* the sequence only changes while a writer holds updateMutex, this is the one the update will be published with */
+    image->sensorWrites[sensor] = atomic_load_explicit(&image->publishedSequence, memory_order_relaxed) + 2;
+    return update + image->offsets[sensor];
+}
+
+/* publishes the modified actuator values as a whole, they are adopted at the start of the next cycle */
+void publishActuatorUpdate(ProcessImage* image)
+{
+    unsigned int sequence = atomic_load_explicit(&image->publishedSequence, memory_order_relaxed);
+    atomic_store_explicit(&image->publishedSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(image->published, image->update, image->size);
+    memcpy(image->publishedWrites, image->sensorWrites, sizeof(*image->sensorWrites) * image->sensorCount);
+    atomic_store_explicit(&image->publishedSequence, sequence + 2, memory_order_release);
+    pthread_mutex_unlock(&image->updateMutex);
+}
+
+/*
+ *  copies the last published actuator values and the sensors written since the last adoption into the process
+ *  image if they have not been adopted yet, called by the control loop. A copy overlapping with a publication is
+ *  repeated, so the values are always one complete set.
+ *  returns 1 if new values have been adopted
+ */
+unsigned int adoptActuatorUpdate(ProcessImage* image)
+{
+    unsigned int sequence = atomic_load_explicit(&image->publishedSequence, memory_order_acquire);
+    if (sequence == image->adoptedSequence)
+    {
+        return 0;
+    }
+    while (1)
+    {
+        if ((sequence & 1) == 0)
+        {
+            memcpy(image->values + image->sensorSize, image->published + image->sensorSize, image->size - image->sensorSize);
+            /* the sequence of a written sensor only grows, so a sensor copied by a repeated attempt is copied again */
+            for (int i = 0; i < image->sensorCount; i++)
+            {
+                if (image->publishedWrites[i] > image->adoptedSequence)
+                {
+                    memcpy(image->values + image->offsets[i], image->published + image->offsets[i], image->valueSizes[i]);
+                }
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&image->publishedSequence, memory_order_relaxed) == sequence)
+            {
+                break;
+            }
+        }
+        sequence = atomic_load_explicit(&image->publishedSequence, memory_order_acquire);
+    }
+    image->adoptedSequence = sequence;
+    return 1;
+}
+
+/* publishes a copy of all values for the readers of the snapshot, called by the control loop once per cycle */
+void publishProcessImageSnapshot(ProcessImage* image)
+{
+    unsigned int sequence = atomic_load_explicit(&image->snapshotSequence, memory_order_relaxed);
+    atomic_store_explicit(&image->snapshotSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(image->snapshot, image->values, image->size);
+    atomic_store_explicit(&image->snapshotSequence, sequence + 2, memory_order_release);
+}
+
+/*
+ *  copies the last snapshot into values, which has to have the size of the process image. The values have the
+ *  same offsets as in the process image.
+ *  returns the epoch of the snapshot, the amount of snapshots published before it
+ */
+unsigned int readProcessImageSnapshot(ProcessImage* image, char* values)
+{
+    while (1)
+    {
+        unsigned int sequence = atomic_load_explicit(&image->snapshotSequence, memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            memcpy(values, image->snapshot, image->size);
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&image->snapshotSequence, memory_order_relaxed) == sequence)
+            {
+                return sequence / 2;
+            }
+        }
+    }
+}
+
+/*
+ *  moves the current values back into the buffers the sensors and actuators had before the image was created,
+ *  so they can be destroyed as usual. Sensors and actuators can be NULL if they are destroyed already.
+ */
+void destroyProcessImage(ProcessImage* image, Sensor* sensors, Actuator* actuators)
+{
+    if (image == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < image->sensorCount + image->actuatorCount && image->values != NULL; i++)
+    {
+        char** value = i < image->sensorCount ? (sensors == NULL ? NULL : &sensors[i].value) : (actuators == NULL ? NULL : &actuators[i - image->sensorCount].value);
+        if (value != NULL)
+        {
+            memcpy(image->originalValues[i], image->values + image->offsets[i], image->valueSizes[i]);
+            *value = image->originalValues[i];
+        }
+    }
+    free(image->values);
+    free(image->previous);
+    free(image->offsets);
+    free(image->valueSizes);
+    free(image->originalValues);
+    free(image->changedSensors);
+    free(image->changedActuators);
+    free(image->update);
+    free(image->published);
+    free(image->sensorWrites);
+    free(image->publishedWrites);
+    free(image->snapshot);
+    pthread_mutex_destroy(&image->updateMutex);
+    free(image);
+}
\ No newline at end of file
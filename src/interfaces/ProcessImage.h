@@ -0,0 +1,82 @@
+#ifndef PROCESSIMAGE_H
+#define PROCESSIMAGE_H
+
+#include "SensorsActuators.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ *  The values of all sensors and actuators in one contiguous buffer, the sensors first. The value pointers of
+ *  the sensors and actuators are moved into the buffer, so everything bound to them (e.g. the protection rules)
+ *  has to be created afterwards. A second buffer keeps the values of the last commit, comparing both finds
+ *  the changed values without any allocation.
+ *  Only the control loop accesses the values. Other threads hand over new actuator values, and the values of
+ *  sensors set by the user, as a complete set (beginActuatorUpdate, publishActuatorUpdate) which the control loop
+ *  adopts at the start of a cycle, and read a snapshot of all values the control loop publishes once per cycle.
+ *  Both are seqlocks, so the control loop and the readers of the snapshot never block and never see a partial
+ *  update.
+ *  values                -   the current values, the value of every sensor and actuator points into it
+ *  previous              -   the values at the last commit
+ *  size                  -   the size of both buffers in bytes
+ *  sensorSize            -   the size of the values of the sensors at the start of both buffers
+ *  offsets               -   the offset of the value of every sensor followed by every actuator
+ *  valueSizes            -   the size of the value of every sensor followed by every actuator
+ *  sensorCount           -   the amount of sensors
+ *  actuatorCount         -   the amount of actuators
+ *  originalValues        -   the values the sensors and actuators had before, restored by destroyProcessImage
+ *  changedSensors        -   the indexes of the sensors changed between the last two commits
+ *  changedSensorCount    -   the amount of changed sensors
+ *  changedActuators      -   the indexes of the actuators changed between the last two actuator commits
+ *  changedActuatorCount  -   the amount of changed actuators
+ *  update                -   the values modified by the writer holding updateMutex, only the actuators and the
+ *                            written sensors are adopted
+ *  published             -   the last complete set of values published by a writer
+ *  sensorWrites          -   the sequence of the update that last wrote every sensor, 0 if it has never been written
+ *  publishedWrites       -   sensorWrites of published
+ *  publishedSequence     -   the sequence of published, odd while a writer copies into it
+ *  adoptedSequence       -   the sequence of the actuator values last adopted by the control loop
+ *  updateMutex           -   serializes the writers of actuator values. The control loop only locks it to publish
+ *                            the stop values after a triggered rule, so writers must not block while holding it.
+ *                            It inherits the priority of the control loop in the real-time mode.
+ *  snapshot              -   a copy of all values, published by the control loop once per cycle
+ *  snapshotSequence      -   the sequence of snapshot, odd while the control loop copies into it
+ */
+typedef struct
+{
+    char*           values;
+    char*           previous;
+    unsigned int    size;
+    unsigned int    sensorSize;
+    unsigned int*   offsets;
+    unsigned int*   valueSizes;
+    unsigned int    sensorCount;
+    unsigned int    actuatorCount;
+    char**          originalValues;
+    unsigned int*   changedSensors;
+    unsigned int    changedSensorCount;
+    unsigned int*   changedActuators;
+    unsigned int    changedActuatorCount;
+    char*           update;
+    char*           published;
+    unsigned int*   sensorWrites;
+    unsigned int*   publishedWrites;
+    atomic_uint     publishedSequence;
+    unsigned int    adoptedSequence;
+    pthread_mutex_t updateMutex;
+    char*           snapshot;
+    atomic_uint     snapshotSequence;
+} ProcessImage;
+
+ProcessImage* createProcessImage(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount);
+unsigned int commitSensorChanges(ProcessImage* image);
+unsigned int commitActuatorChanges(ProcessImage* image);
+char* beginActuatorUpdate(ProcessImage* image);
+char* getActuatorUpdateValue(ProcessImage* image, char* update, unsigned int actuator);
+char* getSensorUpdateValue(ProcessImage* image, char* update, unsigned int sensor);
+void publishActuatorUpdate(ProcessImage* image);
+unsigned int adoptActuatorUpdate(ProcessImage* image);
+void publishProcessImageSnapshot(ProcessImage* image);
+unsigned int readProcessImageSnapshot(ProcessImage* image, char* values);
+void destroyProcessImage(ProcessImage* image, Sensor* sensors, Actuator* actuators);
+
+#endif
\ No newline at end of file
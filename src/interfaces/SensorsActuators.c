@@ -297,6 +297,28 @@ Actuator* parseActuators(char* str, int length, unsigned int* actuatorCount, uns
     return actuators;
 }
 
+/* creates the variables of the expressions, all sensors followed by all actuators, as done by the services */
+Variable* createSensorActuatorVariables(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    Variable* variables = malloc(sizeof(*variables) * (sensorCount + actuatorCount + 1));
+    if (variables == NULL)
+    {
+        log_error("malloc error: %s", strerror(errno));
+        return NULL;
+    }
+    for (int i = 0; i < sensorCount; i++)
+    {
+        OperandType operandType = sensors[i].type == SensorTypeBinary ? OperandTypeBinary : OperandTypeNumber;
+        variables[i] = (Variable){operandType, sensors[i].sensorID, sensors[i].value, getValueSizeOfSensorType(sensors[i].type)};
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        OperandType operandType = actuators[i].type == ActuatorTypeBinary ? OperandTypeBinary : OperandTypeNumber;
+        variables[sensorCount + i] = (Variable){operandType, actuators[i].actuatorID, actuators[i].value, getValueSizeOfActuatorType(actuators[i].type)};
+    }
+    return variables;
+}
+
 void printSensorData(Sensor sensor)
 {
     printf("SensorID:               %s\n", sensor.sensorID);
@@ -496,4 +518,36 @@ JSON* ActuatorDataPacketToJSON(ActuatorDataPacket packet)
     JSONAddStringToObject(dataPacket, "ActuatorID", packet.actuatorID);
     JSONAddStringToObject(dataPacket, "ActuatorType", actuatorTypeToString(packet.actuatorType));
     return dataPacket;
+}
+
+/* serializes a packet without whitespace like SensorDataPacketToJSON, returns NULL on error */
+char* serializeSensorDataPacket(SensorDataPacket packet)
+{
+    if (packet.sensorType != SensorTypeBinary)
+    {
+        return NULL;
+    }
+    JSON* dataPacket = JSONCreateObject();
+    JSONAddNumberToObject(dataPacket, "SensorValue", (unsigned char)packet.value[0]);
+    JSONAddStringToObject(dataPacket, "SensorID", packet.sensorID);
+    JSONAddStringToObject(dataPacket, "SensorType", sensorTypeToString(packet.sensorType));
+    char* string = JSONPrintUnformatted(dataPacket);
+    JSONDelete(dataPacket);
+    return string;
+}
+
+/* serializes a packet without whitespace as an element of the array read by parseActuatorDataPackets, returns NULL on error */
+char* serializeActuatorDataPacket(ActuatorDataPacket packet)
+{
+    if (packet.actuatorType != ActuatorTypeBinary)
+    {
+        return NULL;
+    }
+    JSON* dataPacket = JSONCreateObject();
+    JSONAddStringToObject(dataPacket, "ActuatorID", packet.actuatorID);
+    JSONAddStringToObject(dataPacket, "ActuatorType", actuatorTypeToString(packet.actuatorType));
+    JSONAddNumberToObject(dataPacket, "ActuatorValue", (unsigned char)packet.value[0]);
+    char* string = JSONPrintUnformatted(dataPacket);
+    JSONDelete(dataPacket);
+    return string;
 }
\ No newline at end of file
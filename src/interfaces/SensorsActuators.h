@@ -2,6 +2,7 @@
 #define SENSORSACTUATORS_H
 
 #include "../parsers/json.h"
+#include "../parsers/BooleanExpressionParser.h"
 #include <stdio.h>
 
 typedef enum 
@@ -59,6 +60,8 @@ SensorDataPacket* parseSensorDataPackets(char* str, int length, unsigned int* pa
 ActuatorDataPacket* parseActuatorDataPackets(char* str, int length, unsigned int* packetCount);
 JSON* SensorDataPacketToJSON(SensorDataPacket packet);
 JSON* ActuatorDataPacketToJSON(ActuatorDataPacket packet);
+char* serializeSensorDataPacket(SensorDataPacket packet);
+char* serializeActuatorDataPacket(ActuatorDataPacket packet);
 
 Sensor* getSensorWithID(Sensor* sensors, char* id, int sensorcount);
 Actuator* getActuatorWithID(Actuator* actuators, char* id, int actuatorcount);
@@ -72,6 +75,8 @@ char* unbeautifyActuatorValue(JSON* valueJSON, ActuatorType actuatorType);
 void destroySensors(Sensor* sensors, unsigned int sensorCount);
 void destroyActuators(Actuator* actuators, unsigned int actuatorCount);
 
+Variable* createSensorActuatorVariables(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount);
+
 void printSensorData(Sensor sensor);
 void printActuatorData(Actuator actuator);
 
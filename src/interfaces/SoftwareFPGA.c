@@ -0,0 +1,164 @@
+#include "SoftwareFPGA.h"
+#include "../logging/log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+SoftwareFPGA softwareFPGA;
+
+static unsigned long long getTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* clears all pins and counters, the latencies and the loopbacks are kept */
+void resetSoftwareFPGA(void)
+{
+    memset(softwareFPGA.inputs, 0, sizeof(softwareFPGA.inputs));
+    memset(softwareFPGA.outputs, 0, sizeof(softwareFPGA.outputs));
+    memset(softwareFPGA.jtagPins, 0, sizeof(softwareFPGA.jtagPins));
+    softwareFPGA.transfers = 0;
+    softwareFPGA.bytes = 0;
+    softwareFPGA.commands = 0;
+    softwareFPGA.unknownCommands = 0;
+    softwareFPGA.jtagClocks = 0;
+}
+
+/*
+ *  connects output pins to input pins, so the value written to an actuator is read back by a sensor
+ *  mapping -   comma separated pairs of pins, e.g. "48:20,47:21" connects the output 48 to the input 20 and
+ *              the output 47 to the input 21
+ *  returns 1 if the mapping is invalid, the loopbacks are not changed in this case
+ */
+int parseSoftwareFPGALoopback(const char* mapping)
+{
+    unsigned char outputs[SOFTWARE_FPGA_MAX_LOOPBACKS];
+    unsigned char inputs[SOFTWARE_FPGA_MAX_LOOPBACKS];
+    unsigned int count = 0;
+    const char* position = mapping;
+    while (*position != 0)
+    {
+        char* end;
+        unsigned long output = strtoul(position, &end, 10);
+        if (end == position || *end != ':' || output > 255)
+        {
+            log_error("SoftwareFPGA: invalid loopback %s", mapping);
+            return 1;
+        }
+        position = end + 1;
+        unsigned long input = strtoul(position, &end, 10);
+        if (end == position || (*end != ',' && *end != 0) || input > 255 || count == SOFTWARE_FPGA_MAX_LOOPBACKS)
+        {
+            log_error("SoftwareFPGA: invalid loopback %s", mapping);
+            return 1;
+        }
+        outputs[count] = output;
+        inputs[count++] = input;
+        position = *end == ',' ? end + 1 : end;
+    }
+    memcpy(softwareFPGA.loopbackOutputs, outputs, count);
+    memcpy(softwareFPGA.loopbackInputs, inputs, count);
+    softwareFPGA.loopbackCount = count;
+    return 0;
+}
+
+static void writeOutput(unsigned char pin, char value)
+{
+    softwareFPGA.outputs[pin] = value;
+    for (int i = 0; i < softwareFPGA.loopbackCount; i++)
+    {
+        if (softwareFPGA.loopbackOutputs[i] == pin)
+        {
+            softwareFPGA.inputs[softwareFPGA.loopbackInputs[i]] = value;
+        }
+    }
+}
+
+static int beginSoftwareFPGA(void)
+{
+    resetSoftwareFPGA();
+    return 0;
+}
+
+static void endSoftwareFPGA(void)
+{
+}
+
+/*
+ *  executes the commands one after another like the FPGA does while the chip select is active, every byte
+ *  that is not an answer is received as 0. The latency is spent busy waiting, as the bcm2835 library does.
+ */
+static void transferSoftwareFPGA(char* buffer, unsigned int length)
+{
+    unsigned long long end = getTime() + softwareFPGA.transferLatency + softwareFPGA.byteLatency * length;
+    unsigned int i = 0;
+    while (i < length)
+    {
+        unsigned char command = buffer[i];
+        spiCommand read = SPICOMMAND_READ_BINARY;
+        spiCommand write = SPICOMMAND_WRITE_BINARY;
+        if (command == (unsigned char)read.command && i + 1 + read.dataLength + read.answerLength <= length)
+        {
+            unsigned char pin = buffer[i + 1];
+            memset(buffer + i, 0, 1 + read.dataLength);
+            buffer[i + 1 + read.dataLength] = softwareFPGA.inputs[pin];
+            i += 1 + read.dataLength + read.answerLength;
+            softwareFPGA.commands++;
+        }
+        else if (command == (unsigned char)write.command && i + 1 + write.dataLength + write.answerLength <= length)
+        {
+            unsigned char pin = buffer[i + 1];
+            writeOutput(pin, buffer[i + 2]);
+            memset(buffer + i, 0, 1 + write.dataLength + write.answerLength);
+            i += 1 + write.dataLength + write.answerLength;
+            softwareFPGA.commands++;
+        }
+        else
+        {
+            buffer[i++] = 0;
+            softwareFPGA.unknownCommands++;
+        }
+    }
+    softwareFPGA.transfers++;
+    softwareFPGA.bytes += length;
+    while (getTime() < end)
+    {
+    }
+}
+
+/* selected with setSPIBackend(&softwareFPGABackend) */
+const SPIBackend softwareFPGABackend = {"software FPGA", beginSoftwareFPGA, endSoftwareFPGA, transferSoftwareFPGA};
+
+static int beginSoftwareFPGAGPIO(void)
+{
+    return 0;
+}
+
+static void endSoftwareFPGAGPIO(void)
+{
+}
+
+/* counts the clocks of the JTAG port, the bitstream itself is not interpreted */
+static void writeSoftwareFPGAGPIO(int pin, unsigned data)
+{
+    if (pin < 0 || pin >= sizeof(softwareFPGA.jtagPins))
+    {
+        return;
+    }
+    if (pin == TCK && data && !softwareFPGA.jtagPins[pin])
+    {
+        softwareFPGA.jtagClocks++;
+    }
+    softwareFPGA.jtagPins[pin] = data != 0;
+}
+
+/* TDO is not driven, so the expected values of the bitstream are not checked and every bitstream is accepted */
+static int readSoftwareFPGAGPIO(int pin)
+{
+    return pin == TDO ? GPIO_NOT_DRIVEN : softwareFPGA.jtagPins[pin & 31];
+}
+
+/* selected with setGPIOBackend(&softwareFPGAGPIOBackend) */
+const GPIOBackend softwareFPGAGPIOBackend = {"software FPGA", beginSoftwareFPGAGPIO, endSoftwareFPGAGPIO, writeSoftwareFPGAGPIO, readSoftwareFPGAGPIO};
\ No newline at end of file
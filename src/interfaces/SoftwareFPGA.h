@@ -0,0 +1,52 @@
+#ifndef SOFTWAREFPGA_H
+#define SOFTWAREFPGA_H
+
+#include "spi.h"
+#include "../programmer/bcmGPIO.h"
+
+/* the most pairs of pins that can be connected by parseSoftwareFPGALoopback */
+#define SOFTWARE_FPGA_MAX_LOOPBACKS 256
+
+/*
+ *  A model of the FPGA behind the SPI interface and its JTAG port, it answers the binary read and write commands
+ *  of any amount of commands per transfer and accepts every bitstream. Used to run and benchmark the services
+ *  without a Raspberry Pi.
+ *  inputs          -   the values of the sensor pins, read by SPICOMMAND_READ_BINARY
+ *  outputs         -   the values of the actuator pins, written by SPICOMMAND_WRITE_BINARY
+ *  loopbackOutputs -   the output pins which are connected to an input pin, e.g. an actuator driving a sensor
+ *  loopbackInputs  -   the input pin every loopback output is connected to
+ *  loopbackCount   -   the amount of connected pairs of pins
+ *  transfers       -   the amount of transfers so far
+ *  bytes           -   the amount of transferred bytes so far
+ *  commands        -   the amount of executed commands so far
+ *  unknownCommands -   the amount of bytes that did not start a known command
+ *  transferLatency -   the time every transfer takes in ns, e.g. for the chip select and the system call
+ *  byteLatency     -   the additional time every byte takes in ns, 2051 ns at the 3.9 MHz of the bcm2835 backend
+ *  jtagPins        -   the levels of the JTAG pins written by the GPIO backend
+ *  jtagClocks      -   the amount of rising edges of TCK so far
+ */
+typedef struct
+{
+    char                inputs[256];
+    char                outputs[256];
+    unsigned char       loopbackOutputs[SOFTWARE_FPGA_MAX_LOOPBACKS];
+    unsigned char       loopbackInputs[SOFTWARE_FPGA_MAX_LOOPBACKS];
+    unsigned int        loopbackCount;
+    unsigned long long  transfers;
+    unsigned long long  bytes;
+    unsigned long long  commands;
+    unsigned long long  unknownCommands;
+    unsigned long long  transferLatency;
+    unsigned long long  byteLatency;
+    unsigned char       jtagPins[32];
+    unsigned long long  jtagClocks;
+} SoftwareFPGA;
+
+extern SoftwareFPGA softwareFPGA;
+extern const SPIBackend softwareFPGABackend;
+extern const GPIOBackend softwareFPGAGPIOBackend;
+
+void resetSoftwareFPGA(void);
+int parseSoftwareFPGALoopback(const char* mapping);
+
+#endif
\ No newline at end of file
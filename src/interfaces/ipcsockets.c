@@ -146,6 +146,15 @@ IPCSocketConnection* acceptIPCConnection(int fd, IPCMsgHandler messageHandler)
     return connection;
 }
 
+/* writes a number of the message header like serializeInt without allocating */
+static void writeHeaderInt(char* buffer, int num)
+{
+    buffer[0] = num >> 24;
+    buffer[1] = num >> 16;
+    buffer[2] = num >> 8;
+    buffer[3] = num;
+}
+
 /*
  *  Sends a message to the IPC socket specified by ipcsc.
  */
@@ -168,24 +177,14 @@ int sendMessageIPC(IPCSocketConnection* ipcsc, MessageType messageType, char* ms
     pthread_mutex_lock(&ipcsc->mutex);
     for (int i = 0; i < fragments; i++)
     {
-        // prepare buffer for sending the message 
-        char* buffer = malloc(completeLength[i]);
+        // prepare buffer for sending the message, a fragment is small enough for the stack
+        char buffer[MAX_MESSAGE_SIZE];
 
         // prepare message header and build SocketMessage
-        char* type = serializeInt(messageType);
-        char* length = serializeInt(messageLength[i]);
-        char* fragmentNumber = serializeInt(i);
-        char* isLastFragment = serializeInt(i == (fragments-1));
-
-        memcpy(buffer, type, sizeof(int));
-        memcpy(buffer+sizeof(int), length, sizeof(int));
-        memcpy(buffer+sizeof(int)*2, fragmentNumber, sizeof(int));
-        memcpy(buffer+sizeof(int)*3, isLastFragment, sizeof(int));
-
-        free(type);
-        free(length);
-        free(fragmentNumber);
-        free(isLastFragment);
+        writeHeaderInt(buffer, messageType);
+        writeHeaderInt(buffer+sizeof(int), messageLength[i]);
+        writeHeaderInt(buffer+sizeof(int)*2, i);
+        writeHeaderInt(buffer+sizeof(int)*3, i == (fragments-1));
 
         // copy message into buffer
         memcpy(buffer+MESSAGE_HEADER_SIZE, msg+i*(MAX_MESSAGE_SIZE-MESSAGE_HEADER_SIZE), messageLength[i]);
@@ -197,13 +196,11 @@ int sendMessageIPC(IPCSocketConnection* ipcsc, MessageType messageType, char* ms
             {
                 log_error("write error: %s", strerror(errno));
                 //perror("write error");
-                free(buffer);
                 return -1;
             }
         }
         
         //printf("TYPE:    %d\nLENGTH:  %d\nCONTENT: %s\n", messageType, messageLength, msg);
-        free(buffer);
     }
     pthread_mutex_unlock(&ipcsc->mutex);
 
@@ -247,6 +244,26 @@ unsigned int hasMessages(IPCSocketConnection* ipcsc)
     return count;
 }
 
+/*
+ *  Sleeps until data arrives on the IPC socket or the timeout (in ms, -1 for none) expires, returns the amount
+ *  of available bytes like hasMessages. A connection closed by the other side is marked as not open.
+ */
+unsigned int waitForMessages(IPCSocketConnection* ipcsc, int timeout)
+{
+    struct pollfd socketPoll = {ipcsc->fd, POLLIN, 0};
+    if (poll(&socketPoll, 1, timeout) <= 0)
+    {
+        return 0;
+    }
+    unsigned int count = hasMessages(ipcsc);
+    if (count == 0 && (socketPoll.revents & (POLLHUP | POLLERR | POLLNVAL)))
+    {
+        log_info("IPC connection has been closed by the other side");
+        ipcsc->open = 0;
+    }
+    return count;
+}
+
 /*
  *  Receives a SocketMessage from the IPC socket specified by ipcsc.
  */
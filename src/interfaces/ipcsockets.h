@@ -5,6 +5,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <systemd/sd-daemon.h>
 #include <string.h>
@@ -23,6 +24,9 @@
 #define MAX_MESSAGE_SIZE 64
 #define MESSAGE_HEADER_SIZE 16
 
+/* the maximum time in ms a message handler sleeps in waitForMessages before checking its connection again */
+#define IPC_WAIT_TIMEOUT 100
+
 /*
  *  Describes a connection to another Service via an IPC socket:
  *  fd - File Descriptor of the open socket
@@ -78,7 +82,10 @@ typedef enum
     IPCMSGTYPE_PROGRAMCONTROLUNITFINISHED           = 35,
     IPCMSGTYPE_EXPERIMENTINIT                       = 36,
     IPCMSGTYPE_STOPCOMMANDSERVICE                   = 37,
-    IPCMSGTYPE_RETURNCOMMANDSERVICE                 = 38
+    IPCMSGTYPE_RETURNCOMMANDSERVICE                 = 38,
+    IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE           = 39,
+    IPCMSGTYPE_INITINITIALIZATIONIMAGE              = 40,
+    IPCMSGTYPE_PROTECTIONPROFILE                    = 41
 } MessageType;
 
 /*
@@ -100,5 +107,6 @@ int sendMessageIPC(IPCSocketConnection* ipcsc, MessageType messageType, char* ms
 Message receiveMessageIPC(IPCSocketConnection* ipcsc);
 void closeIPCConnection(IPCSocketConnection* ipcsc);
 unsigned int hasMessages(IPCSocketConnection* ipcsc);
+unsigned int waitForMessages(IPCSocketConnection* ipcsc, int timeout);
 
 #endif
\ No newline at end of file
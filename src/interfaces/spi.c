@@ -1,8 +1,10 @@
 #include "spi.h"
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
 #include "../logging/log.h"
 
-int setupSPIInterface()
+static int beginBCM2835SPI(void)
 {
     if (!bcm2835_init())
     {
@@ -19,12 +21,44 @@ int setupSPIInterface()
     return 0;
 }
 
-void closeSPIInterface()
+static void endBCM2835SPI(void)
 {
     bcm2835_spi_end();
     bcm2835_close();
 }
 
+static void transferBCM2835SPI(char* buffer, unsigned int length)
+{
+    bcm2835_spi_transfern(buffer, length);
+}
+
+/* the SPI interface of the Raspberry Pi connected to the FPGA */
+const SPIBackend bcm2835SPIBackend = {"bcm2835", beginBCM2835SPI, endBCM2835SPI, transferBCM2835SPI};
+
+static const SPIBackend* spiBackend = &bcm2835SPIBackend;
+
+/* selects the backend used for all transfers, has to be called before setupSPIInterface */
+void setSPIBackend(const SPIBackend* backend)
+{
+    spiBackend = backend;
+}
+
+const SPIBackend* getSPIBackend(void)
+{
+    return spiBackend;
+}
+
+int setupSPIInterface()
+{
+    log_info("SPI: using the %s backend", spiBackend->name);
+    return spiBackend->begin();
+}
+
+void closeSPIInterface()
+{
+    spiBackend->end();
+}
+
 spiCommand SensorTypeToSPICommandRead(SensorType sensorType)
 {
     switch (sensorType)
@@ -79,13 +113,9 @@ spiCommand ActuatorTypeToSPICommandWrite(ActuatorType actuatorType)
 
 int executeSPICommand(spiCommand command, unsigned char pinMapping, char* value, pthread_mutex_t* mutex)
 {
+    /* the commands are only a few bytes long, they are built on the stack so the control loop never allocates */
     int completeCommandLength = 1 + command.dataLength + command.answerLength;
-    char* completeCommand = malloc(completeCommandLength);
-    if (completeCommand == NULL)
-    {
-        log_error("SPI: error occurred during malloc");
-        return -1;
-    }
+    char completeCommand[completeCommandLength];
 
     completeCommand[0] = command.command;
     completeCommand[1] = pinMapping;
@@ -96,7 +126,7 @@ int executeSPICommand(spiCommand command, unsigned char pinMapping, char* value,
     }
 
     pthread_mutex_lock(mutex);
-    bcm2835_spi_transfern(completeCommand, completeCommandLength);
+    spiBackend->transfer(completeCommand, completeCommandLength);
     pthread_mutex_unlock(mutex);
 
     if (command.answerLength > 0)
@@ -106,7 +136,6 @@ int executeSPICommand(spiCommand command, unsigned char pinMapping, char* value,
             value[i] = completeCommand[completeCommandLength - command.answerLength + i];
         }
     }
-    free(completeCommand);
     return 0;
 }
 
@@ -134,3 +163,184 @@ int SPIWriteActuator(Actuator* actuator, pthread_mutex_t* mutex)
     spiCommand command = ActuatorTypeToSPICommandWrite(actuator->type);
     return executeSPICommand(command, actuator->pinMapping, actuator->value, mutex);
 }
+
+/* returns the length of a command with its data and answer */
+static unsigned int getSPICommandLength(spiCommand command)
+{
+    return 1 + command.dataLength + command.answerLength;
+}
+
+/*
+ *  creates a frame reading all sensors that have a read command, up to every actuator can be written by it too
+ *  returns NULL on error
+ */
+SPIFrame* createSPIFrame(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    SPIFrame* frame = calloc(1, sizeof(*frame));
+    if (frame == NULL)
+    {
+        log_error("SPI: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    unsigned int writeLength = 0;
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        writeLength += getSPICommandLength(ActuatorTypeToSPICommandWrite(actuators[i].type));
+    }
+    for (int i = 0; i < sensorCount; i++)
+    {
+        frame->readLength += getSPICommandLength(SensorTypeToSPICommandRead(sensors[i].type));
+    }
+    frame->capacity = frame->readLength + writeLength;
+    frame->commands = malloc(frame->readLength + 1);
+    frame->buffer = malloc(frame->capacity + 1);
+    frame->sensors = malloc(sizeof(*frame->sensors) * (sensorCount + 1));
+    frame->answerOffsets = malloc(sizeof(*frame->answerOffsets) * (sensorCount + 1));
+    if (frame->commands == NULL || frame->buffer == NULL || frame->sensors == NULL || frame->answerOffsets == NULL)
+    {
+        log_error("SPI: malloc error %s", strerror(errno));
+        destroySPIFrame(frame);
+        return NULL;
+    }
+
+    unsigned int offset = 0;
+    for (int i = 0; i < sensorCount; i++)
+    {
+        spiCommand command = SensorTypeToSPICommandRead(sensors[i].type);
+        if (command.answerLength == 0)
+        {
+            continue;
+        }
+        frame->commands[offset] = command.command;
+        frame->commands[offset + 1] = sensors[i].pinMapping;
+        memset(frame->commands + offset + 2, 0, getSPICommandLength(command) - 2);
+        frame->sensors[frame->readCount] = &sensors[i];
+        frame->answerOffsets[frame->readCount++] = offset + 1 + command.dataLength;
+        offset += getSPICommandLength(command);
+    }
+    frame->readLength = offset;
+    frame->length = offset;
+    return frame;
+}
+
+/*
+ *  creates a frame that writes the stop value of every actuator with every transfer, built once so stopping only
+ *  has to transfer it
+ *  returns NULL on error
+ */
+SPIFrame* createSPIStopFrame(Actuator* actuators, unsigned int actuatorCount)
+{
+    SPIFrame* frame = createSPIFrame(NULL, 0, actuators, actuatorCount);
+    if (frame == NULL)
+    {
+        return NULL;
+    }
+    frame->commandOffsets = malloc(sizeof(*frame->commandOffsets) * (actuatorCount + 1));
+    if (frame->commandOffsets == NULL)
+    {
+        log_error("SPI: malloc error %s", strerror(errno));
+        destroySPIFrame(frame);
+        return NULL;
+    }
+    for (int i = 0; i < actuatorCount; i++)
+    {
+        Actuator stoppedActuator = actuators[i];
+        stoppedActuator.value = stoppedActuator.stopValue;
+        unsigned int offset = frame->length;
+        if (!stageSPIFrameWrite(frame, &stoppedActuator))
+        {
+            frame->commandOffsets[frame->commandCount++] = offset;
+        }
+    }
+    frame->commandOffsets[frame->commandCount] = frame->length;
+    /* the staged writes become the commands, so the answers of a transfer never replace them */
+    char* commands = realloc(frame->commands, frame->length + 1);
+    if (commands == NULL)
+    {
+        log_error("SPI: malloc error %s", strerror(errno));
+        destroySPIFrame(frame);
+        return NULL;
+    }
+    frame->commands = commands;
+    memcpy(frame->commands, frame->buffer, frame->length);
+    frame->readLength = frame->length;
+    frame->writeCount = 0;
+    return frame;
+}
+
+/*
+ *  appends a write of the current value of the actuator to the next transfer, every actuator must only be staged
+ *  once per transfer. Returns 1 if the actuator has no write command.
+ */
+int stageSPIFrameWrite(SPIFrame* frame, Actuator* actuator)
+{
+    spiCommand command = ActuatorTypeToSPICommandWrite(actuator->type);
+    unsigned int length = getSPICommandLength(command);
+    if (command.dataLength == 0 || frame->length + length > frame->capacity)
+    {
+        return 1;
+    }
+    frame->buffer[frame->length] = command.command;
+    frame->buffer[frame->length + 1] = actuator->pinMapping;
+    memcpy(frame->buffer + frame->length + 2, actuator->value, command.dataLength - 1);
+    memset(frame->buffer + frame->length + 1 + command.dataLength, 0, command.answerLength);
+    frame->length += length;
+    frame->writeCount++;
+    return 0;
+}
+
+/* discards all staged writes */
+void clearSPIFrameWrites(SPIFrame* frame)
+{
+    frame->length = frame->readLength;
+    frame->writeCount = 0;
+}
+
+/*
+ *  reads all sensors and writes the staged actuators in one transfer, the answers are written to the values of
+ *  the sensors and the staged writes are cleared
+ */
+int transferSPIFrame(SPIFrame* frame, pthread_mutex_t* mutex)
+{
+    memcpy(frame->buffer, frame->commands, frame->readLength);
+    pthread_mutex_lock(mutex);
+    spiBackend->transfer(frame->buffer, frame->length);
+    pthread_mutex_unlock(mutex);
+    for (int i = 0; i < frame->readCount; i++)
+    {
+        Sensor* sensor = frame->sensors[i];
+        memcpy(sensor->value, frame->buffer + frame->answerOffsets[i], SensorTypeToSPICommandRead(sensor->type).answerLength);
+    }
+    clearSPIFrameWrites(frame);
+    return 0;
+}
+
+/*
+ *  sends the writes of a stop frame like transferSPIFrame, but every write in its own transfer like the single
+ *  writes of SPIWriteActuator, for a bus that is not used with frames. The commands are still built only once.
+ */
+int transferSPIFrameCommands(SPIFrame* frame, pthread_mutex_t* mutex)
+{
+    memcpy(frame->buffer, frame->commands, frame->readLength);
+    pthread_mutex_lock(mutex);
+    for (int i = 0; i < frame->commandCount; i++)
+    {
+        spiBackend->transfer(frame->buffer + frame->commandOffsets[i], frame->commandOffsets[i + 1] - frame->commandOffsets[i]);
+    }
+    pthread_mutex_unlock(mutex);
+    return 0;
+}
+
+void destroySPIFrame(SPIFrame* frame)
+{
+    if (frame == NULL)
+    {
+        return;
+    }
+    free(frame->commands);
+    free(frame->buffer);
+    free(frame->sensors);
+    free(frame->answerOffsets);
+    free(frame->commandOffsets);
+    free(frame);
+}
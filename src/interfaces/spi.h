@@ -24,7 +24,56 @@ typedef struct spiAnswer_s
     unsigned int    length;
 } spiAnswer;
 
+/*
+ *  executes the SPI transfers, the bcm2835 backend is used unless another one is set before setupSPIInterface
+ *  name        -   the name of the backend used in logs
+ *  begin       -   initializes the interface, returns 1 on error
+ *  end         -   closes the interface
+ *  transfer    -   sends the given bytes and replaces them by the received ones
+ */
+typedef struct
+{
+    const char* name;
+    int         (*begin)(void);
+    void        (*end)(void);
+    void        (*transfer)(char* buffer, unsigned int length);
+} SPIBackend;
+
+/*
+ *  A frame reading all sensors and writing the staged actuators in a single transfer. The commands are the
+ *  same as for the single transfers, they are sent back to back while the chip select is active.
+ *  commands        -   the commands sent with every transfer, copied to the start of the buffer before it: the read
+ *                      commands of all sensors, or the writes of the stop values in a stop frame
+ *  readLength      -   the length of the commands
+ *  buffer          -   the frame, contains the answers after the transfer
+ *  length          -   the length of the frame including the staged writes
+ *  capacity        -   the size of the buffer, large enough to write every actuator once
+ *  sensors         -   the sensor of every read command
+ *  answerOffsets   -   the offset of the answer of every read command
+ *  readCount       -   the amount of read commands
+ *  writeCount      -   the amount of staged writes
+ *  commandOffsets  -   the offset of every write of a stop frame followed by the end of the last one, NULL otherwise
+ *  commandCount    -   the amount of writes of a stop frame
+ */
+typedef struct
+{
+    char*           commands;
+    unsigned int    readLength;
+    char*           buffer;
+    unsigned int    length;
+    unsigned int    capacity;
+    Sensor**        sensors;
+    unsigned int*   answerOffsets;
+    unsigned int    readCount;
+    unsigned int    writeCount;
+    unsigned int*   commandOffsets;
+    unsigned int    commandCount;
+} SPIFrame;
+
+extern const SPIBackend bcm2835SPIBackend;
 
+void setSPIBackend(const SPIBackend* backend);
+const SPIBackend* getSPIBackend(void);
 int setupSPIInterface();
 void closeSPIInterface();
 int SPIReadSensor(Sensor* sensor, pthread_mutex_t* mutex);
@@ -32,5 +81,13 @@ int SPIReadActuator(Actuator* actuator, pthread_mutex_t* mutex);
 int SPIWriteSensor(Sensor* sensor, pthread_mutex_t* mutex);
 int SPIWriteActuator(Actuator* actuator, pthread_mutex_t* mutex);
 
+SPIFrame* createSPIFrame(Sensor* sensors, unsigned int sensorCount, Actuator* actuators, unsigned int actuatorCount);
+SPIFrame* createSPIStopFrame(Actuator* actuators, unsigned int actuatorCount);
+int stageSPIFrameWrite(SPIFrame* frame, Actuator* actuator);
+void clearSPIFrameWrites(SPIFrame* frame);
+int transferSPIFrame(SPIFrame* frame, pthread_mutex_t* mutex);
+int transferSPIFrameCommands(SPIFrame* frame, pthread_mutex_t* mutex);
+void destroySPIFrame(SPIFrame* frame);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,587 @@
+#include "BDDRuleEngine.h"
+#include <limits.h>
+#include "../logging/log.h"
+
+/* returned instead of a node if the diagram could not be created */
+#define BDD_INVALID UINT_MAX
+
+/* the operators that can be applied to two diagrams */
+typedef enum
+{
+    BDDOperatorAND,
+    BDDOperatorOR,
+    BDDOperatorXOR,
+    BDDOperatorIMPLIES
+} BDDOperator;
+
+/* returns the input tested by the node, the terminals are ordered after all inputs */
+static unsigned int getNodeInput(BDDRuleEngine* engine, unsigned int node)
+{
+    return node <= BDD_TRUE ? UINT_MAX : engine->nodes[node].input;
+}
+
+static unsigned int hashNode(unsigned int input, unsigned int low, unsigned int high)
+{
+    unsigned int hash = input * 2654435761u;
+    hash ^= low * 2246822519u + (hash << 6) + (hash >> 2);
+    hash ^= high * 3266489917u + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+/* doubles the unique table and moves all nodes into their new buckets */
+static int growUniqueTable(BDDRuleEngine* engine)
+{
+    unsigned int bucketCount = engine->bucketCount * 2;
+    unsigned int* buckets = calloc(bucketCount, sizeof(*buckets));
+    if (buckets == NULL)
+    {
+        log_error("BDDRuleEngine: malloc error %s", strerror(errno));
+        return 1;
+    }
+    for (unsigned int i = BDD_TRUE + 1; i < engine->nodeCount; i++)
+    {
+        BDDNode* node = &engine->nodes[i];
+        unsigned int bucket = hashNode(node->input, node->low, node->high) & (bucketCount - 1);
+        node->next = buckets[bucket];
+        buckets[bucket] = i;
+    }
+    free(engine->buckets);
+    engine->buckets = buckets;
+    engine->bucketCount = bucketCount;
+    return 0;
+}
+
+/* returns the node testing input with the given successors, every node exists only once */
+static unsigned int makeNode(BDDRuleEngine* engine, unsigned int input, unsigned int low, unsigned int high)
+{
+    if (low == high)
+    {
+        return low;
+    }
+    unsigned int bucket = hashNode(input, low, high) & (engine->bucketCount - 1);
+    for (unsigned int node = engine->buckets[bucket]; node != 0; node = engine->nodes[node].next)
+    {
+        if (engine->nodes[node].input == input && engine->nodes[node].low == low && engine->nodes[node].high == high)
+        {
+            return node;
+        }
+    }
+
+    if (engine->nodeCount == engine->nodeCapacity)
+    {
+        if (engine->nodeCapacity >= BDDRULEENGINE_MAX_NODES)
+        {
+            return BDD_INVALID;
+        }
+        BDDNode* nodes = realloc(engine->nodes, sizeof(*nodes) * engine->nodeCapacity * 2);
+        if (nodes == NULL)
+        {
+            log_error("BDDRuleEngine: malloc error %s", strerror(errno));
+            return BDD_INVALID;
+        }
+        engine->nodes = nodes;
+        engine->nodeCapacity *= 2;
+    }
+    unsigned int node = engine->nodeCount++;
+    engine->nodes[node] = (BDDNode){input, low, high, engine->buckets[bucket]};
+    engine->buckets[bucket] = node;
+    if (engine->nodeCount > engine->bucketCount && growUniqueTable(engine))
+    {
+        return BDD_INVALID;
+    }
+    return node;
+}
+
+/* combines two diagrams with the given operator */
+static unsigned int applyOperator(BDDRuleEngine* engine, BDDOperator operator, unsigned int left, unsigned int right)
+{
+    if (left == BDD_INVALID || right == BDD_INVALID)
+    {
+        return BDD_INVALID;
+    }
+    switch (operator)
+    {
+        case BDDOperatorAND:
+            if (left == BDD_FALSE || right == BDD_FALSE)
+            {
+                return BDD_FALSE;
+            }
+            if (left == BDD_TRUE || left == right)
+            {
+                return right;
+            }
+            if (right == BDD_TRUE)
+            {
+                return left;
+            }
+            break;
+
+        case BDDOperatorOR:
+            if (left == BDD_TRUE || right == BDD_TRUE)
+            {
+                return BDD_TRUE;
+            }
+            if (left == BDD_FALSE || left == right)
+            {
+                return right;
+            }
+            if (right == BDD_FALSE)
+            {
+                return left;
+            }
+            break;
+
+        default:
+            if (left == right)
+            {
+                return BDD_FALSE;
+            }
+            if (left == BDD_FALSE)
+            {
+                return right;
+            }
+            if (right == BDD_FALSE)
+            {
+                return left;
+            }
+            break;
+    }
+
+    /* all operators are commutative */
+    if (left > right)
+    {
+        unsigned int swap = left;
+        left = right;
+        right = swap;
+    }
+    unsigned int* entry = &engine->cache[4 * (hashNode(operator, left, right) & (BDDRULEENGINE_CACHE_SIZE - 1))];
+    if (entry[0] == operator && entry[1] == left && entry[2] == right)
+    {
+        return entry[3];
+    }
+    if (++engine->operations > BDDRULEENGINE_MAX_OPERATIONS)
+    {
+        return BDD_INVALID;
+    }
+
+    unsigned int leftInput = getNodeInput(engine, left);
+    unsigned int rightInput = getNodeInput(engine, right);
+    unsigned int input = leftInput < rightInput ? leftInput : rightInput;
+    unsigned int leftLow = leftInput == input ? engine->nodes[left].low : left;
+    unsigned int leftHigh = leftInput == input ? engine->nodes[left].high : left;
+    unsigned int rightLow = rightInput == input ? engine->nodes[right].low : right;
+    unsigned int rightHigh = rightInput == input ? engine->nodes[right].high : right;
+    unsigned int low = applyOperator(engine, operator, leftLow, rightLow);
+    unsigned int high = applyOperator(engine, operator, leftHigh, rightHigh);
+    if (low == BDD_INVALID || high == BDD_INVALID)
+    {
+        return BDD_INVALID;
+    }
+    unsigned int result = makeNode(engine, input, low, high);
+    entry[0] = operator;
+    entry[1] = left;
+    entry[2] = right;
+    entry[3] = result;
+    return result;
+}
+
+/* returns the index of the input for the variable or comparison, the input is added if it is new */
+static int getInputIndex(BDDRuleEngine* engine, const char* value, BooleanExpression* comparison, unsigned int* inputCapacity)
+{
+    for (unsigned int i = 0; i < engine->inputCount; i++)
+    {
+        if (engine->inputs[i].value == value && engine->inputs[i].comparison == comparison)
+        {
+            return i;
+        }
+    }
+    if (engine->inputCount == *inputCapacity)
+    {
+        BDDInput* inputs = realloc(engine->inputs, sizeof(*inputs) * (*inputCapacity) * 2);
+        if (inputs == NULL)
+        {
+            log_error("BDDRuleEngine: malloc error %s", strerror(errno));
+            return -1;
+        }
+        engine->inputs = inputs;
+        *inputCapacity *= 2;
+    }
+    engine->inputs[engine->inputCount] = (BDDInput){value, comparison, 0};
+    return engine->inputCount++;
+}
+
+/* adds all inputs of the expression and counts how often they are used */
+static int collectInputs(BDDRuleEngine* engine, BooleanExpression* expression, unsigned int* inputCapacity)
+{
+    if (expression == NULL)
+    {
+        return 1;
+    }
+    int input;
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
+            return 0;
+
+        case BoolExprNOT:
+            return collectInputs(engine, expression->leftside, inputCapacity);
+
+        case BoolExprAND:
+        case BoolExprOR:
+            return collectInputs(engine, expression->leftside, inputCapacity) || collectInputs(engine, expression->rightside, inputCapacity);
+
+        case BoolExprVARIABLE:
+            input = expression->value == NULL ? -1 : getInputIndex(engine, expression->value, NULL, inputCapacity);
+            break;
+
+        default:
+            input = getInputIndex(engine, NULL, expression, inputCapacity);
+            break;
+    }
+    if (input < 0)
+    {
+        return 1;
+    }
+    engine->inputs[input].occurrences++;
+    return 0;
+}
+
+/*
+ *  orders the inputs by how often they are used, inputs used equally often keep the order of their first
+ *  appearance. Testing inputs shared by many rules first keeps the diagrams small.
+ */
+static void orderInputs(BDDRuleEngine* engine)
+{
+    for (unsigned int i = 1; i < engine->inputCount; i++)
+    {
+        BDDInput input = engine->inputs[i];
+        unsigned int j = i;
+        while (j > 0 && engine->inputs[j - 1].occurrences < input.occurrences)
+        {
+            engine->inputs[j] = engine->inputs[j - 1];
+            j--;
+        }
+        engine->inputs[j] = input;
+    }
+}
+
+/*
+ *  converts the expression into a diagram, the inputs have to be collected before. Comparisons
+ *  become inputs of their own, identical comparisons of different rules are treated as different inputs.
+ */
+static unsigned int buildDiagram(BDDRuleEngine* engine, BooleanExpression* expression, unsigned int* inputCapacity)
+{
+    if (expression == NULL)
+    {
+        return BDD_INVALID;
+    }
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
+            return expression->value != NULL && expression->value[0] != 0 ? BDD_TRUE : BDD_FALSE;
+
+        case BoolExprVARIABLE:
+        {
+            int input = expression->value == NULL ? -1 : getInputIndex(engine, expression->value, NULL, inputCapacity);
+            return input < 0 ? BDD_INVALID : makeNode(engine, input, BDD_FALSE, BDD_TRUE);
+        }
+
+        case BoolExprNOT:
+            return applyOperator(engine, BDDOperatorXOR, buildDiagram(engine, expression->leftside, inputCapacity), BDD_TRUE);
+
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            unsigned int left = buildDiagram(engine, expression->leftside, inputCapacity);
+            unsigned int right = buildDiagram(engine, expression->rightside, inputCapacity);
+            return applyOperator(engine, expression->type == BoolExprAND ? BDDOperatorAND : BDDOperatorOR, left, right);
+        }
+
+        default:
+        {
+            int input = getInputIndex(engine, NULL, expression, inputCapacity);
+            return input < 0 ? BDD_INVALID : makeNode(engine, input, BDD_FALSE, BDD_TRUE);
+        }
+    }
+}
+
+/* removes all nodes created after nodeCount, no older node refers to them */
+static void removeNodesAfter(BDDRuleEngine* engine, unsigned int nodeCount)
+{
+    engine->nodeCount = nodeCount;
+    memset(engine->buckets, 0, sizeof(*engine->buckets) * engine->bucketCount);
+    for (unsigned int i = BDD_TRUE + 1; i < engine->nodeCount; i++)
+    {
+        BDDNode* node = &engine->nodes[i];
+        unsigned int bucket = hashNode(node->input, node->low, node->high) & (engine->bucketCount - 1);
+        node->next = engine->buckets[bucket];
+        engine->buckets[bucket] = i;
+    }
+    memset(engine->cache, 0xff, sizeof(*engine->cache) * 4 * BDDRULEENGINE_CACHE_SIZE);
+}
+
+/* returns whether left implies right, without creating any nodes */
+static unsigned int implies(BDDRuleEngine* engine, unsigned int left, unsigned int right)
+{
+    if (left == BDD_FALSE || right == BDD_TRUE || left == right)
+    {
+        return 1;
+    }
+    /* reduced diagrams other than the terminals are neither always false nor always true */
+    if (left == BDD_TRUE || right == BDD_FALSE)
+    {
+        return 0;
+    }
+    unsigned int* entry = &engine->cache[4 * (hashNode(BDDOperatorIMPLIES, left, right) & (BDDRULEENGINE_CACHE_SIZE - 1))];
+    if (entry[0] == BDDOperatorIMPLIES && entry[1] == left && entry[2] == right)
+    {
+        return entry[3];
+    }
+    unsigned int leftInput = getNodeInput(engine, left);
+    unsigned int rightInput = getNodeInput(engine, right);
+    unsigned int input = leftInput < rightInput ? leftInput : rightInput;
+    unsigned int result = implies(engine, leftInput == input ? engine->nodes[left].low : left, rightInput == input ? engine->nodes[right].low : right) &&
+                          implies(engine, leftInput == input ? engine->nodes[left].high : left, rightInput == input ? engine->nodes[right].high : right);
+    entry[0] = BDDOperatorIMPLIES;
+    entry[1] = left;
+    entry[2] = right;
+    entry[3] = result;
+    return result;
+}
+
+/*
+ *  marks the rules that imply the disjunction of the other rules as redundant, of a group of equivalent
+ *  rules the first one is kept. Returns 1 if the disjunctions need too many nodes.
+ */
+static int findCoveredRules(BDDRuleEngine* engine)
+{
+    unsigned int following[engine->ruleCount + 1];
+    following[engine->ruleCount] = BDD_FALSE;
+    for (int i = (int)engine->ruleCount - 1; i >= 0; i--)
+    {
+        following[i] = applyOperator(engine, BDDOperatorOR, engine->rules[i], following[i + 1]);
+        if (following[i] == BDD_INVALID)
+        {
+            return 1;
+        }
+    }
+
+    unsigned int required = BDD_FALSE;
+    for (unsigned int i = 0; i < engine->ruleCount; i++)
+    {
+        if (engine->status[i] == BDDRuleNeverTriggered)
+        {
+            continue;
+        }
+        unsigned int others = applyOperator(engine, BDDOperatorOR, required, following[i + 1]);
+        if (others == BDD_INVALID)
+        {
+            return 1;
+        }
+        if (implies(engine, engine->rules[i], others))
+        {
+            engine->status[i] = BDDRuleRedundant;
+        }
+        else
+        {
+            required = applyOperator(engine, BDDOperatorOR, required, engine->rules[i]);
+        }
+    }
+    return required == BDD_INVALID;
+}
+
+/*
+ *  marks the rules that imply a single other rule as redundant, used if the disjunctions of the other rules
+ *  are too large. A rule is only compared with later rules and with earlier rules that are kept, so one rule
+ *  of every group of equivalent rules is kept.
+ */
+static void findImpliedRules(BDDRuleEngine* engine)
+{
+    for (unsigned int i = 0; i < engine->ruleCount; i++)
+    {
+        for (unsigned int j = 0; j < engine->ruleCount && engine->status[i] == BDDRuleRequired; j++)
+        {
+            if (j != i && engine->status[j] == BDDRuleRequired && implies(engine, engine->rules[i], engine->rules[j]))
+            {
+                engine->status[i] = BDDRuleRedundant;
+            }
+        }
+    }
+}
+
+/*
+ *  builds the disjunction of all rules and finds out which rules can never trigger and which rules only
+ *  trigger together with other rules. Returns 1 if the disjunction needs too many nodes.
+ */
+static int analyzeRules(BDDRuleEngine* engine)
+{
+    engine->anyRule = BDD_FALSE;
+    for (unsigned int i = 0; i < engine->ruleCount; i++)
+    {
+        engine->status[i] = engine->rules[i] == BDD_FALSE ? BDDRuleNeverTriggered : BDDRuleRequired;
+        engine->anyRule = applyOperator(engine, BDDOperatorOR, engine->anyRule, engine->rules[i]);
+    }
+    if (engine->anyRule == BDD_INVALID)
+    {
+        return 1;
+    }
+
+    /* the nodes of the analysis are not needed for the evaluation */
+    unsigned int nodeCount = engine->nodeCount;
+    if (findCoveredRules(engine))
+    {
+        log_debug("BDDRuleEngine: the rules are too large to compare them with the disjunction of the other rules");
+        removeNodesAfter(engine, nodeCount);
+        for (unsigned int i = 0; i < engine->ruleCount; i++)
+        {
+            engine->status[i] = engine->status[i] == BDDRuleRedundant ? BDDRuleRequired : engine->status[i];
+        }
+        findImpliedRules(engine);
+    }
+    else
+    {
+        removeNodesAfter(engine, nodeCount);
+    }
+
+    for (unsigned int i = 0; i < engine->ruleCount; i++)
+    {
+        engine->neverTriggered += engine->status[i] == BDDRuleNeverTriggered;
+        engine->redundant += engine->status[i] == BDDRuleRedundant;
+    }
+    return 0;
+}
+
+BDDRuleEngine* createBDDRuleEngine(BooleanExpression** expressions, unsigned int ruleCount)
+{
+    BDDRuleEngine* engine = calloc(1, sizeof(*engine));
+    if (engine == NULL)
+    {
+        log_error("BDDRuleEngine: malloc error %s", strerror(errno));
+        return NULL;
+    }
+
+    unsigned int inputCapacity = 16;
+    engine->ruleCount = ruleCount;
+    engine->nodeCapacity = 1024;
+    engine->nodeCount = BDD_TRUE + 1;
+    engine->bucketCount = 1024;
+    engine->nodes = malloc(sizeof(*engine->nodes) * engine->nodeCapacity);
+    engine->buckets = calloc(engine->bucketCount, sizeof(*engine->buckets));
+    engine->cache = malloc(sizeof(*engine->cache) * 4 * BDDRULEENGINE_CACHE_SIZE);
+    engine->inputs = malloc(sizeof(*engine->inputs) * inputCapacity);
+    engine->rules = malloc(sizeof(*engine->rules) * (ruleCount > 0 ? ruleCount : 1));
+    engine->status = calloc(ruleCount > 0 ? ruleCount : 1, sizeof(*engine->status));
+    engine->results = calloc(ruleCount > 0 ? ruleCount : 1, sizeof(*engine->results));
+    if (engine->nodes == NULL || engine->buckets == NULL || engine->cache == NULL || engine->inputs == NULL ||
+        engine->rules == NULL || engine->status == NULL || engine->results == NULL)
+    {
+        log_error("BDDRuleEngine: malloc error %s", strerror(errno));
+        destroyBDDRuleEngine(engine);
+        return NULL;
+    }
+    /* no operation uses UINT_MAX as operator, so the cache starts out empty */
+    memset(engine->cache, 0xff, sizeof(*engine->cache) * 4 * BDDRULEENGINE_CACHE_SIZE);
+    engine->nodes[BDD_FALSE] = (BDDNode){UINT_MAX, BDD_FALSE, BDD_FALSE, 0};
+    engine->nodes[BDD_TRUE] = (BDDNode){UINT_MAX, BDD_TRUE, BDD_TRUE, 0};
+
+    for (unsigned int i = 0; i < ruleCount; i++)
+    {
+        if (collectInputs(engine, expressions[i], &inputCapacity))
+        {
+            log_error("BDDRuleEngine: the inputs of rule %u could not be collected", i);
+            destroyBDDRuleEngine(engine);
+            return NULL;
+        }
+    }
+    orderInputs(engine);
+    for (unsigned int i = 0; i < ruleCount; i++)
+    {
+        engine->rules[i] = buildDiagram(engine, expressions[i], &inputCapacity);
+        if (engine->rules[i] == BDD_INVALID)
+        {
+            log_error("BDDRuleEngine: rule %u could not be converted, the diagrams are too large", i);
+            destroyBDDRuleEngine(engine);
+            return NULL;
+        }
+    }
+    if (analyzeRules(engine))
+    {
+        log_error("BDDRuleEngine: the disjunction of the rules is too large");
+        destroyBDDRuleEngine(engine);
+        return NULL;
+    }
+
+    free(engine->cache);
+    engine->cache = NULL;
+    log_debug("BDDRuleEngine: %u rules over %u inputs use %u nodes", ruleCount, engine->inputCount, engine->nodeCount);
+    return engine;
+}
+
+/* returns the value of an input */
+static inline unsigned int readInput(BDDRuleEngine* engine, unsigned int input)
+{
+    BDDInput* current = &engine->inputs[input];
+    if (current->comparison == NULL)
+    {
+        return current->value[0] != 0;
+    }
+    return evaluateBooleanExpression(current->comparison) == 1;
+}
+
+/* walks through the diagram with the current inputs, every input is tested at most once */
+static inline unsigned int walkDiagram(BDDRuleEngine* engine, unsigned int node)
+{
+    while (node > BDD_TRUE)
+    {
+        BDDNode* current = &engine->nodes[node];
+        node = readInput(engine, current->input) ? current->high : current->low;
+    }
+    return node;
+}
+
+/*
+ *  evaluates all rules, as long as no rule triggers only the diagram of their disjunction is walked
+ *  returns the amount of triggered rules
+ */
+unsigned int evaluateBDDRuleEngine(BDDRuleEngine* engine)
+{
+    if (walkDiagram(engine, engine->anyRule) == BDD_FALSE)
+    {
+        if (engine->triggered > 0)
+        {
+            memset(engine->results, 0, engine->ruleCount);
+            engine->triggered = 0;
+        }
+        return 0;
+    }
+
+    /* redundant rules are evaluated as well, so every triggered rule is reported */
+    engine->triggered = 0;
+    for (unsigned int i = 0; i < engine->ruleCount; i++)
+    {
+        engine->results[i] = engine->status[i] != BDDRuleNeverTriggered && walkDiagram(engine, engine->rules[i]) == BDD_TRUE;
+        engine->triggered += engine->results[i];
+    }
+    return engine->triggered;
+}
+
+unsigned int isBDDRuleTriggered(BDDRuleEngine* engine, unsigned int rule)
+{
+    return engine->results[rule];
+}
+
+void destroyBDDRuleEngine(BDDRuleEngine* engine)
+{
+    if (engine == NULL)
+    {
+        return;
+    }
+    free(engine->nodes);
+    free(engine->buckets);
+    free(engine->cache);
+    free(engine->inputs);
+    free(engine->rules);
+    free(engine->status);
+    free(engine->results);
+    free(engine);
+}
\ No newline at end of file
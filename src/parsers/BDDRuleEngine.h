@@ -0,0 +1,104 @@
+#ifndef BDDRULEENGINE_H
+#define BDDRULEENGINE_H
+
+#include "BooleanExpressionParser.h"
+
+/* the terminal nodes, every other node index refers to an inner node */
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+
+/* the creation fails if the diagrams of the rules need more nodes */
+#define BDDRULEENGINE_MAX_NODES (1u << 20)
+
+/* the creation also fails if combining the diagrams takes more steps, the cache can not hold every result */
+#define BDDRULEENGINE_MAX_OPERATIONS (1u << 23)
+
+/* the amount of entries of the cache for already combined nodes (a power of two) */
+#define BDDRULEENGINE_CACHE_SIZE (1u << 16)
+
+/* what the analysis found out about a rule */
+typedef enum
+{
+    BDDRuleRequired,
+    BDDRuleNeverTriggered,
+    BDDRuleRedundant
+} BDDRuleStatus;
+
+/*
+ *  An inner node of a binary decision diagram
+ *  input   -   the index of the input tested by the node, inputs with a lower index are tested first
+ *  low     -   the node to continue with if the input is 0
+ *  high    -   the node to continue with if the input is 1
+ *  next    -   the next node inside of the same bucket of the unique table
+ */
+typedef struct
+{
+    unsigned int    input;
+    unsigned int    low;
+    unsigned int    high;
+    unsigned int    next;
+} BDDNode;
+
+/*
+ *  An input of the diagrams, either a binary variable or a comparison which is evaluated as a whole
+ *  value       -   the address of the value of a binary variable
+ *  comparison  -   the comparison, NULL for binary variables
+ *  occurrences -   how often the input is used by the rules, inputs used more often are tested first
+ */
+typedef struct
+{
+    const char*         value;
+    BooleanExpression*  comparison;
+    unsigned int        occurrences;
+} BDDInput;
+
+/*
+ *  Evaluates a set of rules with reduced ordered binary decision diagrams. The disjunction of all rules is
+ *  checked every cycle by a single walk through its diagram, which tests every input at most once. Only if
+ *  it is true the diagrams of the single rules are walked to find out which rules triggered.
+ *  nodes           -   all nodes, the first two entries stand for the terminals
+ *  nodeCount       -   the amount of used nodes including the terminals
+ *  nodeCapacity    -   the amount of allocated nodes
+ *  buckets         -   the unique table, the first node of every bucket (0 for empty buckets)
+ *  bucketCount     -   the amount of buckets (always a power of two)
+ *  cache           -   results of already combined pairs of nodes (four entries per operation: operator,
+ *                      both operands and the result), only used during the creation
+ *  operations      -   the amount of combinations that were not found in the cache during the creation
+ *  inputs          -   the inputs in the order they are tested
+ *  inputCount      -   the amount of inputs
+ *  rules           -   the root of the diagram of every rule
+ *  status          -   the BDDRuleStatus of every rule
+ *  results         -   the result of every rule in the last evaluation
+ *  ruleCount       -   the amount of rules
+ *  anyRule         -   the root of the diagram of the disjunction of all rules
+ *  triggered       -   the amount of rules that triggered in the last evaluation
+ *  neverTriggered  -   the amount of rules which can never trigger
+ *  redundant       -   the amount of rules which only trigger together with other rules
+ */
+typedef struct
+{
+    BDDNode*        nodes;
+    unsigned int    nodeCount;
+    unsigned int    nodeCapacity;
+    unsigned int*   buckets;
+    unsigned int    bucketCount;
+    unsigned int*   cache;
+    unsigned int    operations;
+    BDDInput*       inputs;
+    unsigned int    inputCount;
+    unsigned int*   rules;
+    unsigned char*  status;
+    unsigned char*  results;
+    unsigned int    ruleCount;
+    unsigned int    anyRule;
+    unsigned int    triggered;
+    unsigned int    neverTriggered;
+    unsigned int    redundant;
+} BDDRuleEngine;
+
+BDDRuleEngine* createBDDRuleEngine(BooleanExpression** expressions, unsigned int ruleCount);
+unsigned int evaluateBDDRuleEngine(BDDRuleEngine* engine);
+unsigned int isBDDRuleTriggered(BDDRuleEngine* engine, unsigned int rule);
+void destroyBDDRuleEngine(BDDRuleEngine* engine);
+
+#endif
\ No newline at end of file
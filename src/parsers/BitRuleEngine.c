@@ -0,0 +1,424 @@
+#include "BitRuleEngine.h"
+#include "../logging/log.h"
+
+/* four terms are matched at once, GCC lowers this to NEON/SSE instructions or to scalar code */
+typedef uint64_t TermVector __attribute__((vector_size(4 * sizeof(uint64_t))));
+
+/*
+ *  A list of terms in disjunctive normal form, only used while creating a BitRuleEngine
+ *  care        -   the care masks of the terms
+ *  value       -   the value masks of the terms
+ *  count       -   the amount of terms in the list
+ *  wordCount   -   the amount of words per term
+ */
+typedef struct
+{
+    uint64_t*       care;
+    uint64_t*       value;
+    unsigned int    count;
+    unsigned int    wordCount;
+} TermList;
+
+static TermList* createTermList(unsigned int wordCount)
+{
+    TermList* list = malloc(sizeof(*list));
+    if (list == NULL)
+    {
+        return NULL;
+    }
+    list->care = calloc(BITRULEENGINE_MAX_TERMS_PER_RULE * wordCount, sizeof(uint64_t));
+    list->value = calloc(BITRULEENGINE_MAX_TERMS_PER_RULE * wordCount, sizeof(uint64_t));
+    list->count = 0;
+    list->wordCount = wordCount;
+    if (list->care == NULL || list->value == NULL)
+    {
+        free(list->care);
+        free(list->value);
+        free(list);
+        return NULL;
+    }
+    return list;
+}
+
+static void destroyTermList(TermList* list)
+{
+    if (list == NULL)
+    {
+        return;
+    }
+    free(list->care);
+    free(list->value);
+    free(list);
+}
+
+/* appends a term to the list, returns 0 if the list is full */
+static int appendTerm(TermList* list, const uint64_t* care, const uint64_t* value)
+{
+    if (list->count >= BITRULEENGINE_MAX_TERMS_PER_RULE)
+    {
+        return 0;
+    }
+    memcpy(list->care + list->count * list->wordCount, care, sizeof(uint64_t) * list->wordCount);
+    memcpy(list->value + list->count * list->wordCount, value, sizeof(uint64_t) * list->wordCount);
+    list->count++;
+    return 1;
+}
+
+static int getPackedVariableIndex(BitRuleEngine* engine, const char* value)
+{
+    for (int i = 0; i < engine->variableCount; i++)
+    {
+        if (engine->variables[i].value == value)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  converts an expression into its disjunctive normal form, negations are pushed down to the variables
+ *  returns NULL if the expression contains anything but binary variables, constants, and, or and not
+ *  or if the amount of terms exceeds BITRULEENGINE_MAX_TERMS_PER_RULE
+ */
+static TermList* convertToTerms(BitRuleEngine* engine, BooleanExpression* expression, int negated)
+{
+    if (expression == NULL)
+    {
+        return NULL;
+    }
+
+    unsigned int wordCount = engine->wordCount;
+    switch (expression->type)
+    {
+        case BoolExprVARIABLE:
+        {
+            int index = getPackedVariableIndex(engine, expression->value);
+            if (index == -1)
+            {
+                return NULL;
+            }
+            TermList* list = createTermList(wordCount);
+            if (list == NULL)
+            {
+                return NULL;
+            }
+            uint64_t care[wordCount];
+            uint64_t value[wordCount];
+            memset(care, 0, sizeof(care));
+            memset(value, 0, sizeof(value));
+            care[engine->variables[index].word] = engine->variables[index].mask;
+            value[engine->variables[index].word] = negated ? 0 : engine->variables[index].mask;
+            appendTerm(list, care, value);
+            return list;
+        }
+
+        case BoolExprCONSTANT:
+        {
+            if (expression->value == NULL || expression->valueSize != 1)
+            {
+                return NULL;
+            }
+            TermList* list = createTermList(wordCount);
+            if (list == NULL)
+            {
+                return NULL;
+            }
+            if ((expression->value[0] != 0) != negated)
+            {
+                /* a term without any cared for variable always matches */
+                uint64_t empty[wordCount];
+                memset(empty, 0, sizeof(empty));
+                appendTerm(list, empty, empty);
+            }
+            return list;
+        }
+
+        case BoolExprNOT:
+        {
+            return convertToTerms(engine, expression->leftside, !negated);
+        }
+
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            TermList* left = convertToTerms(engine, expression->leftside, negated);
+            TermList* right = convertToTerms(engine, expression->rightside, negated);
+            TermList* result = createTermList(wordCount);
+            if (left == NULL || right == NULL || result == NULL)
+            {
+                destroyTermList(left);
+                destroyTermList(right);
+                destroyTermList(result);
+                return NULL;
+            }
+
+            int success = 1;
+            if ((expression->type == BoolExprAND) != negated)
+            {
+                /* conjunction: every term of the left side is combined with every term of the right side */
+                uint64_t care[wordCount];
+                uint64_t value[wordCount];
+                for (int i = 0; i < left->count && success; i++)
+                {
+                    for (int j = 0; j < right->count && success; j++)
+                    {
+                        uint64_t* leftCare = left->care + i * wordCount;
+                        uint64_t* leftValue = left->value + i * wordCount;
+                        uint64_t* rightCare = right->care + j * wordCount;
+                        uint64_t* rightValue = right->value + j * wordCount;
+                        uint64_t conflict = 0;
+                        for (int w = 0; w < wordCount; w++)
+                        {
+                            conflict |= (leftValue[w] ^ rightValue[w]) & leftCare[w] & rightCare[w];
+                            care[w] = leftCare[w] | rightCare[w];
+                            value[w] = leftValue[w] | rightValue[w];
+                        }
+                        if (!conflict)
+                        {
+                            success = appendTerm(result, care, value);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                /* disjunction: the terms of both sides are simply collected */
+                for (int i = 0; i < left->count && success; i++)
+                {
+                    success = appendTerm(result, left->care + i * wordCount, left->value + i * wordCount);
+                }
+                for (int i = 0; i < right->count && success; i++)
+                {
+                    success = appendTerm(result, right->care + i * wordCount, right->value + i * wordCount);
+                }
+            }
+
+            destroyTermList(left);
+            destroyTermList(right);
+            if (!success)
+            {
+                destroyTermList(result);
+                return NULL;
+            }
+            return result;
+        }
+
+        default:
+            return NULL;
+    }
+}
+
+/*
+ *  creates a BitRuleEngine for the given rules
+ *  expressions     -   the parsed expressions of the rules
+ *  programs        -   the compiled expressions of the rules, used for rules that can not be converted
+ *  ruleCount       -   the amount of rules
+ *  variables       -   all variables the expressions may reference, only binary ones are packed
+ *  variablesCount  -   the amount of variables
+ */
+BitRuleEngine* createBitRuleEngine(BooleanExpression** expressions, CompiledBooleanExpression** programs, unsigned int ruleCount, Variable* variables, unsigned int variablesCount)
+{
+    BitRuleEngine* engine = calloc(1, sizeof(*engine));
+    if (engine == NULL)
+    {
+        log_error("BitRuleEngine: malloc error %s", strerror(errno));
+        return NULL;
+    }
+
+    engine->ruleCount = ruleCount;
+    engine->variables = malloc(sizeof(*engine->variables) * (variablesCount > 0 ? variablesCount : 1));
+    for (int i = 0; i < variablesCount; i++)
+    {
+        if (variables[i].type == OperandTypeBinary && variables[i].value != NULL)
+        {
+            unsigned int index = engine->variableCount++;
+            engine->variables[index] = (PackedVariable){variables[i].value, BITRULEENGINE_WORD(index), BITRULEENGINE_BIT(index)};
+        }
+    }
+    engine->wordCount = engine->variableCount > 0 ? BITRULEENGINE_WORD(engine->variableCount - 1) + 1 : 1;
+    engine->triggeredWordCount = ruleCount > 0 ? BITRULEENGINE_WORD(ruleCount - 1) + 1 : 1;
+    engine->inputs = calloc(engine->wordCount, sizeof(uint64_t));
+    engine->triggered = calloc(engine->triggeredWordCount, sizeof(uint64_t));
+    engine->fallbackPrograms = malloc(sizeof(*engine->fallbackPrograms) * (ruleCount > 0 ? ruleCount : 1));
+    engine->fallbackRules = malloc(sizeof(*engine->fallbackRules) * (ruleCount > 0 ? ruleCount : 1));
+    TermList** terms = calloc(ruleCount > 0 ? ruleCount : 1, sizeof(*terms));
+    if (engine->variables == NULL || engine->inputs == NULL || engine->triggered == NULL ||
+        engine->fallbackPrograms == NULL || engine->fallbackRules == NULL || terms == NULL)
+    {
+        log_error("BitRuleEngine: malloc error %s", strerror(errno));
+        free(terms);
+        destroyBitRuleEngine(engine);
+        return NULL;
+    }
+
+    for (int i = 0; i < ruleCount; i++)
+    {
+        terms[i] = convertToTerms(engine, expressions[i], 0);
+        if (terms[i] != NULL)
+        {
+            engine->termCount += terms[i]->count;
+        }
+        else
+        {
+            log_debug("BitRuleEngine: rule %d is evaluated with its compiled expression", i);
+            engine->fallbackPrograms[engine->fallbackCount] = programs[i];
+            engine->fallbackRules[engine->fallbackCount] = i;
+            engine->fallbackCount++;
+        }
+    }
+
+    unsigned int termCapacity = engine->termCount > 0 ? engine->termCount : 1;
+    engine->care = malloc(sizeof(uint64_t) * termCapacity * engine->wordCount);
+    engine->value = malloc(sizeof(uint64_t) * termCapacity * engine->wordCount);
+    engine->termRules = malloc(sizeof(*engine->termRules) * termCapacity);
+    engine->termMatches = malloc(sizeof(uint64_t) * termCapacity);
+    if (engine->care == NULL || engine->value == NULL || engine->termRules == NULL || engine->termMatches == NULL)
+    {
+        log_error("BitRuleEngine: malloc error %s", strerror(errno));
+        for (int i = 0; i < ruleCount; i++)
+        {
+            destroyTermList(terms[i]);
+        }
+        free(terms);
+        destroyBitRuleEngine(engine);
+        return NULL;
+    }
+
+    unsigned int termIndex = 0;
+    for (int i = 0; i < ruleCount; i++)
+    {
+        if (terms[i] == NULL)
+        {
+            continue;
+        }
+        memcpy(engine->care + termIndex * engine->wordCount, terms[i]->care, sizeof(uint64_t) * terms[i]->count * engine->wordCount);
+        memcpy(engine->value + termIndex * engine->wordCount, terms[i]->value, sizeof(uint64_t) * terms[i]->count * engine->wordCount);
+        for (int j = 0; j < terms[i]->count; j++)
+        {
+            engine->termRules[termIndex++] = i;
+        }
+        destroyTermList(terms[i]);
+    }
+    free(terms);
+
+    log_debug("BitRuleEngine: %d rules, %d packed variables in %d words, %d terms, %d fallback rules",
+              ruleCount, engine->variableCount, engine->wordCount, engine->termCount, engine->fallbackCount);
+    return engine;
+}
+
+/* packs the current values of all binary variables into the input words */
+void packBitRuleEngineInputs(BitRuleEngine* engine)
+{
+    memset(engine->inputs, 0, sizeof(uint64_t) * engine->wordCount);
+    for (int i = 0; i < engine->variableCount; i++)
+    {
+        PackedVariable* variable = &engine->variables[i];
+        engine->inputs[variable->word] |= variable->mask & -(uint64_t)(variable->value[0] != 0);
+    }
+}
+
+/* matches all terms against a single input word, termMatches is 0 for every matching term */
+static void matchTermsSingleWord(BitRuleEngine* engine)
+{
+    uint64_t input = engine->inputs[0];
+    unsigned int t = 0;
+    if (engine->termCount >= BITRULEENGINE_VECTOR_THRESHOLD)
+    {
+        TermVector inputVector = {input, input, input, input};
+        for (; t + 4 <= engine->termCount; t += 4)
+        {
+            TermVector care;
+            TermVector value;
+            memcpy(&care, engine->care + t, sizeof(care));
+            memcpy(&value, engine->value + t, sizeof(value));
+            TermVector matches = (inputVector & care) ^ value;
+            memcpy(engine->termMatches + t, &matches, sizeof(matches));
+        }
+    }
+    for (; t < engine->termCount; t++)
+    {
+        engine->termMatches[t] = (input & engine->care[t]) ^ engine->value[t];
+    }
+}
+
+/* matches all terms against multiple input words, termMatches is 0 for every matching term */
+static void matchTermsMultiWord(BitRuleEngine* engine)
+{
+    unsigned int wordCount = engine->wordCount;
+    for (unsigned int t = 0; t < engine->termCount; t++)
+    {
+        const uint64_t* care = engine->care + t * wordCount;
+        const uint64_t* value = engine->value + t * wordCount;
+        uint64_t mismatch = 0;
+        for (unsigned int w = 0; w < wordCount; w++)
+        {
+            mismatch |= (engine->inputs[w] & care[w]) ^ value[w];
+        }
+        engine->termMatches[t] = mismatch;
+    }
+}
+
+/*
+ *  evaluates all rules with the current values of the variables, afterwards engine->triggered
+ *  contains a bit for every rule that evaluated to 1 (or could not be evaluated)
+ *  returns the amount of triggered rules
+ */
+unsigned int evaluateBitRuleEngine(BitRuleEngine* engine)
+{
+    packBitRuleEngineInputs(engine);
+    memset(engine->triggered, 0, sizeof(uint64_t) * engine->triggeredWordCount);
+
+    if (engine->wordCount == 1)
+    {
+        matchTermsSingleWord(engine);
+    }
+    else
+    {
+        matchTermsMultiWord(engine);
+    }
+
+    for (unsigned int t = 0; t < engine->termCount; t++)
+    {
+        unsigned int rule = engine->termRules[t];
+        engine->triggered[BITRULEENGINE_WORD(rule)] |= BITRULEENGINE_BIT(rule) & -(uint64_t)(engine->termMatches[t] == 0);
+    }
+
+    for (unsigned int i = 0; i < engine->fallbackCount; i++)
+    {
+        if (evaluateCompiledBooleanExpression(engine->fallbackPrograms[i]))
+        {
+            engine->triggered[BITRULEENGINE_WORD(engine->fallbackRules[i])] |= BITRULEENGINE_BIT(engine->fallbackRules[i]);
+        }
+    }
+
+    unsigned int triggeredCount = 0;
+    for (unsigned int w = 0; w < engine->triggeredWordCount; w++)
+    {
+        triggeredCount += __builtin_popcountll(engine->triggered[w]);
+    }
+    return triggeredCount;
+}
+
+unsigned int isRuleTriggered(BitRuleEngine* engine, unsigned int rule)
+{
+    return (engine->triggered[BITRULEENGINE_WORD(rule)] & BITRULEENGINE_BIT(rule)) != 0;
+}
+
+void destroyBitRuleEngine(BitRuleEngine* engine)
+{
+    if (engine == NULL)
+    {
+        return;
+    }
+    free(engine->variables);
+    free(engine->inputs);
+    free(engine->care);
+    free(engine->value);
+    free(engine->termRules);
+    free(engine->termMatches);
+    free(engine->fallbackPrograms);
+    free(engine->fallbackRules);
+    free(engine->triggered);
+    free(engine);
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef BITRULEENGINE_H
+#define BITRULEENGINE_H
+
+#include <stdint.h>
+#include "BooleanExpressionParser.h"
+#include "BooleanExpressionCompiler.h"
+
+/* rules whose disjunctive normal form has more terms are evaluated with their compiled expression instead */
+#define BITRULEENGINE_MAX_TERMS_PER_RULE 64
+
+/* from this amount of terms on the terms are matched with vector instructions */
+#define BITRULEENGINE_VECTOR_THRESHOLD 8
+
+#define BITRULEENGINE_WORD(index) ((index) >> 6)
+#define BITRULEENGINE_BIT(index) ((uint64_t)1 << ((index) & 63))
+
+/*
+ *  A binary variable packed into the input words of a BitRuleEngine
+ *  value   -   the address of the value of the variable
+ *  word    -   the index of the input word the variable is packed into
+ *  mask    -   the bit of the variable inside of the input word
+ */
+typedef struct
+{
+    const char*     value;
+    unsigned int    word;
+    uint64_t        mask;
+} PackedVariable;
+
+/*
+ *  Evaluates a whole set of rules at once. Every rule is converted into its disjunctive normal form,
+ *  every term of it is stored as a care mask (which variables are part of the term) and a value mask
+ *  (which value these variables need to have). A term matches if (inputs & care) ^ value == 0.
+ *  variables           -   all binary variables packed into the input words
+ *  variableCount       -   the amount of packed variables
+ *  inputs              -   the packed values of all binary variables
+ *  wordCount           -   the amount of input words
+ *  care                -   the care masks of all terms (termCount * wordCount words)
+ *  value               -   the value masks of all terms (termCount * wordCount words)
+ *  termRules           -   the index of the rule every term belongs to
+ *  termMatches         -   scratch buffer for the match results of the terms
+ *  termCount           -   the amount of terms
+ *  fallbackPrograms    -   compiled expressions of rules which can not be converted
+ *  fallbackRules       -   the rule indices of the fallback programs
+ *  fallbackCount       -   the amount of fallback rules
+ *  ruleCount           -   the amount of rules
+ *  triggered           -   one bit per rule, set if the rule evaluated to 1 in the last evaluation
+ *  triggeredWordCount  -   the amount of words in triggered
+ */
+typedef struct
+{
+    PackedVariable*             variables;
+    unsigned int                variableCount;
+    uint64_t*                   inputs;
+    unsigned int                wordCount;
+    uint64_t*                   care;
+    uint64_t*                   value;
+    unsigned int*               termRules;
+    uint64_t*                   termMatches;
+    unsigned int                termCount;
+    CompiledBooleanExpression** fallbackPrograms;
+    unsigned int*               fallbackRules;
+    unsigned int                fallbackCount;
+    unsigned int                ruleCount;
+    uint64_t*                   triggered;
+    unsigned int                triggeredWordCount;
+} BitRuleEngine;
+
+BitRuleEngine* createBitRuleEngine(BooleanExpression** expressions, CompiledBooleanExpression** programs, unsigned int ruleCount, Variable* variables, unsigned int variablesCount);
+void packBitRuleEngineInputs(BitRuleEngine* engine);
+unsigned int evaluateBitRuleEngine(BitRuleEngine* engine);
+unsigned int isRuleTriggered(BitRuleEngine* engine, unsigned int rule);
+void destroyBitRuleEngine(BitRuleEngine* engine);
+
+#endif
\ No newline at end of file
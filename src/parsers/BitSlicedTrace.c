@@ -0,0 +1,303 @@
+#include "BitSlicedTrace.h"
+#include "../logging/log.h"
+
+/* a whole slice is processed at once, GCC lowers this to AVX2/NEON/SSE instructions or to scalar code */
+typedef uint64_t SliceVector __attribute__((vector_size(BITSLICEDTRACE_WORDS * sizeof(uint64_t))));
+
+/* binary variables only need one plane, the planes of numbers are stored from the least significant bit on */
+static unsigned int getPlaneCount(Variable* variable)
+{
+    return variable->type == OperandTypeBinary ? 1 : 8 * variable->valueSize;
+}
+
+/*
+ *  creates an empty trace for snapshots of the given variables, numbers may have up to 8 bytes
+ *  the variables have to stay valid as long as the trace is used
+ */
+BitSlicedTrace* createBitSlicedTrace(Variable* variables, unsigned int variablesCount)
+{
+    BitSlicedTrace* trace = calloc(1, sizeof(*trace));
+    if (trace == NULL)
+    {
+        log_error("BitSlicedTrace: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    trace->variables = variables;
+    trace->variablesCount = variablesCount;
+    trace->planeOffsets = malloc(sizeof(*trace->planeOffsets) * (variablesCount > 0 ? variablesCount : 1));
+    if (trace->planeOffsets == NULL)
+    {
+        log_error("BitSlicedTrace: malloc error %s", strerror(errno));
+        destroyBitSlicedTrace(trace);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < variablesCount; i++)
+    {
+        if (variables[i].valueSize > sizeof(unsigned long long))
+        {
+            log_error("BitSlicedTrace: variable %s has %u bytes, at most %zu are supported", variables[i].name, variables[i].valueSize, sizeof(unsigned long long));
+            destroyBitSlicedTrace(trace);
+            return NULL;
+        }
+        trace->planeOffsets[i] = trace->planeCount;
+        trace->planeCount += getPlaneCount(&variables[i]);
+    }
+    trace->planes = calloc(trace->planeCount > 0 ? trace->planeCount : 1, sizeof(*trace->planes));
+    if (trace->planes == NULL)
+    {
+        log_error("BitSlicedTrace: malloc error %s", strerror(errno));
+        destroyBitSlicedTrace(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+/* removes all snapshots */
+void clearBitSlicedTrace(BitSlicedTrace* trace)
+{
+    memset(trace->planes, 0, sizeof(*trace->planes) * trace->planeCount);
+    trace->stepCount = 0;
+}
+
+/*
+ *  adds a snapshot to the trace
+ *  values  -   the value of every variable of the trace
+ *  returns 1 if the trace already contains BITSLICEDTRACE_STEPS snapshots
+ */
+int addBitSlicedSnapshot(BitSlicedTrace* trace, const unsigned long long* values)
+{
+    if (trace->stepCount == BITSLICEDTRACE_STEPS)
+    {
+        return 1;
+    }
+    unsigned int word = trace->stepCount >> 6;
+    uint64_t bit = (uint64_t)1 << (trace->stepCount & 63);
+    for (unsigned int i = 0; i < trace->variablesCount; i++)
+    {
+        BitSlice* planes = trace->planes + trace->planeOffsets[i];
+        if (trace->variables[i].type == OperandTypeBinary)
+        {
+            if (values[i] != 0)
+            {
+                planes[0].words[word] |= bit;
+            }
+            continue;
+        }
+        for (unsigned long long value = values[i], plane = 0; value != 0; value >>= 1, plane++)
+        {
+            if (value & 1)
+            {
+                planes[plane].words[word] |= bit;
+            }
+        }
+    }
+    trace->stepCount++;
+    return 0;
+}
+
+void destroyBitSlicedTrace(BitSlicedTrace* trace)
+{
+    if (trace == NULL)
+    {
+        return;
+    }
+    free(trace->planeOffsets);
+    free(trace->planes);
+    free(trace);
+}
+
+/* binds an operand of a compiled instruction to the planes of its variable, every other operand is a constant */
+static BitSlicedOperand bindOperand(BitSlicedTrace* trace, const char* value, unsigned int valueSize)
+{
+    for (unsigned int i = 0; i < trace->variablesCount; i++)
+    {
+        if (trace->variables[i].value == value)
+        {
+            return (BitSlicedOperand){trace->planeOffsets[i], getPlaneCount(&trace->variables[i]), 0};
+        }
+    }
+
+    /* constants are big-endian, only their significant bits have to be compared */
+    BitSlicedOperand constant = {-1, 0, 0};
+    for (unsigned int i = 0; i < valueSize; i++)
+    {
+        constant.constant = (constant.constant << 8) | (unsigned char)value[i];
+    }
+    for (unsigned long long rest = constant.constant; rest != 0; rest >>= 1)
+    {
+        constant.bitCount++;
+    }
+    return constant;
+}
+
+/*
+ *  binds a compiled expression to the planes of the trace, every variable of the expression which is not part
+ *  of the trace is treated as a constant with its current value
+ *  returns NULL if an operand of a comparison has more than 8 bytes
+ */
+BitSlicedProgram* bindBitSlicedProgram(BitSlicedTrace* trace, const CompiledBooleanExpression* program)
+{
+    if (program == NULL)
+    {
+        return NULL;
+    }
+    BitSlicedProgram* slicedProgram = malloc(sizeof(*slicedProgram));
+    if (slicedProgram == NULL)
+    {
+        log_error("BitSlicedTrace: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    slicedProgram->instructions = malloc(sizeof(*slicedProgram->instructions) * (program->instructionCount > 0 ? program->instructionCount : 1));
+    if (slicedProgram->instructions == NULL)
+    {
+        log_error("BitSlicedTrace: malloc error %s", strerror(errno));
+        free(slicedProgram);
+        return NULL;
+    }
+    slicedProgram->instructionCount = program->instructionCount;
+    slicedProgram->stackSize = program->stackSize;
+
+    for (unsigned int i = 0; i < program->instructionCount; i++)
+    {
+        const BooleanInstruction* instruction = &program->instructions[i];
+        BitSlicedInstruction* slicedInstruction = &slicedProgram->instructions[i];
+        slicedInstruction->type = instruction->type;
+        slicedInstruction->left = (BitSlicedOperand){-1, 0, 0};
+        slicedInstruction->right = (BitSlicedOperand){-1, 0, 0};
+        switch (instruction->type)
+        {
+            case BoolInstrLOAD:
+                slicedInstruction->left = bindOperand(trace, instruction->left, 1);
+                break;
+
+            case BoolInstrGREATER:
+            case BoolInstrLOWER:
+            case BoolInstrEQUAL:
+                if (instruction->leftSize > sizeof(unsigned long long) || instruction->rightSize > sizeof(unsigned long long))
+                {
+                    log_error("BitSlicedTrace: comparisons of more than %zu bytes are not supported", sizeof(unsigned long long));
+                    destroyBitSlicedProgram(slicedProgram);
+                    return NULL;
+                }
+                slicedInstruction->left = bindOperand(trace, instruction->left, instruction->leftSize);
+                slicedInstruction->right = bindOperand(trace, instruction->right, instruction->rightSize);
+                break;
+
+            default:
+                break;
+        }
+    }
+    return slicedProgram;
+}
+
+/* loads the given bit of the operand in all snapshots */
+static void loadOperandBit(BitSlicedTrace* trace, const BitSlicedOperand* operand, unsigned int bit, SliceVector* slice)
+{
+    SliceVector zero = {0};
+    if (bit >= operand->bitCount)
+    {
+        *slice = zero;
+    }
+    else if (operand->plane < 0)
+    {
+        *slice = ((operand->constant >> bit) & 1) ? ~zero : zero;
+    }
+    else
+    {
+        memcpy(slice, trace->planes[operand->plane + bit].words, sizeof(*slice));
+    }
+}
+
+/* compares both operands in all snapshots at once, starting with the most significant bit */
+static void compareOperands(BitSlicedTrace* trace, const BitSlicedInstruction* instruction, SliceVector* result)
+{
+    SliceVector greater = {0};
+    SliceVector lower = {0};
+    SliceVector equal = ~greater;
+    unsigned int bitCount = instruction->left.bitCount > instruction->right.bitCount ? instruction->left.bitCount : instruction->right.bitCount;
+    for (unsigned int bit = bitCount; bit-- > 0;)
+    {
+        SliceVector left;
+        SliceVector right;
+        loadOperandBit(trace, &instruction->left, bit, &left);
+        loadOperandBit(trace, &instruction->right, bit, &right);
+        greater |= equal & left & ~right;
+        lower |= equal & ~left & right;
+        equal &= ~(left ^ right);
+    }
+    switch (instruction->type)
+    {
+        case BoolInstrGREATER:
+            *result = greater;
+            break;
+
+        case BoolInstrLOWER:
+            *result = lower;
+            break;
+
+        default:
+            *result = equal;
+            break;
+    }
+}
+
+/*
+ *  evaluates the program in all snapshots of the trace with a single pass over its instructions
+ *  result  -   bit k is set if the expression is 1 in snapshot k, bits of missing snapshots are 0
+ */
+void evaluateBitSlicedProgram(BitSlicedTrace* trace, const BitSlicedProgram* program, BitSlice* result)
+{
+    SliceVector stack[program->stackSize > 0 ? program->stackSize : 1];
+    unsigned int top = 0;
+    for (unsigned int i = 0; i < program->instructionCount; i++)
+    {
+        const BitSlicedInstruction* instruction = &program->instructions[i];
+        switch (instruction->type)
+        {
+            case BoolInstrLOAD:
+                loadOperandBit(trace, &instruction->left, 0, &stack[top++]);
+                break;
+
+            case BoolInstrAND:
+                top--;
+                stack[top-1] &= stack[top];
+                break;
+
+            case BoolInstrOR:
+                top--;
+                stack[top-1] |= stack[top];
+                break;
+
+            case BoolInstrNOT:
+                stack[top-1] = ~stack[top-1];
+                break;
+
+            default:
+                compareOperands(trace, instruction, &stack[top++]);
+                break;
+        }
+    }
+
+    /* negations set the bits of the snapshots which were not added */
+    SliceVector valid;
+    for (unsigned int word = 0; word < BITSLICEDTRACE_WORDS; word++)
+    {
+        unsigned int steps = trace->stepCount > 64 * word ? trace->stepCount - 64 * word : 0;
+        valid[word] = steps >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << steps) - 1;
+    }
+    if (top > 0)
+    {
+        valid &= stack[0];
+    }
+    memcpy(result->words, &valid, sizeof(valid));
+}
+
+void destroyBitSlicedProgram(BitSlicedProgram* program)
+{
+    if (program == NULL)
+    {
+        return;
+    }
+    free(program->instructions);
+    free(program);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef BITSLICEDTRACE_H
+#define BITSLICEDTRACE_H
+
+#include <stdint.h>
+#include "BooleanExpressionParser.h"
+#include "BooleanExpressionCompiler.h"
+
+/* the amount of 64 bit words of a slice, 4 words (256 snapshots) fill an AVX2 register */
+#define BITSLICEDTRACE_WORDS 4
+
+/* the amount of snapshots evaluated at once */
+#define BITSLICEDTRACE_STEPS (64 * BITSLICEDTRACE_WORDS)
+
+/* one bit per snapshot, bit k of word w belongs to snapshot 64 * w + k */
+typedef struct
+{
+    uint64_t    words[BITSLICEDTRACE_WORDS];
+} BitSlice;
+
+/*
+ *  An operand of a BitSlicedInstruction
+ *  plane       -   the first plane of the variable (its least significant bit), -1 for constants
+ *  bitCount    -   the amount of planes of the variable or the significant bits of the constant
+ *  constant    -   the value of a constant
+ */
+typedef struct
+{
+    int                 plane;
+    unsigned int        bitCount;
+    unsigned long long  constant;
+} BitSlicedOperand;
+
+/*
+ *  A BooleanInstruction whose operands are bound to the planes of a BitSlicedTrace
+ *  type    -   the BooleanInstructionType of the instruction
+ *  left    -   LOAD: the loaded operand, comparisons: the left operand
+ *  right   -   comparisons: the right operand
+ */
+typedef struct
+{
+    unsigned int        type;
+    BitSlicedOperand    left;
+    BitSlicedOperand    right;
+} BitSlicedInstruction;
+
+/*
+ *  A CompiledBooleanExpression bound to a BitSlicedTrace
+ *  instructions        -   the instructions in postfix order
+ *  instructionCount    -   the amount of instructions
+ *  stackSize           -   the maximum depth of the evaluation stack needed by the instructions
+ */
+typedef struct
+{
+    BitSlicedInstruction*   instructions;
+    unsigned int            instructionCount;
+    unsigned int            stackSize;
+} BitSlicedProgram;
+
+/*
+ *  Up to BITSLICEDTRACE_STEPS snapshots of a set of variables stored time-sliced: every bit of every variable
+ *  is a plane (a BitSlice) whose bit k is the value of that bit in snapshot k. A BitSlicedProgram evaluates
+ *  all snapshots with a single pass over its instructions, comparisons are done bit by bit from the most
+ *  significant plane down.
+ *  variables       -   the variables of the snapshots
+ *  variablesCount  -   the amount of variables
+ *  planeOffsets    -   the first plane of every variable, binary variables have one plane, numbers one per bit
+ *  planes          -   all planes
+ *  planeCount      -   the amount of planes
+ *  stepCount       -   the amount of snapshots added since the last clear
+ */
+typedef struct
+{
+    Variable*       variables;
+    unsigned int    variablesCount;
+    unsigned int*   planeOffsets;
+    BitSlice*       planes;
+    unsigned int    planeCount;
+    unsigned int    stepCount;
+} BitSlicedTrace;
+
+BitSlicedTrace* createBitSlicedTrace(Variable* variables, unsigned int variablesCount);
+void clearBitSlicedTrace(BitSlicedTrace* trace);
+int addBitSlicedSnapshot(BitSlicedTrace* trace, const unsigned long long* values);
+void destroyBitSlicedTrace(BitSlicedTrace* trace);
+
+BitSlicedProgram* bindBitSlicedProgram(BitSlicedTrace* trace, const CompiledBooleanExpression* program);
+void evaluateBitSlicedProgram(BitSlicedTrace* trace, const BitSlicedProgram* program, BitSlice* result);
+void destroyBitSlicedProgram(BitSlicedProgram* program);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "BooleanExpressionCompiler.h"
+#include "../logging/log.h"
+
+static unsigned int isOperand(BooleanExpression* expression)
+{
+    return expression->type == BoolExprVARIABLE || expression->type == BoolExprCONSTANT;
+}
+
+/* counts the instructions and the bytes of constants needed for the given expression, returns 0 on error */
+static int measureExpression(BooleanExpression* expression, unsigned int* instructionCount, unsigned int* constantsSize)
+{
+    if (expression == NULL)
+    {
+        return 0;
+    }
+
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
+        {
+            if (expression->value == NULL)
+            {
+                return 0;
+            }
+            *constantsSize += expression->valueSize;
+            (*instructionCount)++;
+            return 1;
+        }
+
+        case BoolExprVARIABLE:
+        {
+            if (expression->value == NULL)
+            {
+                return 0;
+            }
+            (*instructionCount)++;
+            return 1;
+        }
+
+        case BoolExprNOT:
+        {
+            (*instructionCount)++;
+            return measureExpression(expression->leftside, instructionCount, constantsSize);
+        }
+
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            (*instructionCount)++;
+            return measureExpression(expression->leftside, instructionCount, constantsSize) &&
+                   measureExpression(expression->rightside, instructionCount, constantsSize);
+        }
+
+        case BoolExprGREATER:
+        case BoolExprLOWER:
+        case BoolExprEQUAL:
+        {
+            if (expression->leftside == NULL || expression->rightside == NULL ||
+                !isOperand(expression->leftside) || !isOperand(expression->rightside))
+            {
+                log_error("BooleanExpressionCompiler: comparisons are only supported between variables and constants");
+                return 0;
+            }
+            if (expression->leftside->value == NULL || expression->rightside->value == NULL)
+            {
+                return 0;
+            }
+            if (expression->leftside->type == BoolExprCONSTANT)
+            {
+                *constantsSize += expression->leftside->valueSize;
+            }
+            if (expression->rightside->type == BoolExprCONSTANT)
+            {
+                *constantsSize += expression->rightside->valueSize;
+            }
+            (*instructionCount)++;
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+/* returns the operand address used by an instruction, constants are copied into the constants of the program */
+static const char* bindOperand(BooleanExpression* operand, CompiledBooleanExpression* program, unsigned int* constantsOffset)
+{
+    if (operand->type == BoolExprVARIABLE)
+    {
+        return operand->value;
+    }
+    char* constant = program->constants + *constantsOffset;
+    memcpy(constant, operand->value, operand->valueSize);
+    *constantsOffset += operand->valueSize;
+    return constant;
+}
+
+/* emits the instructions of the given expression in postfix order, returns the stack depth needed by them */
+static unsigned int emitInstructions(BooleanExpression* expression, CompiledBooleanExpression* program, unsigned int* constantsOffset)
+{
+    BooleanInstruction* instruction;
+    unsigned int depthLeft;
+    unsigned int depthRight;
+
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
+        case BoolExprVARIABLE:
+        {
+            instruction = &program->instructions[program->instructionCount++];
+            *instruction = (BooleanInstruction){BoolInstrLOAD, expression->valueSize, 0, NULL, NULL};
+            instruction->left = bindOperand(expression, program, constantsOffset);
+            return 1;
+        }
+
+        case BoolExprNOT:
+        {
+            depthLeft = emitInstructions(expression->leftside, program, constantsOffset);
+            program->instructions[program->instructionCount++] = (BooleanInstruction){BoolInstrNOT, 0, 0, NULL, NULL};
+            return depthLeft;
+        }
+
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            depthLeft = emitInstructions(expression->leftside, program, constantsOffset);
+            depthRight = emitInstructions(expression->rightside, program, constantsOffset) + 1;
+            BooleanInstructionType type = expression->type == BoolExprAND ? BoolInstrAND : BoolInstrOR;
+            program->instructions[program->instructionCount++] = (BooleanInstruction){type, 0, 0, NULL, NULL};
+            return depthLeft > depthRight ? depthLeft : depthRight;
+        }
+
+        default:
+        {
+            instruction = &program->instructions[program->instructionCount++];
+            switch (expression->type)
+            {
+                case BoolExprGREATER:
+                    instruction->type = BoolInstrGREATER;
+                    break;
+                case BoolExprLOWER:
+                    instruction->type = BoolInstrLOWER;
+                    break;
+                default:
+                    instruction->type = BoolInstrEQUAL;
+                    break;
+            }
+            instruction->leftSize = expression->leftside->valueSize;
+            instruction->rightSize = expression->rightside->valueSize;
+            instruction->left = bindOperand(expression->leftside, program, constantsOffset);
+            instruction->right = bindOperand(expression->rightside, program, constantsOffset);
+            return 1;
+        }
+    }
+}
+
+/*
+ *  compiles a parsed BooleanExpression into a flat array of instructions which can be evaluated without
+ *  recursion or heap allocations. Variables are bound to the addresses of their values, constants are
+ *  copied, so the expression may be destroyed afterwards.
+ *  expression  -   the BooleanExpression to be compiled
+ */
+CompiledBooleanExpression* compileBooleanExpression(BooleanExpression* expression)
+{
+    if (expression == NULL || expression->resultType != OperandTypeBinary || expression->valueSize != 1)
+    {
+        log_error("BooleanExpressionCompiler: expression does not have a binary result");
+        return NULL;
+    }
+
+    unsigned int instructionCount = 0;
+    unsigned int constantsSize = 0;
+    if (!measureExpression(expression, &instructionCount, &constantsSize))
+    {
+        log_error("BooleanExpressionCompiler: expression could not be compiled");
+        return NULL;
+    }
+
+    CompiledBooleanExpression* program = malloc(sizeof(*program));
+    if (program == NULL)
+    {
+        log_error("BooleanExpressionCompiler: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    program->instructions = malloc(sizeof(*program->instructions) * instructionCount);
+    program->constants = constantsSize > 0 ? malloc(constantsSize) : NULL;
+    program->constantsSize = constantsSize;
+    program->instructionCount = 0;
+    if (program->instructions == NULL || (constantsSize > 0 && program->constants == NULL))
+    {
+        log_error("BooleanExpressionCompiler: malloc error %s", strerror(errno));
+        destroyCompiledBooleanExpression(program);
+        return NULL;
+    }
+
+    unsigned int constantsOffset = 0;
+    program->stackSize = emitInstructions(expression, program, &constantsOffset);
+    if (program->stackSize > BOOLEAN_PROGRAM_MAX_STACK)
+    {
+        log_error("BooleanExpressionCompiler: expression needs a stack of depth %d, maximum is %d", program->stackSize, BOOLEAN_PROGRAM_MAX_STACK);
+        destroyCompiledBooleanExpression(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+/*
+ *  evaluates a compiled BooleanExpression on a fixed size stack
+ *  returns 1 or 0 as the result of the expression and -1 if the program is invalid
+ */
+int evaluateCompiledBooleanExpression(const CompiledBooleanExpression* program)
+{
+    if (program == NULL)
+    {
+        return -1;
+    }
+
+    unsigned char stack[BOOLEAN_PROGRAM_MAX_STACK];
+    unsigned int top = 0;
+    const BooleanInstruction* instruction = program->instructions;
+    const BooleanInstruction* end = program->instructions + program->instructionCount;
+
+    for (; instruction < end; instruction++)
+    {
+        switch (instruction->type)
+        {
+            case BoolInstrLOAD:
+                stack[top++] = instruction->left[0] != 0;
+                break;
+
+            case BoolInstrAND:
+                top--;
+                stack[top-1] &= stack[top];
+                break;
+
+            case BoolInstrOR:
+                top--;
+                stack[top-1] |= stack[top];
+                break;
+
+            case BoolInstrNOT:
+                stack[top-1] ^= 1;
+                break;
+
+            case BoolInstrGREATER:
+                stack[top++] = compareOperandValues(instruction->left, instruction->leftSize, instruction->right, instruction->rightSize) > 0;
+                break;
+
+            case BoolInstrLOWER:
+                stack[top++] = compareOperandValues(instruction->left, instruction->leftSize, instruction->right, instruction->rightSize) < 0;
+                break;
+
+            case BoolInstrEQUAL:
+                stack[top++] = compareOperandValues(instruction->left, instruction->leftSize, instruction->right, instruction->rightSize) == 0;
+                break;
+        }
+    }
+
+    return stack[0];
+}
+
+/* moves an operand into the given range or into the constants of the copy */
+static const char* rebindOperand(const char* operand, const CompiledBooleanExpression* program, const char* from, unsigned int size,
+                                 const char* to, const CompiledBooleanExpression* copy)
+{
+    if (operand >= from && operand < from + size)
+    {
+        return to + (operand - from);
+    }
+    if (program->constants != NULL && operand >= program->constants && operand < program->constants + program->constantsSize)
+    {
+        return copy->constants + (operand - program->constants);
+    }
+    return operand;
+}
+
+/*
+ *  copies a compiled BooleanExpression, the operands bound to the range of size bytes at from are bound to the
+ *  same offsets at to instead. Used to evaluate a rule on a copy of the values, e.g. a snapshot of a process image.
+ *  returns NULL on error
+ */
+CompiledBooleanExpression* rebindCompiledBooleanExpression(const CompiledBooleanExpression* program, const char* from, unsigned int size, const char* to)
+{
+    if (program == NULL)
+    {
+        return NULL;
+    }
+    CompiledBooleanExpression* copy = malloc(sizeof(*copy));
+    if (copy == NULL)
+    {
+        log_error("BooleanExpressionCompiler: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    *copy = *program;
+    copy->instructions = malloc(sizeof(*copy->instructions) * (program->instructionCount + 1));
+    copy->constants = program->constantsSize > 0 ? malloc(program->constantsSize) : NULL;
+    if (copy->instructions == NULL || (program->constantsSize > 0 && copy->constants == NULL))
+    {
+        log_error("BooleanExpressionCompiler: malloc error %s", strerror(errno));
+        destroyCompiledBooleanExpression(copy);
+        return NULL;
+    }
+    if (program->constantsSize > 0)
+    {
+        memcpy(copy->constants, program->constants, program->constantsSize);
+    }
+    for (int i = 0; i < program->instructionCount; i++)
+    {
+        BooleanInstruction instruction = program->instructions[i];
+        instruction.left = instruction.left == NULL ? NULL : rebindOperand(instruction.left, program, from, size, to, copy);
+        instruction.right = instruction.right == NULL ? NULL : rebindOperand(instruction.right, program, from, size, to, copy);
+        copy->instructions[i] = instruction;
+    }
+    return copy;
+}
+
+void destroyCompiledBooleanExpression(CompiledBooleanExpression* program)
+{
+    if (program == NULL)
+    {
+        return;
+    }
+    free(program->instructions);
+    free(program->constants);
+    free(program);
+}
\ No newline at end of file
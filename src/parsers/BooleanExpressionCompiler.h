@@ -0,0 +1,59 @@
+#ifndef BOOLEANEXPRESSIONCOMPILER_H
+#define BOOLEANEXPRESSIONCOMPILER_H
+
+#include "BooleanExpressionParser.h"
+
+/* the maximum depth of the evaluation stack, deeper expressions are rejected by the compiler */
+#define BOOLEAN_PROGRAM_MAX_STACK 64
+
+typedef enum BooleanInstructionTypes
+{
+    BoolInstrLOAD,
+    BoolInstrAND,
+    BoolInstrOR,
+    BoolInstrNOT,
+    BoolInstrGREATER,
+    BoolInstrLOWER,
+    BoolInstrEQUAL
+} BooleanInstructionType;
+
+/*
+ *  A single instruction of a compiled BooleanExpression, the instructions are executed in postfix order
+ *  type        -   the BooleanInstructionType of the instruction
+ *  left        -   LOAD: the operand whose binary value is pushed, comparisons: the left operand
+ *  right       -   comparisons: the right operand
+ *  leftSize    -   the size of the left operand in bytes
+ *  rightSize   -   the size of the right operand in bytes
+ */
+typedef struct
+{
+    unsigned int    type;
+    unsigned int    leftSize;
+    unsigned int    rightSize;
+    const char*     left;
+    const char*     right;
+} BooleanInstruction;
+
+/*
+ *  A BooleanExpression compiled to a flat array of instructions
+ *  instructions        -   the instructions in postfix order
+ *  instructionCount    -   the amount of instructions
+ *  stackSize           -   the maximum depth of the evaluation stack needed by the instructions
+ *  constants           -   a copy of all constant operands, the instructions point into this buffer
+ *  constantsSize       -   the size of constants in bytes
+ */
+typedef struct
+{
+    BooleanInstruction* instructions;
+    unsigned int        instructionCount;
+    unsigned int        stackSize;
+    char*               constants;
+    unsigned int        constantsSize;
+} CompiledBooleanExpression;
+
+CompiledBooleanExpression* compileBooleanExpression(BooleanExpression* expression);
+int evaluateCompiledBooleanExpression(const CompiledBooleanExpression* program);
+CompiledBooleanExpression* rebindCompiledBooleanExpression(const CompiledBooleanExpression* program, const char* from, unsigned int size, const char* to);
+void destroyCompiledBooleanExpression(CompiledBooleanExpression* program);
+
+#endif
\ No newline at end of file
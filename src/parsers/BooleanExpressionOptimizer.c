@@ -0,0 +1,256 @@
+#include "BooleanExpressionOptimizer.h"
+#include "../logging/log.h"
+
+/* returns whether the given expression is the binary constant with the given value */
+static unsigned int isBinaryConstant(BooleanExpression* expression, char value)
+{
+    return expression != NULL && expression->type == BoolExprCONSTANT && expression->operandType == OperandTypeBinary &&
+           expression->valueSize == 1 && expression->value != NULL && (expression->value[0] != 0) == value;
+}
+
+/* returns whether the given expression is a number constant whose value is 0 */
+static unsigned int isZeroNumber(BooleanExpression* expression)
+{
+    if (expression->type != BoolExprCONSTANT || expression->value == NULL)
+    {
+        return 0;
+    }
+    for (int i = 0; i < expression->valueSize; i++)
+    {
+        if (expression->value[i] != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* returns whether both expressions are structurally identical, & and | are compared in both orders */
+static unsigned int isSameExpression(BooleanExpression* left, BooleanExpression* right)
+{
+    if (left == NULL || right == NULL)
+    {
+        return left == right;
+    }
+    if (left->type != right->type)
+    {
+        return 0;
+    }
+
+    switch (left->type)
+    {
+        case BoolExprVARIABLE:
+            return left->value == right->value;
+
+        case BoolExprCONSTANT:
+            return left->valueSize == right->valueSize && left->value != NULL && right->value != NULL &&
+                   !memcmp(left->value, right->value, left->valueSize);
+
+        case BoolExprAND:
+        case BoolExprOR:
+            return (isSameExpression(left->leftside, right->leftside) && isSameExpression(left->rightside, right->rightside)) ||
+                   (isSameExpression(left->leftside, right->rightside) && isSameExpression(left->rightside, right->leftside));
+
+        default:
+            return isSameExpression(left->leftside, right->leftside) && isSameExpression(left->rightside, right->rightside);
+    }
+}
+
+/* destroys the given expression and returns a binary constant with the given value in its place */
+static BooleanExpression* replaceWithConstant(BooleanExpression* expression, char value)
+{
+    BooleanExpression* constant = createBinaryConstant(value);
+    if (constant == NULL)
+    {
+        return expression;
+    }
+    destroyBooleanExpression(expression);
+    return constant;
+}
+
+/* destroys the given expression except for the given child, which is returned in its place */
+static BooleanExpression* replaceWithChild(BooleanExpression* expression, BooleanExpression* child)
+{
+    if (expression->leftside == child)
+    {
+        expression->leftside = NULL;
+    }
+    if (expression->rightside == child)
+    {
+        expression->rightside = NULL;
+    }
+    destroyBooleanExpression(expression);
+    return child;
+}
+
+/* simplifies & and | whose children have already been optimized */
+static BooleanExpression* optimizeJunction(BooleanExpression* expression)
+{
+    BooleanExpression* left = expression->leftside;
+    BooleanExpression* right = expression->rightside;
+    /* the value which decides the junction on its own: 0 for &, 1 for | */
+    char dominant = expression->type == BoolExprOR;
+    unsigned int innerType = expression->type == BoolExprAND ? BoolExprOR : BoolExprAND;
+
+    /* a & 0 = 0, a | 1 = 1 */
+    if (isBinaryConstant(left, dominant) || isBinaryConstant(right, dominant))
+    {
+        return replaceWithConstant(expression, dominant);
+    }
+    /* a & 1 = a, a | 0 = a */
+    if (isBinaryConstant(left, !dominant))
+    {
+        return replaceWithChild(expression, right);
+    }
+    if (isBinaryConstant(right, !dominant))
+    {
+        return replaceWithChild(expression, left);
+    }
+    /* idempotence: a & a = a, a | a = a */
+    if (isSameExpression(left, right))
+    {
+        return replaceWithChild(expression, left);
+    }
+    /* complement: a & !a = 0, a | !a = 1 */
+    if ((left->type == BoolExprNOT && isSameExpression(left->leftside, right)) ||
+        (right->type == BoolExprNOT && isSameExpression(right->leftside, left)))
+    {
+        return replaceWithConstant(expression, dominant);
+    }
+    /* absorption: a & (a | b) = a, a | (a & b) = a */
+    if (right->type == innerType && (isSameExpression(right->leftside, left) || isSameExpression(right->rightside, left)))
+    {
+        return replaceWithChild(expression, left);
+    }
+    if (left->type == innerType && (isSameExpression(left->leftside, right) || isSameExpression(left->rightside, right)))
+    {
+        return replaceWithChild(expression, right);
+    }
+    return expression;
+}
+
+/* folds comparisons whose result does not depend on the values of the variables */
+static BooleanExpression* optimizeComparison(BooleanExpression* expression)
+{
+    BooleanExpression* left = expression->leftside;
+    BooleanExpression* right = expression->rightside;
+
+    if (left->type == BoolExprCONSTANT && right->type == BoolExprCONSTANT && left->value != NULL && right->value != NULL)
+    {
+        int comparison = compareOperandValues(left->value, left->valueSize, right->value, right->valueSize);
+        switch (expression->type)
+        {
+            case BoolExprEQUAL:
+                return replaceWithConstant(expression, comparison == 0);
+            case BoolExprGREATER:
+                return replaceWithConstant(expression, comparison > 0);
+            default:
+                return replaceWithConstant(expression, comparison < 0);
+        }
+    }
+    /* a = a is always true, a > a and a < a never */
+    if (isSameExpression(left, right))
+    {
+        return replaceWithConstant(expression, expression->type == BoolExprEQUAL);
+    }
+    /* values are unsigned, so nothing is lower than 0 */
+    if ((expression->type == BoolExprLOWER && isZeroNumber(right)) || (expression->type == BoolExprGREATER && isZeroNumber(left)))
+    {
+        return replaceWithConstant(expression, 0);
+    }
+    return expression;
+}
+
+static BooleanExpression* optimizeNode(BooleanExpression* expression)
+{
+    if (expression == NULL)
+    {
+        return NULL;
+    }
+
+    expression->leftside = optimizeNode(expression->leftside);
+    if (expression->leftside != NULL)
+    {
+        expression->leftside->parent = expression;
+    }
+    expression->rightside = optimizeNode(expression->rightside);
+    if (expression->rightside != NULL)
+    {
+        expression->rightside->parent = expression;
+    }
+
+    switch (expression->type)
+    {
+        case BoolExprNOT:
+        {
+            BooleanExpression* child = expression->leftside;
+            if (child == NULL)
+            {
+                return expression;
+            }
+            /* !!a = a */
+            if (child->type == BoolExprNOT && child->leftside != NULL)
+            {
+                BooleanExpression* grandchild = child->leftside;
+                child->leftside = NULL;
+                destroyBooleanExpression(expression);
+                return grandchild;
+            }
+            /* !0 = 1, !1 = 0 */
+            if (isBinaryConstant(child, 0) || isBinaryConstant(child, 1))
+            {
+                return replaceWithConstant(expression, child->value[0] == 0);
+            }
+            return expression;
+        }
+
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            if (expression->leftside == NULL || expression->rightside == NULL)
+            {
+                return expression;
+            }
+            return optimizeJunction(expression);
+        }
+
+        case BoolExprGREATER:
+        case BoolExprLOWER:
+        case BoolExprEQUAL:
+        {
+            if (expression->leftside == NULL || expression->rightside == NULL)
+            {
+                return expression;
+            }
+            return optimizeComparison(expression);
+        }
+
+        default:
+            return expression;
+    }
+}
+
+/*
+ *  simplifies the given expression without changing its result: constants are folded, double negations
+ *  are removed and idempotence, complement and absorption are applied. Removed nodes are destroyed.
+ *  returns the root of the optimized expression, which replaces the given expression
+ */
+BooleanExpression* optimizeBooleanExpression(BooleanExpression* expression)
+{
+    BooleanExpression* result = optimizeNode(expression);
+    if (result != NULL)
+    {
+        result->parent = NULL;
+    }
+    return result;
+}
+
+/* returns the amount of nodes of the given expression */
+unsigned int countBooleanExpressionNodes(BooleanExpression* expression)
+{
+    if (expression == NULL)
+    {
+        return 0;
+    }
+    return 1 + countBooleanExpressionNodes(expression->leftside) + countBooleanExpressionNodes(expression->rightside);
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef BOOLEANEXPRESSIONOPTIMIZER_H
+#define BOOLEANEXPRESSIONOPTIMIZER_H
+
+#include "BooleanExpressionParser.h"
+
+BooleanExpression* optimizeBooleanExpression(BooleanExpression* expression);
+unsigned int countBooleanExpressionNodes(BooleanExpression* expression);
+
+#endif
\ No newline at end of file
@@ -1,29 +1,52 @@
 #include "BooleanExpressionParser.h"
 #include "../logging/log.h"
 
-/* All possible token types used in the shunting-yard-algorithm */
+#define SYMBOLTABLE_MIN_BUCKETS 8
+
+/* All possible token types of a boolean expression */
 typedef enum TokenTypes
 {
+    TokenTypeEnd,
     TokenTypeOperand,
     TokenTypeOperator,
-    TokenTypeOpeningParentheses
+    TokenTypeOpeningParentheses,
+    TokenTypeClosingParentheses
 } TokenType;
 
 /*
- *  Tokens are used for parsing the given expression in infix notation to an expression in RPN
+ *  Tokens are views into the parsed string, their content is never copied
  *  type - the type of the token
- *  precedence - if the token is an operator this number represents how strong it binds to its operands (higher number <=> stronger bind)
- *  content - a string representation of the token, could be operator (&,|,!,<,>,=), a number or a name for a sensor / an actuator (not null-terminated)
- *  length - the length of the string representation
+ *  content - the start of the token inside of the parsed string (not null-terminated)
+ *  length - the length of the token
+ *  position - the offset of the token inside of the parsed string, used for error messages
  */
 typedef struct Token_s
 {
     TokenType type;
-    unsigned int precedence;
-    char* content;
+    const char* content;
     unsigned int length;
+    unsigned int position;
 } Token;
 
+/*
+ *  The state of the parser while parsing a single expression
+ *  str - the parsed string
+ *  length - the length of the parsed string
+ *  position - the offset of the next unread character
+ *  current - the token that is parsed next
+ *  symbols - resolves the names of the variables
+ *  error - receives the first error found in the expression
+ */
+typedef struct
+{
+    const char* str;
+    unsigned int length;
+    unsigned int position;
+    Token current;
+    SymbolTable* symbols;
+    BooleanExpressionParseError* error;
+} Parser;
+
 Variable* getVariableWithName(Variable* variables, char* name, int variablesCount)
 {
     Variable* current = variables;
@@ -38,294 +61,452 @@ Variable* getVariableWithName(Variable* variables, char* name, int variablesCoun
     return NULL;
 }
 
-static unsigned int isNumber(char *str, int length)
+/* FNV-1a hash of a name of the given length */
+static unsigned int hashName(const char* name, unsigned int length)
 {
-    for (int i = 0; i < length; i++)
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < length; i++)
     {
-        if (str[i] - 48 < 0 || str[i] - 48 > 9)
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ *  creates a hashed lookup table for the names of the given variables, the variables have to
+ *  outlive the table and every expression parsed with it. If a name occurs more than once the
+ *  first variable with this name is used.
+ */
+SymbolTable* createSymbolTable(Variable* variables, unsigned int variablesCount)
+{
+    SymbolTable* symbols = malloc(sizeof(*symbols));
+    if (symbols == NULL)
+    {
+        log_error("BooleanExpressionParser: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    /* at most half of the buckets are used, so every probe sequence ends quickly */
+    symbols->bucketCount = SYMBOLTABLE_MIN_BUCKETS;
+    while (symbols->bucketCount < variablesCount * 2)
+    {
+        symbols->bucketCount *= 2;
+    }
+    symbols->variables = variables;
+    symbols->variablesCount = variablesCount;
+    symbols->buckets = calloc(symbols->bucketCount, sizeof(*symbols->buckets));
+    symbols->nameLengths = malloc(sizeof(*symbols->nameLengths) * (variablesCount > 0 ? variablesCount : 1));
+    if (symbols->buckets == NULL || symbols->nameLengths == NULL)
+    {
+        log_error("BooleanExpressionParser: malloc error %s", strerror(errno));
+        destroySymbolTable(symbols);
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < variablesCount; i++)
+    {
+        symbols->nameLengths[i] = strlen(variables[i].name);
+        if (lookupSymbol(symbols, variables[i].name, symbols->nameLengths[i]) != NULL)
         {
-            return 0;
+            continue;
+        }
+        unsigned int bucket = hashName(variables[i].name, symbols->nameLengths[i]) & (symbols->bucketCount - 1);
+        while (symbols->buckets[bucket] != 0)
+        {
+            bucket = (bucket + 1) & (symbols->bucketCount - 1);
         }
+        symbols->buckets[bucket] = i + 1;
     }
-    return 1;
+    return symbols;
 }
 
-static char* parseNumber(char *str, int length)
+/* returns the variable with the given name (not null-terminated) or NULL if there is none */
+Variable* lookupSymbol(SymbolTable* symbols, const char* name, unsigned int length)
 {
-    long long number = 0;
-    unsigned int size = sizeof(long long);
-    char* result = malloc(size);
-    for (int i = 0; i < length; i++)
+    unsigned int bucket = hashName(name, length) & (symbols->bucketCount - 1);
+    while (symbols->buckets[bucket] != 0)
     {
-        number = number * 10 + (str[i] - 48);
+        unsigned int index = symbols->buckets[bucket] - 1;
+        if (symbols->nameLengths[index] == length && !memcmp(symbols->variables[index].name, name, length))
+        {
+            return &symbols->variables[index];
+        }
+        bucket = (bucket + 1) & (symbols->bucketCount - 1);
     }
-    for (int i = 0; i < size/8; i++)
+    return NULL;
+}
+
+void destroySymbolTable(SymbolTable* symbols)
+{
+    if (symbols == NULL)
     {
-        result[i] = (number << (i * 8)) >> (size - 8);
+        return;
     }
-    free(str);
-    return result;
+    free(symbols->buckets);
+    free(symbols->nameLengths);
+    free(symbols);
 }
 
+/* returns the precedence of the given binary operator (higher number <=> stronger bind), -1 if it is none */
 static int getOperatorPrecedence(char operator)
 {
     switch(operator)
     {
-        case '&':
-            return 3;
-        case '!':
-            return 4;
         case '|':
+            return 1;
+        case '&':
             return 2;
         case '=':
-            return 1;
+            return 3;
         case '>':
-            return 1;
+            return 3;
         case '<':
-            return 1;
+            return 3;
         default:
             return -1;
     }
 }
 
-static void destroyToken(Token *token)
+/* the negation binds stronger than all binary operators */
+#define NEGATION_PRECEDENCE 4
+
+static unsigned int isDelimiter(char character)
 {
-    free(token->content);
-    free(token);
+    switch (character)
+    {
+        case '&':
+        case '|':
+        case '<':
+        case '>':
+        case '=':
+        case '!':
+        case '(':
+        case ')':
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case '\0':
+            return 1;
+        default:
+            return 0;
+    }
 }
 
-/* can be used to print an overview of the queue */
-static void printTokenQueue(queue_t* queue)
+/* reads the next token of the parsed string into parser->current */
+static void nextToken(Parser* parser)
 {
-    printf("Current queue:\n");
-    if (queue_empty(queue))
+    while (parser->position < parser->length &&
+           (parser->str[parser->position] == ' ' || parser->str[parser->position] == '\t' ||
+            parser->str[parser->position] == '\r' || parser->str[parser->position] == '\n'))
+    {
+        parser->position++;
+    }
+
+    Token* token = &parser->current;
+    token->content = parser->str + parser->position;
+    token->position = parser->position;
+    token->length = 1;
+    if (parser->position >= parser->length || parser->str[parser->position] == '\0')
     {
+        token->type = TokenTypeEnd;
+        token->length = 0;
         return;
     }
-    struct queue_node_s *current = queue->front;
-    Token *token = (Token*)current->data;
-    while (token != NULL)
+
+    switch (parser->str[parser->position])
     {
-        printf("Type: %d, Content: %.*s, Length: %d, Precedence: %d\n", token->type, token->length, token->content, token->length, token->precedence);
-        if (current->next != NULL)
-            current = current->next;
-        else
+        case '(':
+            token->type = TokenTypeOpeningParentheses;
+            break;
+
+        case ')':
+            token->type = TokenTypeClosingParentheses;
+            break;
+
+        case '&':
+        case '|':
+        case '<':
+        case '>':
+        case '=':
+        case '!':
+            token->type = TokenTypeOperator;
             break;
-        token = (Token*)current->data;
+
+        default:
+        {
+            token->type = TokenTypeOperand;
+            token->length = 0;
+            while (parser->position + token->length < parser->length && !isDelimiter(parser->str[parser->position + token->length]))
+            {
+                token->length++;
+            }
+            break;
+        }
     }
+    parser->position += token->length;
 }
 
-/* can be used to print an overview of the stack */
-static void printTokenStack(stack_dt *stack)
+/* records the first error of the expression, always returns NULL */
+static BooleanExpression* parserError(Parser* parser, unsigned int position, const char* message)
 {
-    printf("Current stack:\n");
-    if (stack_empty(stack))
+    if (parser->error->message == NULL)
     {
-        return;
+        parser->error->position = position;
+        parser->error->message = message;
     }
-    struct stack_frame_s *current = stack->top;
-    Token *token = (Token*)current->data;
-    while (token != NULL)
+    return NULL;
+}
+
+static BooleanExpression* createExpressionNode(Parser* parser, unsigned int type, OperandType operandType, OperandType resultType)
+{
+    BooleanExpression* expression = malloc(sizeof(*expression));
+    if (expression == NULL)
     {
-        printf("Type: %d, Content: %.*s, Length: %d, Precedence: %d\n", token->type, token->length, token->content, token->length, token->precedence);
-        if (current->next != NULL)
-            current = current->next;
-        else
-            break;
-        token = (Token*)current->data;
+        log_error("BooleanExpressionParser: malloc error %s", strerror(errno));
+        return parserError(parser, parser->current.position, "out of memory");
     }
+    *expression = (BooleanExpression){type, NULL, NULL, NULL, NULL, NULL, 1, operandType, resultType};
+    return expression;
 }
 
-/* removes all negation operators that would cancel out each other */
-static void removeDoubleNegation(char *str, unsigned int length)
+/* creates a constant from a number token, its type is decided by the operator it is used with */
+static BooleanExpression* parseConstant(Parser* parser, Token* token)
 {
-    int lastNegation = 0;
-    int negationFound = 0;
-    for (int i = 0; i < length; i++)
+    unsigned long long number = 0;
+    for (int i = 0; i < token->length; i++)
     {
-        if (str[i] == '!' && !negationFound)
+        if (token->content[i] < '0' || token->content[i] > '9')
         {
-            negationFound = 1;
-            lastNegation = i;
+            return parserError(parser, token->position, "unknown variable");
         }
-        else if (str[i] == '!' && negationFound)
-        {
-            negationFound = 0;
-            str[i] = ' ';
-            str[lastNegation] = ' ';
-        }
-        else if (str[i] != ' ' && str[i] != '!')
-        {
-            negationFound = 0;
-        }
-    }    
-}
-
-/* Is called when an operator is found in the given expression TODO: error handling*/
-static int shuntingyardReadOperator(char operator, char *firstOperand, unsigned int *sizeFirstOperand, 
-                            unsigned int *startIndexFirstOperand, queue_t *queue, stack_dt *stack)
-{
-    int precedence = getOperatorPrecedence(operator);
+        number = number * 10 + (token->content[i] - '0');
+    }
 
-    if (precedence < 1)
+    BooleanExpression* constant = createExpressionNode(parser, BoolExprCONSTANT, OperandTypeUnknown, OperandTypeUnknown);
+    if (constant == NULL)
     {
-        return 0;
+        return NULL;
     }
-
-    if (*sizeFirstOperand)
+    constant->valueSize = sizeof(long long);
+    constant->value = malloc(constant->valueSize);
+    if (constant->value == NULL)
     {
-        Token *operandToken = malloc(sizeof(Token));
-        operandToken->type = TokenTypeOperand;
-        operandToken->content = malloc(*sizeFirstOperand);
-        memcpy(operandToken->content, firstOperand, *sizeFirstOperand);
-        operandToken->length = *sizeFirstOperand;
-        operandToken->precedence = 0;
-        queue_enqueue(queue, operandToken);
+        log_error("BooleanExpressionParser: malloc error %s", strerror(errno));
+        free(constant);
+        return parserError(parser, token->position, "out of memory");
     }
-
-    Token *operatorToken = malloc(sizeof(Token));
-    operatorToken->type = TokenTypeOperator;
-    operatorToken->content = malloc(1);
-    operatorToken->content[0] = operator;
-    operatorToken->length = 1;
-    operatorToken->precedence = precedence;
-
-    while ( !stack_empty(stack) && 
-            ((Token*)stack->top->data)->type == TokenTypeOperator &&
-            operatorToken->precedence <= ((Token*)stack->top->data)->precedence )
+    for (int i = 0; i < constant->valueSize; i++)
     {
-        queue_enqueue(queue, stack_pop(stack));
+        constant->value[i] = number >> ((constant->valueSize - 1 - i) * 8);
     }
-    
-    stack_push(stack, operatorToken);
-
-    *startIndexFirstOperand += *sizeFirstOperand+1;
-    *sizeFirstOperand = 0;
-
-    return 1;
+    return constant;
 }
 
-/* A simple implementation of the shunting-yard-algorithm */
-static queue_t *shuntingyardAlgorithm(char *str, unsigned int length)
+/*
+ *  checks that the given operand results in a value of the given type, constants without a type
+ *  are converted to it. Binary constants have to be 0 or 1.
+ *  returns 0 if the operand can not be used with the given type
+ */
+static int adaptOperand(Parser* parser, BooleanExpression* operand, OperandType type, unsigned int position)
 {
-    removeDoubleNegation(str, strlen(str));
-	queue_t *queue = queue_new();
-	stack_dt *stack = stack_new();
-    char currentValue[length];
-    unsigned int sizeCurrentValue = 0;
-    unsigned int startIndexCurrentValue = 0;
-	for (int i = 0; i < length; i++)
-	{
-		switch(str[i])
+    if (operand->resultType == OperandTypeUnknown)
+    {
+        if (type == OperandTypeBinary)
         {
-            case '&':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
-
-            case '|':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
-
-            case '<':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
-
-            case '>':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
+            for (int i = 0; i < operand->valueSize - 1; i++)
+            {
+                if (operand->value[i] != 0)
+                {
+                    parserError(parser, position, "binary constants have to be 0 or 1");
+                    return 0;
+                }
+            }
+            if ((unsigned char)operand->value[operand->valueSize - 1] > 1)
+            {
+                parserError(parser, position, "binary constants have to be 0 or 1");
+                return 0;
+            }
+            operand->value[0] = operand->value[operand->valueSize - 1];
+            operand->valueSize = 1;
+        }
+        operand->operandType = type;
+        operand->resultType = type;
+        return 1;
+    }
+    if (operand->resultType != type)
+    {
+        parserError(parser, position, type == OperandTypeBinary ? "binary operand expected" : "number operand expected");
+        return 0;
+    }
+    return 1;
+}
 
-            case '=':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
+static BooleanExpression* parseExpression(Parser* parser, int minimumPrecedence);
 
-            case '!':
-                shuntingyardReadOperator(str[i], currentValue, &sizeCurrentValue, &startIndexCurrentValue, queue, stack);
-                break;
+/* parses a variable, a constant, a negation or an expression in parentheses */
+static BooleanExpression* parseOperand(Parser* parser)
+{
+    Token token = parser->current;
+    switch (token.type)
+    {
+        case TokenTypeOperand:
+        {
+            nextToken(parser);
+            Variable* variable = lookupSymbol(parser->symbols, token.content, token.length);
+            if (variable == NULL)
+            {
+                return parseConstant(parser, &token);
+            }
+            if (variable->value == NULL)
+            {
+                return parserError(parser, token.position, "variable has no value");
+            }
+            BooleanExpression* leaf = createExpressionNode(parser, BoolExprVARIABLE, variable->type, variable->type);
+            if (leaf != NULL)
+            {
+                leaf->name = variable->name;
+                leaf->value = (char*)variable->value;
+                leaf->valueSize = variable->valueSize;
+            }
+            return leaf;
+        }
 
-            case '(':
+        case TokenTypeOpeningParentheses:
+        {
+            nextToken(parser);
+            BooleanExpression* expression = parseExpression(parser, 0);
+            if (expression == NULL)
             {
-                Token *token = malloc(sizeof(Token));
-                token->type = TokenTypeOpeningParentheses;
-                token->content = malloc(1);
-                token->content[0] = str[i];
-                token->length = 1;
-                token->precedence = 0;
-                stack_push(stack, token);
-                startIndexCurrentValue++;
-                break;
+                return NULL;
             }
+            if (parser->current.type != TokenTypeClosingParentheses)
+            {
+                destroyBooleanExpression(expression);
+                return parserError(parser, parser->current.position, "missing closing parenthesis");
+            }
+            nextToken(parser);
+            return expression;
+        }
 
-            case ')':
+        case TokenTypeOperator:
+        {
+            if (token.content[0] != '!')
             {
-                if (sizeCurrentValue > 0)
-                {
-                    Token *token = malloc(sizeof(Token));
-                    token->type = TokenTypeOperand;
-                    token->content = malloc(sizeCurrentValue);
-                    memcpy(token->content, currentValue, sizeCurrentValue);
-                    token->length = sizeCurrentValue;
-                    token->precedence = 0;
-                    queue_enqueue(queue, token);
-                    startIndexCurrentValue += sizeCurrentValue+1;
-                    sizeCurrentValue = 0;
-                }
-                while (!(((Token*)stack->top->data)->type == TokenTypeOpeningParentheses))
-                {
-                    if(stack_empty(stack))
-                    {
-                        log_error("BooleanExpressionParser: Too many closing parentheses\n");
-                        return NULL;
-                    }
-                    queue_enqueue(queue, stack_pop(stack));
-                }
-                destroyToken((Token*)stack_pop(stack));
-                break;
+                return parserError(parser, token.position, "operand expected");
             }
+            nextToken(parser);
+            BooleanExpression* operand = parseExpression(parser, NEGATION_PRECEDENCE);
+            if (operand == NULL)
+            {
+                return NULL;
+            }
+            BooleanExpression* negation = createExpressionNode(parser, BoolExprNOT, OperandTypeBinary, OperandTypeBinary);
+            if (negation == NULL || !adaptOperand(parser, operand, OperandTypeBinary, token.position + 1))
+            {
+                destroyBooleanExpression(operand);
+                free(negation);
+                return NULL;
+            }
+            negation->leftside = operand;
+            operand->parent = negation;
+            return negation;
+        }
 
-            case ' ':
-                startIndexCurrentValue++;
-                break;
+        case TokenTypeClosingParentheses:
+            return parserError(parser, token.position, "operand expected");
 
-            case '\n':
-                if (sizeCurrentValue > 0)
-                {
-                    Token *token = malloc(sizeof(Token));
-                    token->type = TokenTypeOperand;
-                    token->content = malloc(sizeCurrentValue);
-                    memcpy(token->content, currentValue, sizeCurrentValue);
-                    token->length = sizeCurrentValue;
-                    token->precedence = 0;
-                    queue_enqueue(queue, token);
-                }
-                break;
+        default:
+            return parserError(parser, token.position, "unexpected end of expression");
+    }
+}
 
-            default:
-                currentValue[i-startIndexCurrentValue] = str[i];
-                sizeCurrentValue++;
-        }
-        if (i == length-1 && sizeCurrentValue > 0)
+/* creates the node of a binary operator and checks the types of both operands */
+static BooleanExpression* createOperation(Parser* parser, Token* operator, BooleanExpression* left, BooleanExpression* right)
+{
+    BooleanExpression* operation;
+    switch (operator->content[0])
+    {
+        case '&':
+            operation = createExpressionNode(parser, BoolExprAND, OperandTypeBinary, OperandTypeBinary);
+            break;
+        case '|':
+            operation = createExpressionNode(parser, BoolExprOR, OperandTypeBinary, OperandTypeBinary);
+            break;
+        case '>':
+            operation = createExpressionNode(parser, BoolExprGREATER, OperandTypeNumber, OperandTypeBinary);
+            break;
+        case '<':
+            operation = createExpressionNode(parser, BoolExprLOWER, OperandTypeNumber, OperandTypeBinary);
+            break;
+        default:
+            operation = createExpressionNode(parser, BoolExprEQUAL, OperandTypeNumber, OperandTypeBinary);
+            break;
+    }
+    if (operation == NULL)
+    {
+        return NULL;
+    }
+    if (!adaptOperand(parser, left, operation->operandType, operator->position) ||
+        !adaptOperand(parser, right, operation->operandType, operator->position))
+    {
+        free(operation);
+        return NULL;
+    }
+    operation->leftside = left;
+    operation->rightside = right;
+    left->parent = operation;
+    right->parent = operation;
+    return operation;
+}
+
+/* precedence climbing: parses operands joined by binary operators binding stronger than minimumPrecedence */
+static BooleanExpression* parseExpression(Parser* parser, int minimumPrecedence)
+{
+    BooleanExpression* left = parseOperand(parser);
+    if (left == NULL)
+    {
+        return NULL;
+    }
+
+    while (parser->current.type == TokenTypeOperator && getOperatorPrecedence(parser->current.content[0]) > minimumPrecedence)
+    {
+        Token operator = parser->current;
+        nextToken(parser);
+        /* operators of the same precedence are left-associative */
+        BooleanExpression* right = parseExpression(parser, getOperatorPrecedence(operator.content[0]));
+        if (right == NULL)
         {
-            Token *token = malloc(sizeof(Token));
-            token->type = TokenTypeOperand;
-            token->content = malloc(sizeCurrentValue);
-            memcpy(token->content, currentValue, sizeCurrentValue);
-            token->length = sizeCurrentValue;
-            token->precedence = 0;
-            queue_enqueue(queue, token);
+            destroyBooleanExpression(left);
+            return NULL;
         }
-	}
-    while (!stack_empty(stack))
-    {
-        if (((Token*)stack->top->data)->type == TokenTypeOpeningParentheses)
+        BooleanExpression* operation = createOperation(parser, &operator, left, right);
+        if (operation == NULL)
         {
-            printf("Error: Too many opening parentheses\n");
+            destroyBooleanExpression(left);
+            destroyBooleanExpression(right);
             return NULL;
         }
-        queue_enqueue(queue, stack_pop(stack));
+        left = operation;
     }
+    return left;
+}
 
-    stack_destroy(stack);
-    return queue;
+/* creates a binary constant with the given value (0 or 1), returns NULL if it could not be created */
+BooleanExpression* createBinaryConstant(char value)
+{
+    BooleanExpression* constant = malloc(sizeof(*constant));
+    char* constantValue = malloc(1);
+    if (constant == NULL || constantValue == NULL)
+    {
+        log_error("BooleanExpressionParser: malloc error %s", strerror(errno));
+        free(constant);
+        free(constantValue);
+        return NULL;
+    }
+    constantValue[0] = value;
+    *constant = (BooleanExpression){BoolExprCONSTANT, NULL, NULL, NULL, NULL, constantValue, 1, OperandTypeBinary, OperandTypeBinary};
+    return constant;
 }
 
 void destroyBooleanExpression(BooleanExpression *expression)
@@ -338,12 +519,8 @@ void destroyBooleanExpression(BooleanExpression *expression)
     destroyBooleanExpression(expression->leftside);
     destroyBooleanExpression(expression->rightside);
 
-    if (expression->name != NULL)
-    {
-        free(expression->name);
-    }
-
-    if (expression->name == NULL && expression->value != NULL)
+    /* variables point to the value of the variable, all other values belong to the expression */
+    if (expression->type != BoolExprVARIABLE && expression->value != NULL)
     {
         free(expression->value);
     }
@@ -351,215 +528,65 @@ void destroyBooleanExpression(BooleanExpression *expression)
     free(expression);
 }
 
-int inVariables(Token* token, Variable* variables, unsigned int variablesCount)
+/*
+ *  parses a boolean expression in a single pass, the names of variables are resolved with the given
+ *  symbol table. Operators by decreasing precedence: !, (=, <, >), &, |
+ *  str     -   the expression, it is not modified
+ *  length  -   the length of the expression
+ *  symbols -   the symbol table containing all variables that may be used
+ *  error   -   receives the position and description of the first error, may be NULL
+ *  returns the parsed expression or NULL on error
+ */
+BooleanExpression* parseBooleanExpressionWithSymbols(const char* str, unsigned int length, SymbolTable* symbols, BooleanExpressionParseError* error)
 {
-    for (int i = 0; i < variablesCount; i++)
+    BooleanExpressionParseError localError;
+    if (error == NULL)
     {
-        if (token->length == strlen(variables[i].name))
-        {
-            unsigned int isEqual = 1;
-            for (int j = 0; j < token->length; j++)
-            {
-                if (token->content[j] != variables[i].name[j])
-                {
-                    isEqual = 0;
-                }
-            }
-            if (isEqual)
-            {
-                return i;
-            }
-        }
+        error = &localError;
     }
-    return -1;
-}
-
-char* adaptConstant(BooleanExpression* expression)
-{
-    switch (expression->operandType)
+    *error = (BooleanExpressionParseError){0, NULL};
+    if (str == NULL || symbols == NULL)
     {
-        case OperandTypeBinary:
-            expression->valueSize = 1;
-            char* result = malloc(1);
-            if (!strcmp(expression->value, "1"))
-            {
-                result[0] = 1;
-            }
-            else if (!strcmp(expression->value, "0"))
-            {
-                result[0] = 0;
-            }
-            else
-            {
-                free(result);
-                return NULL;
-            }
-            free(expression->value);
-            return result;
-            break;
+        error->message = "no expression given";
+        return NULL;
+    }
 
-        case OperandTypeNumber:
-            expression->valueSize = sizeof(long long);
-            if (isNumber(expression->value, strlen(expression->value)))
-            {
-                return parseNumber(expression->value, strlen(expression->value));
-            }
-            else
-            {
-                return NULL;
-            }
-            break;
-        
-        default:
-            return NULL;
+    Parser parser = {str, length, 0, {TokenTypeEnd, str, 0, 0}, symbols, error};
+    nextToken(&parser);
+    BooleanExpression* expression = parseExpression(&parser, 0);
+    if (expression == NULL)
+    {
+        return NULL;
+    }
+    if (parser.current.type != TokenTypeEnd)
+    {
+        destroyBooleanExpression(expression);
+        return parserError(&parser, parser.current.position,
+                           parser.current.type == TokenTypeClosingParentheses ? "unexpected closing parenthesis" : "operator expected");
     }
+    if (!adaptOperand(&parser, expression, OperandTypeBinary, 0))
+    {
+        destroyBooleanExpression(expression);
+        return NULL;
+    }
+    return expression;
 }
 
 /* this function is used to parse a boolean expression from a string with given length */
 BooleanExpression *parseBooleanExpression(char* str, unsigned int length, Variable* variables, unsigned int variablesCount)
 {
-    queue_t *queue = shuntingyardAlgorithm(str, length);
-    BooleanExpression *expression;
-    stack_dt *expressionStack = stack_new();
-
-    while (!queue_empty(queue))
+    SymbolTable* symbols = createSymbolTable(variables, variablesCount);
+    if (symbols == NULL)
     {
-        Token *token = (Token*)queue_dequeue(queue);
-
-        switch (token->type)
-        {
-            case TokenTypeOperator:
-            {
-                BooleanExpression *operation = malloc(sizeof(BooleanExpression));
-                *operation = (BooleanExpression){BoolExprCONSTANT, NULL, NULL, NULL, NULL, NULL, 1, OperandTypeUnknown, OperandTypeBinary};
-
-                if (token->content[0] == '!')
-                {
-                    operation->type = BoolExprNOT;
-                    operation->operandType = OperandTypeBinary;
-                    operation->valueSize = 1;
-                    operation->leftside = (BooleanExpression*)stack_pop(expressionStack);
-                    operation->leftside->parent = operation;
-                }
-                else
-                {
-                    switch(token->content[0])
-                    {
-                        case '&':
-                            operation->type = BoolExprAND;
-                            operation->operandType = OperandTypeBinary;
-                            operation->valueSize = 1;
-                            break;
-                        case '|':
-                            operation->type = BoolExprOR;
-                            operation->operandType = OperandTypeBinary;
-                            operation->valueSize = 1;
-                            break;
-                        case '>':
-                            operation->type = BoolExprGREATER;
-                            operation->operandType = OperandTypeNumber;
-                            operation->valueSize = 1;
-                            break;
-                        case '<':
-                            operation->type = BoolExprLOWER;
-                            operation->operandType = OperandTypeNumber;
-                            operation->valueSize = 1;
-                            break;
-                        case '=':
-                            operation->type = BoolExprEQUAL;
-                            operation->operandType = OperandTypeNumber;
-                            operation->valueSize = 1;
-                            break;
-                    }
-
-                    /* get the right child */
-                    operation->rightside = (BooleanExpression*)stack_pop(expressionStack);
-                    operation->rightside->parent = operation;
-
-                    if (operation->rightside->operandType == OperandTypeUnknown) // right child is a constant
-                    {
-                        operation->rightside->operandType = operation->operandType;
-                        operation->rightside->resultType = operation->operandType;
-                        operation->rightside->value = adaptConstant(operation->rightside);
-                    }
-                    else if (operation->rightside->operandType != operation->operandType)
-                    {
-                        log_error("BooleanExpressionParser: OperandTypes do not match!");
-                        return NULL;
-                    }
-                    else if (operation->rightside->resultType != operation->operandType)
-                    {
-                        log_error("BooleanExpressionParser: ResultType and OperandType do not match!");
-                        return NULL;
-                    }
-
-                    /* get the left child */
-                    operation->leftside = (BooleanExpression*)stack_pop(expressionStack);
-                    operation->leftside->parent = operation;
-
-                    if (operation->leftside->operandType == OperandTypeUnknown) // left child is a constant
-                    {
-                        operation->leftside->operandType = operation->operandType;
-                        operation->leftside->resultType = operation->operandType;
-                        operation->leftside->value = adaptConstant(operation->leftside);
-                    }
-                    else if (operation->leftside->operandType != operation->operandType)
-                    {
-                        log_error("BooleanExpressionParser: OperandTypes do not match!");
-                        return NULL;
-                    }
-                    else if (operation->leftside->resultType != operation->operandType)
-                    {
-                        log_error("BooleanExpressionParser: ResultType and OperandType do not match!");
-                        return NULL;
-                    }
-                }
-                stack_push(expressionStack, operation);
-                break;
-            }
-
-            case TokenTypeOperand:
-            {
-                BooleanExpression *leaf = malloc(sizeof(BooleanExpression));
-                *leaf = (BooleanExpression){BoolExprCONSTANT, NULL, NULL, leaf, NULL, NULL, 0, OperandTypeUnknown, OperandTypeUnknown};
-
-                int index = inVariables(token, variables, variablesCount);
-                if (index != -1)
-                {
-                    leaf->type = BoolExprVARIABLE;
-                    leaf->resultType = OperandTypeBinary;
-                    leaf->operandType = variables[index].type;
-                    leaf->name = malloc(token->length+1);
-                    memcpy(leaf->name, token->content, token->length);
-                    leaf->name[token->length] = '\0';
-                    leaf->value = variables[index].value;
-                    leaf->valueSize = variables[index].valueSize;
-                    if (leaf->value == NULL)
-                    {
-                        return NULL;
-                    }
-                }
-                else
-                {
-                    leaf->value = malloc(token->length+1);
-                    memcpy(leaf->value, token->content, token->length);
-                    leaf->value[token->length] = '\0';
-                }
-
-                stack_push(expressionStack, leaf);
-                break;
-            }
-            
-            default:
-                break;
-        }
-        destroyToken(token);
+        return NULL;
     }
-
-    expression = stack_pop(expressionStack);
-    queue_destroy(queue);
-    stack_destroy(expressionStack);
-
+    BooleanExpressionParseError error;
+    BooleanExpression* expression = parseBooleanExpressionWithSymbols(str, length, symbols, &error);
+    if (expression == NULL)
+    {
+        log_error("BooleanExpressionParser: %s at position %u of \"%.*s\"", error.message, error.position, length, str);
+    }
+    destroySymbolTable(symbols);
     return expression;
 }
 
@@ -638,294 +665,107 @@ void printBooleanExpression(BooleanExpression *expression)
     }
 }
 
-char* calculateValue(BooleanExpression* expression)
+/*
+ *  compares two operand values of possibly different sizes, both values are interpreted as 
+ *  unsigned big-endian numbers (the shorter one is padded with leading zeros)
+ *  returns 1 if left > right, -1 if left < right and 0 if both values are equal
+ */
+int compareOperandValues(const char* left, unsigned int leftSize, const char* right, unsigned int rightSize)
 {
-    char* result1;
-    char* result2;
-    char* result;
-    switch (expression->type)
+    unsigned int size = leftSize > rightSize ? leftSize : rightSize;
+    for (unsigned int i = 0; i < size; i++)
     {
-        case BoolExprCONSTANT:
+        unsigned char leftByte = i < size - leftSize ? 0 : (unsigned char)left[i - (size - leftSize)];
+        unsigned char rightByte = i < size - rightSize ? 0 : (unsigned char)right[i - (size - rightSize)];
+        if (leftByte != rightByte)
         {
-            if (expression->value != NULL)
-            {
-                return expression->value;
-            }
-            return NULL;
+            return leftByte > rightByte ? 1 : -1;
         }
+    }
+    return 0;
+}
 
+/* recursively calculates the value of the given expression without allocating, returns -1 on error */
+static int calculateValue(BooleanExpression* expression)
+{
+    int result1;
+    int result2;
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
         case BoolExprVARIABLE:
         {
-            if (expression->value != NULL)
+            if (expression->value == NULL)
             {
-                return expression->value;
+                return -1;
             }
-            return NULL;
+            return expression->value[0] != 0;
         }
 
         case BoolExprAND:
         {
             result1 = calculateValue(expression->leftside);
             result2 = calculateValue(expression->rightside);
-            if (result1 == NULL || result2 == NULL)
-            {
-                return NULL;
-            }
-            result = malloc(1);
-            if (result1[0] && result2[0])
+            if (result1 == -1 || result2 == -1)
             {
-                result[0] = 1;
+                return -1;
             }
-            else 
-            {
-                result[0] = 0;
-            }
-            return result;
+            return result1 && result2;
         }
 
         case BoolExprOR:
         {
             result1 = calculateValue(expression->leftside);
             result2 = calculateValue(expression->rightside);
-            if (result1 == NULL || result2 == NULL)
-            {
-                return NULL;
-            }
-            result = malloc(1);
-            if (result1[0] || result2[0])
+            if (result1 == -1 || result2 == -1)
             {
-                result[0] = 1;
+                return -1;
             }
-            else 
-            {
-                result[0] = 0;
-            }
-            return result;
+            return result1 || result2;
         }
 
         case BoolExprNOT:
         {
             result1 = calculateValue(expression->leftside);
-            if (result1 == NULL)
+            if (result1 == -1)
             {
-                return NULL;
+                return -1;
             }
-            result = malloc(1);
-            if (!result1[0])
-            {
-                result[0] = 1;
-            }
-            else 
-            {
-                result[0] = 0;
-            }
-            return result;
+            return !result1;
         }
 
         case BoolExprEQUAL:
-        {
-            result1 = calculateValue(expression->leftside);
-            result2 = calculateValue(expression->rightside);
-            unsigned int result1Size = expression->leftside->valueSize;
-            unsigned int result2Size = expression->rightside->valueSize;
-            if (result1 == NULL || result2 == NULL)
-            {
-                return NULL;
-            }
-            result = malloc(1);
-            result[0] = 1;
-            if (result1Size > result2Size)
-            {
-                for (int i = 0; i < result1Size - result2Size; i++)
-                {
-                    if (result1[i] != 0)
-                    {
-                        result[0] = 0;
-                        return result;
-                    }
-                }
-                for (int i = result1Size - result2Size; i < result1Size; i++)
-                {
-                    int j = i - (result1Size - result2Size);
-                    if (result1[i] != result2[j])
-                    {
-                        result[0] = 0;
-                        return result;
-                    }
-                }
-            }
-            else 
-            {
-                for (int i = 0; i < result2Size - result1Size; i++)
-                {
-                    if (result2[i] != 0)
-                    {
-                        result[0] = 0;
-                        return result;
-                    }
-                }
-                for (int i = result2Size - result1Size; i < result2Size; i++)
-                {
-                    int j = i - (result2Size - result1Size);
-                    if (result1[i] != result2[j])
-                    {
-                        result[0] = 0;
-                        return result;
-                    }
-                }
-            }
-            return result;
-        }
-
         case BoolExprGREATER:
-        {
-            result1 = calculateValue(expression->leftside);
-            result2 = calculateValue(expression->rightside);
-            unsigned int result1Size = expression->leftside->valueSize;
-            unsigned int result2Size = expression->rightside->valueSize;
-            if (result1 == NULL || result2 == NULL)
-            {
-                return NULL;
-            }
-            result = malloc(1);
-            result[0] = 0;
-            if (result1Size > result2Size)
-            {
-                for (int i = 0; i < result1Size - result2Size; i++)
-                {
-                    if (result1[i] != 0)
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                }
-                for (int i = result1Size - result2Size; i < result1Size; i++)
-                {
-                    int j = i - (result1Size - result2Size);
-                    if (result1[i] > result2[j])
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                    else if (result1[i] < result2[j])
-                    {
-                        return result;
-                    }
-                }
-            }
-            else 
-            {
-                for (int i = 0; i < result2Size - result1Size; i++)
-                {
-                    if (result2[i] != 0)
-                    {
-                        return result;
-                    }
-                }
-                for (int i = result2Size - result1Size; i < result2Size; i++)
-                {
-                    int j = i - (result2Size - result1Size);
-                    if (result1[i] > result2[j])
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                    else if (result1[i] < result2[j])
-                    {
-                        return result;
-                    }
-                }
-            }
-            return result;
-        }
-
         case BoolExprLOWER:
         {
-            result1 = calculateValue(expression->leftside);
-            result2 = calculateValue(expression->rightside);
-            unsigned int result1Size = expression->leftside->valueSize;
-            unsigned int result2Size = expression->rightside->valueSize;
-            if (result1 == NULL || result2 == NULL)
+            if (expression->leftside->value == NULL || expression->rightside->value == NULL)
             {
-                return NULL;
+                return -1;
             }
-            result = malloc(1);
-            result[0] = 0;
-            if (result1Size > result2Size)
+            int comparison = compareOperandValues(expression->leftside->value, expression->leftside->valueSize, 
+                                                  expression->rightside->value, expression->rightside->valueSize);
+            if (expression->type == BoolExprEQUAL)
             {
-                for (int i = 0; i < result1Size - result2Size; i++)
-                {
-                    if (result1[i] != 0)
-                    {
-                        return result;
-                    }
-                }
-                for (int i = result1Size - result2Size; i < result1Size; i++)
-                {
-                    int j = i - (result1Size - result2Size);
-                    if (result1[i] < result2[j])
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                    else if (result1[i] > result2[j])
-                    {
-                        return result;
-                    }
-                }
+                return comparison == 0;
             }
-            else 
+            else if (expression->type == BoolExprGREATER)
             {
-                for (int i = 0; i < result2Size - result1Size; i++)
-                {
-                    if (result2[i] != 0)
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                }
-                for (int i = result2Size - result1Size; i < result2Size; i++)
-                {
-                    int j = i - (result2Size - result1Size);
-                    if (result1[i] < result2[j])
-                    {
-                        result[0] = 1;
-                        return result;
-                    }
-                    else if (result1[i] > result2[j])
-                    {
-                        return result;
-                    }
-                }
+                return comparison > 0;
             }
-            return result;
+            return comparison < 0;
         }
         
         default:
-            break;
+            return -1;
     }
 }
 
 int evaluateBooleanExpression(BooleanExpression *expression)
 {
-    if (expression->resultType != OperandTypeBinary || expression->valueSize != 1)
-    {
-        return -1;
-    }
-
-    char* result = calculateValue(expression);
-
-    if (result == NULL)
+    if (expression == NULL || expression->resultType != OperandTypeBinary || expression->valueSize != 1)
     {
         return -1;
     }
 
-    if (*result = 1)
-    {
-        return 1;
-    }
-    else 
-    {
-        return 0;
-    }
-}
\ No newline at end of file
+    return calculateValue(expression);
+}
@@ -4,8 +4,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include "../utils/stack.h"
-#include "../utils/queue.h"
 
 typedef struct {
     int type;
@@ -41,16 +39,51 @@ struct BooleanExpression_s
     BooleanExpression*  leftside;
     BooleanExpression*  rightside;
     BooleanExpression*  parent;
-    unsigned char*      name;
+    const char*         name;
     char*               value;
     unsigned int        valueSize;
     OperandType         operandType;
     OperandType         resultType;
 };
 
+/*
+ *  A hashed lookup table for the names of variables, built once and used for many expressions
+ *  variables       -   the variables inside of the table
+ *  variablesCount  -   the amount of variables
+ *  nameLengths     -   the length of the name of every variable
+ *  buckets         -   the index of a variable plus one per bucket, 0 marks an empty bucket
+ *  bucketCount     -   the amount of buckets (always a power of two)
+ */
+typedef struct
+{
+    Variable*       variables;
+    unsigned int    variablesCount;
+    unsigned int*   nameLengths;
+    unsigned int*   buckets;
+    unsigned int    bucketCount;
+} SymbolTable;
+
+/*
+ *  Describes why an expression could not be parsed
+ *  position    -   the offset of the error inside of the expression
+ *  message     -   a description of the error
+ */
+typedef struct
+{
+    unsigned int    position;
+    const char*     message;
+} BooleanExpressionParseError;
+
+SymbolTable* createSymbolTable(Variable* variables, unsigned int variablesCount);
+Variable* lookupSymbol(SymbolTable* symbols, const char* name, unsigned int length);
+void destroySymbolTable(SymbolTable* symbols);
+
+BooleanExpression* parseBooleanExpressionWithSymbols(const char* str, unsigned int length, SymbolTable* symbols, BooleanExpressionParseError* error);
 BooleanExpression *parseBooleanExpression(char* str, unsigned int length, Variable* variables, unsigned int variablesCount);
 int evaluateBooleanExpression(BooleanExpression* expression);
+int compareOperandValues(const char* left, unsigned int leftSize, const char* right, unsigned int rightSize);
 void printBooleanExpression(BooleanExpression* expression);
+BooleanExpression* createBinaryConstant(char value);
 void destroyBooleanExpression(BooleanExpression* expression);
 Variable* getVariableWithName(Variable* variables, char* id, int variablesCount);
 
@@ -0,0 +1,243 @@
+#include "DependencyIndex.h"
+#include "../logging/log.h"
+
+static int getVariableIndexByValue(Variable* variables, unsigned int variablesCount, const char* value)
+{
+    for (int i = 0; i < variablesCount; i++)
+    {
+        if (variables[i].value == value)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  walks the given expression and records it as dependent of every variable it references
+ *  dependents      -   one list of dependent expressions per variable
+ *  dependentCounts -   the amount of dependents recorded per variable
+ *  expressionIndex -   the index of the walked expression
+ */
+static void collectDependencies(BooleanExpression* expression, Variable* variables, unsigned int variablesCount,
+                                unsigned int** dependents, unsigned int* dependentCounts, unsigned int expressionIndex)
+{
+    if (expression == NULL)
+    {
+        return;
+    }
+
+    if (expression->type == BoolExprVARIABLE)
+    {
+        int variableIndex = getVariableIndexByValue(variables, variablesCount, expression->value);
+        if (variableIndex == -1)
+        {
+            return;
+        }
+        unsigned int count = dependentCounts[variableIndex];
+        /* expressions are walked one after another, so a duplicate can only be the last entry */
+        if (count > 0 && dependents[variableIndex][count-1] == expressionIndex)
+        {
+            return;
+        }
+        dependents[variableIndex][count] = expressionIndex;
+        dependentCounts[variableIndex]++;
+        return;
+    }
+
+    collectDependencies(expression->leftside, variables, variablesCount, dependents, dependentCounts, expressionIndex);
+    collectDependencies(expression->rightside, variables, variablesCount, dependents, dependentCounts, expressionIndex);
+}
+
+/* frees the lists of dependents of all variables, used if the index could not be created */
+static void destroyDependents(unsigned int** dependents, unsigned int* dependentCounts, unsigned int variablesCount)
+{
+    for (int i = 0; i < variablesCount; i++)
+    {
+        free(dependents[i]);
+    }
+    free(dependents);
+    free(dependentCounts);
+}
+
+/*
+ *  creates a DependencyIndex for the given expressions, initially all expressions are marked as dirty
+ *  expressions     -   the parsed expressions, used to find the referenced variables
+ *  expressionCount -   the amount of expressions
+ *  variables       -   all variables the expressions may reference
+ *  variablesCount  -   the amount of variables
+ *  evaluator       -   evaluates a single expression during the updates
+ *  context         -   passed to every call of the evaluator
+ */
+DependencyIndex* createDependencyIndex(BooleanExpression** expressions, unsigned int expressionCount, Variable* variables, unsigned int variablesCount,
+                                       DependencyIndexEvaluator evaluator, void* context)
+{
+    DependencyIndex* index = calloc(1, sizeof(*index));
+    unsigned int* dependentCounts = calloc(variablesCount > 0 ? variablesCount : 1, sizeof(*dependentCounts));
+    unsigned int** dependents = calloc(variablesCount > 0 ? variablesCount : 1, sizeof(*dependents));
+    if (index == NULL || dependentCounts == NULL || dependents == NULL)
+    {
+        log_error("DependencyIndex: malloc error %s", strerror(errno));
+        free(index);
+        free(dependentCounts);
+        free(dependents);
+        return NULL;
+    }
+
+    /* every expression can reference a variable at most once, so this is an upper bound for the dependents */
+    int failed = 0;
+    for (int i = 0; i < variablesCount; i++)
+    {
+        dependents[i] = malloc(sizeof(**dependents) * (expressionCount > 0 ? expressionCount : 1));
+        failed |= dependents[i] == NULL;
+    }
+    if (failed)
+    {
+        log_error("DependencyIndex: malloc error %s", strerror(errno));
+        destroyDependents(dependents, dependentCounts, variablesCount);
+        destroyDependencyIndex(index);
+        return NULL;
+    }
+    for (int i = 0; i < expressionCount; i++)
+    {
+        collectDependencies(expressions[i], variables, variablesCount, dependents, dependentCounts, i);
+    }
+
+    unsigned int snapshotSize = 0;
+    for (int i = 0; i < variablesCount; i++)
+    {
+        if (dependentCounts[i] > 0)
+        {
+            index->variableCount++;
+            snapshotSize += variables[i].valueSize;
+        }
+    }
+
+    index->expressionCount = expressionCount;
+    index->evaluator = evaluator;
+    index->context = context;
+    index->variables = malloc(sizeof(*index->variables) * (index->variableCount > 0 ? index->variableCount : 1));
+    index->snapshot = calloc(snapshotSize > 0 ? snapshotSize : 1, 1);
+    index->results = malloc(sizeof(*index->results) * (expressionCount > 0 ? expressionCount : 1));
+    index->dirty = malloc(expressionCount > 0 ? expressionCount : 1);
+    index->dirtyList = malloc(sizeof(*index->dirtyList) * (expressionCount > 0 ? expressionCount : 1));
+    if (index->variables == NULL || index->snapshot == NULL || index->results == NULL || index->dirty == NULL || index->dirtyList == NULL)
+    {
+        log_error("DependencyIndex: malloc error %s", strerror(errno));
+        destroyDependents(dependents, dependentCounts, variablesCount);
+        index->variableCount = 0;
+        destroyDependencyIndex(index);
+        return NULL;
+    }
+
+    unsigned int variableIndex = 0;
+    unsigned int snapshotOffset = 0;
+    for (int i = 0; i < variablesCount; i++)
+    {
+        if (dependentCounts[i] == 0)
+        {
+            free(dependents[i]);
+            continue;
+        }
+        IndexedVariable* variable = &index->variables[variableIndex++];
+        variable->value = variables[i].value;
+        variable->valueSize = variables[i].valueSize;
+        variable->snapshotOffset = snapshotOffset;
+        variable->dependents = dependents[i];
+        variable->dependentCount = dependentCounts[i];
+        memcpy(index->snapshot + snapshotOffset, variable->value, variable->valueSize);
+        snapshotOffset += variables[i].valueSize;
+    }
+    free(dependents);
+    free(dependentCounts);
+
+    for (int i = 0; i < expressionCount; i++)
+    {
+        index->results[i] = -1;
+    }
+    invalidateDependencyIndex(index);
+
+    log_debug("DependencyIndex: %d expressions depend on %d variables", expressionCount, index->variableCount);
+    return index;
+}
+
+/* marks all expressions as dirty, so they are evaluated in the next update */
+void invalidateDependencyIndex(DependencyIndex* index)
+{
+    for (int i = 0; i < index->expressionCount; i++)
+    {
+        index->dirty[i] = 1;
+        index->dirtyList[i] = i;
+    }
+    index->dirtyCount = index->expressionCount;
+}
+
+/*
+ *  compares all referenced variables with their values from the last update and evaluates only
+ *  the expressions depending on changed variables (or marked as dirty otherwise)
+ *  returns the amount of evaluated expressions
+ */
+unsigned int updateDependencyIndex(DependencyIndex* index)
+{
+    for (unsigned int i = 0; i < index->variableCount; i++)
+    {
+        IndexedVariable* variable = &index->variables[i];
+        char* lastValue = index->snapshot + variable->snapshotOffset;
+        if (variable->valueSize == 1 ? lastValue[0] == variable->value[0] : !memcmp(lastValue, variable->value, variable->valueSize))
+        {
+            continue;
+        }
+        memcpy(lastValue, variable->value, variable->valueSize);
+        for (unsigned int j = 0; j < variable->dependentCount; j++)
+        {
+            unsigned int dependent = variable->dependents[j];
+            if (!index->dirty[dependent])
+            {
+                index->dirty[dependent] = 1;
+                index->dirtyList[index->dirtyCount++] = dependent;
+            }
+        }
+    }
+
+    unsigned int evaluations = index->dirtyCount;
+    for (unsigned int i = 0; i < evaluations; i++)
+    {
+        unsigned int expression = index->dirtyList[i];
+        index->results[expression] = index->evaluator(index->context, expression);
+        index->dirty[expression] = 0;
+    }
+    index->dirtyCount = 0;
+
+    index->lastEvaluations = evaluations;
+    index->updates++;
+    index->evaluations += evaluations;
+    index->skippedEvaluations += index->expressionCount - evaluations;
+    return evaluations;
+}
+
+/* returns the result of the given expression as calculated during the last update */
+int getCachedResult(DependencyIndex* index, unsigned int expression)
+{
+    return index->results[expression];
+}
+
+void destroyDependencyIndex(DependencyIndex* index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+    if (index->variables != NULL)
+    {
+        for (int i = 0; i < index->variableCount; i++)
+        {
+            free(index->variables[i].dependents);
+        }
+    }
+    free(index->variables);
+    free(index->snapshot);
+    free(index->results);
+    free(index->dirty);
+    free(index->dirtyList);
+    free(index);
+}
\ No newline at end of file
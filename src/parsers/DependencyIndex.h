@@ -0,0 +1,73 @@
+#ifndef DEPENDENCYINDEX_H
+#define DEPENDENCYINDEX_H
+
+#include "BooleanExpressionParser.h"
+
+/*
+ *  A variable referenced by at least one expression of a DependencyIndex
+ *  value           -   the address of the value of the variable
+ *  valueSize       -   the size of the value in bytes
+ *  snapshotOffset  -   the offset of the last seen value inside of the snapshot of the index
+ *  dependents      -   the indices of all expressions referencing the variable
+ *  dependentCount  -   the amount of expressions referencing the variable
+ */
+typedef struct
+{
+    const char*     value;
+    unsigned int    valueSize;
+    unsigned int    snapshotOffset;
+    unsigned int*   dependents;
+    unsigned int    dependentCount;
+} IndexedVariable;
+
+/*
+ *  evaluates the expression with the given index, returns 1 or 0 as its result and -1 on error
+ *  context     -   the context given to createDependencyIndex
+ *  expression  -   the index of the expression
+ */
+typedef int (*DependencyIndexEvaluator)(void* context, unsigned int expression);
+
+/*
+ *  Maps every variable to the expressions referencing it, so only expressions whose inputs changed
+ *  since the last update are evaluated again. The results of all expressions are cached.
+ *  variables           -   all variables referenced by the expressions
+ *  variableCount       -   the amount of referenced variables
+ *  snapshot            -   the values of all referenced variables as seen in the last update
+ *  evaluator           -   evaluates a single expression
+ *  context             -   passed to every call of the evaluator
+ *  expressionCount     -   the amount of expressions
+ *  results             -   the cached result of every expression
+ *  dirty               -   marks the expressions that need to be evaluated in the next update
+ *  dirtyList           -   the indices of all expressions marked as dirty
+ *  dirtyCount          -   the amount of expressions marked as dirty
+ *  updates             -   the amount of updates so far
+ *  evaluations         -   the amount of evaluations done by all updates so far
+ *  skippedEvaluations  -   the amount of evaluations skipped by all updates so far
+ *  lastEvaluations     -   the amount of evaluations done by the last update
+ */
+typedef struct
+{
+    IndexedVariable*            variables;
+    unsigned int                variableCount;
+    char*                       snapshot;
+    DependencyIndexEvaluator    evaluator;
+    void*                       context;
+    unsigned int                expressionCount;
+    int*                        results;
+    unsigned char*              dirty;
+    unsigned int*               dirtyList;
+    unsigned int                dirtyCount;
+    unsigned long long          updates;
+    unsigned long long          evaluations;
+    unsigned long long          skippedEvaluations;
+    unsigned int                lastEvaluations;
+} DependencyIndex;
+
+DependencyIndex* createDependencyIndex(BooleanExpression** expressions, unsigned int expressionCount, Variable* variables, unsigned int variablesCount,
+                                       DependencyIndexEvaluator evaluator, void* context);
+unsigned int updateDependencyIndex(DependencyIndex* index);
+int getCachedResult(DependencyIndex* index, unsigned int expression);
+void invalidateDependencyIndex(DependencyIndex* index);
+void destroyDependencyIndex(DependencyIndex* index);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "ExpressionStore.h"
+#include <stdint.h>
+#include "../logging/log.h"
+
+/* FNV-1a over the given bytes, continuing from the given hash */
+static unsigned int hashBytes(unsigned int hash, const void* bytes, unsigned int length)
+{
+    const unsigned char* current = bytes;
+    for (unsigned int i = 0; i < length; i++)
+    {
+        hash ^= current[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int hashNode(unsigned int type, SharedExpression* leftside, SharedExpression* rightside, const char* value, unsigned int valueSize)
+{
+    unsigned int hash = 2166136261u;
+    hash = hashBytes(hash, &type, sizeof(type));
+    hash = hashBytes(hash, &leftside, sizeof(leftside));
+    hash = hashBytes(hash, &rightside, sizeof(rightside));
+    if (type == BoolExprCONSTANT)
+    {
+        hash = hashBytes(hash, value, valueSize);
+    }
+    else
+    {
+        hash = hashBytes(hash, &value, sizeof(value));
+    }
+    return hash;
+}
+
+static unsigned int isSameNode(SharedExpression* node, unsigned int type, SharedExpression* leftside, SharedExpression* rightside, const char* value, unsigned int valueSize)
+{
+    if (node->type != type || node->leftside != leftside || node->rightside != rightside || node->valueSize != valueSize)
+    {
+        return 0;
+    }
+    if (type == BoolExprCONSTANT)
+    {
+        return !memcmp(node->value, value, valueSize);
+    }
+    return node->value == value;
+}
+
+/* doubles the amount of buckets of the store */
+static int growExpressionStore(ExpressionStore* store)
+{
+    unsigned int bucketCount = store->bucketCount * 2;
+    SharedExpression** buckets = calloc(bucketCount, sizeof(*buckets));
+    if (buckets == NULL)
+    {
+        return 0;
+    }
+    for (unsigned int i = 0; i < store->bucketCount; i++)
+    {
+        SharedExpression* node = store->buckets[i];
+        while (node != NULL)
+        {
+            SharedExpression* next = node->next;
+            node->next = buckets[node->hash & (bucketCount - 1)];
+            buckets[node->hash & (bucketCount - 1)] = node;
+            node = next;
+        }
+    }
+    free(store->buckets);
+    store->buckets = buckets;
+    store->bucketCount = bucketCount;
+    return 1;
+}
+
+/* returns the node with the given content, the node is created if it does not exist yet */
+static SharedExpression* getOrCreateNode(ExpressionStore* store, unsigned int type, SharedExpression* leftside, SharedExpression* rightside, const char* value, unsigned int valueSize)
+{
+    /* and/or are commutative, ordering the children lets a & b and b & a share one node */
+    if ((type == BoolExprAND || type == BoolExprOR) && (uintptr_t)leftside > (uintptr_t)rightside)
+    {
+        SharedExpression* swap = leftside;
+        leftside = rightside;
+        rightside = swap;
+    }
+
+    store->requestedNodes++;
+    unsigned int hash = hashNode(type, leftside, rightside, value, valueSize);
+    for (SharedExpression* node = store->buckets[hash & (store->bucketCount - 1)]; node != NULL; node = node->next)
+    {
+        if (node->hash == hash && isSameNode(node, type, leftside, rightside, value, valueSize))
+        {
+            return node;
+        }
+    }
+
+    SharedExpression* node = malloc(sizeof(*node));
+    if (node == NULL)
+    {
+        log_error("ExpressionStore: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    *node = (SharedExpression){type, leftside, rightside, NULL, valueSize, hash, NULL, 0, -1};
+    if (type == BoolExprCONSTANT)
+    {
+        node->value = malloc(valueSize > 0 ? valueSize : 1);
+        if (node->value == NULL)
+        {
+            log_error("ExpressionStore: malloc error %s", strerror(errno));
+            free(node);
+            return NULL;
+        }
+        memcpy(node->value, value, valueSize);
+    }
+    else
+    {
+        node->value = (char*)value;
+    }
+
+    if (store->nodeCount + 1 > store->bucketCount - store->bucketCount / 4)
+    {
+        growExpressionStore(store);
+    }
+    node->next = store->buckets[hash & (store->bucketCount - 1)];
+    store->buckets[hash & (store->bucketCount - 1)] = node;
+    store->nodeCount++;
+    return node;
+}
+
+ExpressionStore* createExpressionStore(void)
+{
+    ExpressionStore* store = calloc(1, sizeof(*store));
+    if (store == NULL)
+    {
+        log_error("ExpressionStore: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    store->bucketCount = EXPRESSIONSTORE_INITIAL_BUCKETS;
+    store->buckets = calloc(store->bucketCount, sizeof(*store->buckets));
+    if (store->buckets == NULL)
+    {
+        log_error("ExpressionStore: malloc error %s", strerror(errno));
+        free(store);
+        return NULL;
+    }
+    store->epoch = 1;
+    return store;
+}
+
+/*
+ *  adds the given expression to the store and returns its root node, subexpressions which already
+ *  exist inside of the store are reused. The expression itself is not modified and may be destroyed.
+ */
+SharedExpression* internBooleanExpression(ExpressionStore* store, BooleanExpression* expression)
+{
+    if (store == NULL || expression == NULL)
+    {
+        return NULL;
+    }
+
+    SharedExpression* leftside = NULL;
+    SharedExpression* rightside = NULL;
+    if (expression->leftside != NULL)
+    {
+        leftside = internBooleanExpression(store, expression->leftside);
+        if (leftside == NULL)
+        {
+            return NULL;
+        }
+    }
+    if (expression->rightside != NULL)
+    {
+        rightside = internBooleanExpression(store, expression->rightside);
+        if (rightside == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    switch (expression->type)
+    {
+        case BoolExprVARIABLE:
+        case BoolExprCONSTANT:
+        {
+            if (expression->value == NULL)
+            {
+                return NULL;
+            }
+            return getOrCreateNode(store, expression->type, NULL, NULL, expression->value, expression->valueSize);
+        }
+
+        default:
+            return getOrCreateNode(store, expression->type, leftside, rightside, NULL, 0);
+    }
+}
+
+/* starts a new epoch, all memoized results become invalid */
+void advanceExpressionStoreEpoch(ExpressionStore* store)
+{
+    store->epoch++;
+}
+
+/*
+ *  evaluates a node of the store, every node is evaluated at most once per epoch
+ *  returns 1 or 0 as the result of the expression and -1 if it could not be evaluated
+ */
+int evaluateSharedExpression(ExpressionStore* store, SharedExpression* expression)
+{
+    if (expression == NULL)
+    {
+        return -1;
+    }
+    store->evaluations++;
+    if (expression->epoch == store->epoch)
+    {
+        store->memoHits++;
+        return expression->result;
+    }
+
+    int result;
+    int result1;
+    int result2;
+    switch (expression->type)
+    {
+        case BoolExprVARIABLE:
+        case BoolExprCONSTANT:
+            result = expression->value[0] != 0;
+            break;
+
+        case BoolExprNOT:
+            result1 = evaluateSharedExpression(store, expression->leftside);
+            result = result1 == -1 ? -1 : !result1;
+            break;
+
+        case BoolExprAND:
+            result1 = evaluateSharedExpression(store, expression->leftside);
+            result2 = evaluateSharedExpression(store, expression->rightside);
+            result = (result1 == -1 || result2 == -1) ? -1 : (result1 && result2);
+            break;
+
+        case BoolExprOR:
+            result1 = evaluateSharedExpression(store, expression->leftside);
+            result2 = evaluateSharedExpression(store, expression->rightside);
+            result = (result1 == -1 || result2 == -1) ? -1 : (result1 || result2);
+            break;
+
+        case BoolExprEQUAL:
+        case BoolExprGREATER:
+        case BoolExprLOWER:
+        {
+            int comparison = compareOperandValues(expression->leftside->value, expression->leftside->valueSize,
+                                                  expression->rightside->value, expression->rightside->valueSize);
+            if (expression->type == BoolExprEQUAL)
+            {
+                result = comparison == 0;
+            }
+            else if (expression->type == BoolExprGREATER)
+            {
+                result = comparison > 0;
+            }
+            else
+            {
+                result = comparison < 0;
+            }
+            break;
+        }
+
+        default:
+            result = -1;
+            break;
+    }
+
+    expression->result = result;
+    expression->epoch = store->epoch;
+    return result;
+}
+
+void destroyExpressionStore(ExpressionStore* store)
+{
+    if (store == NULL)
+    {
+        return;
+    }
+    for (unsigned int i = 0; i < store->bucketCount; i++)
+    {
+        SharedExpression* node = store->buckets[i];
+        while (node != NULL)
+        {
+            SharedExpression* next = node->next;
+            if (node->type == BoolExprCONSTANT)
+            {
+                free(node->value);
+            }
+            free(node);
+            node = next;
+        }
+    }
+    free(store->buckets);
+    free(store);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef EXPRESSIONSTORE_H
+#define EXPRESSIONSTORE_H
+
+#include "BooleanExpressionParser.h"
+
+#define EXPRESSIONSTORE_INITIAL_BUCKETS 64
+
+typedef struct SharedExpression_s SharedExpression;
+
+/*
+ *  A node of the expression DAG inside of an ExpressionStore, structurally identical subexpressions
+ *  are represented by the same node
+ *  type        -   the BooleanExpressionType of the node
+ *  leftside    -   the left (or only) child of the node
+ *  rightside   -   the right child of the node
+ *  value       -   variables: the address of the value, constants: a copy of the value owned by the node
+ *  valueSize   -   the size of the value in bytes
+ *  hash        -   the hash of the node, used for the lookup inside of the store
+ *  next        -   the next node inside of the same hash bucket
+ *  epoch       -   the epoch in which result was calculated
+ *  result      -   the memoized result of the node
+ */
+struct SharedExpression_s
+{
+    unsigned int        type;
+    SharedExpression*   leftside;
+    SharedExpression*   rightside;
+    char*               value;
+    unsigned int        valueSize;
+    unsigned int        hash;
+    SharedExpression*   next;
+    unsigned long long  epoch;
+    int                 result;
+};
+
+/*
+ *  A hash-consed store for expressions, every node is evaluated at most once per epoch
+ *  buckets         -   the hash buckets containing all nodes
+ *  bucketCount     -   the amount of buckets (always a power of two)
+ *  nodeCount       -   the amount of distinct nodes inside of the store
+ *  requestedNodes  -   the amount of nodes that have been interned, including the shared ones
+ *  epoch           -   the current epoch, results of older epochs are calculated again
+ *  evaluations     -   the amount of node evaluations so far
+ *  memoHits        -   the amount of node evaluations answered by a result of the current epoch
+ */
+typedef struct
+{
+    SharedExpression**  buckets;
+    unsigned int        bucketCount;
+    unsigned int        nodeCount;
+    unsigned int        requestedNodes;
+    unsigned long long  epoch;
+    unsigned long long  evaluations;
+    unsigned long long  memoHits;
+} ExpressionStore;
+
+ExpressionStore* createExpressionStore(void);
+SharedExpression* internBooleanExpression(ExpressionStore* store, BooleanExpression* expression);
+void advanceExpressionStoreEpoch(ExpressionStore* store);
+int evaluateSharedExpression(ExpressionStore* store, SharedExpression* expression);
+void destroyExpressionStore(ExpressionStore* store);
+
+#endif
\ No newline at end of file
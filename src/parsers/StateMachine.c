@@ -1,4 +1,5 @@
 #include "StateMachine.h"
+#include "BooleanExpressionOptimizer.h"
 #include "json.h"
 #include "string.h"
 #include "../logging/log.h"
@@ -16,7 +17,262 @@ static StateMachineState* getStateMachineStateByName(char* name, StateMachine* s
     return NULL;
 }
 
-StateMachine* parseStateMachines(char* string, unsigned int length, Variable* variables, unsigned int variablesCount, unsigned int* stateMachineCount)
+/* evaluates the transition function of a state through the expression store of the state machine */
+static int evaluateTransitionFunction(void* context, unsigned int state)
+{
+    StateMachine* stateMachine = context;
+    return evaluateSharedExpression(stateMachine->expressions, stateMachine->states[state].sharedTransitionFunction);
+}
+
+/*
+ *  collects the variables of a transition function which are not states of the state machine
+ *  returns 1 if the function contains a comparison or has more than STATEMACHINE_TABLE_MAX_INPUTS inputs
+ */
+static int collectTableInputs(StateMachine* stateMachine, BooleanExpression* expression, const char** inputs, unsigned int* inputCount)
+{
+    switch (expression->type)
+    {
+        case BoolExprAND:
+        case BoolExprOR:
+            return collectTableInputs(stateMachine, expression->leftside, inputs, inputCount) ||
+                   collectTableInputs(stateMachine, expression->rightside, inputs, inputCount);
+
+        case BoolExprNOT:
+            return collectTableInputs(stateMachine, expression->leftside, inputs, inputCount);
+
+        case BoolExprCONSTANT:
+            return expression->value == NULL;
+
+        case BoolExprVARIABLE:
+        {
+            for (int i = 0; i < stateMachine->statesCount; i++)
+            {
+                if (expression->value == (char*)&stateMachine->states[i].isActive)
+                {
+                    return 0;
+                }
+            }
+            for (int i = 0; i < *inputCount; i++)
+            {
+                if (inputs[i] == expression->value)
+                {
+                    return 0;
+                }
+            }
+            if (*inputCount == STATEMACHINE_TABLE_MAX_INPUTS)
+            {
+                return 1;
+            }
+            inputs[(*inputCount)++] = expression->value;
+            return 0;
+        }
+
+        default:
+            return 1;
+    }
+}
+
+/*
+ *  calculates the truth table of a transition function for all combinations of the table inputs while the
+ *  given state is active, bit k of result is the result if the inputs are k
+ *  words   -   the amount of 64 bit words of a truth table
+ *  returns 1 if memory could not be allocated
+ */
+static int calculateTruthTable(StateMachine* stateMachine, BooleanExpression* expression, unsigned int state, unsigned int words,
+                               unsigned long long* result)
+{
+    /* the patterns of the 6 lowest bits of the combinations inside of one word */
+    static const unsigned long long patterns[6] = {0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+                                                   0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+    switch (expression->type)
+    {
+        case BoolExprAND:
+        case BoolExprOR:
+        {
+            unsigned long long* right = malloc(sizeof(*right) * words);
+            if (right == NULL || calculateTruthTable(stateMachine, expression->leftside, state, words, result) ||
+                calculateTruthTable(stateMachine, expression->rightside, state, words, right))
+            {
+                free(right);
+                return 1;
+            }
+            for (int i = 0; i < words; i++)
+            {
+                result[i] = expression->type == BoolExprAND ? result[i] & right[i] : result[i] | right[i];
+            }
+            free(right);
+            return 0;
+        }
+
+        case BoolExprNOT:
+        {
+            if (calculateTruthTable(stateMachine, expression->leftside, state, words, result))
+            {
+                return 1;
+            }
+            for (int i = 0; i < words; i++)
+            {
+                result[i] = ~result[i];
+            }
+            return 0;
+        }
+
+        case BoolExprCONSTANT:
+        {
+            memset(result, expression->value[0] != 0 ? 0xFF : 0, sizeof(*result) * words);
+            return 0;
+        }
+
+        default:
+        {
+            for (int i = 0; i < stateMachine->statesCount; i++)
+            {
+                if (expression->value == (char*)&stateMachine->states[i].isActive)
+                {
+                    memset(result, i == state ? 0xFF : 0, sizeof(*result) * words);
+                    return 0;
+                }
+            }
+            unsigned int input = 0;
+            while (stateMachine->tableInputs[input] != expression->value)
+            {
+                input++;
+            }
+            unsigned int bit = stateMachine->tableInputCount - 1 - input;
+            for (int i = 0; i < words; i++)
+            {
+                result[i] = bit < 6 ? patterns[bit] : ((i >> (bit - 6)) & 1) ? ~0ull : 0;
+            }
+            return 0;
+        }
+    }
+}
+
+/*
+ *  replaces the transition functions by a table with the next active state for every active state and every
+ *  combination of the inputs. This is only possible if the transition functions only use binary variables
+ *  and if there are few enough of them, otherwise the transition functions are evaluated as before. The rows
+ *  of the end state are never used, as a state machine in its end state is not updated anymore. Every other
+ *  entry after which not exactly one state would be active is STATEMACHINE_TABLE_NO_STATE, the transition
+ *  functions are evaluated for these steps only.
+ */
+static void createNextStateTable(StateMachine* stateMachine)
+{
+    const char* inputs[STATEMACHINE_TABLE_MAX_INPUTS];
+    unsigned int inputCount = 0;
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        BooleanExpression* transitionFunction = stateMachine->states[i].transitionFunction;
+        if (transitionFunction == NULL || transitionFunction->resultType != OperandTypeBinary || transitionFunction->valueSize != 1 ||
+            collectTableInputs(stateMachine, transitionFunction, inputs, &inputCount))
+        {
+            log_debug("%s: the transition functions can not be replaced by a next state table", stateMachine->name);
+            return;
+        }
+    }
+    unsigned long long combinations = 1ull << inputCount;
+    if (stateMachine->statesCount >= STATEMACHINE_TABLE_NO_STATE || stateMachine->statesCount * combinations > STATEMACHINE_TABLE_MAX_ENTRIES)
+    {
+        log_debug("%s: a next state table would have too many entries", stateMachine->name);
+        return;
+    }
+
+    unsigned int words = (combinations + 63) / 64;
+    unsigned short* table = malloc(sizeof(*table) * stateMachine->statesCount * combinations);
+    unsigned long long* truthTables = malloc(sizeof(*truthTables) * words * stateMachine->statesCount);
+    const char** tableInputs = malloc(sizeof(*tableInputs) * (inputCount > 0 ? inputCount : 1));
+    if (table == NULL || truthTables == NULL || tableInputs == NULL)
+    {
+        log_error("state machine %s: malloc error %s", stateMachine->name, strerror(errno));
+        free(table);
+        free(truthTables);
+        free(tableInputs);
+        return;
+    }
+    memcpy(tableInputs, inputs, sizeof(*inputs) * inputCount);
+    stateMachine->tableInputs = tableInputs;
+    stateMachine->tableInputCount = inputCount;
+
+    int error = 0;
+    unsigned long long decided = 0;
+    unsigned long long undecided = 0;
+    for (unsigned int state = 0; state < stateMachine->statesCount && !error; state++)
+    {
+        if (&stateMachine->states[state] == stateMachine->endState)
+        {
+            for (unsigned long long combination = 0; combination < combinations; combination++)
+            {
+                table[(state << inputCount) | combination] = STATEMACHINE_TABLE_NO_STATE;
+            }
+            continue;
+        }
+        for (unsigned int i = 0; i < stateMachine->statesCount && !error; i++)
+        {
+            error = calculateTruthTable(stateMachine, stateMachine->states[i].transitionFunction, state, words, truthTables + i * words);
+        }
+        for (unsigned long long combination = 0; combination < combinations && !error; combination++)
+        {
+            unsigned int nextStates = 0;
+            for (unsigned int i = 0; i < stateMachine->statesCount; i++)
+            {
+                if ((truthTables[i * words + combination / 64] >> (combination % 64)) & 1)
+                {
+                    table[(state << inputCount) | combination] = i;
+                    nextStates++;
+                }
+            }
+            if (nextStates != 1)
+            {
+                table[(state << inputCount) | combination] = STATEMACHINE_TABLE_NO_STATE;
+                undecided++;
+            }
+            else
+            {
+                decided++;
+            }
+        }
+    }
+    free(truthTables);
+    if (!error && decided == 0)
+    {
+        log_debug("%s: the next state table would not decide any transition", stateMachine->name);
+        error = 1;
+    }
+    if (error)
+    {
+        free(table);
+        free(tableInputs);
+        stateMachine->tableInputs = NULL;
+        stateMachine->tableInputCount = 0;
+        return;
+    }
+    stateMachine->nextStateTable = table;
+    log_debug("%s: next state table with %u inputs and %u entries (%u bytes), %llu entries are decided by the transition functions",
+              stateMachine->name, inputCount, getNextStateTableSize(stateMachine), getNextStateTableSize(stateMachine) * (unsigned int)sizeof(*table),
+              undecided);
+}
+
+/*
+ *  a state without a transition function is never entered, its transition function is replaced by a
+ *  constant false so that every back end handles it like any other state. Returns 1 on failure.
+ */
+static int setMissingTransitionFunction(StateMachineState* state, ExpressionStore* expressions)
+{
+    state->transitionFunction = createBinaryConstant(0);
+    state->sharedTransitionFunction = state->transitionFunction == NULL ? NULL : internBooleanExpression(expressions, state->transitionFunction);
+    if (state->sharedTransitionFunction == NULL)
+    {
+        log_error("transition function of state %s could not be added to the expression store", state->name);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ *  parses the state machines of the initializers, the transition functions of all state machines are
+ *  added to the given expression store, so identical subexpressions are shared between them
+ */
+StateMachine* parseStateMachines(char* string, unsigned int length, Variable* variables, unsigned int variablesCount, ExpressionStore* expressions, unsigned int* stateMachineCount)
 {
     JSON* json = JSONParse(string);
     *stateMachineCount = JSONGetArraySize(json);
@@ -26,6 +282,14 @@ StateMachine* parseStateMachines(char* string, unsigned int length, Variable* va
     int stateMachineIndex = 0;
     JSONArrayForEach(jsonStateMachine, json)
     {
+        stateMachines[stateMachineIndex].expressions = expressions;
+        stateMachines[stateMachineIndex].compiledNextStates = NULL;
+        stateMachines[stateMachineIndex].compiledIndex = 0;
+        stateMachines[stateMachineIndex].nextStateTable = NULL;
+        stateMachines[stateMachineIndex].tableInputs = NULL;
+        stateMachines[stateMachineIndex].tableInputCount = 0;
+        stateMachines[stateMachineIndex].tableFallbacks = 0;
+        stateMachines[stateMachineIndex].changedStates = 0;
         stateMachines[stateMachineIndex].name = malloc(strlen(jsonStateMachine->string)+1);
         strcpy(stateMachines[stateMachineIndex].name, jsonStateMachine->string);
         JSON* jsonStateNames = JSONGetObjectItem(jsonStateMachine, "StateNames");
@@ -45,9 +309,12 @@ StateMachine* parseStateMachines(char* string, unsigned int length, Variable* va
             stateMachines[stateMachineIndex].states[currentIndex].name = malloc(strlen(jsonStateName->valuestring)+1);
             strcpy(stateMachines[stateMachineIndex].states[currentIndex].name, jsonStateName->valuestring);
             stateMachines[stateMachineIndex].states[currentIndex].isActive = 0;
+            stateMachines[stateMachineIndex].states[currentIndex].nextIsActive = 0;
+            stateMachines[stateMachineIndex].states[currentIndex].transitionFunction = NULL;
+            stateMachines[stateMachineIndex].states[currentIndex].sharedTransitionFunction = NULL;
             stateMachines[stateMachineIndex].states[currentIndex].outputs = NULL;
             stateMachines[stateMachineIndex].states[currentIndex].outputCount = 0;
-            variablesNew[variablesCount+currentIndex] = (Variable){OperandTypeBinary, stateMachines[stateMachineIndex].states[currentIndex].name, &stateMachines[stateMachineIndex].states[currentIndex].isActive, 1};
+            variablesNew[variablesCount+currentIndex] = (Variable){OperandTypeBinary, stateMachines[stateMachineIndex].states[currentIndex].name, (char*)&stateMachines[stateMachineIndex].states[currentIndex].isActive, 1};
             currentIndex++;
         }
         
@@ -69,10 +336,30 @@ StateMachine* parseStateMachines(char* string, unsigned int length, Variable* va
 
         JSON* jsonStateEquations = JSONGetObjectItem(jsonStateMachine, "StateTransitionFunctions");
         JSON* jsonStateEquation = NULL;
+        SymbolTable* symbols = createSymbolTable(variablesNew, variablesCountNew);
         JSONArrayForEach(jsonStateEquation, jsonStateEquations)
         {
             StateMachineState* currentState = getStateMachineStateByName(jsonStateEquation->string, &stateMachines[stateMachineIndex]);
-            currentState->transitionFunction = parseBooleanExpression(jsonStateEquation->valuestring, strlen(jsonStateEquation->valuestring), variablesNew, variablesCountNew);
+            BooleanExpressionParseError parseError;
+            BooleanExpression* transitionFunction = parseBooleanExpressionWithSymbols(jsonStateEquation->valuestring, strlen(jsonStateEquation->valuestring), symbols, &parseError);
+            if (transitionFunction == NULL)
+            {
+                log_error("transition function of state %s could not be parsed: %s at position %u", currentState->name, parseError.message, parseError.position);
+            }
+            currentState->transitionFunction = optimizeBooleanExpression(transitionFunction);
+            currentState->sharedTransitionFunction = internBooleanExpression(expressions, currentState->transitionFunction);
+            if (currentState->sharedTransitionFunction == NULL)
+            {
+                log_error("transition function of state %s could not be added to the expression store", currentState->name);
+            }
+        }
+        destroySymbolTable(symbols);
+        for (int i = 0; i < stateMachines[stateMachineIndex].statesCount; i++)
+        {
+            if (JSONGetObjectItem(jsonStateEquations, stateMachines[stateMachineIndex].states[i].name) == NULL)
+            {
+                setMissingTransitionFunction(&stateMachines[stateMachineIndex].states[i], expressions);
+            }
         }
 
         JSON* jsonStateOutputs = JSONGetObjectItem(jsonStateMachine, "StateOutputs");
@@ -91,9 +378,23 @@ StateMachine* parseStateMachines(char* string, unsigned int length, Variable* va
                 Variable* currentActuator = getVariableWithName(variables, jsonStateOutputValue->string, variablesCount);
                 currentState->outputs[outputIndex].value = unbeautifyActuatorValue(jsonStateOutputValue, currentActuator->type);
                 currentState->outputs[outputIndex].type = currentActuator->type;
+                currentState->outputs[outputIndex].actuatorIndex = 0;
+                currentState->outputs[outputIndex].packet = NULL;
+                currentState->outputs[outputIndex].packetLength = 0;
+                outputIndex++;
             }
         }
 
+        /* only transition functions whose inputs changed are evaluated again during the updates */
+        BooleanExpression* transitionFunctions[stateMachines[stateMachineIndex].statesCount];
+        for (int i = 0; i < stateMachines[stateMachineIndex].statesCount; i++)
+        {
+            transitionFunctions[i] = stateMachines[stateMachineIndex].states[i].transitionFunction;
+        }
+        stateMachines[stateMachineIndex].dependencies = createDependencyIndex(transitionFunctions, stateMachines[stateMachineIndex].statesCount, variablesNew, variablesCountNew,
+                                                                              evaluateTransitionFunction, &stateMachines[stateMachineIndex]);
+        createNextStateTable(&stateMachines[stateMachineIndex]);
+
         free(variablesNew);
         stateMachineIndex++;
     }
@@ -102,6 +403,167 @@ StateMachine* parseStateMachines(char* string, unsigned int length, Variable* va
     return stateMachines;
 }
 
+/* creates a state machine of an experiment image, returns 1 if it is invalid */
+static int loadStateMachine(StateMachine* stateMachine, const ExperimentImage* image, const ImageStateMachine* imageStateMachine,
+                            Variable* variables, unsigned int variablesCount, ExpressionStore* expressions)
+{
+    const ImageState* imageStates = getImageRecords(image, image->header->states, imageStateMachine->states, sizeof(*imageStates));
+    const char* name = getImageString(image, imageStateMachine->name, 0);
+    if (imageStates == NULL || name == NULL || imageStateMachine->startState >= imageStateMachine->states.count ||
+        imageStateMachine->endState >= imageStateMachine->states.count)
+    {
+        log_error("state machine: the image contains an invalid state machine");
+        return 1;
+    }
+    stateMachine->name = malloc(strlen(name) + 1);
+    stateMachine->states = calloc(imageStateMachine->states.count + 1, sizeof(*stateMachine->states));
+    unsigned int variablesCountNew = variablesCount + imageStateMachine->states.count;
+    Variable* variablesNew = malloc(sizeof(*variablesNew) * variablesCountNew);
+    if (stateMachine->name == NULL || stateMachine->states == NULL || variablesNew == NULL)
+    {
+        log_error("state machine %s: malloc error %s", name, strerror(errno));
+        free(variablesNew);
+        return 1;
+    }
+    stateMachine->statesCount = imageStateMachine->states.count;
+    strcpy(stateMachine->name, name);
+    memcpy(variablesNew, variables, sizeof(*variables) * variablesCount);
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        const char* stateName = getImageString(image, imageStates[i].name, 0);
+        stateMachine->states[i].name = stateName == NULL ? NULL : malloc(strlen(stateName) + 1);
+        if (stateMachine->states[i].name == NULL)
+        {
+            log_error("state machine %s: state %d is invalid", stateMachine->name, i);
+            free(variablesNew);
+            return 1;
+        }
+        strcpy(stateMachine->states[i].name, stateName);
+        variablesNew[variablesCount + i] = (Variable){OperandTypeBinary, stateMachine->states[i].name, (char*)&stateMachine->states[i].isActive, 1};
+    }
+    stateMachine->startState = &stateMachine->states[imageStateMachine->startState];
+    stateMachine->activeState = stateMachine->startState;
+    stateMachine->startState->isActive = 1;
+    stateMachine->endState = &stateMachine->states[imageStateMachine->endState];
+
+    int error = 0;
+    for (int i = 0; i < stateMachine->statesCount && !error; i++)
+    {
+        StateMachineState* state = &stateMachine->states[i];
+        if (imageStates[i].transitionFunction.count > 0)
+        {
+            /* the transition functions are already optimized by goldi-image */
+            state->transitionFunction = createImageExpression(image, imageStates[i].transitionFunction, variablesNew, variablesCountNew);
+            state->sharedTransitionFunction = state->transitionFunction == NULL ? NULL : internBooleanExpression(expressions, state->transitionFunction);
+            error = state->sharedTransitionFunction == NULL;
+        }
+        else
+        {
+            error = setMissingTransitionFunction(state, expressions);
+        }
+
+        const ImageOutput* imageOutputs = getImageRecords(image, image->header->outputs, imageStates[i].outputs, sizeof(*imageOutputs));
+        error |= imageOutputs == NULL;
+        if (!error && imageStates[i].outputs.count > 0)
+        {
+            state->outputs = calloc(imageStates[i].outputs.count, sizeof(*state->outputs));
+            state->outputCount = state->outputs == NULL ? 0 : imageStates[i].outputs.count;
+            error = state->outputs == NULL;
+        }
+        for (int j = 0; j < state->outputCount && !error; j++)
+        {
+            unsigned int valueSize = getValueSizeOfActuatorType(imageOutputs[j].type);
+            const char* actuatorID = getImageString(image, imageOutputs[j].actuatorID, 0);
+            const char* value = getImageString(image, imageOutputs[j].value, valueSize);
+            state->outputs[j].type = imageOutputs[j].type;
+            state->outputs[j].actuatorID = actuatorID == NULL ? NULL : malloc(strlen(actuatorID) + 1);
+            state->outputs[j].value = value == NULL ? NULL : malloc(valueSize > 0 ? valueSize : 1);
+            error = state->outputs[j].actuatorID == NULL || state->outputs[j].value == NULL;
+            if (!error)
+            {
+                strcpy(state->outputs[j].actuatorID, actuatorID);
+                memcpy(state->outputs[j].value, value, valueSize);
+            }
+        }
+        if (error)
+        {
+            log_error("state machine %s: state %s is invalid", stateMachine->name, state->name);
+        }
+    }
+
+    BooleanExpression* transitionFunctions[stateMachine->statesCount + 1];
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        transitionFunctions[i] = stateMachine->states[i].transitionFunction;
+    }
+    stateMachine->dependencies = error ? NULL : createDependencyIndex(transitionFunctions, stateMachine->statesCount, variablesNew, variablesCountNew,
+                                                                      evaluateTransitionFunction, stateMachine);
+    error |= stateMachine->dependencies == NULL;
+    free(variablesNew);
+
+    /* the next state table has been calculated by goldi-image, its inputs are bound to the given variables */
+    if (!error && imageStateMachine->table != EXPERIMENT_IMAGE_NONE)
+    {
+        const uint32_t* tableInputs = getImageRecords(image, image->header->tableInputs, imageStateMachine->tableInputs, sizeof(*tableInputs));
+        ImageRange table = {imageStateMachine->table, 0};
+        if (imageStateMachine->tableInputs.count <= STATEMACHINE_TABLE_MAX_INPUTS)
+        {
+            table.count = stateMachine->statesCount << imageStateMachine->tableInputs.count;
+        }
+        const uint16_t* tableEntries = getImageRecords(image, image->header->tables, table, sizeof(*tableEntries));
+        error = tableInputs == NULL || tableEntries == NULL || table.count == 0;
+        for (int i = 0; i < imageStateMachine->tableInputs.count && !error; i++)
+        {
+            error = tableInputs[i] >= variablesCount;
+        }
+        for (int i = 0; i < table.count && !error; i++)
+        {
+            error = tableEntries[i] >= stateMachine->statesCount && tableEntries[i] != STATEMACHINE_TABLE_NO_STATE;
+        }
+        stateMachine->nextStateTable = error ? NULL : malloc(sizeof(*stateMachine->nextStateTable) * table.count);
+        stateMachine->tableInputs = error ? NULL : malloc(sizeof(*stateMachine->tableInputs) * (imageStateMachine->tableInputs.count + 1));
+        if (stateMachine->nextStateTable == NULL || stateMachine->tableInputs == NULL)
+        {
+            log_error("state machine %s: the next state table is invalid", stateMachine->name);
+            return 1;
+        }
+        memcpy(stateMachine->nextStateTable, tableEntries, sizeof(*stateMachine->nextStateTable) * table.count);
+        for (int i = 0; i < imageStateMachine->tableInputs.count; i++)
+        {
+            stateMachine->tableInputs[i] = variables[tableInputs[i]].value;
+        }
+        stateMachine->tableInputCount = imageStateMachine->tableInputs.count;
+    }
+    return error;
+}
+
+/*
+ *  creates the state machines of the initializers from an experiment image written by goldi-image, the variables
+ *  have to be in the order of the image (the sensors followed by the actuators). Works like parseStateMachines
+ *  without parsing, optimizing and calculating the next state tables again.
+ */
+StateMachine* loadStateMachines(const ExperimentImage* image, Variable* variables, unsigned int variablesCount, ExpressionStore* expressions, unsigned int* stateMachineCount)
+{
+    const ImageStateMachine* imageStateMachines = getImageSection(image, image->header->stateMachines);
+    *stateMachineCount = image->header->stateMachines.count;
+    StateMachine* stateMachines = calloc(*stateMachineCount + 1, sizeof(*stateMachines));
+    if (stateMachines == NULL)
+    {
+        log_error("state machine: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    for (int i = 0; i < *stateMachineCount; i++)
+    {
+        stateMachines[i].expressions = expressions;
+        if (loadStateMachine(&stateMachines[i], image, &imageStateMachines[i], variables, variablesCount, expressions))
+        {
+            destroyStateMachines(stateMachines, i + 1);
+            return NULL;
+        }
+    }
+    return stateMachines;
+}
+
 StateMachine* getStateMachineByName(char* name, StateMachine* stateMachines, unsigned int stateMachineCount)
 {
     for (int i = 0; i < stateMachineCount; i++)
@@ -114,47 +576,333 @@ StateMachine* getStateMachineByName(char* name, StateMachine* stateMachines, uns
     return NULL;
 }
 
-int updateStateMachine(StateMachine* stateMachine)
+/* uses the next state function of a compiled plugin, the states are passed as a bit mask */
+static void updateCompiledStateMachine(StateMachine* stateMachine)
 {
+    unsigned long long activeStates = 0;
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        activeStates |= (unsigned long long)(stateMachine->states[i].isActive != 0) << i;
+    }
+    activeStates = stateMachine->compiledNextStates(stateMachine->compiledIndex, activeStates);
+    stateMachine->changedStates = 0;
     for (int i = 0; i < stateMachine->statesCount; i++)
     {
-        int resultTransitionFunction = evaluateBooleanExpression(stateMachine->states[i].transitionFunction);
-        if (resultTransitionFunction != -1)
+        stateMachine->changedStates += stateMachine->states[i].isActive != ((activeStates >> i) & 1);
+        stateMachine->states[i].isActive = (activeStates >> i) & 1;
+        if (stateMachine->states[i].isActive)
         {
-            stateMachine->states[i].isActive = resultTransitionFunction;
             stateMachine->activeState = &stateMachine->states[i];
-            break;
         }
-        else
+    }
+}
+
+/*
+ *  looks up the next active state in the next state table, exactly one state is active before and after
+ *  returns 0 if the table does not decide this step and the transition functions have to be evaluated
+ */
+static int updateTableStateMachine(StateMachine* stateMachine)
+{
+    unsigned int state = stateMachine->activeState - stateMachine->states;
+    unsigned int index = state;
+    for (int i = 0; i < stateMachine->tableInputCount; i++)
+    {
+        index = (index << 1) | (stateMachine->tableInputs[i][0] != 0);
+    }
+    unsigned int nextState = stateMachine->nextStateTable[index];
+    if (nextState == STATEMACHINE_TABLE_NO_STATE)
+    {
+        stateMachine->tableFallbacks++;
+        return 0;
+    }
+    stateMachine->changedStates = 0;
+    if (nextState != state)
+    {
+        stateMachine->states[state].isActive = 0;
+        stateMachine->states[nextState].isActive = 1;
+        stateMachine->activeState = &stateMachine->states[nextState];
+        stateMachine->changedStates = 2;
+    }
+    return 1;
+}
+
+/* returns the amount of entries of the next state table, 0 if the state machine has none */
+unsigned int getNextStateTableSize(StateMachine* stateMachine)
+{
+    return stateMachine->nextStateTable == NULL ? 0 : stateMachine->statesCount << stateMachine->tableInputCount;
+}
+
+/*
+ *  evaluates the transition functions of all states against the current state values and only
+ *  afterwards applies the results, so every transition function sees the same state. Only the
+ *  transition functions whose inputs changed since the last update are evaluated again, shared
+ *  subexpressions are evaluated once per update. changedStates is set to the amount of states whose
+ *  activity changed.
+ *  returns 0 if a transition function could not be evaluated
+ */
+int updateStateMachine(StateMachine* stateMachine)
+{
+    if (stateMachine->compiledNextStates != NULL)
+    {
+        updateCompiledStateMachine(stateMachine);
+        return 1;
+    }
+    if (stateMachine->nextStateTable != NULL && updateTableStateMachine(stateMachine))
+    {
+        return 1;
+    }
+    advanceExpressionStoreEpoch(stateMachine->expressions);
+    updateDependencyIndex(stateMachine->dependencies);
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        int resultTransitionFunction = getCachedResult(stateMachine->dependencies, i);
+        if (resultTransitionFunction == -1)
         {
             return 0;
         }
+        stateMachine->states[i].nextIsActive = resultTransitionFunction;
+    }
+
+    stateMachine->changedStates = 0;
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        stateMachine->changedStates += stateMachine->states[i].isActive != stateMachine->states[i].nextIsActive;
+        stateMachine->states[i].isActive = stateMachine->states[i].nextIsActive;
+        if (stateMachine->states[i].isActive)
+        {
+            stateMachine->activeState = &stateMachine->states[i];
+        }
     }
 
     return 1;
 }
 
+int initStateMachineExecution(StateMachineExecution* execution)
+{
+    execution->stateMachines = NULL;
+    execution->stateMachineCount = 0;
+    execution->stopped = 1;
+    execution->finished = 1;
+    execution->inputsChanged = 0;
+    execution->result = 1;
+    execution->transitionStates = NULL;
+    execution->pendingTransitions = NULL;
+    execution->pendingCount = 0;
+    pthread_mutex_init(&execution->mutex, NULL);
+    pthread_cond_init(&execution->inputsChangedCondition, NULL);
+    pthread_cond_init(&execution->transitionCondition, NULL);
+    return 0;
+}
+
+/*
+ *  prepares the execution of the given state machines, transitions of a previous execution are dropped
+ *  returns 1 if the state machines could not be stored
+ */
+int startStateMachineExecution(StateMachineExecution* execution, StateMachine** stateMachines, unsigned int stateMachineCount)
+{
+    StateMachine** executedStateMachines = malloc(sizeof(*executedStateMachines) * (stateMachineCount > 0 ? stateMachineCount : 1));
+    unsigned int* transitionStates = malloc(sizeof(*transitionStates) * (stateMachineCount > 0 ? stateMachineCount : 1));
+    unsigned char* pendingTransitions = calloc(stateMachineCount > 0 ? stateMachineCount : 1, sizeof(*pendingTransitions));
+    if (executedStateMachines == NULL || transitionStates == NULL || pendingTransitions == NULL)
+    {
+        log_error("state machine execution: malloc error %s", strerror(errno));
+        free(executedStateMachines);
+        free(transitionStates);
+        free(pendingTransitions);
+        return 1;
+    }
+    memcpy(executedStateMachines, stateMachines, sizeof(*stateMachines) * stateMachineCount);
+
+    pthread_mutex_lock(&execution->mutex);
+    free(execution->stateMachines);
+    free(execution->transitionStates);
+    free(execution->pendingTransitions);
+    execution->stateMachines = executedStateMachines;
+    execution->stateMachineCount = stateMachineCount;
+    execution->transitionStates = transitionStates;
+    execution->pendingTransitions = pendingTransitions;
+    execution->pendingCount = 0;
+    execution->stopped = 0;
+    execution->finished = 0;
+    execution->inputsChanged = 1;
+    execution->result = 1;
+    pthread_mutex_unlock(&execution->mutex);
+    return 0;
+}
+
+/* records a change of the active state for waitForStateMachineTransitions, the mutex has to be locked */
+static void recordStateMachineTransition(StateMachineExecution* execution, unsigned int stateMachine)
+{
+    execution->transitionStates[stateMachine] = execution->stateMachines[stateMachine]->activeState - execution->stateMachines[stateMachine]->states;
+    if (!execution->pendingTransitions[stateMachine])
+    {
+        execution->pendingTransitions[stateMachine] = 1;
+        execution->pendingCount++;
+    }
+}
+
+/*
+ *  executes all state machines of the execution in the calling thread until every one of them reached its
+ *  end state or the execution is stopped. The state machines sleep until their inputs changed
+ *  (endStateMachineInputUpdate), as the states are inputs of the transition functions they are updated again
+ *  as long as any state changes. A state machine that reached its end state is not updated anymore. The
+ *  changes of the active states of one round are recorded together for waitForStateMachineTransitions.
+ *  returns 0 if a transition function could not be evaluated
+ */
 int executeStateMachine(StateMachineExecution* execution)
 {
-    log_debug("current state: %s, end state: %s", execution->stateMachine->activeState->name, execution->stateMachine->endState->name);
-    while(strcmp(execution->stateMachine->activeState->name, execution->stateMachine->endState->name) != 0)
+    pthread_mutex_lock(&execution->mutex);
+    unsigned int running = 0;
+    for (int i = 0; i < execution->stateMachineCount; i++)
     {
+        StateMachine* stateMachine = execution->stateMachines[i];
+        log_debug("%s: current state: %s, end state: %s", stateMachine->name, stateMachine->activeState->name, stateMachine->endState->name);
+        running += stateMachine->activeState != stateMachine->endState;
+    }
+    while (running > 0)
+    {
+        while (!execution->stopped && !execution->inputsChanged)
+        {
+            pthread_cond_wait(&execution->inputsChangedCondition, &execution->mutex);
+        }
         if (execution->stopped)
         {
             log_debug("execution has been stopped");
-            return 1;
+            break;
         }
-        if (!updateStateMachine(execution->stateMachine))
+
+        execution->inputsChanged = 0;
+        unsigned int transitions = 0;
+        for (int i = 0; i < execution->stateMachineCount && execution->result; i++)
         {
-            log_debug("an error has occurred during the update of the Statemachine");
-            execution->stopped = 1;
-            return 0;
+            StateMachine* stateMachine = execution->stateMachines[i];
+            StateMachineState* previousState = stateMachine->activeState;
+            if (previousState == stateMachine->endState)
+            {
+                continue;
+            }
+            if (!updateStateMachine(stateMachine))
+            {
+                log_debug("an error has occurred during the update of the Statemachine %s", stateMachine->name);
+                execution->result = 0;
+                break;
+            }
+            execution->inputsChanged |= stateMachine->changedStates > 0;
+            if (stateMachine->activeState != previousState)
+            {
+                recordStateMachineTransition(execution, i);
+                transitions++;
+            }
+            if (stateMachine->activeState == stateMachine->endState)
+            {
+                log_debug("%s: endstate has been reached", stateMachine->name);
+                running--;
+            }
+        }
+        if (transitions > 0)
+        {
+            pthread_cond_signal(&execution->transitionCondition);
+        }
+        if (!execution->result)
+        {
+            break;
         }
     }
-    log_debug("current state: %s, end state: %s", execution->stateMachine->activeState->name, execution->stateMachine->endState->name);
-    log_debug("endstate has been reached");
     execution->stopped = 1;
-    return 1;
+    execution->finished = 1;
+    pthread_cond_broadcast(&execution->transitionCondition);
+    pthread_mutex_unlock(&execution->mutex);
+    return execution->result;
+}
+
+/* has to be called before the inputs of the executed state machines are changed, blocks a running update */
+void beginStateMachineInputUpdate(StateMachineExecution* execution)
+{
+    pthread_mutex_lock(&execution->mutex);
+}
+
+/* wakes up the execution after the inputs of the state machines were changed */
+void endStateMachineInputUpdate(StateMachineExecution* execution)
+{
+    execution->inputsChanged = 1;
+    pthread_cond_signal(&execution->inputsChangedCondition);
+    pthread_mutex_unlock(&execution->mutex);
+}
+
+/*
+ *  blocks until the active state of one of the executed state machines changes and takes all pending changes
+ *  activeStates    -   the index of the active state of every executed state machine, updated by the changes
+ *  returns the amount of state machines whose active state changed, 0 once the execution finished and all
+ *  changes were taken
+ */
+unsigned int waitForStateMachineTransitions(StateMachineExecution* execution, unsigned int* activeStates)
+{
+    pthread_mutex_lock(&execution->mutex);
+    while (execution->pendingCount == 0 && !execution->finished)
+    {
+        pthread_cond_wait(&execution->transitionCondition, &execution->mutex);
+    }
+    unsigned int transitions = execution->pendingCount;
+    for (unsigned int i = 0; i < execution->stateMachineCount && execution->pendingCount > 0; i++)
+    {
+        if (execution->pendingTransitions[i])
+        {
+            activeStates[i] = execution->transitionStates[i];
+            execution->pendingTransitions[i] = 0;
+            execution->pendingCount--;
+        }
+    }
+    pthread_mutex_unlock(&execution->mutex);
+    return transitions;
+}
+
+void stopStateMachineExecution(StateMachineExecution* execution)
+{
+    pthread_mutex_lock(&execution->mutex);
+    execution->stopped = 1;
+    pthread_cond_signal(&execution->inputsChangedCondition);
+    pthread_mutex_unlock(&execution->mutex);
+}
+
+void destroyStateMachineExecution(StateMachineExecution* execution)
+{
+    free(execution->stateMachines);
+    free(execution->transitionStates);
+    free(execution->pendingTransitions);
+    pthread_mutex_destroy(&execution->mutex);
+    pthread_cond_destroy(&execution->inputsChangedCondition);
+    pthread_cond_destroy(&execution->transitionCondition);
+}
+
+/*
+ *  binds the outputs of all states to the given actuators and serializes their actuator data packets, so the
+ *  outputs can be sent on a transition without any JSON work. Only binary actuators can be serialized, the
+ *  packet of any other output is NULL.
+ *  returns 1 if an output refers to an unknown actuator
+ */
+int prepareStateMachineOutputs(StateMachine* stateMachines, unsigned int stateMachineCount, Actuator* actuators, unsigned int actuatorCount)
+{
+    for (int i = 0; i < stateMachineCount; i++)
+    {
+        for (int j = 0; j < stateMachines[i].statesCount; j++)
+        {
+            for (int k = 0; k < stateMachines[i].states[j].outputCount; k++)
+            {
+                StateMachineOutput* output = &stateMachines[i].states[j].outputs[k];
+                Actuator* actuator = getActuatorWithID(actuators, output->actuatorID, actuatorCount);
+                if (actuator == NULL)
+                {
+                    log_error("state machine %s: state %s sets the unknown actuator %s", stateMachines[i].name, stateMachines[i].states[j].name, output->actuatorID);
+                    return 1;
+                }
+                free(output->packet);
+                output->actuatorIndex = actuator - actuators;
+                output->packet = serializeActuatorDataPacket((ActuatorDataPacket){output->actuatorID, output->type, output->value});
+                output->packetLength = output->packet == NULL ? 0 : strlen(output->packet);
+            }
+        }
+    }
+    return 0;
 }
 
 void resetStateMachine(StateMachine* stateMachine)
@@ -180,10 +928,15 @@ void destroyStateMachines(StateMachine* stateMachines, unsigned int stateMachine
                 for (int k = 0; k < stateMachines[i].states[j].outputCount; k++)
                 {
                     free(stateMachines[i].states[j].outputs[k].actuatorID);
+                    free(stateMachines[i].states[j].outputs[k].value);
+                    free(stateMachines[i].states[j].outputs[k].packet);
                 }
                 free(stateMachines[i].states[j].outputs);
             }
         }
+        destroyDependencyIndex(stateMachines[i].dependencies);
+        free(stateMachines[i].nextStateTable);
+        free(stateMachines[i].tableInputs);
         free(stateMachines[i].name);
         free(stateMachines[i].states);
     }
@@ -197,6 +950,7 @@ void printStateMachineInfo(StateMachine* stateMachine)
     printf("    Start State:    %s\n", stateMachine->startState->name);
     printf("    Active State:   %s\n", stateMachine->activeState->name);
     printf("    End State:      %s\n", stateMachine->endState->name);
+    printf("    Next State Table: %u entries\n", getNextStateTableSize(stateMachine));
     for (int i = 0; i < stateMachine->statesCount; i++)
     {
         printf("    State %s:\n", stateMachine->states[i].name);
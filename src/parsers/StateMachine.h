@@ -2,24 +2,60 @@
 #define STATEMACHINE_H
 
 #include "BooleanExpressionParser.h"
+#include "ExpressionStore.h"
+#include "DependencyIndex.h"
 #include "../interfaces/SensorsActuators.h"
+#include "../interfaces/ExperimentImage.h"
+#include <pthread.h>
 
+/* a next state table is only created for state machines with at most this many binary inputs */
+#define STATEMACHINE_TABLE_MAX_INPUTS 16
+
+/* and only if it has at most this many entries (the amount of states times 2 ^ inputs) */
+#define STATEMACHINE_TABLE_MAX_ENTRIES (1u << 20)
+
+/* the entry of the table if not exactly one state is active afterwards, the transition functions decide this step */
+#define STATEMACHINE_TABLE_NO_STATE 0xFFFF
+
+/*
+ *  actuatorIndex   -   the index of the actuator, set by prepareStateMachineOutputs
+ *  packet          -   the serialized actuator data packet of the output, set by prepareStateMachineOutputs,
+ *                      NULL if the type of the actuator can not be serialized
+ *  packetLength    -   the length of packet
+ */
 typedef struct
 {
     char*           actuatorID;
     ActuatorType    type;
     char*           value;  
+    unsigned int    actuatorIndex;
+    char*           packet;
+    unsigned int    packetLength;
 } StateMachineOutput;
 
 typedef struct 
 {
-    char*               name;
-    BooleanExpression*  transitionFunction;
-    StateMachineOutput* outputs;
-    unsigned int        outputCount;
-    unsigned char       isActive; 
+    char*                       name;
+    BooleanExpression*          transitionFunction;
+    SharedExpression*           sharedTransitionFunction;
+    StateMachineOutput*         outputs;
+    unsigned int                outputCount;
+    unsigned char               isActive; 
+    unsigned char               nextIsActive;
 } StateMachineState;
 
+/*
+ *  compiledNextStates  -   the next state function of a plugin generated by goldi-compile, used instead of
+ *                          the transition functions if set (see ExperimentPlugin.h)
+ *  compiledIndex       -   the index of the state machine inside of the plugin
+ *  nextStateTable      -   the next active state for every active state and every combination of the inputs,
+ *                          indexed by (active state << tableInputCount) | inputs, the first input is the most
+ *                          significant bit. Used instead of the transition functions if set, except for the
+ *                          entries STATEMACHINE_TABLE_NO_STATE
+ *  tableInputs         -   the values of the binary variables the transition functions depend on
+ *  tableInputCount     -   the amount of inputs of the table
+ *  tableFallbacks      -   the amount of updates the table could not decide
+ */
 typedef struct 
 {
     char*               name;
@@ -28,21 +64,69 @@ typedef struct
     StateMachineState*  startState;
     StateMachineState*  activeState;
     StateMachineState*  endState;
+    DependencyIndex*    dependencies;
+    ExpressionStore*    expressions;
+    unsigned long long  (*compiledNextStates)(unsigned int stateMachine, unsigned long long activeStates);
+    unsigned int        compiledIndex;
+    unsigned short*     nextStateTable;
+    const char**        tableInputs;
+    unsigned int        tableInputCount;
+    unsigned long long  tableFallbacks;
+    unsigned int        changedStates;
 } StateMachine;
 
+/*
+ *  The execution of one or more state machines by executeStateMachine, which updates all of them in a single
+ *  thread and only after their inputs changed. All fields are protected by mutex.
+ *  stateMachines           -   the executed state machines
+ *  stateMachineCount       -   the amount of executed state machines
+ *  stopped                 -   set to stop the execution, also set by the execution once it ends
+ *  finished                -   set by the execution once it ends
+ *  inputsChanged           -   set if the state machines have to be updated
+ *  result                  -   the result of executeStateMachine
+ *  transitionStates        -   the active state of every executed state machine as set by its last transition
+ *  pendingTransitions      -   set for every state machine whose transition was not yet taken by
+ *                              waitForStateMachineTransitions
+ *  pendingCount            -   the amount of state machines with a pending transition
+ *  mutex                   -   protects the execution and the inputs of the state machines
+ *  inputsChangedCondition  -   signaled when inputsChanged or stopped is set
+ *  transitionCondition     -   signaled when transitions are pending or the execution finished
+ *  The transitions are stored per state machine and allocated by startStateMachineExecution, so a transition
+ *  never allocates. Several transitions of one state machine before they are taken are taken as the last one.
+ */
 typedef struct
 {
-    StateMachine*   stateMachine;
-    unsigned int    stopped:1;
+    StateMachine**  stateMachines;
+    unsigned int    stateMachineCount;
+    unsigned int    stopped;
+    unsigned int    finished;
+    unsigned int    inputsChanged;
+    int             result;
+    unsigned int*   transitionStates;
+    unsigned char*  pendingTransitions;
+    unsigned int    pendingCount;
+    pthread_mutex_t mutex;
+    pthread_cond_t  inputsChangedCondition;
+    pthread_cond_t  transitionCondition;
 } StateMachineExecution;
 
 
-StateMachine* parseStateMachines(char* string, unsigned int length, Variable* variables, unsigned int variablesCount, unsigned int* stateMachineCount);
+StateMachine* parseStateMachines(char* string, unsigned int length, Variable* variables, unsigned int variablesCount, ExpressionStore* expressions, unsigned int* stateMachineCount);
+StateMachine* loadStateMachines(const ExperimentImage* image, Variable* variables, unsigned int variablesCount, ExpressionStore* expressions, unsigned int* stateMachineCount);
 StateMachine* getStateMachineByName(char* name, StateMachine* stateMachines, unsigned int stateMachineCount);
 int updateStateMachine(StateMachine* stateMachine);
 void resetStateMachine(StateMachine* stateMachine);
+unsigned int getNextStateTableSize(StateMachine* stateMachine);
+int prepareStateMachineOutputs(StateMachine* stateMachines, unsigned int stateMachineCount, Actuator* actuators, unsigned int actuatorCount);
 void destroyStateMachines(StateMachine* stateMachine, unsigned int stateMachineCount);
 void printStateMachineInfo(StateMachine* StateMachine);
+int initStateMachineExecution(StateMachineExecution* execution);
+int startStateMachineExecution(StateMachineExecution* execution, StateMachine** stateMachines, unsigned int stateMachineCount);
 int executeStateMachine(StateMachineExecution* execution);
+void beginStateMachineInputUpdate(StateMachineExecution* execution);
+void endStateMachineInputUpdate(StateMachineExecution* execution);
+unsigned int waitForStateMachineTransitions(StateMachineExecution* execution, unsigned int* activeStates);
+void stopStateMachineExecution(StateMachineExecution* execution);
+void destroyStateMachineExecution(StateMachineExecution* execution);
 
 #endif
\ No newline at end of file
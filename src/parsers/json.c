@@ -12,6 +12,10 @@ char* JSONPrint(const JSON *item)
 {
     return cJSON_Print(item);
 }
+char* JSONPrintUnformatted(const JSON *item)
+{
+    return cJSON_PrintUnformatted(item);
+}
 void JSONDelete(JSON *item)
 {
     return cJSON_Delete(item);
@@ -20,6 +20,7 @@ typedef cJSON JSON;
 JSON* JSONParse(const char *value);
 JSON* JSONParseWithLength(const char *value, size_t buffer_length);
 char* JSONPrint(const JSON *item);
+char* JSONPrintUnformatted(const JSON *item);
 void JSONDelete(JSON *item);
 
 /* Returns the number of items in an array (or object). */
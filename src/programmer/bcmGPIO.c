@@ -7,7 +7,7 @@
 
 //TODO maybe merge with spi because bcm2835 init and close may cause problems if called from separate locations
 
-int initGPIO()
+static int beginBCM2835GPIO(void)
 {
     // If you call this, it will not actually access the GPIO
     // Use for testing
@@ -25,17 +25,52 @@ int initGPIO()
     return 0;
 }
 
-void writeGPIO(int pin, unsigned data)
+static void endBCM2835GPIO(void)
+{
+    bcm2835_close();
+}
+
+static void writeBCM2835GPIO(int pin, unsigned data)
 {
     bcm2835_gpio_write(pin, data);
 }
 
-unsigned readGPIO(int pin)
+static int readBCM2835GPIO(int pin)
 {
     return bcm2835_gpio_lev(pin);
 }
 
-void stopGPIO(void)
+/* the GPIO pins of the Raspberry Pi connected to the JTAG interface of the FPGA */
+const GPIOBackend bcm2835GPIOBackend = {"bcm2835", beginBCM2835GPIO, endBCM2835GPIO, writeBCM2835GPIO, readBCM2835GPIO};
+
+static const GPIOBackend* gpioBackend = &bcm2835GPIOBackend;
+
+void setGPIOBackend(const GPIOBackend* backend)
 {
-    bcm2835_close();
+    gpioBackend = backend;
 }
+
+const GPIOBackend* getGPIOBackend(void)
+{
+    return gpioBackend;
+}
+
+int initGPIO()
+{
+    return gpioBackend->begin();
+}
+
+void writeGPIO(int pin, unsigned data)
+{
+    gpioBackend->write(pin, data);
+}
+
+int readGPIO(int pin)
+{
+    return gpioBackend->read(pin);
+}
+
+void stopGPIO(void)
+{
+    gpioBackend->end();
+}
\ No newline at end of file
@@ -1,3 +1,6 @@
+#ifndef BCMGPIO_H
+#define BCMGPIO_H
+
 #include <bcm2835.h>
 #include <stdio.h>
 
@@ -6,7 +9,33 @@
 #define TDO 24
 #define TDI 26
 
+/* returned by readGPIO if the pin is not driven, e.g. by a simulated FPGA */
+#define GPIO_NOT_DRIVEN -1
+
+/*
+ *  drives the JTAG pins, the bcm2835 backend is used unless another one is set before initGPIO
+ *  name    -   the name of the backend used in logs
+ *  begin   -   initializes the interface and configures the JTAG pins, returns 1 on error
+ *  end     -   closes the interface
+ *  write   -   sets the level of an output pin
+ *  read    -   returns the level of an input pin or GPIO_NOT_DRIVEN
+ */
+typedef struct
+{
+    const char* name;
+    int         (*begin)(void);
+    void        (*end)(void);
+    void        (*write)(int pin, unsigned data);
+    int         (*read)(int pin);
+} GPIOBackend;
+
+extern const GPIOBackend bcm2835GPIOBackend;
+
+void setGPIOBackend(const GPIOBackend* backend);
+const GPIOBackend* getGPIOBackend(void);
 int initGPIO(void);
 void writeGPIO(int pin, unsigned data);
-unsigned readGPIO(int pin);
+int readGPIO(int pin);
 void stopGPIO(void);
+
+#endif
\ No newline at end of file
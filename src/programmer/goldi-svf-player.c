@@ -159,7 +159,7 @@ static struct libxsvf_host h = {
 
 int programFPGA(char* filepath)
 {
-	if (!bcm2835_init())
+	if (initGPIO())
 	{
 		log_error("gpio interface could not be started");
 		return 1;
@@ -175,7 +175,7 @@ int programFPGA(char* filepath)
 		return 1;
 	}
 
-	bcm2835_close();
+	stopGPIO();
 	
 	return 0;
 }
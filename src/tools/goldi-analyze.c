@@ -0,0 +1,663 @@
+/*
+ *  goldi-analyze: inspects the logic of an ExperimentData.json without any hardware
+ *
+ *  usage: goldi-analyze [--dump-optimized] [--bdd] [--trace <file.csv>] <ExperimentData.json>
+ *      --dump-optimized    -   prints the node count of every protection rule and transition function
+ *                              before and after optimizeBooleanExpression
+ *      --bdd               -   prints which protection rules can never trigger or are redundant and compares
+ *                              the evaluation time of the BDD engine with the tree interpreter
+ *      --trace             -   evaluates the protection rules over a recorded trace and prints the first
+ *                              snapshot in which every rule triggered
+ */
+
+#include "../parsers/BooleanExpressionParser.h"
+#include "../parsers/BooleanExpressionOptimizer.h"
+#include "../parsers/BDDRuleEngine.h"
+#include "../parsers/BitSlicedTrace.h"
+#include "../parsers/json.h"
+#include "../interfaces/SensorsActuators.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+
+/* the amount of evaluations the BDD engine and the tree interpreter are timed with */
+#define BDD_BENCHMARK_CYCLES 1000000
+
+/* the amount of different random assignments of the variables used by the benchmark */
+#define BDD_BENCHMARK_INPUTS 1024
+
+/* sums of the node counts of all analyzed expressions */
+static unsigned int totalNodesBefore = 0;
+static unsigned int totalNodesAfter = 0;
+
+/*
+ *  parses and optimizes the given expression and prints the node counts before and after
+ *  label   -   printed in front of the expression
+ */
+static int dumpOptimizedExpression(const char* label, char* expressionString, SymbolTable* symbols)
+{
+    BooleanExpressionParseError parseError;
+    BooleanExpression* expression = parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError);
+    if (expression == NULL)
+    {
+        printf("    %-8s %-40s %s at position %u\n", label, expressionString, parseError.message, parseError.position);
+        return 1;
+    }
+    unsigned int nodesBefore = countBooleanExpressionNodes(expression);
+    expression = optimizeBooleanExpression(expression);
+    unsigned int nodesAfter = countBooleanExpressionNodes(expression);
+    totalNodesBefore += nodesBefore;
+    totalNodesAfter += nodesAfter;
+
+    printf("    %-8s %-40s %3u -> %3u nodes", label, expressionString, nodesBefore, nodesAfter);
+    if (expression->type == BoolExprCONSTANT)
+    {
+        printf("  (always %d)", expression->value[0] != 0);
+    }
+    printf("\n");
+
+    destroyBooleanExpression(expression);
+    return 0;
+}
+
+/* prints the node counts of all protection rules and transition functions of the experiment */
+static int dumpOptimized(JSON* experimentJSON, Variable* variables, unsigned int variablesCount)
+{
+    int errors = 0;
+    char label[32];
+
+    SymbolTable* symbols = createSymbolTable(variables, variablesCount);
+    if (symbols == NULL)
+    {
+        return 1;
+    }
+    printf("protection rules:\n");
+    JSON* ruleJSON = NULL;
+    int ruleIndex = 0;
+    JSONArrayForEach(ruleJSON, JSONGetObjectItem(experimentJSON, "ProtectionRules"))
+    {
+        snprintf(label, sizeof(label), "[%d]", ruleIndex++);
+        errors += dumpOptimizedExpression(label, JSONGetObjectItem(ruleJSON, "Expression")->valuestring, symbols);
+    }
+    destroySymbolTable(symbols);
+
+    JSON* initializerJSON = NULL;
+    JSONArrayForEach(initializerJSON, JSONGetObjectItem(experimentJSON, "Initializers"))
+    {
+        printf("initializer %s:\n", initializerJSON->string);
+
+        /* the states of the initializer can be used as variables by its transition functions */
+        JSON* stateNamesJSON = JSONGetObjectItem(initializerJSON, "StateNames");
+        unsigned int stateCount = JSONGetArraySize(stateNamesJSON);
+        Variable initializerVariables[variablesCount + stateCount];
+        char stateValues[stateCount > 0 ? stateCount : 1];
+        memcpy(initializerVariables, variables, sizeof(*variables) * variablesCount);
+        for (int i = 0; i < stateCount; i++)
+        {
+            stateValues[i] = 0;
+            initializerVariables[variablesCount + i] = (Variable){OperandTypeBinary, JSONGetArrayItem(stateNamesJSON, i)->valuestring, &stateValues[i], 1};
+        }
+
+        SymbolTable* initializerSymbols = createSymbolTable(initializerVariables, variablesCount + stateCount);
+        if (initializerSymbols == NULL)
+        {
+            return 1;
+        }
+        JSON* transitionFunctionJSON = NULL;
+        JSONArrayForEach(transitionFunctionJSON, JSONGetObjectItem(initializerJSON, "StateTransitionFunctions"))
+        {
+            snprintf(label, sizeof(label), "%s:", transitionFunctionJSON->string);
+            errors += dumpOptimizedExpression(label, transitionFunctionJSON->valuestring, initializerSymbols);
+        }
+        destroySymbolTable(initializerSymbols);
+    }
+
+    printf("total: %u -> %u nodes", totalNodesBefore, totalNodesAfter);
+    if (totalNodesBefore > 0)
+    {
+        printf(" (%.1f%% removed)", 100.0 * (totalNodesBefore - totalNodesAfter) / totalNodesBefore);
+    }
+    printf("\n");
+    return errors;
+}
+
+/* sets every binary variable to a random value, a quarter of them to 1 */
+static void randomizeVariables(Variable* variables, unsigned int variablesCount)
+{
+    for (int i = 0; i < variablesCount; i++)
+    {
+        if (variables[i].type == OperandTypeBinary && variables[i].valueSize > 0)
+        {
+            *(char*)variables[i].value = (rand() & 3) == 0;
+        }
+    }
+}
+
+/* evaluates all rules with the tree interpreter, returns the amount of triggered rules */
+static unsigned int evaluateTrees(BooleanExpression** expressions, unsigned int ruleCount)
+{
+    unsigned int triggered = 0;
+    for (int i = 0; i < ruleCount; i++)
+    {
+        triggered += evaluateBooleanExpression(expressions[i]) == 1;
+    }
+    return triggered;
+}
+
+/*
+ *  creates BDD_BENCHMARK_INPUTS random assignments of the binary variables, if quiet is set only assignments
+ *  for which no rule triggers are used (like during normal operation)
+ *  returns NULL if no such assignments could be found
+ */
+static char* createBenchmarkInputs(Variable* variables, unsigned int variablesCount, BooleanExpression** expressions, unsigned int ruleCount, int quiet)
+{
+    char* inputs = malloc(BDD_BENCHMARK_INPUTS * (variablesCount > 0 ? variablesCount : 1));
+    if (inputs == NULL)
+    {
+        log_error("goldi-analyze: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    unsigned int attempts = 0;
+    for (int i = 0; i < BDD_BENCHMARK_INPUTS; i++)
+    {
+        do
+        {
+            if (++attempts > 1000 * BDD_BENCHMARK_INPUTS)
+            {
+                free(inputs);
+                return NULL;
+            }
+            randomizeVariables(variables, variablesCount);
+        } while (quiet && evaluateTrees(expressions, ruleCount) > 0);
+        for (int j = 0; j < variablesCount; j++)
+        {
+            inputs[i * variablesCount + j] = variables[j].valueSize > 0 ? variables[j].value[0] : 0;
+        }
+    }
+    return inputs;
+}
+
+/* copies one of the assignments of createBenchmarkInputs into the variables */
+static void applyBenchmarkInput(Variable* variables, unsigned int variablesCount, const char* inputs, int cycle)
+{
+    const char* input = inputs + (cycle % BDD_BENCHMARK_INPUTS) * variablesCount;
+    for (int j = 0; j < variablesCount; j++)
+    {
+        if (variables[j].valueSize > 0)
+        {
+            *(char*)variables[j].value = input[j];
+        }
+    }
+}
+
+/* prints the time per evaluation of all rules of the BDD engine and the tree interpreter, returns the amount of mismatches */
+static unsigned long long benchmarkBDD(const char* name, BDDRuleEngine* engine, BooleanExpression** expressions, unsigned int ruleCount,
+                                       Variable* variables, unsigned int variablesCount, const char* inputs)
+{
+    /* the time to apply the inputs is measured on its own and subtracted */
+    double start = getNanoseconds();
+    for (int cycle = 0; cycle < BDD_BENCHMARK_CYCLES; cycle++)
+    {
+        applyBenchmarkInput(variables, variablesCount, inputs, cycle);
+        __asm__ volatile("" ::: "memory");
+    }
+    double inputTime = getNanoseconds() - start;
+
+    unsigned long long bddTriggered = 0;
+    start = getNanoseconds();
+    for (int cycle = 0; cycle < BDD_BENCHMARK_CYCLES; cycle++)
+    {
+        applyBenchmarkInput(variables, variablesCount, inputs, cycle);
+        bddTriggered += evaluateBDDRuleEngine(engine);
+    }
+    double bddTime = getNanoseconds() - start - inputTime;
+
+    unsigned long long treeTriggered = 0;
+    start = getNanoseconds();
+    for (int cycle = 0; cycle < BDD_BENCHMARK_CYCLES; cycle++)
+    {
+        applyBenchmarkInput(variables, variablesCount, inputs, cycle);
+        treeTriggered += evaluateTrees(expressions, ruleCount);
+    }
+    double treeTime = getNanoseconds() - start - inputTime;
+
+    /* every assignment is checked rule by rule */
+    unsigned long long mismatches = 0;
+    for (int cycle = 0; cycle < BDD_BENCHMARK_INPUTS; cycle++)
+    {
+        applyBenchmarkInput(variables, variablesCount, inputs, cycle);
+        evaluateBDDRuleEngine(engine);
+        for (int i = 0; i < ruleCount; i++)
+        {
+            mismatches += isBDDRuleTriggered(engine, i) != (evaluateBooleanExpression(expressions[i]) == 1);
+        }
+    }
+    printf("%-14s bdd %7.1f ns, tree interpreter %7.1f ns per evaluation of all rules (%.2f rules triggered per cycle), %llu mismatches\n",
+           name, bddTime / BDD_BENCHMARK_CYCLES, treeTime / BDD_BENCHMARK_CYCLES, (double)treeTriggered / BDD_BENCHMARK_CYCLES, mismatches);
+    return mismatches + (bddTriggered != treeTriggered);
+}
+
+/*
+ *  prints the analysis of the BDD engine for the protection rules and the time per evaluation of all rules
+ *  with the BDD engine and the tree interpreter, both are checked against each other on the same inputs
+ */
+static int analyzeBDD(JSON* experimentJSON, Variable* variables, unsigned int variablesCount)
+{
+    SymbolTable* symbols = createSymbolTable(variables, variablesCount);
+    if (symbols == NULL)
+    {
+        return 1;
+    }
+    JSON* protectionRulesJSON = JSONGetObjectItem(experimentJSON, "ProtectionRules");
+    unsigned int ruleCount = JSONGetArraySize(protectionRulesJSON);
+    BooleanExpression* expressions[ruleCount > 0 ? ruleCount : 1];
+    int errors = 0;
+    JSON* ruleJSON = NULL;
+    int ruleIndex = 0;
+    JSONArrayForEach(ruleJSON, protectionRulesJSON)
+    {
+        char* expressionString = JSONGetObjectItem(ruleJSON, "Expression")->valuestring;
+        BooleanExpressionParseError parseError;
+        expressions[ruleIndex] = parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError);
+        if (expressions[ruleIndex] == NULL)
+        {
+            printf("    [%d] %s: %s at position %u\n", ruleIndex, expressionString, parseError.message, parseError.position);
+            errors++;
+        }
+        else
+        {
+            expressions[ruleIndex] = optimizeBooleanExpression(expressions[ruleIndex]);
+        }
+        ruleIndex++;
+    }
+    destroySymbolTable(symbols);
+    BDDRuleEngine* engine = errors > 0 ? NULL : createBDDRuleEngine(expressions, ruleCount);
+
+    if (engine != NULL)
+    {
+        printf("protection rules as binary decision diagrams:\n");
+        ruleIndex = 0;
+        JSONArrayForEach(ruleJSON, protectionRulesJSON)
+        {
+            if (engine->status[ruleIndex] != BDDRuleRequired)
+            {
+                printf("    [%d] %-40s %s\n", ruleIndex, JSONGetObjectItem(ruleJSON, "Expression")->valuestring,
+                       engine->status[ruleIndex] == BDDRuleNeverTriggered ? "can never trigger" : "only triggers together with other rules");
+            }
+            ruleIndex++;
+        }
+        printf("%u rules over %u inputs use %u nodes, %u never trigger, %u are redundant\n", ruleCount, engine->inputCount,
+               engine->nodeCount, engine->neverTriggered, engine->redundant);
+
+        srand(1);
+        char* randomInputs = createBenchmarkInputs(variables, variablesCount, expressions, ruleCount, 0);
+        char* quietInputs = createBenchmarkInputs(variables, variablesCount, expressions, ruleCount, 1);
+        if (randomInputs != NULL)
+        {
+            errors += benchmarkBDD("random inputs:", engine, expressions, ruleCount, variables, variablesCount, randomInputs) > 0;
+        }
+        if (quietInputs != NULL)
+        {
+            errors += benchmarkBDD("no rule fires:", engine, expressions, ruleCount, variables, variablesCount, quietInputs) > 0;
+        }
+        else
+        {
+            printf("no rule fires:  no random assignment found for which no rule triggers\n");
+        }
+        free(randomInputs);
+        free(quietInputs);
+    }
+    else
+    {
+        errors++;
+    }
+
+    destroyBDDRuleEngine(engine);
+    for (int i = 0; i < ruleIndex; i++)
+    {
+        destroyBooleanExpression(expressions[i]);
+    }
+    return errors;
+}
+
+/* the maximum length of a timestamp of a trace, longer ones are cut off */
+#define TRACE_TIMESTAMP_SIZE 32
+
+/*
+ *  splits a line of a trace at every comma, unlike strtok empty fields are kept so the fields stay aligned
+ *  with the columns of the header. The line break is removed and the line is modified in place.
+ *  fields      -   receives the start of the first fieldCapacity fields
+ *  returns the amount of fields of the line, which may be larger than fieldCapacity
+ */
+static unsigned int splitTraceLine(char* line, char** fields, unsigned int fieldCapacity)
+{
+    line[strcspn(line, "\r\n")] = '\0';
+    unsigned int fieldCount = 0;
+    for (char* field = line; field != NULL; fieldCount++)
+    {
+        char* separator = strchr(field, ',');
+        if (separator != NULL)
+        {
+            *separator = '\0';
+        }
+        if (fieldCount < fieldCapacity)
+        {
+            fields[fieldCount] = field;
+        }
+        field = separator == NULL ? NULL : separator + 1;
+    }
+    return fieldCount;
+}
+
+/*
+ *  reads the header of a trace and finds the variable of every column, the first column holds the timestamps
+ *  columns -   the index of the variable of every column, -1 for columns that are ignored
+ *  returns the amount of columns, 0 on error
+ */
+static unsigned int readTraceHeader(char* line, Variable* variables, unsigned int variablesCount, int** columns)
+{
+    unsigned int columnCount = 1;
+    for (char* current = line; *current != '\0'; current++)
+    {
+        columnCount += *current == ',';
+    }
+    char** names = malloc(sizeof(*names) * columnCount);
+    *columns = malloc(sizeof(**columns) * columnCount);
+    if (names == NULL || *columns == NULL)
+    {
+        log_error("goldi-analyze: malloc error %s", strerror(errno));
+        free(names);
+        return 0;
+    }
+
+    splitTraceLine(line, names, columnCount);
+    for (unsigned int column = 0; column < columnCount; column++)
+    {
+        (*columns)[column] = -1;
+        char* name = names[column];
+        while (*name == ' ')
+        {
+            name++;
+        }
+        if (column == 0 || *name == '\0')
+        {
+            continue;
+        }
+        Variable* variable = getVariableWithName(variables, name, variablesCount);
+        if (variable != NULL)
+        {
+            (*columns)[column] = variable - variables;
+        }
+        else
+        {
+            log_info("goldi-analyze: column %s of the trace is no sensor or actuator and is ignored", name);
+        }
+    }
+    free(names);
+    return columnCount;
+}
+
+/*
+ *  evaluates the protection rules over every snapshot of a recorded trace and prints when every rule triggered
+ *  first. The trace is a CSV file whose header names the timestamp column followed by sensor and actuator IDs,
+ *  every following line is one snapshot. BITSLICEDTRACE_STEPS snapshots are evaluated at once.
+ */
+static int replayTrace(JSON* experimentJSON, Variable* variables, unsigned int variablesCount, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        log_error("goldi-analyze: %s could not be opened: %s", path, strerror(errno));
+        return 1;
+    }
+
+    JSON* protectionRulesJSON = JSONGetObjectItem(experimentJSON, "ProtectionRules");
+    unsigned int ruleCount = JSONGetArraySize(protectionRulesJSON);
+    BitSlicedProgram* programs[ruleCount > 0 ? ruleCount : 1];
+    char firstTimestamps[ruleCount > 0 ? ruleCount : 1][TRACE_TIMESTAMP_SIZE];
+    unsigned long long firstSnapshots[ruleCount > 0 ? ruleCount : 1];
+    unsigned long long triggerCounts[ruleCount > 0 ? ruleCount : 1];
+    int errors = 0;
+
+    BitSlicedTrace* trace = createBitSlicedTrace(variables, variablesCount);
+    SymbolTable* symbols = createSymbolTable(variables, variablesCount);
+    JSON* ruleJSON = NULL;
+    int ruleIndex = 0;
+    JSONArrayForEach(ruleJSON, protectionRulesJSON)
+    {
+        char* expressionString = JSONGetObjectItem(ruleJSON, "Expression")->valuestring;
+        BooleanExpressionParseError parseError;
+        BooleanExpression* expression = symbols == NULL ? NULL : parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError);
+        expression = expression == NULL ? NULL : optimizeBooleanExpression(expression);
+        CompiledBooleanExpression* program = expression == NULL ? NULL : compileBooleanExpression(expression);
+        programs[ruleIndex] = trace == NULL ? NULL : bindBitSlicedProgram(trace, program);
+        destroyCompiledBooleanExpression(program);
+        destroyBooleanExpression(expression);
+        if (programs[ruleIndex] == NULL)
+        {
+            printf("    [%d] %s could not be compiled\n", ruleIndex, expressionString);
+            errors++;
+        }
+        firstSnapshots[ruleIndex] = 0;
+        triggerCounts[ruleIndex] = 0;
+        ruleIndex++;
+    }
+    destroySymbolTable(symbols);
+
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    int* columns = NULL;
+    unsigned int columnCount = 0;
+    if (errors == 0 && getline(&line, &lineCapacity, file) > 0)
+    {
+        columnCount = readTraceHeader(line, variables, variablesCount, &columns);
+    }
+    if (columnCount == 0)
+    {
+        log_error("goldi-analyze: %s has no valid header", path);
+        errors++;
+    }
+
+    unsigned long long values[variablesCount > 0 ? variablesCount : 1];
+    char* fields[columnCount > 0 ? columnCount : 1];
+    char timestamps[BITSLICEDTRACE_STEPS][TRACE_TIMESTAMP_SIZE];
+    unsigned long long lineNumber = 1;
+    unsigned long long snapshotCount = 0;
+    double evaluationTime = 0;
+    int endOfFile = errors > 0;
+    while (!endOfFile)
+    {
+        /* collects the next BITSLICEDTRACE_STEPS snapshots */
+        clearBitSlicedTrace(trace);
+        while (trace->stepCount < BITSLICEDTRACE_STEPS)
+        {
+            if (getline(&line, &lineCapacity, file) <= 0)
+            {
+                endOfFile = 1;
+                break;
+            }
+            lineNumber++;
+            if (line[0] == '\n' || line[0] == '\r')
+            {
+                continue;
+            }
+            unsigned int fieldCount = splitTraceLine(line, fields, columnCount);
+            if (fieldCount != columnCount)
+            {
+                log_error("goldi-analyze: line %llu of %s has %u instead of %u columns", lineNumber, path, fieldCount, columnCount);
+                errors++;
+                endOfFile = 1;
+                break;
+            }
+            memset(values, 0, sizeof(values));
+            for (unsigned int column = 0; column < columnCount; column++)
+            {
+                if (column == 0)
+                {
+                    snprintf(timestamps[trace->stepCount], TRACE_TIMESTAMP_SIZE, "%s", fields[column]);
+                }
+                else if (columns[column] >= 0)
+                {
+                    values[columns[column]] = strtoull(fields[column], NULL, 0);
+                }
+            }
+            addBitSlicedSnapshot(trace, values);
+        }
+
+        double start = getNanoseconds();
+        for (int i = 0; i < ruleCount; i++)
+        {
+            BitSlice result;
+            evaluateBitSlicedProgram(trace, programs[i], &result);
+            for (int word = 0; word < BITSLICEDTRACE_WORDS; word++)
+            {
+                if (result.words[word] == 0)
+                {
+                    continue;
+                }
+                if (triggerCounts[i] == 0)
+                {
+                    unsigned int step = 64 * word + __builtin_ctzll(result.words[word]);
+                    memcpy(firstTimestamps[i], timestamps[step], TRACE_TIMESTAMP_SIZE);
+                    firstSnapshots[i] = snapshotCount + step;
+                }
+                triggerCounts[i] += __builtin_popcountll(result.words[word]);
+            }
+        }
+        evaluationTime += getNanoseconds() - start;
+        snapshotCount += trace->stepCount;
+    }
+
+    if (errors == 0)
+    {
+        printf("trace %s: %llu snapshots, %u rules evaluated in %.1f ms (%.2f ns per snapshot and rule)\n", path, snapshotCount, ruleCount,
+               evaluationTime / 1e6, snapshotCount > 0 && ruleCount > 0 ? evaluationTime / snapshotCount / ruleCount : 0);
+        ruleIndex = 0;
+        JSONArrayForEach(ruleJSON, protectionRulesJSON)
+        {
+            printf("    [%d] %-40s ", ruleIndex, JSONGetObjectItem(ruleJSON, "Expression")->valuestring);
+            if (triggerCounts[ruleIndex] > 0)
+            {
+                printf("first triggered at %s (snapshot %llu), triggered in %llu snapshots\n", firstTimestamps[ruleIndex],
+                       firstSnapshots[ruleIndex], triggerCounts[ruleIndex]);
+            }
+            else
+            {
+                printf("never triggered\n");
+            }
+            ruleIndex++;
+        }
+    }
+
+    for (int i = 0; i < ruleIndex; i++)
+    {
+        destroyBitSlicedProgram(programs[i]);
+    }
+    destroyBitSlicedTrace(trace);
+    free(columns);
+    free(line);
+    fclose(file);
+    return errors;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options] <ExperimentData.json>\n", name);
+    printf("    -o, --dump-optimized    print the node counts of all expressions before and after optimization\n");
+    printf("    -b, --bdd               print the BDD analysis of the protection rules and benchmark the BDD engine\n");
+    printf("    -t, --trace <file.csv>  print when every protection rule triggered first in a recorded trace\n");
+    printf("    -h, --help              print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"dump-optimized",  no_argument,        NULL, 'o'},
+        {"bdd",             no_argument,        NULL, 'b'},
+        {"trace",           required_argument,  NULL, 't'},
+        {"help",            no_argument,        NULL, 'h'},
+        {NULL,              0,                  NULL, 0}
+    };
+
+    unsigned int dumpOptimizedRequested = 0;
+    unsigned int bddRequested = 0;
+    const char* tracePath = NULL;
+    int option;
+    while ((option = getopt_long(argc, argv, "obt:h", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'o':
+                dumpOptimizedRequested = 1;
+                break;
+
+            case 'b':
+                bddRequested = 1;
+                break;
+
+            case 't':
+                tracePath = optarg;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || (!dumpOptimizedRequested && !bddRequested && tracePath == NULL))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    char* experimentString = readFile(argv[optind], NULL);
+    if (experimentString == NULL)
+    {
+        log_error("goldi-analyze: %s could not be read", argv[optind]);
+        return 1;
+    }
+    JSON* experimentJSON = JSONParse(experimentString);
+    free(experimentString);
+    if (experimentJSON == NULL)
+    {
+        log_error("goldi-analyze: %s does not contain valid json", argv[optind]);
+        return 1;
+    }
+
+    char* sensorsString = JSONPrint(JSONGetObjectItem(experimentJSON, "Sensors"));
+    char* actuatorsString = JSONPrint(JSONGetObjectItem(experimentJSON, "Actuators"));
+    unsigned int sensorCount = 0;
+    unsigned int actuatorCount = 0;
+    Sensor* sensors = sensorsString == NULL ? NULL : parseSensors(sensorsString, strlen(sensorsString), &sensorCount);
+    Actuator* actuators = actuatorsString == NULL ? NULL : parseActuators(actuatorsString, strlen(actuatorsString), &actuatorCount, sensorCount);
+    free(sensorsString);
+    free(actuatorsString);
+    if (sensors == NULL || actuators == NULL)
+    {
+        log_error("goldi-analyze: sensors and actuators could not be parsed");
+        JSONDelete(experimentJSON);
+        return 1;
+    }
+
+    Variable* variables = createSensorActuatorVariables(sensors, sensorCount, actuators, actuatorCount);
+    int result = variables == NULL;
+    if (variables != NULL && dumpOptimizedRequested)
+    {
+        result |= dumpOptimized(experimentJSON, variables, sensorCount + actuatorCount) != 0;
+    }
+    if (variables != NULL && bddRequested)
+    {
+        result |= analyzeBDD(experimentJSON, variables, sensorCount + actuatorCount) != 0;
+    }
+    if (variables != NULL && tracePath != NULL)
+    {
+        result |= replayTrace(experimentJSON, variables, sensorCount + actuatorCount, tracePath) != 0;
+    }
+
+    free(variables);
+    destroySensors(sensors, sensorCount);
+    destroyActuators(actuators, actuatorCount);
+    JSONDelete(experimentJSON);
+    return result;
+}
\ No newline at end of file
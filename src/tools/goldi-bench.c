@@ -0,0 +1,662 @@
+/*
+ *  goldi-bench: measures the expression parser and evaluators with synthetic rule sets and state machines,
+ *  only the parsers and utils are used so it runs on any machine
+ *
+ *  usage: goldi-bench [options]
+ *      the generated variables are named x<i> (binary, 1 byte) and n<i> (numbers, 2 bytes), the rules are
+ *      random trees of the given depth over them, the state machines are chains whose transitions are
+ *      random expressions of the same depth. For every evaluator the time, the allocations per evaluation
+ *      and the resident set size are printed.
+ */
+
+#include "../parsers/BooleanExpressionParser.h"
+#include "../parsers/BooleanExpressionCompiler.h"
+#include "../parsers/BooleanExpressionOptimizer.h"
+#include "../parsers/StateMachine.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+/* the amount of different random process images the evaluations cycle through */
+#define BENCH_INPUTS 256
+
+/*
+ *  the allocations are counted by wrapping malloc, calloc and realloc at link time
+ *  (-Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc)
+ */
+static unsigned long long allocationCount = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size)
+{
+    allocationCount++;
+    return __real_realloc(pointer, size);
+}
+
+/*
+ *  the parameters of the generated rule sets and state machines
+ *  variableCount       -   the amount of variables
+ *  numberPercentage    -   the share of the variables which are numbers, the others are binary
+ *  depth               -   the depth of the generated expressions
+ *  ruleCount           -   the amount of rules
+ *  stateMachineCount   -   the amount of state machines
+ *  stateCount          -   the amount of states of every state machine
+ *  cycles              -   the amount of cycles every evaluator is timed with
+ *  seed                -   the seed of the random generator
+ */
+typedef struct
+{
+    unsigned int    variableCount;
+    unsigned int    numberPercentage;
+    unsigned int    depth;
+    unsigned int    ruleCount;
+    unsigned int    stateMachineCount;
+    unsigned int    stateCount;
+    unsigned int    cycles;
+    unsigned int    seed;
+} BenchParameters;
+
+/*
+ *  the generated variables
+ *  variables   -   the variables, the binary ones first
+ *  binaryCount -   the amount of binary variables
+ *  names       -   the storage of all names
+ *  values      -   the storage of all values, 1 byte per binary and 2 bytes per number variable
+ *  valuesSize  -   the size of values
+ *  inputs      -   BENCH_INPUTS random copies of values
+ */
+typedef struct
+{
+    Variable*       variables;
+    unsigned int    variableCount;
+    unsigned int    binaryCount;
+    char*           names;
+    char*           values;
+    unsigned int    valuesSize;
+    char*           inputs;
+} BenchVariables;
+
+/* a growing string the expressions and the state machines are written to */
+typedef struct
+{
+    char*           string;
+    unsigned int    length;
+    unsigned int    capacity;
+} Buffer;
+
+static int append(Buffer* buffer, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static int append(Buffer* buffer, const char* format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(NULL, 0, format, arguments);
+    va_end(arguments);
+    if (buffer->length + length + 1 > buffer->capacity)
+    {
+        unsigned int capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+        while (buffer->length + length + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+        char* string = realloc(buffer->string, capacity);
+        if (string == NULL)
+        {
+            log_error("goldi-bench: malloc error %s", strerror(errno));
+            return 1;
+        }
+        buffer->string = string;
+        buffer->capacity = capacity;
+    }
+    va_start(arguments, format);
+    vsnprintf(buffer->string + buffer->length, buffer->capacity - buffer->length, format, arguments);
+    va_end(arguments);
+    buffer->length += length;
+    return 0;
+}
+
+/* prints the current and the peak resident set size */
+static void printMemoryUsage(const char* label)
+{
+    long size = 0;
+    long residentPages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != NULL)
+    {
+        if (fscanf(statm, "%ld %ld", &size, &residentPages) != 2)
+        {
+            residentPages = 0;
+        }
+        fclose(statm);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("rss %-28s %8ld kB (peak %ld kB)\n", label, residentPages * (sysconf(_SC_PAGESIZE) / 1024), usage.ru_maxrss);
+}
+
+/* creates the variables and BENCH_INPUTS random process images, a quarter of the binary variables is 1 */
+static int createBenchVariables(BenchVariables* bench, BenchParameters* parameters)
+{
+    unsigned int numberCount = parameters->variableCount * parameters->numberPercentage / 100;
+    bench->variableCount = parameters->variableCount;
+    bench->binaryCount = parameters->variableCount - numberCount;
+    bench->valuesSize = bench->binaryCount + 2 * numberCount;
+    bench->variables = malloc(sizeof(*bench->variables) * bench->variableCount);
+    bench->names = malloc(16 * bench->variableCount);
+    bench->values = calloc(bench->valuesSize + 1, 1);
+    bench->inputs = malloc((size_t)BENCH_INPUTS * (bench->valuesSize + 1));
+    if (bench->variables == NULL || bench->names == NULL || bench->values == NULL || bench->inputs == NULL)
+    {
+        log_error("goldi-bench: malloc error %s", strerror(errno));
+        return 1;
+    }
+
+    unsigned int offset = 0;
+    for (int i = 0; i < bench->variableCount; i++)
+    {
+        char* name = bench->names + 16 * i;
+        if (i < bench->binaryCount)
+        {
+            snprintf(name, 16, "x%d", i);
+            bench->variables[i] = (Variable){OperandTypeBinary, name, bench->values + offset, 1};
+            offset += 1;
+        }
+        else
+        {
+            snprintf(name, 16, "n%d", i - bench->binaryCount);
+            bench->variables[i] = (Variable){OperandTypeNumber, name, bench->values + offset, 2};
+            offset += 2;
+        }
+    }
+
+    for (int input = 0; input < BENCH_INPUTS; input++)
+    {
+        char* values = bench->inputs + input * (bench->valuesSize + 1);
+        for (int i = 0; i < bench->binaryCount; i++)
+        {
+            values[i] = (rand() & 3) == 0;
+        }
+        for (int i = bench->binaryCount; i < bench->valuesSize; i++)
+        {
+            values[i] = rand();
+        }
+    }
+    return 0;
+}
+
+static void destroyBenchVariables(BenchVariables* bench)
+{
+    free(bench->variables);
+    free(bench->names);
+    free(bench->values);
+    free(bench->inputs);
+}
+
+/* copies one of the random process images into the values of the variables */
+static void applyInput(BenchVariables* bench, unsigned int cycle)
+{
+    memcpy(bench->values, bench->inputs + (cycle % BENCH_INPUTS) * (bench->valuesSize + 1), bench->valuesSize);
+}
+
+/* appends a random variable, negated variable or comparison */
+static int generateOperand(Buffer* buffer, BenchVariables* bench)
+{
+    unsigned int numberCount = bench->variableCount - bench->binaryCount;
+    if (numberCount > 0 && (bench->binaryCount == 0 || rand() % bench->variableCount >= bench->binaryCount))
+    {
+        /* random values are almost never equal to a constant, so only < and > are used */
+        return append(buffer, "n%u %c %u", rand() % numberCount, (rand() & 1) ? '<' : '>', rand() & 0xFFFF);
+    }
+    return append(buffer, "%sx%u", (rand() & 3) == 0 ? "!" : "", rand() % bench->binaryCount);
+}
+
+/* appends a random expression of the given depth */
+static int generateExpression(Buffer* buffer, BenchVariables* bench, unsigned int depth)
+{
+    if (depth == 0)
+    {
+        return generateOperand(buffer, bench);
+    }
+    int error = append(buffer, "%s(", (rand() & 7) == 0 ? "!" : "");
+    error |= generateExpression(buffer, bench, depth - 1);
+    error |= append(buffer, " %c ", (rand() & 1) ? '&' : '|');
+    error |= generateExpression(buffer, bench, depth - 1);
+    error |= append(buffer, ")");
+    return error;
+}
+
+/*
+ *  appends a random expression which is true for some but not all of the random process images, so the
+ *  state machines do not get stuck in a state
+ */
+static int generateCondition(Buffer* buffer, BenchVariables* bench, unsigned int depth)
+{
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        buffer->length = 0;
+        if (generateExpression(buffer, bench, depth))
+        {
+            return 1;
+        }
+        BooleanExpression* expression = parseBooleanExpression(buffer->string, buffer->length, bench->variables, bench->variableCount);
+        unsigned int trueCount = 0;
+        for (unsigned int input = 0; input < BENCH_INPUTS && expression != NULL; input++)
+        {
+            applyInput(bench, input);
+            trueCount += evaluateBooleanExpression(expression) == 1;
+        }
+        destroyBooleanExpression(expression);
+        if (trueCount >= BENCH_INPUTS / 16 && trueCount <= BENCH_INPUTS - BENCH_INPUTS / 16)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+/*
+ *  generates the initializers as the Initialization Service receives them: every state machine is a chain
+ *  of states, state i is left for state i + 1 as soon as its random condition is true
+ */
+static int generateStateMachines(Buffer* buffer, BenchVariables* bench, BenchParameters* parameters)
+{
+    int error = append(buffer, "{");
+    for (int machine = 0; machine < parameters->stateMachineCount; machine++)
+    {
+        error |= append(buffer, "%s\"m%d\": {\"StateNames\": [", machine > 0 ? ", " : "", machine);
+        for (int state = 0; state < parameters->stateCount; state++)
+        {
+            error |= append(buffer, "%s\"m%dz%d\"", state > 0 ? ", " : "", machine, state);
+        }
+        error |= append(buffer, "], \"StartState\": \"m%dz0\", \"EndState\": \"m%dz%u\", \"StateTransitionFunctions\": {",
+                        machine, machine, parameters->stateCount - 1);
+
+        /* the condition to leave state i is used by the transition functions of state i and i + 1 */
+        Buffer conditions[parameters->stateCount];
+        for (int state = 0; state < parameters->stateCount; state++)
+        {
+            conditions[state] = (Buffer){NULL, 0, 0};
+            error |= generateCondition(&conditions[state], bench, parameters->depth);
+        }
+        for (int state = 0; state < parameters->stateCount && !error; state++)
+        {
+            error |= append(buffer, "%s\"m%dz%d\": \"", state > 0 ? ", " : "", machine, state);
+            if (state == parameters->stateCount - 1)
+            {
+                error |= append(buffer, "m%dz%d", machine, state);
+            }
+            else
+            {
+                error |= append(buffer, "(m%dz%d & !%s)", machine, state, conditions[state].string);
+            }
+            if (state > 0)
+            {
+                error |= append(buffer, " | (m%dz%d & %s)", machine, state - 1, conditions[state - 1].string);
+            }
+            error |= append(buffer, "\"");
+        }
+        for (int state = 0; state < parameters->stateCount; state++)
+        {
+            free(conditions[state].string);
+        }
+        error |= append(buffer, "}, \"StateOutputs\": {}}");
+    }
+    error |= append(buffer, "}");
+    return error;
+}
+
+/* the evaluators share one signature so they can be timed by the same loop */
+typedef int (*RuleEvaluator)(void* rule);
+
+static int evaluateTree(void* rule)
+{
+    return evaluateBooleanExpression(rule);
+}
+
+static int evaluateBytecode(void* rule)
+{
+    return evaluateCompiledBooleanExpression(rule);
+}
+
+/*
+ *  times the evaluation of all rules with the given evaluator, prints the time and the allocations per rule evaluation
+ *  inputTime   -   the time needed to apply the inputs of all cycles, it is subtracted
+ */
+static void benchmarkEvaluator(const char* name, RuleEvaluator evaluate, void** rules, BenchVariables* bench, BenchParameters* parameters, double inputTime)
+{
+    unsigned long long triggered = 0;
+    unsigned long long allocations = allocationCount;
+    double start = getNanoseconds();
+    for (unsigned int cycle = 0; cycle < parameters->cycles; cycle++)
+    {
+        applyInput(bench, cycle);
+        for (unsigned int i = 0; i < parameters->ruleCount; i++)
+        {
+            triggered += evaluate(rules[i]) == 1;
+        }
+    }
+    double time = getNanoseconds() - start - inputTime;
+    double evaluations = (double)parameters->cycles * parameters->ruleCount;
+    printf("eval  %-28s %8.1f ns per rule, %8.3f allocations per rule (%.2f rules triggered per cycle)\n",
+           name, time / evaluations, (allocationCount - allocations) / evaluations, (double)triggered / parameters->cycles);
+}
+
+/* parses the rules in every supported way and benchmarks every evaluator with them */
+static int benchmarkRules(BenchVariables* bench, BenchParameters* parameters)
+{
+    char** ruleStrings = calloc(parameters->ruleCount, sizeof(*ruleStrings));
+    BooleanExpression** trees = calloc(parameters->ruleCount, sizeof(*trees));
+    BooleanExpression** optimized = calloc(parameters->ruleCount, sizeof(*optimized));
+    CompiledBooleanExpression** programs = calloc(parameters->ruleCount, sizeof(*programs));
+    if (ruleStrings == NULL || trees == NULL || optimized == NULL || programs == NULL)
+    {
+        log_error("goldi-bench: malloc error %s", strerror(errno));
+        return 1;
+    }
+
+    int error = 0;
+    unsigned long long characters = 0;
+    for (int i = 0; i < parameters->ruleCount && !error; i++)
+    {
+        Buffer buffer = {NULL, 0, 0};
+        error = generateExpression(&buffer, bench, parameters->depth);
+        ruleStrings[i] = buffer.string;
+        characters += buffer.length;
+    }
+    if (error)
+    {
+        goto cleanup;
+    }
+    printf("rules: %u rules of depth %u over %u variables (%u binary), %.1f characters per rule\n",
+           parameters->ruleCount, parameters->depth, bench->variableCount, bench->binaryCount, (double)characters / parameters->ruleCount);
+
+    /* the linear search for the variables (parseBooleanExpression) and the symbol table used by the services */
+    unsigned long long allocations = allocationCount;
+    double start = getNanoseconds();
+    for (int i = 0; i < parameters->ruleCount; i++)
+    {
+        trees[i] = parseBooleanExpression(ruleStrings[i], strlen(ruleStrings[i]), bench->variables, bench->variableCount);
+    }
+    double time = getNanoseconds() - start;
+    printf("parse %-28s %8.1f us per rule, %8.1f allocations per rule\n", "parseBooleanExpression",
+           time / 1e3 / parameters->ruleCount, (double)(allocationCount - allocations) / parameters->ruleCount);
+
+    allocations = allocationCount;
+    start = getNanoseconds();
+    SymbolTable* symbols = createSymbolTable(bench->variables, bench->variableCount);
+    for (int i = 0; i < parameters->ruleCount && symbols != NULL; i++)
+    {
+        BooleanExpressionParseError parseError;
+        optimized[i] = parseBooleanExpressionWithSymbols(ruleStrings[i], strlen(ruleStrings[i]), symbols, &parseError);
+    }
+    time = getNanoseconds() - start;
+    destroySymbolTable(symbols);
+    printf("parse %-28s %8.1f us per rule, %8.1f allocations per rule\n", "with symbol table",
+           time / 1e3 / parameters->ruleCount, (double)(allocationCount - allocations) / parameters->ruleCount);
+
+    start = getNanoseconds();
+    for (int i = 0; i < parameters->ruleCount; i++)
+    {
+        optimized[i] = optimizeBooleanExpression(optimized[i]);
+        programs[i] = compileBooleanExpression(optimized[i]);
+        if (trees[i] == NULL || optimized[i] == NULL || programs[i] == NULL)
+        {
+            log_error("goldi-bench: rule %d could not be parsed: %s", i, ruleStrings[i]);
+            error = 1;
+            goto cleanup;
+        }
+    }
+    time = getNanoseconds() - start;
+    printf("parse %-28s %8.1f us per rule\n", "optimize and compile", time / 1e3 / parameters->ruleCount);
+    printMemoryUsage("after parsing the rules");
+
+    /* the time to apply the inputs is measured on its own and subtracted */
+    start = getNanoseconds();
+    for (unsigned int cycle = 0; cycle < parameters->cycles; cycle++)
+    {
+        applyInput(bench, cycle);
+        __asm__ volatile("" ::: "memory");
+    }
+    double inputTime = getNanoseconds() - start;
+
+    benchmarkEvaluator("evaluateBooleanExpression", evaluateTree, (void**)trees, bench, parameters, inputTime);
+    benchmarkEvaluator("optimized tree", evaluateTree, (void**)optimized, bench, parameters, inputTime);
+    benchmarkEvaluator("bytecode", evaluateBytecode, (void**)programs, bench, parameters, inputTime);
+
+cleanup:
+    for (int i = 0; i < parameters->ruleCount; i++)
+    {
+        free(ruleStrings[i]);
+        destroyBooleanExpression(trees[i]);
+        destroyBooleanExpression(optimized[i]);
+        destroyCompiledBooleanExpression(programs[i]);
+    }
+    free(ruleStrings);
+    free(trees);
+    free(optimized);
+    free(programs);
+    return error;
+}
+
+/* times the updates of the state machines, a state machine starts again once its end state is reached */
+static int timeStateMachines(const char* name, StateMachine* stateMachines, unsigned int stateMachineCount, BenchVariables* bench, BenchParameters* parameters)
+{
+    int error = 0;
+    unsigned long long transitions = 0;
+    unsigned long long allocations = allocationCount;
+    double start = getNanoseconds();
+    for (unsigned int cycle = 0; cycle < parameters->cycles && !error; cycle++)
+    {
+        applyInput(bench, cycle);
+        for (unsigned int i = 0; i < stateMachineCount; i++)
+        {
+            StateMachineState* previousState = stateMachines[i].activeState;
+            error |= !updateStateMachine(&stateMachines[i]);
+            transitions += stateMachines[i].activeState != previousState;
+            if (stateMachines[i].activeState == stateMachines[i].endState)
+            {
+                resetStateMachine(&stateMachines[i]);
+            }
+        }
+    }
+    double time = getNanoseconds() - start;
+    double updates = (double)parameters->cycles * stateMachineCount;
+    if (error)
+    {
+        log_error("goldi-bench: a transition function could not be evaluated");
+    }
+    else
+    {
+        printf("eval  %-28s %8.1f ns per update, %8.3f allocations per update (%.3f transitions per update)\n", name,
+               time / updates, (allocationCount - allocations) / updates, transitions / updates);
+    }
+    return error;
+}
+
+/* parses the state machines and times their updates with and without their next state tables */
+static int benchmarkStateMachines(BenchVariables* bench, BenchParameters* parameters)
+{
+    Buffer buffer = {NULL, 0, 0};
+    if (generateStateMachines(&buffer, bench, parameters))
+    {
+        free(buffer.string);
+        return 1;
+    }
+    printf("state machines: %u state machines with %u states\n", parameters->stateMachineCount, parameters->stateCount);
+
+    ExpressionStore* expressions = createExpressionStore();
+    if (expressions == NULL)
+    {
+        free(buffer.string);
+        return 1;
+    }
+    unsigned int stateMachineCount = 0;
+    unsigned long long allocations = allocationCount;
+    double start = getNanoseconds();
+    StateMachine* stateMachines = parseStateMachines(buffer.string, buffer.length, bench->variables, bench->variableCount, expressions, &stateMachineCount);
+    double time = getNanoseconds() - start;
+    free(buffer.string);
+    if (stateMachines == NULL)
+    {
+        log_error("goldi-bench: the state machines could not be parsed");
+        destroyExpressionStore(expressions);
+        return 1;
+    }
+    printf("parse %-28s %8.1f us per state machine, %8.1f allocations per state machine\n", "parseStateMachines",
+           time / 1e3 / stateMachineCount, (double)(allocationCount - allocations) / stateMachineCount);
+    printMemoryUsage("after parsing the machines");
+
+    unsigned int tableCount = 0;
+    unsigned long long tableEntries = 0;
+    for (unsigned int i = 0; i < stateMachineCount; i++)
+    {
+        tableCount += stateMachines[i].nextStateTable != NULL;
+        tableEntries += getNextStateTableSize(&stateMachines[i]);
+    }
+    printf("table %-28s %8u of %u state machines, %llu entries (%llu kB)\n", "next state tables", tableCount, stateMachineCount,
+           tableEntries, tableEntries * sizeof(*stateMachines[0].nextStateTable) / 1024);
+
+    int error = timeStateMachines(tableCount > 0 ? "updateStateMachine (tables)" : "updateStateMachine", stateMachines, stateMachineCount, bench, parameters);
+
+    /* the same updates without the tables, the transition functions are evaluated instead */
+    if (tableCount > 0 && !error)
+    {
+        unsigned short* tables[stateMachineCount];
+        for (unsigned int i = 0; i < stateMachineCount; i++)
+        {
+            tables[i] = stateMachines[i].nextStateTable;
+            stateMachines[i].nextStateTable = NULL;
+            resetStateMachine(&stateMachines[i]);
+        }
+        error = timeStateMachines("updateStateMachine (functions)", stateMachines, stateMachineCount, bench, parameters);
+        for (unsigned int i = 0; i < stateMachineCount; i++)
+        {
+            stateMachines[i].nextStateTable = tables[i];
+        }
+    }
+
+    destroyStateMachines(stateMachines, stateMachineCount);
+    destroyExpressionStore(expressions);
+    return error;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -v, --variables <n>         the amount of variables (default 64)\n");
+    printf("    -n, --numbers <percent>     the share of number variables (default 25)\n");
+    printf("    -d, --depth <n>             the depth of the generated expressions (default 3)\n");
+    printf("    -r, --rules <n>             the amount of rules (default 100)\n");
+    printf("    -m, --machines <n>          the amount of state machines (default 4)\n");
+    printf("    -s, --states <n>            the amount of states of every state machine (default 8)\n");
+    printf("    -c, --cycles <n>            the amount of cycles every evaluator is timed with (default 100000)\n");
+    printf("    -S, --seed <n>              the seed of the random generator (default 1)\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"variables",   required_argument,  NULL, 'v'},
+        {"numbers",     required_argument,  NULL, 'n'},
+        {"depth",       required_argument,  NULL, 'd'},
+        {"rules",       required_argument,  NULL, 'r'},
+        {"machines",    required_argument,  NULL, 'm'},
+        {"states",      required_argument,  NULL, 's'},
+        {"cycles",      required_argument,  NULL, 'c'},
+        {"seed",        required_argument,  NULL, 'S'},
+        {"help",        no_argument,        NULL, 'h'},
+        {NULL,          0,                  NULL, 0}
+    };
+
+    BenchParameters parameters = {64, 25, 3, 100, 4, 8, 100000, 1};
+    int option;
+    while ((option = getopt_long(argc, argv, "v:n:d:r:m:s:c:S:h", options, NULL)) != -1)
+    {
+        unsigned int value = optarg != NULL ? strtoul(optarg, NULL, 10) : 0;
+        switch (option)
+        {
+            case 'v':
+                parameters.variableCount = value;
+                break;
+
+            case 'n':
+                parameters.numberPercentage = value;
+                break;
+
+            case 'd':
+                parameters.depth = value;
+                break;
+
+            case 'r':
+                parameters.ruleCount = value;
+                break;
+
+            case 'm':
+                parameters.stateMachineCount = value;
+                break;
+
+            case 's':
+                parameters.stateCount = value;
+                break;
+
+            case 'c':
+                parameters.cycles = value;
+                break;
+
+            case 'S':
+                parameters.seed = value;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    unsigned int numberCount = parameters.variableCount * parameters.numberPercentage / 100;
+    if (optind != argc || parameters.numberPercentage > 100 || numberCount == parameters.variableCount || parameters.depth > 16 ||
+        parameters.ruleCount == 0 || parameters.stateCount < 2 || parameters.cycles == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    srand(parameters.seed);
+    BenchVariables bench;
+    if (createBenchVariables(&bench, &parameters))
+    {
+        destroyBenchVariables(&bench);
+        return 1;
+    }
+    printMemoryUsage("at start");
+
+    int result = benchmarkRules(&bench, &parameters);
+    if (parameters.stateMachineCount > 0)
+    {
+        result |= benchmarkStateMachines(&bench, &parameters);
+    }
+    printMemoryUsage("at end");
+
+    destroyBenchVariables(&bench);
+    return result != 0;
+}
\ No newline at end of file
@@ -0,0 +1,645 @@
+/*
+ *  goldi-compile: generates a C plugin for the Protection and Initialization Service from an ExperimentData.json
+ *
+ *  usage: goldi-compile [-o <output.c>] <ExperimentData.json>
+ *      -o, --output    -   the file the generated C code is written to (default: stdout)
+ *
+ *  The generated code reads the sensor and actuator values through static process-image arrays, checks the
+ *  protection rules in straight-line code and runs every initializer as a switch over its active states,
+ *  with the transition functions specialized for every single active state. It is built into a shared object, see
+ *  ExperimentPlugin.h for the interface and how the services find it.
+ */
+
+#include "../parsers/BooleanExpressionParser.h"
+#include "../parsers/BooleanExpressionOptimizer.h"
+#include "../parsers/json.h"
+#include "../interfaces/SensorsActuators.h"
+#include "../interfaces/ExperimentPlugin.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+
+/*
+ *  everything needed to translate the variables of an expression into C
+ *  output          -   the file the code is written to
+ *  variables       -   the sensors followed by the actuators
+ *  sensorCount     -   the amount of sensors
+ *  variablesCount  -   the amount of sensors and actuators
+ *  stateValues     -   the values the states of the current state machine are bound to while parsing
+ *  stateCount      -   the amount of states of the current state machine, 0 outside of state machines
+ */
+typedef struct
+{
+    FILE*           output;
+    Variable*       variables;
+    unsigned int    sensorCount;
+    unsigned int    variablesCount;
+    const char*     stateValues;
+    unsigned int    stateCount;
+} Generator;
+
+/*
+ *  writes the given name as a C string literal, quotes, backslashes, question marks (trigraphs) and
+ *  all non-printable characters are escaped
+ */
+static void emitString(FILE* output, const char* name)
+{
+    fputc('"', output);
+    for (const unsigned char* character = (const unsigned char*)name; *character != '\0'; character++)
+    {
+        if (*character == '"' || *character == '\\' || *character == '?')
+        {
+            fprintf(output, "\\%c", *character);
+        }
+        else if (*character < 0x20 || *character >= 0x7F)
+        {
+            /* always three octal digits, so a following digit is not read as part of the escape sequence */
+            fprintf(output, "\\%03o", *character);
+        }
+        else
+        {
+            fputc(*character, output);
+        }
+    }
+    fputc('"', output);
+}
+
+/* writes the given name inside of a C comment, a contained end of a comment or line break is broken up */
+static void emitComment(FILE* output, const char* name)
+{
+    for (const char* character = name; *character != '\0'; character++)
+    {
+        if (*character == '\n' || *character == '\r')
+        {
+            fputc(' ', output);
+            continue;
+        }
+        fputc(*character, output);
+        if (*character == '*' && character[1] == '/')
+        {
+            fputc(' ', output);
+        }
+    }
+}
+
+/* returns the index of the state the value belongs to, -1 if the value belongs to no state */
+static int getStateIndex(Generator* generator, const char* value)
+{
+    if (generator->stateCount > 0 && value >= generator->stateValues && value < generator->stateValues + generator->stateCount)
+    {
+        return value - generator->stateValues;
+    }
+    return -1;
+}
+
+/* writes the process-image entry of the variable with the given value address, returns 1 if there is none */
+static int emitVariable(Generator* generator, const char* value)
+{
+    for (unsigned int i = 0; i < generator->variablesCount; i++)
+    {
+        if (generator->variables[i].value == value)
+        {
+            if (i < generator->sensorCount)
+            {
+                fprintf(generator->output, "sensor[%u]", i);
+            }
+            else
+            {
+                fprintf(generator->output, "actuator[%u]", i - generator->sensorCount);
+            }
+            return 0;
+        }
+    }
+    log_error("goldi-compile: expression uses a variable that is neither a sensor nor an actuator");
+    return 1;
+}
+
+/* writes an operand of a comparison as unsigned long long, the interpreter compares unsigned big-endian values */
+static int emitNumber(Generator* generator, BooleanExpression* expression)
+{
+    if (expression->valueSize > sizeof(unsigned long long))
+    {
+        log_error("goldi-compile: values with more than %zu bytes are not supported", sizeof(unsigned long long));
+        return 1;
+    }
+    if (expression->type == BoolExprCONSTANT)
+    {
+        unsigned long long number = 0;
+        for (unsigned int i = 0; i < expression->valueSize; i++)
+        {
+            number = (number << 8) | (unsigned char)expression->value[i];
+        }
+        fprintf(generator->output, "%lluull", number);
+        return 0;
+    }
+    if (expression->type != BoolExprVARIABLE)
+    {
+        log_error("goldi-compile: comparisons can only be used on variables and constants");
+        return 1;
+    }
+    int state = getStateIndex(generator, expression->value);
+    if (state >= 0)
+    {
+        fprintf(generator->output, "((activeStates >> %d) & 1)", state);
+        return 0;
+    }
+    fprintf(generator->output, "readNumber(");
+    if (emitVariable(generator, expression->value))
+    {
+        return 1;
+    }
+    fprintf(generator->output, ", %u)", expression->valueSize);
+    return 0;
+}
+
+/* writes the expression as a C expression evaluating to 0 or 1, without any branches */
+static int emitExpression(Generator* generator, BooleanExpression* expression)
+{
+    switch (expression->type)
+    {
+        case BoolExprCONSTANT:
+            fprintf(generator->output, "%d", expression->value[0] != 0);
+            return 0;
+
+        case BoolExprVARIABLE:
+            if (getStateIndex(generator, expression->value) >= 0)
+            {
+                fprintf(generator->output, "((activeStates >> %d) & 1)", getStateIndex(generator, expression->value));
+                return 0;
+            }
+            fprintf(generator->output, "(");
+            if (emitVariable(generator, expression->value))
+            {
+                return 1;
+            }
+            fprintf(generator->output, "[0] != 0)");
+            return 0;
+
+        case BoolExprNOT:
+            fprintf(generator->output, "!");
+            return emitExpression(generator, expression->leftside);
+
+        case BoolExprAND:
+        case BoolExprOR:
+            fprintf(generator->output, "(");
+            if (emitExpression(generator, expression->leftside))
+            {
+                return 1;
+            }
+            fprintf(generator->output, expression->type == BoolExprAND ? " & " : " | ");
+            if (emitExpression(generator, expression->rightside))
+            {
+                return 1;
+            }
+            fprintf(generator->output, ")");
+            return 0;
+
+        default:
+        {
+            const char* operator = expression->type == BoolExprEQUAL ? " == " : expression->type == BoolExprGREATER ? " > " : " < ";
+            fprintf(generator->output, "(");
+            if (emitNumber(generator, expression->leftside))
+            {
+                return 1;
+            }
+            fprintf(generator->output, "%s", operator);
+            if (emitNumber(generator, expression->rightside))
+            {
+                return 1;
+            }
+            fprintf(generator->output, ")");
+            return 0;
+        }
+    }
+}
+
+/* parses and optimizes the given expression, logs the position of a syntax error */
+static BooleanExpression* parseExpression(const char* expressionString, SymbolTable* symbols)
+{
+    BooleanExpressionParseError parseError;
+    BooleanExpression* expression = parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError);
+    if (expression == NULL)
+    {
+        log_error("goldi-compile: expression %s could not be parsed: %s at position %u", expressionString, parseError.message, parseError.position);
+        return NULL;
+    }
+    return optimizeBooleanExpression(expression);
+}
+
+/* writes the process image, the helpers and the function binding the process image */
+static void emitProcessImage(Generator* generator, unsigned int actuatorCount)
+{
+    FILE* output = generator->output;
+    fprintf(output, "#define SENSOR_COUNT %u\n", generator->sensorCount);
+    fprintf(output, "#define ACTUATOR_COUNT %u\n\n", actuatorCount);
+    fprintf(output, "/* the addresses of the values of all sensors and actuators, set by bindProcessImage */\n");
+    fprintf(output, "static const char* sensor[SENSOR_COUNT > 0 ? SENSOR_COUNT : 1];\n");
+    fprintf(output, "static const char* actuator[ACTUATOR_COUNT > 0 ? ACTUATOR_COUNT : 1];\n\n");
+    fprintf(output, "/* reads an unsigned big-endian value, as compared by the interpreter */\n");
+    fprintf(output, "static inline unsigned long long readNumber(const char* value, unsigned int size)\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    unsigned long long number = 0;\n");
+    fprintf(output, "    for (unsigned int i = 0; i < size; i++)\n");
+    fprintf(output, "    {\n");
+    fprintf(output, "        number = (number << 8) | (unsigned char)value[i];\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "    return number;\n");
+    fprintf(output, "}\n\n");
+    fprintf(output, "static void bindProcessImage(char* const* sensorValues, char* const* actuatorValues)\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    for (unsigned int i = 0; i < SENSOR_COUNT; i++)\n");
+    fprintf(output, "    {\n");
+    fprintf(output, "        sensor[i] = sensorValues[i];\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "    for (unsigned int i = 0; i < ACTUATOR_COUNT; i++)\n");
+    fprintf(output, "    {\n");
+    fprintf(output, "        actuator[i] = actuatorValues[i];\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "}\n\n");
+}
+
+/* writes evaluateProtectionRules, every rule is a single branch-free statement */
+static int emitProtectionRules(Generator* generator, JSON* protectionRulesJSON)
+{
+    SymbolTable* symbols = createSymbolTable(generator->variables, generator->variablesCount);
+    if (symbols == NULL)
+    {
+        return 1;
+    }
+    FILE* output = generator->output;
+    fprintf(output, "#define RULE_COUNT %d\n\n", JSONGetArraySize(protectionRulesJSON));
+    fprintf(output, "static unsigned int evaluateProtectionRules(unsigned char* results)\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    unsigned int triggered = 0;\n");
+
+    int errors = 0;
+    int ruleIndex = 0;
+    JSON* ruleJSON = NULL;
+    JSONArrayForEach(ruleJSON, protectionRulesJSON)
+    {
+        BooleanExpression* expression = parseExpression(JSONGetObjectItem(ruleJSON, "Expression")->valuestring, symbols);
+        if (expression == NULL)
+        {
+            errors++;
+            ruleIndex++;
+            continue;
+        }
+        fprintf(output, "    /* ErrorCode %d */\n", JSONGetObjectItem(ruleJSON, "ErrorCode")->valueint);
+        fprintf(output, "    results[%d] = ", ruleIndex);
+        errors += emitExpression(generator, expression);
+        fprintf(output, ";\n");
+        fprintf(output, "    triggered += results[%d];\n", ruleIndex);
+        destroyBooleanExpression(expression);
+        ruleIndex++;
+    }
+    fprintf(output, "    return triggered;\n");
+    fprintf(output, "}\n\n");
+
+    destroySymbolTable(symbols);
+    return errors;
+}
+
+/* replaces every state of the state machine inside of the expression by a constant, only state is active */
+static int specializeForState(Generator* generator, BooleanExpression* expression, int state)
+{
+    if (expression == NULL)
+    {
+        return 0;
+    }
+    if (expression->type == BoolExprVARIABLE && getStateIndex(generator, expression->value) >= 0)
+    {
+        int isActive = getStateIndex(generator, expression->value) == state;
+        expression->value = malloc(1);
+        if (expression->value == NULL)
+        {
+            log_error("goldi-compile: malloc error %s", strerror(errno));
+            return 1;
+        }
+        expression->type = BoolExprCONSTANT;
+        expression->name = NULL;
+        expression->value[0] = isActive;
+        expression->valueSize = 1;
+        return 0;
+    }
+    return specializeForState(generator, expression->leftside, state) || specializeForState(generator, expression->rightside, state);
+}
+
+/*
+ *  writes the transitions of the state machine for one active state, or for any combination of active
+ *  states if state is -1. Transition functions that are always false for the active state are left out.
+ */
+static int emitTransitions(Generator* generator, char** transitionFunctions, SymbolTable* symbols, int state)
+{
+    FILE* output = generator->output;
+    for (int i = 0; i < generator->stateCount; i++)
+    {
+        /* a missing transition function is constant false, like in the state machines of the service */
+        BooleanExpression* expression = transitionFunctions[i] == NULL ? createBinaryConstant(0) : parseExpression(transitionFunctions[i], symbols);
+        if (expression == NULL)
+        {
+            return 1;
+        }
+        if (state >= 0)
+        {
+            if (specializeForState(generator, expression, state))
+            {
+                destroyBooleanExpression(expression);
+                return 1;
+            }
+            expression = optimizeBooleanExpression(expression);
+        }
+
+        int errors = 0;
+        if (expression->type != BoolExprCONSTANT)
+        {
+            fprintf(output, "            nextStates |= (unsigned long long)");
+            errors = emitExpression(generator, expression);
+            fprintf(output, " << %d;\n", i);
+        }
+        else if (expression->value[0] != 0)
+        {
+            fprintf(output, "            nextStates |= 1ull << %d;\n", i);
+        }
+        destroyBooleanExpression(expression);
+        if (errors)
+        {
+            return 1;
+        }
+    }
+    fprintf(output, "            break;\n");
+    return 0;
+}
+
+/*
+ *  writes the function returning the next states of one initializer, every single active state gets its
+ *  own case with the transition functions specialized for it
+ */
+static int emitStateMachine(Generator* generator, JSON* initializerJSON, unsigned int stateMachineIndex)
+{
+    JSON* stateNamesJSON = JSONGetObjectItem(initializerJSON, "StateNames");
+    JSON* transitionFunctionsJSON = JSONGetObjectItem(initializerJSON, "StateTransitionFunctions");
+    unsigned int stateCount = JSONGetArraySize(stateNamesJSON);
+    if (stateCount > EXPERIMENT_PLUGIN_MAX_STATES)
+    {
+        log_error("goldi-compile: initializer %s has more than %d states", initializerJSON->string, EXPERIMENT_PLUGIN_MAX_STATES);
+        return 1;
+    }
+    unsigned int variablesCount = generator->variablesCount + stateCount;
+
+    /* the states can be used as variables by the transition functions, their values are never read */
+    Variable variables[variablesCount];
+    char stateValues[stateCount > 0 ? stateCount : 1];
+    char* transitionFunctions[stateCount > 0 ? stateCount : 1];
+    memcpy(variables, generator->variables, sizeof(*variables) * generator->variablesCount);
+    for (int i = 0; i < stateCount; i++)
+    {
+        char* stateName = JSONGetArrayItem(stateNamesJSON, i)->valuestring;
+        JSON* transitionFunctionJSON = JSONGetObjectItem(transitionFunctionsJSON, stateName);
+        transitionFunctions[i] = transitionFunctionJSON == NULL ? NULL : transitionFunctionJSON->valuestring;
+        if (transitionFunctions[i] == NULL)
+        {
+            log_info("goldi-compile: state %s of initializer %s has no transition function, it is never entered", stateName, initializerJSON->string);
+        }
+        stateValues[i] = 0;
+        variables[generator->variablesCount + i] = (Variable){OperandTypeBinary, stateName, &stateValues[i], 1};
+    }
+    SymbolTable* symbols = createSymbolTable(variables, variablesCount);
+    if (symbols == NULL)
+    {
+        return 1;
+    }
+    generator->stateValues = stateValues;
+    generator->stateCount = stateCount;
+
+    FILE* output = generator->output;
+    fprintf(output, "/* initializer ");
+    emitComment(output, initializerJSON->string);
+    fprintf(output, " */\n");
+    fprintf(output, "static unsigned long long nextStates%u(unsigned long long activeStates)\n", stateMachineIndex);
+    fprintf(output, "{\n");
+    fprintf(output, "    unsigned long long nextStates = 0;\n");
+    fprintf(output, "    switch (activeStates)\n");
+    fprintf(output, "    {\n");
+    int errors = 0;
+    for (int state = 0; state < stateCount && !errors; state++)
+    {
+        fprintf(output, "        case 1ull << %d:    /* ", state);
+        emitComment(output, JSONGetArrayItem(stateNamesJSON, state)->valuestring);
+        fprintf(output, " */\n");
+        errors = emitTransitions(generator, transitionFunctions, symbols, state);
+        fprintf(output, "\n");
+    }
+    if (!errors)
+    {
+        fprintf(output, "        default:\n");
+        errors = emitTransitions(generator, transitionFunctions, symbols, -1);
+    }
+    fprintf(output, "    }\n");
+    fprintf(output, "    return nextStates;\n");
+    fprintf(output, "}\n\n");
+
+    generator->stateValues = NULL;
+    generator->stateCount = 0;
+    destroySymbolTable(symbols);
+    return errors;
+}
+
+/* writes all initializers, the table of their names and state counts and the dispatching nextState */
+static int emitStateMachines(Generator* generator, JSON* initializersJSON)
+{
+    FILE* output = generator->output;
+    unsigned int stateMachineCount = JSONGetArraySize(initializersJSON);
+    int errors = 0;
+    unsigned int stateMachineIndex = 0;
+    JSON* initializerJSON = NULL;
+    JSONArrayForEach(initializerJSON, initializersJSON)
+    {
+        errors += emitStateMachine(generator, initializerJSON, stateMachineIndex++);
+    }
+
+    fprintf(output, "#define STATE_MACHINE_COUNT %u\n\n", stateMachineCount);
+    fprintf(output, "static const char* const stateMachineNames[STATE_MACHINE_COUNT > 0 ? STATE_MACHINE_COUNT : 1] =\n");
+    fprintf(output, "{\n");
+    JSONArrayForEach(initializerJSON, initializersJSON)
+    {
+        fprintf(output, "    ");
+        emitString(output, initializerJSON->string);
+        fprintf(output, ",\n");
+    }
+    fprintf(output, "};\n\n");
+    fprintf(output, "static const unsigned int stateCounts[STATE_MACHINE_COUNT > 0 ? STATE_MACHINE_COUNT : 1] =\n");
+    fprintf(output, "{\n");
+    JSONArrayForEach(initializerJSON, initializersJSON)
+    {
+        fprintf(output, "    %d,\n", JSONGetArraySize(JSONGetObjectItem(initializerJSON, "StateNames")));
+    }
+    fprintf(output, "};\n\n");
+
+    fprintf(output, "static unsigned long long nextStates(unsigned int stateMachine, unsigned long long activeStates)\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    switch (stateMachine)\n");
+    fprintf(output, "    {\n");
+    for (unsigned int i = 0; i < stateMachineCount; i++)
+    {
+        fprintf(output, "        case %u:\n", i);
+        fprintf(output, "            return nextStates%u(activeStates);\n", i);
+    }
+    fprintf(output, "        default:\n");
+    fprintf(output, "            return 0;\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "}\n\n");
+    return errors;
+}
+
+/* writes the complete plugin of the experiment */
+static int compileExperiment(FILE* output, const char* path, JSON* experimentJSON, unsigned long long protectionHash, unsigned long long initializationHash,
+                             Variable* variables, unsigned int sensorCount, unsigned int actuatorCount)
+{
+    Generator generator = {output, variables, sensorCount, sensorCount + actuatorCount, NULL, 0};
+    fprintf(output, "/* generated by goldi-compile from ");
+    emitComment(output, path);
+    fprintf(output, ", do not edit */\n\n");
+    fprintf(output, "#include \"interfaces/ExperimentPlugin.h\"\n\n");
+
+    emitProcessImage(&generator, actuatorCount);
+    int errors = emitProtectionRules(&generator, JSONGetObjectItem(experimentJSON, "ProtectionRules"));
+    errors += emitStateMachines(&generator, JSONGetObjectItem(experimentJSON, "Initializers"));
+
+    fprintf(output, "const ExperimentPlugin goldiExperimentPlugin =\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    .abiVersion = %d,\n", EXPERIMENT_PLUGIN_ABI_VERSION);
+    fprintf(output, "    .protectionHash = 0x%016llxull,\n", protectionHash);
+    fprintf(output, "    .initializationHash = 0x%016llxull,\n", initializationHash);
+    fprintf(output, "    .sensorCount = SENSOR_COUNT,\n");
+    fprintf(output, "    .actuatorCount = ACTUATOR_COUNT,\n");
+    fprintf(output, "    .ruleCount = RULE_COUNT,\n");
+    fprintf(output, "    .stateMachineCount = STATE_MACHINE_COUNT,\n");
+    fprintf(output, "    .stateMachineNames = stateMachineNames,\n");
+    fprintf(output, "    .stateCounts = stateCounts,\n");
+    fprintf(output, "    .bindProcessImage = bindProcessImage,\n");
+    fprintf(output, "    .evaluateProtectionRules = evaluateProtectionRules,\n");
+    fprintf(output, "    .nextStates = nextStates\n");
+    fprintf(output, "};\n");
+    return errors;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options] <ExperimentData.json>\n", name);
+    printf("    -o, --output <file>     write the generated C code to file instead of stdout\n");
+    printf("    -h, --help              print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"output",  required_argument, NULL, 'o'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL,      0,                 NULL, 0}
+    };
+
+    const char* outputPath = NULL;
+    int option;
+    while ((option = getopt_long(argc, argv, "o:h", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'o':
+                outputPath = optarg;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    char* experimentString = readFile(argv[optind], NULL);
+    if (experimentString == NULL)
+    {
+        log_error("goldi-compile: %s could not be read", argv[optind]);
+        return 1;
+    }
+    JSON* experimentJSON = JSONParse(experimentString);
+    free(experimentString);
+    if (experimentJSON == NULL)
+    {
+        log_error("goldi-compile: %s does not contain valid json", argv[optind]);
+        return 1;
+    }
+
+    /* the sections are printed and hashed exactly like the services receive them from the Communication Service */
+    static const char* sectionNames[] = {"Sensors", "Actuators", "ProtectionRules", "Initializers"};
+    char* sections[4];
+    int sectionsMissing = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        JSON* sectionJSON = JSONGetObjectItem(experimentJSON, sectionNames[i]);
+        sections[i] = sectionJSON == NULL ? NULL : JSONPrint(sectionJSON);
+        if (sections[i] == NULL)
+        {
+            log_error("goldi-compile: %s are missing in %s", sectionNames[i], argv[optind]);
+            sectionsMissing = 1;
+        }
+    }
+    if (sectionsMissing)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            free(sections[i]);
+        }
+        JSONDelete(experimentJSON);
+        return 1;
+    }
+    char* protectionSections[] = {sections[0], sections[1], sections[2]};
+    char* initializationSections[] = {sections[0], sections[1], sections[3]};
+    unsigned long long protectionHash = hashExperimentSections(protectionSections, 3);
+    unsigned long long initializationHash = hashExperimentSections(initializationSections, 3);
+
+    unsigned int sensorCount = 0;
+    unsigned int actuatorCount = 0;
+    Sensor* sensors = parseSensors(sections[0], strlen(sections[0]), &sensorCount);
+    Actuator* actuators = parseActuators(sections[1], strlen(sections[1]), &actuatorCount, sensorCount);
+    for (int i = 0; i < 4; i++)
+    {
+        free(sections[i]);
+    }
+    if (sensors == NULL || actuators == NULL)
+    {
+        log_error("goldi-compile: sensors and actuators could not be parsed");
+        JSONDelete(experimentJSON);
+        return 1;
+    }
+
+    int result = 1;
+    Variable* variables = createSensorActuatorVariables(sensors, sensorCount, actuators, actuatorCount);
+    FILE* output = outputPath == NULL ? stdout : fopen(outputPath, "w");
+    if (output == NULL)
+    {
+        log_error("goldi-compile: %s could not be opened: %s", outputPath, strerror(errno));
+    }
+    else if (variables != NULL)
+    {
+        result = compileExperiment(output, argv[optind], experimentJSON, protectionHash, initializationHash, variables, sensorCount, actuatorCount) != 0;
+    }
+    if (output != NULL && output != stdout)
+    {
+        fclose(output);
+        if (result != 0)
+        {
+            remove(outputPath);
+        }
+    }
+
+    free(variables);
+    destroySensors(sensors, sensorCount);
+    destroyActuators(actuators, actuatorCount);
+    JSONDelete(experimentJSON);
+    return result;
+}
\ No newline at end of file
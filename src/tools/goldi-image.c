@@ -0,0 +1,773 @@
+/*
+ *  goldi-image: writes the binary experiment image loaded by the Protection and Initialization Service
+ *
+ *  usage: goldi-image [-o <output.img>] [-b] [-n <repetitions>] <ExperimentData.json>
+ *      -o, --output        -   the file the image is written to (default: ExperimentData.img next to the input)
+ *      -b, --benchmark     -   measures how long the services need to load the experiment from the JSON-formatted
+ *                              experiment data and from the image instead of writing the image
+ *      -n, --repetitions   -   the amount of loads measured by the benchmark (default: 100)
+ *
+ *  The image contains the sensors, actuators, the optimized protection rules and the state machines of the
+ *  initializers including their next state tables, see ExperimentImage.h for the format. It is written with the
+ *  same parsers the services use, so loading it gives the same result as parsing the experiment data.
+ */
+
+#include "../parsers/BooleanExpressionParser.h"
+#include "../parsers/BooleanExpressionOptimizer.h"
+#include "../parsers/BooleanExpressionCompiler.h"
+#include "../parsers/StateMachine.h"
+#include "../parsers/json.h"
+#include "../interfaces/SensorsActuators.h"
+#include "../interfaces/ExperimentImage.h"
+#include "../interfaces/ExperimentPlugin.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+
+/* the sections of an image in the order they are written */
+typedef enum
+{
+    SectionSensors,
+    SectionActuators,
+    SectionRules,
+    SectionStateMachines,
+    SectionStates,
+    SectionOutputs,
+    SectionNodes,
+    SectionTableInputs,
+    SectionTables,
+    SectionStrings,
+    SectionCount
+} ImageSectionIndex;
+
+typedef struct
+{
+    char*   data;
+    size_t  length;
+    size_t  capacity;
+} ImageBuffer;
+
+/*
+ *  the image while it is assembled
+ *  sections        -   the content of every section
+ *  variables       -   the sensors followed by the actuators
+ *  variablesCount  -   the amount of sensors and actuators
+ *  stateMachine    -   the state machine whose transition functions are written, NULL for the rules
+ *  failed          -   set if the image could not be assembled
+ */
+typedef struct
+{
+    ImageBuffer     sections[SectionCount];
+    Variable*       variables;
+    unsigned int    variablesCount;
+    StateMachine*   stateMachine;
+    int             failed;
+} ImageWriter;
+
+/* the sections of the experiment data, printed like the Communication Service sends them */
+static const char* sectionNames[] = {"Sensors", "Actuators", "ProtectionRules", "Initializers"};
+
+/* appends the given bytes to a section, returns the offset of the bytes inside of the section */
+static uint32_t appendBytes(ImageWriter* writer, ImageSectionIndex section, const void* bytes, size_t size)
+{
+    ImageBuffer* buffer = &writer->sections[section];
+    if (buffer->length + size > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+        while (capacity < buffer->length + size)
+        {
+            capacity *= 2;
+        }
+        char* data = realloc(buffer->data, capacity);
+        if (data == NULL)
+        {
+            log_error("goldi-image: malloc error %s", strerror(errno));
+            writer->failed = 1;
+            return 0;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, bytes, size);
+    buffer->length += size;
+    return buffer->length - size;
+}
+
+/* appends a record to a section, returns the index of the record */
+static uint32_t appendRecord(ImageWriter* writer, ImageSectionIndex section, const void* record, size_t size)
+{
+    return appendBytes(writer, section, record, size) / size;
+}
+
+static uint32_t appendString(ImageWriter* writer, const char* string)
+{
+    return appendBytes(writer, SectionStrings, string, strlen(string) + 1);
+}
+
+/* returns the index of the variable with the given value, states of the current state machine follow the actuators */
+static uint32_t findVariable(ImageWriter* writer, const char* value)
+{
+    for (unsigned int i = 0; i < writer->variablesCount; i++)
+    {
+        if (writer->variables[i].value == value)
+        {
+            return i;
+        }
+    }
+    for (unsigned int i = 0; writer->stateMachine != NULL && i < writer->stateMachine->statesCount; i++)
+    {
+        if ((const char*)&writer->stateMachine->states[i].isActive == value)
+        {
+            return writer->variablesCount + i;
+        }
+    }
+    log_error("goldi-image: an expression uses an unknown variable");
+    writer->failed = 1;
+    return EXPERIMENT_IMAGE_NONE;
+}
+
+/* appends the nodes of an expression in preorder */
+static void appendExpressionNodes(ImageWriter* writer, BooleanExpression* expression)
+{
+    ImageExpressionNode node = {expression->type, expression->operandType, expression->resultType, expression->valueSize, EXPERIMENT_IMAGE_NONE,
+                                (expression->leftside != NULL) | (expression->rightside != NULL) << 1};
+    if (expression->type == BoolExprVARIABLE)
+    {
+        node.operand = findVariable(writer, expression->value);
+    }
+    else if (expression->value != NULL)
+    {
+        node.operand = appendBytes(writer, SectionStrings, expression->value, expression->valueSize);
+    }
+    appendRecord(writer, SectionNodes, &node, sizeof(node));
+    if (expression->leftside != NULL)
+    {
+        appendExpressionNodes(writer, expression->leftside);
+    }
+    if (expression->rightside != NULL)
+    {
+        appendExpressionNodes(writer, expression->rightside);
+    }
+}
+
+static ImageExpression appendExpression(ImageWriter* writer, BooleanExpression* expression)
+{
+    ImageExpression result = {writer->sections[SectionNodes].length / sizeof(ImageExpressionNode), 0};
+    if (expression != NULL)
+    {
+        appendExpressionNodes(writer, expression);
+        result.count = writer->sections[SectionNodes].length / sizeof(ImageExpressionNode) - result.offset;
+    }
+    return result;
+}
+
+/* appends all protection rules, parsed and optimized like the Protection Service does */
+static int appendRules(ImageWriter* writer, JSON* rulesJSON)
+{
+    SymbolTable* symbols = createSymbolTable(writer->variables, writer->variablesCount);
+    if (symbols == NULL)
+    {
+        return 1;
+    }
+    const JSON* ruleJSON = NULL;
+    JSONArrayForEach(ruleJSON, rulesJSON)
+    {
+        const JSON* expressionJSON = JSONGetObjectItem(ruleJSON, "Expression");
+        const JSON* errorMessageJSON = JSONGetObjectItem(ruleJSON, "ErrorMessage");
+        const JSON* errorCodeJSON = JSONGetObjectItem(ruleJSON, "ErrorCode");
+        if (expressionJSON == NULL || !JSONIsString(expressionJSON) || errorMessageJSON == NULL || !JSONIsString(errorMessageJSON) || errorCodeJSON == NULL)
+        {
+            log_error("goldi-image: a protection rule is incomplete");
+            destroySymbolTable(symbols);
+            return 1;
+        }
+        BooleanExpressionParseError parseError;
+        BooleanExpression* expression = parseBooleanExpressionWithSymbols(expressionJSON->valuestring, strlen(expressionJSON->valuestring), symbols, &parseError);
+        if (expression == NULL)
+        {
+            log_error("goldi-image: expression %s could not be parsed: %s at position %u", expressionJSON->valuestring, parseError.message, parseError.position);
+            destroySymbolTable(symbols);
+            return 1;
+        }
+        expression = optimizeBooleanExpression(expression);
+        ImageRule rule = {appendExpression(writer, expression), appendString(writer, expressionJSON->valuestring),
+                          appendString(writer, errorMessageJSON->valuestring), errorCodeJSON->valueint, 0};
+        appendRecord(writer, SectionRules, &rule, sizeof(rule));
+        destroyBooleanExpression(expression);
+    }
+    destroySymbolTable(symbols);
+    return writer->failed;
+}
+
+/* appends all state machines as parsed by the Initialization Service, including their next state tables */
+static int appendStateMachines(ImageWriter* writer, StateMachine* stateMachines, unsigned int stateMachineCount)
+{
+    for (int i = 0; i < stateMachineCount; i++)
+    {
+        StateMachine* stateMachine = &stateMachines[i];
+        writer->stateMachine = stateMachine;
+        ImageStateMachine imageStateMachine = {appendString(writer, stateMachine->name), {0, stateMachine->statesCount},
+                                               EXPERIMENT_IMAGE_NONE, EXPERIMENT_IMAGE_NONE, {0, 0}, EXPERIMENT_IMAGE_NONE, 0};
+        if (stateMachine->startState != NULL)
+        {
+            imageStateMachine.startState = stateMachine->startState - stateMachine->states;
+        }
+        if (stateMachine->endState != NULL)
+        {
+            imageStateMachine.endState = stateMachine->endState - stateMachine->states;
+        }
+
+        /* the states of a state machine are consecutive records, their outputs and nodes are appended in between */
+        ImageState states[stateMachine->statesCount + 1];
+        for (int j = 0; j < stateMachine->statesCount; j++)
+        {
+            StateMachineState* state = &stateMachine->states[j];
+            states[j].name = appendString(writer, state->name);
+            states[j].transitionFunction = appendExpression(writer, state->transitionFunction);
+            states[j].outputs = (ImageRange){writer->sections[SectionOutputs].length / sizeof(ImageOutput), state->outputCount};
+            for (int k = 0; k < state->outputCount; k++)
+            {
+                ImageOutput output = {appendString(writer, state->outputs[k].actuatorID), state->outputs[k].type,
+                                      appendBytes(writer, SectionStrings, state->outputs[k].value, getValueSizeOfActuatorType(state->outputs[k].type)), 0};
+                appendRecord(writer, SectionOutputs, &output, sizeof(output));
+            }
+        }
+        imageStateMachine.states.offset = writer->sections[SectionStates].length / sizeof(ImageState);
+        for (int j = 0; j < stateMachine->statesCount; j++)
+        {
+            appendRecord(writer, SectionStates, &states[j], sizeof(states[j]));
+        }
+
+        if (stateMachine->nextStateTable != NULL)
+        {
+            imageStateMachine.tableInputs = (ImageRange){writer->sections[SectionTableInputs].length / sizeof(uint32_t), stateMachine->tableInputCount};
+            for (int j = 0; j < stateMachine->tableInputCount; j++)
+            {
+                uint32_t input = findVariable(writer, stateMachine->tableInputs[j]);
+                appendRecord(writer, SectionTableInputs, &input, sizeof(input));
+            }
+            imageStateMachine.table = writer->sections[SectionTables].length / sizeof(uint16_t);
+            for (int j = 0; j < getNextStateTableSize(stateMachine); j++)
+            {
+                uint16_t entry = stateMachine->nextStateTable[j];
+                appendRecord(writer, SectionTables, &entry, sizeof(entry));
+            }
+        }
+        appendRecord(writer, SectionStateMachines, &imageStateMachine, sizeof(imageStateMachine));
+    }
+    writer->stateMachine = NULL;
+    return writer->failed;
+}
+
+/* writes the header and all sections (aligned to 8 bytes) to a temporary file which replaces the image afterwards */
+static int writeImage(ImageWriter* writer, ExperimentImageHeader* header, const char* path)
+{
+    static const char padding[8] = {0};
+    ImageRange* ranges[SectionCount] = {&header->sensors, &header->actuators, &header->rules, &header->stateMachines, &header->states,
+                                        &header->outputs, &header->nodes, &header->tableInputs, &header->tables, &header->strings};
+    static const size_t recordSizes[SectionCount] = {sizeof(ImageSensor), sizeof(ImageActuator), sizeof(ImageRule), sizeof(ImageStateMachine),
+                                                     sizeof(ImageState), sizeof(ImageOutput), sizeof(ImageExpressionNode), sizeof(uint32_t),
+                                                     sizeof(uint16_t), 1};
+    size_t size = (sizeof(*header) + 7) & ~(size_t)7;
+    for (int i = 0; i < SectionCount; i++)
+    {
+        ranges[i]->offset = size;
+        ranges[i]->count = writer->sections[i].length / recordSizes[i];
+        size = (size + writer->sections[i].length + 7) & ~(size_t)7;
+    }
+    if (size > 0xFFFFFFFFu)
+    {
+        log_error("goldi-image: the image would be larger than 4 GiB");
+        return 1;
+    }
+    header->size = size;
+
+    char temporaryPath[strlen(path) + 5];
+    sprintf(temporaryPath, "%s.tmp", path);
+    FILE* output = fopen(temporaryPath, "wb");
+    if (output == NULL)
+    {
+        log_error("goldi-image: %s could not be opened: %s", temporaryPath, strerror(errno));
+        return 1;
+    }
+    int failed = fwrite(header, sizeof(*header), 1, output) != 1;
+    failed |= fwrite(padding, ranges[0]->offset - sizeof(*header), 1, output) != 1 && ranges[0]->offset != sizeof(*header);
+    for (int i = 0; i < SectionCount && !failed; i++)
+    {
+        size_t end = i + 1 < SectionCount ? ranges[i + 1]->offset : size;
+        size_t paddingSize = end - ranges[i]->offset - writer->sections[i].length;
+        failed |= writer->sections[i].length > 0 && fwrite(writer->sections[i].data, writer->sections[i].length, 1, output) != 1;
+        failed |= paddingSize > 0 && fwrite(padding, paddingSize, 1, output) != 1;
+    }
+    failed |= fclose(output) != 0;
+    if (failed || rename(temporaryPath, path) != 0)
+    {
+        log_error("goldi-image: %s could not be written: %s", path, strerror(errno));
+        remove(temporaryPath);
+        return 1;
+    }
+    return 0;
+}
+
+/* writes the image of the experiment data in the given string to path */
+static int writeExperimentImage(char* experimentString, const char* path)
+{
+    JSON* experimentJSON = JSONParse(experimentString);
+    if (experimentJSON == NULL)
+    {
+        log_error("goldi-image: the experiment data is no valid json");
+        return 1;
+    }
+
+    /* the sections are printed and hashed exactly like the services receive them from the Communication Service */
+    char* sections[4];
+    int sectionsMissing = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        JSON* sectionJSON = JSONGetObjectItem(experimentJSON, sectionNames[i]);
+        sections[i] = sectionJSON == NULL ? NULL : JSONPrint(sectionJSON);
+        if (sections[i] == NULL)
+        {
+            log_error("goldi-image: %s are missing in the experiment data", sectionNames[i]);
+            sectionsMissing = 1;
+        }
+    }
+    char* protectionSections[] = {sections[0], sections[1], sections[2]};
+    char* initializationSections[] = {sections[0], sections[1], sections[3]};
+    ExperimentImageHeader header = {.magic = EXPERIMENT_IMAGE_MAGIC, .version = EXPERIMENT_IMAGE_VERSION, .byteOrder = EXPERIMENT_IMAGE_BYTE_ORDER};
+    header.sourceHash = hashExperimentSections(&experimentString, 1);
+    if (!sectionsMissing)
+    {
+        header.protectionHash = hashExperimentSections(protectionSections, 3);
+        header.initializationHash = hashExperimentSections(initializationSections, 3);
+    }
+
+    unsigned int sensorCount = 0;
+    unsigned int actuatorCount = 0;
+    unsigned int stateMachineCount = 0;
+    Sensor* sensors = sectionsMissing ? NULL : parseSensors(sections[0], strlen(sections[0]), &sensorCount);
+    Actuator* actuators = sensors == NULL ? NULL : parseActuators(sections[1], strlen(sections[1]), &actuatorCount, sensorCount);
+    Variable* variables = actuators == NULL ? NULL : createSensorActuatorVariables(sensors, sensorCount, actuators, actuatorCount);
+    ExpressionStore* expressions = variables == NULL ? NULL : createExpressionStore();
+    StateMachine* stateMachines = expressions == NULL ? NULL : parseStateMachines(sections[3], strlen(sections[3]), variables, sensorCount + actuatorCount,
+                                                                                  expressions, &stateMachineCount);
+    int result = 1;
+    ImageWriter writer = {0};
+    if (stateMachines == NULL)
+    {
+        log_error("goldi-image: the experiment data could not be parsed");
+    }
+    else
+    {
+        writer.variables = variables;
+        writer.variablesCount = sensorCount + actuatorCount;
+        appendString(&writer, "");
+        for (int i = 0; i < sensorCount; i++)
+        {
+            ImageSensor sensor = {appendString(&writer, sensors[i].sensorID), sensors[i].type, sensors[i].pinMapping, sensors[i].isVirtual};
+            appendRecord(&writer, SectionSensors, &sensor, sizeof(sensor));
+        }
+        for (int i = 0; i < actuatorCount; i++)
+        {
+            ImageActuator actuator = {appendString(&writer, actuators[i].actuatorID), actuators[i].type, actuators[i].pinMapping,
+                                      appendBytes(&writer, SectionStrings, actuators[i].stopValue, getValueSizeOfActuatorType(actuators[i].type))};
+            appendRecord(&writer, SectionActuators, &actuator, sizeof(actuator));
+        }
+        result = writer.failed || appendRules(&writer, JSONGetObjectItem(experimentJSON, "ProtectionRules")) ||
+                 appendStateMachines(&writer, stateMachines, stateMachineCount) || writeImage(&writer, &header, path);
+    }
+    if (result == 0)
+    {
+        log_info("goldi-image: wrote %s with %u sensors, %u actuators, %u rules and %u state machines (%u bytes)", path,
+                 header.sensors.count, header.actuators.count, header.rules.count, header.stateMachines.count, header.size);
+    }
+
+    for (int i = 0; i < SectionCount; i++)
+    {
+        free(writer.sections[i].data);
+    }
+    if (stateMachines != NULL)
+    {
+        destroyStateMachines(stateMachines, stateMachineCount);
+    }
+    destroyExpressionStore(expressions);
+    free(variables);
+    if (actuators != NULL)
+    {
+        destroyActuators(actuators, actuatorCount);
+    }
+    if (sensors != NULL)
+    {
+        destroySensors(sensors, sensorCount);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        free(sections[i]);
+    }
+    JSONDelete(experimentJSON);
+    return result;
+}
+
+/*
+ *  an experiment as loaded by the Protection Service (sensors, actuators and rules) and the Initialization Service
+ *  (its own sensors, actuators and the state machines)
+ */
+typedef struct
+{
+    Sensor*                     sensors[2];
+    Actuator*                   actuators[2];
+    Variable*                   variables[2];
+    unsigned int                sensorCount;
+    unsigned int                actuatorCount;
+    BooleanExpression**         rules;
+    CompiledBooleanExpression** programs;
+    unsigned int                ruleCount;
+    ExpressionStore*            expressions;
+    StateMachine*               stateMachines;
+    unsigned int                stateMachineCount;
+} LoadedExperiment;
+
+static void destroyLoadedExperiment(LoadedExperiment* experiment)
+{
+    for (int i = 0; i < experiment->ruleCount && experiment->rules != NULL; i++)
+    {
+        destroyBooleanExpression(experiment->rules[i]);
+        destroyCompiledBooleanExpression(experiment->programs[i]);
+    }
+    free(experiment->rules);
+    free(experiment->programs);
+    if (experiment->stateMachines != NULL)
+    {
+        destroyStateMachines(experiment->stateMachines, experiment->stateMachineCount);
+    }
+    destroyExpressionStore(experiment->expressions);
+    for (int i = 0; i < 2; i++)
+    {
+        free(experiment->variables[i]);
+        if (experiment->sensors[i] != NULL)
+        {
+            destroySensors(experiment->sensors[i], experiment->sensorCount);
+        }
+        if (experiment->actuators[i] != NULL)
+        {
+            destroyActuators(experiment->actuators[i], experiment->actuatorCount);
+        }
+    }
+    *experiment = (LoadedExperiment){0};
+}
+
+/* prints one section of an initialization message and parses it again, like both services do */
+static char* printMessageSection(JSON* messageJSON, const char* name)
+{
+    JSON* sectionJSON = JSONGetObjectItem(messageJSON, name);
+    return sectionJSON == NULL ? NULL : JSONPrint(sectionJSON);
+}
+
+/*
+ *  loads the experiment from the experiment data: the Communication Service prints the initialization messages, both
+ *  services parse them, print their sections and parse those again
+ */
+static int loadFromExperimentData(JSON* experimentJSON, LoadedExperiment* experiment)
+{
+    static const char* messageSections[2][3] = {{"Sensors", "Actuators", "ProtectionRules"}, {"Sensors", "Actuators", "Initializers"}};
+    int failed = 0;
+    for (int service = 0; service < 2 && !failed; service++)
+    {
+        JSON* messageJSON = JSONCreateObject();
+        for (int i = 0; i < 3; i++)
+        {
+            JSONAddItemReferenceToObject(messageJSON, messageSections[service][i], JSONGetObjectItem(experimentJSON, messageSections[service][i]));
+        }
+        char* message = JSONPrint(messageJSON);
+        JSONDelete(messageJSON);
+        messageJSON = message == NULL ? NULL : JSONParse(message);
+        free(message);
+        char* sections[3];
+        for (int i = 0; i < 3; i++)
+        {
+            sections[i] = messageJSON == NULL ? NULL : printMessageSection(messageJSON, messageSections[service][i]);
+            failed |= sections[i] == NULL;
+        }
+        JSONDelete(messageJSON);
+        if (!failed)
+        {
+            hashExperimentSections(sections, 3);
+            experiment->sensors[service] = parseSensors(sections[0], strlen(sections[0]), &experiment->sensorCount);
+            experiment->actuators[service] = experiment->sensors[service] == NULL ? NULL :
+                                             parseActuators(sections[1], strlen(sections[1]), &experiment->actuatorCount, experiment->sensorCount);
+            experiment->variables[service] = experiment->actuators[service] == NULL ? NULL :
+                                             createSensorActuatorVariables(experiment->sensors[service], experiment->sensorCount, experiment->actuators[service], experiment->actuatorCount);
+            failed = experiment->variables[service] == NULL;
+        }
+        if (!failed && service == 0)
+        {
+            JSON* rulesJSON = JSONParse(sections[2]);
+            SymbolTable* symbols = createSymbolTable(experiment->variables[0], experiment->sensorCount + experiment->actuatorCount);
+            experiment->ruleCount = JSONGetArraySize(rulesJSON);
+            experiment->rules = calloc(experiment->ruleCount + 1, sizeof(*experiment->rules));
+            experiment->programs = calloc(experiment->ruleCount + 1, sizeof(*experiment->programs));
+            failed = rulesJSON == NULL || symbols == NULL || experiment->rules == NULL || experiment->programs == NULL;
+            for (int i = 0; i < experiment->ruleCount && !failed; i++)
+            {
+                const char* expressionString = JSONGetObjectItem(JSONGetArrayItem(rulesJSON, i), "Expression")->valuestring;
+                BooleanExpressionParseError parseError;
+                experiment->rules[i] = optimizeBooleanExpression(parseBooleanExpressionWithSymbols(expressionString, strlen(expressionString), symbols, &parseError));
+                experiment->programs[i] = compileBooleanExpression(experiment->rules[i]);
+                failed = experiment->programs[i] == NULL;
+            }
+            destroySymbolTable(symbols);
+            JSONDelete(rulesJSON);
+        }
+        if (!failed && service == 1)
+        {
+            experiment->expressions = createExpressionStore();
+            experiment->stateMachines = experiment->expressions == NULL ? NULL :
+                                        parseStateMachines(sections[2], strlen(sections[2]), experiment->variables[1], experiment->sensorCount + experiment->actuatorCount,
+                                                           experiment->expressions, &experiment->stateMachineCount);
+            failed = experiment->stateMachines == NULL;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            free(sections[i]);
+        }
+    }
+    return failed;
+}
+
+/* loads the experiment from the image: the Communication Service checks that it is up to date, both services map it */
+static int loadFromImage(const char* experimentString, const char* imagePath, LoadedExperiment* experiment)
+{
+    ExperimentImage* image = openExperimentImage(imagePath);
+    if (image == NULL || image->header->sourceHash != hashExperimentSections((char* const*)&experimentString, 1))
+    {
+        closeExperimentImage(image);
+        return 1;
+    }
+    closeExperimentImage(image);
+
+    int failed = 0;
+    for (int service = 0; service < 2 && !failed; service++)
+    {
+        image = openExperimentImage(imagePath);
+        experiment->sensors[service] = image == NULL ? NULL : createImageSensors(image, &experiment->sensorCount);
+        experiment->actuators[service] = experiment->sensors[service] == NULL ? NULL : createImageActuators(image, &experiment->actuatorCount);
+        experiment->variables[service] = experiment->actuators[service] == NULL ? NULL :
+                                         createSensorActuatorVariables(experiment->sensors[service], experiment->sensorCount, experiment->actuators[service], experiment->actuatorCount);
+        failed = experiment->variables[service] == NULL;
+        if (!failed && service == 0)
+        {
+            const ImageRule* rules = getImageSection(image, image->header->rules);
+            experiment->ruleCount = image->header->rules.count;
+            experiment->rules = calloc(experiment->ruleCount + 1, sizeof(*experiment->rules));
+            experiment->programs = calloc(experiment->ruleCount + 1, sizeof(*experiment->programs));
+            failed = experiment->rules == NULL || experiment->programs == NULL;
+            for (int i = 0; i < experiment->ruleCount && !failed; i++)
+            {
+                experiment->rules[i] = createImageExpression(image, rules[i].expression, experiment->variables[0], experiment->sensorCount + experiment->actuatorCount);
+                experiment->programs[i] = compileBooleanExpression(experiment->rules[i]);
+                failed = experiment->programs[i] == NULL;
+            }
+        }
+        if (!failed && service == 1)
+        {
+            experiment->expressions = createExpressionStore();
+            experiment->stateMachines = experiment->expressions == NULL ? NULL :
+                                        loadStateMachines(image, experiment->variables[1], experiment->sensorCount + experiment->actuatorCount,
+                                                          experiment->expressions, &experiment->stateMachineCount);
+            failed = experiment->stateMachines == NULL;
+        }
+        closeExperimentImage(image);
+    }
+    return failed;
+}
+
+/* compares two expressions, variables are compared by their name since they belong to different sensors and actuators */
+static int equalExpressions(const BooleanExpression* left, const BooleanExpression* right)
+{
+    if (left == NULL || right == NULL)
+    {
+        return left == right;
+    }
+    if (left->type != right->type || left->operandType != right->operandType || left->resultType != right->resultType || left->valueSize != right->valueSize)
+    {
+        return 0;
+    }
+    if (left->type == BoolExprVARIABLE ? strcmp(left->name, right->name) != 0 :
+        (left->value == NULL) != (right->value == NULL) || (left->value != NULL && memcmp(left->value, right->value, left->valueSize) != 0))
+    {
+        return 0;
+    }
+    return equalExpressions(left->leftside, right->leftside) && equalExpressions(left->rightside, right->rightside);
+}
+
+/* checks that the image contains the same experiment as the experiment data */
+static int equalExperiments(LoadedExperiment* parsed, LoadedExperiment* loaded)
+{
+    if (parsed->sensorCount != loaded->sensorCount || parsed->actuatorCount != loaded->actuatorCount || parsed->ruleCount != loaded->ruleCount ||
+        parsed->stateMachineCount != loaded->stateMachineCount)
+    {
+        return 0;
+    }
+    for (int i = 0; i < parsed->ruleCount; i++)
+    {
+        if (!equalExpressions(parsed->rules[i], loaded->rules[i]))
+        {
+            return 0;
+        }
+    }
+    for (int i = 0; i < parsed->stateMachineCount; i++)
+    {
+        StateMachine* left = &parsed->stateMachines[i];
+        StateMachine* right = &loaded->stateMachines[i];
+        if (strcmp(left->name, right->name) != 0 || left->statesCount != right->statesCount || left->startState - left->states != right->startState - right->states ||
+            left->endState - left->states != right->endState - right->states || getNextStateTableSize(left) != getNextStateTableSize(right) ||
+            (left->nextStateTable != NULL && memcmp(left->nextStateTable, right->nextStateTable, sizeof(*left->nextStateTable) * getNextStateTableSize(left)) != 0))
+        {
+            return 0;
+        }
+        for (int j = 0; j < left->statesCount; j++)
+        {
+            if (!equalExpressions(left->states[j].transitionFunction, right->states[j].transitionFunction) ||
+                left->states[j].outputCount != right->states[j].outputCount)
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int compareDoubles(const void* left, const void* right)
+{
+    double difference = *(const double*)left - *(const double*)right;
+    return (difference > 0) - (difference < 0);
+}
+
+/*
+ *  measures how long the Protection and the Initialization Service need to be ready with the experiment data and
+ *  with the image. The experiment data is parsed once by the Communication Service for the Labserver either way,
+ *  so this is not measured.
+ */
+static int benchmarkImage(char* experimentString, const char* imagePath, unsigned int repetitions)
+{
+    JSON* experimentJSON = JSONParse(experimentString);
+    if (experimentJSON == NULL || writeExperimentImage(experimentString, imagePath))
+    {
+        JSONDelete(experimentJSON);
+        return 1;
+    }
+
+    LoadedExperiment parsed = {0};
+    LoadedExperiment loaded = {0};
+    int failed = loadFromExperimentData(experimentJSON, &parsed) || loadFromImage(experimentString, imagePath, &loaded);
+    if (failed || !equalExperiments(&parsed, &loaded))
+    {
+        log_error("goldi-image: the image does not contain the same experiment as the experiment data");
+        failed = 1;
+    }
+    destroyLoadedExperiment(&parsed);
+    destroyLoadedExperiment(&loaded);
+
+    double jsonTimes[repetitions + 1];
+    double imageTimes[repetitions + 1];
+    for (int i = 0; i < repetitions && !failed; i++)
+    {
+        double start = getNanoseconds();
+        failed |= loadFromExperimentData(experimentJSON, &parsed);
+        jsonTimes[i] = (getNanoseconds() - start) / 1e3;
+        destroyLoadedExperiment(&parsed);
+
+        start = getNanoseconds();
+        failed |= loadFromImage(experimentString, imagePath, &loaded);
+        imageTimes[i] = (getNanoseconds() - start) / 1e3;
+        destroyLoadedExperiment(&loaded);
+    }
+    JSONDelete(experimentJSON);
+    if (failed)
+    {
+        return 1;
+    }
+
+    qsort(jsonTimes, repetitions, sizeof(*jsonTimes), compareDoubles);
+    qsort(imageTimes, repetitions, sizeof(*imageTimes), compareDoubles);
+    printf("loading the experiment in the Protection and Initialization Service (%u repetitions)\n", repetitions);
+    printf("    %-20s min %9.1f us, median %9.1f us, max %9.1f us\n", "experiment data", jsonTimes[0], jsonTimes[repetitions / 2], jsonTimes[repetitions - 1]);
+    printf("    %-20s min %9.1f us, median %9.1f us, max %9.1f us\n", "image", imageTimes[0], imageTimes[repetitions / 2], imageTimes[repetitions - 1]);
+    printf("    the image is loaded %.1fx faster\n", jsonTimes[repetitions / 2] / imageTimes[repetitions / 2]);
+    return 0;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options] <ExperimentData.json>\n", name);
+    printf("    -o, --output <file>         write the image to file instead of ExperimentData.img next to the experiment data\n");
+    printf("    -b, --benchmark             compare loading the experiment data and the image\n");
+    printf("    -n, --repetitions <count>   the amount of loads measured by the benchmark (default: 100)\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"output",      required_argument, NULL, 'o'},
+        {"benchmark",   no_argument,       NULL, 'b'},
+        {"repetitions", required_argument, NULL, 'n'},
+        {"help",        no_argument,       NULL, 'h'},
+        {NULL,          0,                 NULL, 0}
+    };
+
+    const char* outputPath = NULL;
+    int benchmark = 0;
+    int repetitions = 100;
+    int option;
+    while ((option = getopt_long(argc, argv, "o:bn:h", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'o':
+                outputPath = optarg;
+                break;
+
+            case 'b':
+                benchmark = 1;
+                break;
+
+            case 'n':
+                repetitions = atoi(optarg);
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || repetitions <= 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    char* experimentString = readFile(argv[optind], NULL);
+    if (experimentString == NULL)
+    {
+        log_error("goldi-image: %s could not be read", argv[optind]);
+        return 1;
+    }
+    const char* directoryEnd = strrchr(argv[optind], '/');
+    unsigned int directoryLength = directoryEnd == NULL ? 0 : directoryEnd - argv[optind] + 1;
+    char defaultPath[directoryLength + strlen(EXPERIMENT_IMAGE_NAME) + 1];
+    sprintf(defaultPath, "%.*s%s", directoryLength, argv[optind], EXPERIMENT_IMAGE_NAME);
+
+    int result;
+    if (benchmark)
+    {
+        result = benchmarkImage(experimentString, outputPath == NULL ? defaultPath : outputPath, repetitions);
+    }
+    else
+    {
+        result = writeExperimentImage(experimentString, outputPath == NULL ? defaultPath : outputPath);
+    }
+    free(experimentString);
+    return result;
+}
\ No newline at end of file
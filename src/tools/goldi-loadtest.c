@@ -0,0 +1,442 @@
+/*
+ *  goldi-loadtest: measures the latency from an actuator to a sensor through a running Protection Service. It
+ *  connects as the Communication Service, so the whole stack is measured: the IPC sockets, the parsing of the
+ *  actuator data, the control loop, the SPI transfers and the sensor data messages.
+ *
+ *  usage: goldi-loadtest [options] <ExperimentData.img>
+ *      the Protection Service has to run on the software FPGA with a loopback from the pin of the actuator to the
+ *      pin of the sensor, e.g. for the 3-axis portal with the electromagnet y6 (pin 48) and the unused x20:
+ *          GOLDiProtectionService --simulate --simulate-loopback 48:20
+ *          goldi-loadtest -a y6 -x x20 /etc/GOLDiServices/experiments/3AxisPortal/ExperimentData.img
+ *      The actuator is toggled again as soon as the sensor reported its last value. The latency of the toggles
+ *      and the toggles per second are printed.
+ *      With --stops the actuator is set to a value that triggers a protection rule instead, e.g. y0 of the 3-axis
+ *      portal, and the physical system is restarted after every fault. The Protection Service reports the latency
+ *      of the stops, from the trigger of the rule until the stop values have been transferred, with its cycle times
+ *      and in its profile (--profile), which compares the real-time mode (--realtime) with the normal one:
+ *          GOLDiProtectionService --simulate --report-interval 1 [--realtime 80]
+ *          goldi-loadtest --stops --load 4 -a y0 -n 200 /etc/GOLDiServices/experiments/3AxisPortal/ExperimentData.img
+ *      --load starts threads that keep all cores and the memory busy while the test runs.
+ *      --profile prints the durations of the phases of the control loop and of the rules afterwards.
+ */
+
+#include "../interfaces/ipcsockets.h"
+#include "../parsers/json.h"
+#include "../utils/CycleTimer.h"
+#include "../utils/LatencyHistogram.h"
+#include "../logging/log.h"
+#include <getopt.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+/* the time the Protection Service gets to load the experiment in ms */
+#define LOADTEST_INIT_TIMEOUT 10000
+/* the time the fault monitor of the Protection Service gets before the physical system is restarted in us */
+#define LOADTEST_RESTART_DELAY 20000
+/* the memory every load thread writes to in bytes, larger than the caches of the Pi */
+#define LOADTEST_LOAD_MEMORY (4 << 20)
+
+/*
+ *  the parameters of the load test
+ *  actuatorID  -   the actuator which is toggled
+ *  sensorID    -   the sensor connected to the actuator
+ *  toggles     -   the amount of toggles
+ *  timeout     -   the time a toggle may take until the test fails in ms
+ *  stops       -   triggers a protection rule with every toggle instead of waiting for the sensor
+ *  loadThreads -   the amount of threads generating load
+ *  profile     -   prints the profile of the Protection Service at the end
+ */
+typedef struct
+{
+    const char*     actuatorID;
+    const char*     sensorID;
+    unsigned int    toggles;
+    unsigned int    timeout;
+    unsigned int    stops;
+    unsigned int    loadThreads;
+    unsigned int    profile;
+} LoadTestParameters;
+
+/*
+ *  the state received by the message handler
+ *  mutex           -   protects the state
+ *  changed         -   signaled on every change of the state
+ *  initResult      -   the result of the initialization, -1 until it has been received
+ *  sensorValue     -   the last value of the sensor, 0 until it has been received
+ *  sensorMessages  -   the amount of sensor data messages
+ *  faults          -   the amount of fault and error messages
+ *  profiles        -   the amount of profile messages
+ *  profile         -   the last profile message
+ */
+static struct
+{
+    pthread_mutex_t     mutex;
+    pthread_cond_t      changed;
+    int                 initResult;
+    int                 sensorValue;
+    unsigned long long  sensorMessages;
+    int                 faults;
+    int                 profiles;
+    JSON*               profile;
+} received = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, -1, 0, 0, 0, 0, NULL};
+
+static const char* sensorID;
+
+/* updates the value of the sensor if the sensor data message contains it */
+static void receiveSensorData(Message* msg)
+{
+    JSON* msgJSON = JSONParseWithLength(msg->content, msg->length);
+    const JSON* packet = NULL;
+    JSONArrayForEach(packet, JSONGetObjectItem(msgJSON, "SensorData"))
+    {
+        JSON* id = JSONGetObjectItem(packet, "SensorID");
+        JSON* value = JSONGetObjectItem(packet, "SensorValue");
+        if (id != NULL && value != NULL && id->valuestring != NULL && !strcmp(id->valuestring, sensorID))
+        {
+            pthread_mutex_lock(&received.mutex);
+            received.sensorValue = value->valueint;
+            pthread_cond_broadcast(&received.changed);
+            pthread_mutex_unlock(&received.mutex);
+        }
+    }
+    received.sensorMessages++;
+    JSONDelete(msgJSON);
+}
+
+static int messageHandlerIPC(IPCSocketConnection* ipcsc)
+{
+    while (ipcsc->open)
+    {
+        if (waitForMessages(ipcsc, IPC_WAIT_TIMEOUT))
+        {
+            Message msg = receiveMessageIPC(ipcsc);
+            switch (msg.type)
+            {
+                case IPCMSGTYPE_INITPROTECTIONFINISHED:
+                {
+                    pthread_mutex_lock(&received.mutex);
+                    received.initResult = msg.length >= 4 ? deserializeInt((unsigned char*)msg.content) : 0;
+                    pthread_cond_broadcast(&received.changed);
+                    pthread_mutex_unlock(&received.mutex);
+                    break;
+                }
+
+                case IPCMSGTYPE_SENSORDATA:
+                {
+                    receiveSensorData(&msg);
+                    break;
+                }
+
+                case IPCMSGTYPE_DELAYBASEDFAULT:
+                case IPCMSGTYPE_USERBASEDERROR:
+                case IPCMSGTYPE_INFRASTRUCTUREBASEDERROR:
+                {
+                    pthread_mutex_lock(&received.mutex);
+                    received.faults++;
+                    pthread_cond_broadcast(&received.changed);
+                    pthread_mutex_unlock(&received.mutex);
+                    break;
+                }
+
+                case IPCMSGTYPE_PROTECTIONPROFILE:
+                {
+                    pthread_mutex_lock(&received.mutex);
+                    JSONDelete(received.profile);
+                    received.profile = JSONParseWithLength(msg.content, msg.length);
+                    received.profiles++;
+                    pthread_cond_broadcast(&received.changed);
+                    pthread_mutex_unlock(&received.mutex);
+                    break;
+                }
+
+                case IPCMSGTYPE_INTERRUPTED:
+                case IPCMSGTYPE_CLOSEDCONNECTION:
+                {
+                    ipcsc->open = 0;
+                    pthread_mutex_lock(&received.mutex);
+                    pthread_cond_broadcast(&received.changed);
+                    pthread_mutex_unlock(&received.mutex);
+                    free(msg.content);
+                    return 0;
+                }
+
+                default:
+                {
+                    break;
+                }
+            }
+            free(msg.content);
+        }
+    }
+    return 0;
+}
+
+/*
+ *  waits until the given state has the given value
+ *  returns 1 on a timeout or if the connection has been closed
+ */
+static int waitForState(IPCSocketConnection* ipcsc, int* state, int value, unsigned int timeout)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (timeout % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    int result = 0;
+    pthread_mutex_lock(&received.mutex);
+    while (*state != value && result == 0 && ipcsc->open)
+    {
+        result = pthread_cond_timedwait(&received.changed, &received.mutex, &deadline);
+    }
+    int reached = *state == value;
+    pthread_mutex_unlock(&received.mutex);
+    return !reached;
+}
+
+static int sendActuatorValue(IPCSocketConnection* ipcsc, const char* actuatorID, int value)
+{
+    char message[128];
+    int length = snprintf(message, sizeof(message), "[{\"ActuatorID\":\"%s\",\"ActuatorType\":\"binary\",\"ActuatorValue\":%d}]", actuatorID, value);
+    if (length >= sizeof(message))
+    {
+        log_error("goldi-loadtest: the actuator ID is too long");
+        return 1;
+    }
+    return sendMessageIPC(ipcsc, IPCMSGTYPE_ACTUATORDATA, message, length) < 0;
+}
+
+/*
+ *  sets the actuator to 1, which has to trigger a protection rule, waits for the fault message and restarts the
+ *  physical system, the stop values of the Protection Service reset the actuator
+ *  returns 1 if there has been no fault message in time
+ */
+static int triggerStop(IPCSocketConnection* ipcsc, LoadTestParameters* parameters, unsigned int stop)
+{
+    int faults = received.faults;
+    if (sendActuatorValue(ipcsc, parameters->actuatorID, 1))
+    {
+        return 1;
+    }
+    if (waitForState(ipcsc, &received.faults, faults + 1, parameters->timeout))
+    {
+        log_error("goldi-loadtest: %s=1 did not trigger a protection rule within %u ms after %u stops",
+                  parameters->actuatorID, parameters->timeout, stop);
+        return 1;
+    }
+    usleep(LOADTEST_RESTART_DELAY);
+    return sendMessageIPC(ipcsc, IPCMSGTYPE_RUNPHYSICALSYSTEM, "", 0) < 0;
+}
+
+static volatile int loadRunning;
+
+/* keeps a core busy by writing to memory larger than the caches, so the cache misses slow down the other cores */
+static void* generateLoad(void* arg)
+{
+    char* memory = malloc(LOADTEST_LOAD_MEMORY);
+    if (memory == NULL)
+    {
+        return NULL;
+    }
+    for (unsigned char pass = 0; loadRunning; pass++)
+    {
+        memset(memory, pass, LOADTEST_LOAD_MEMORY);
+    }
+    free(memory);
+    return NULL;
+}
+
+/* prints the percentiles of one group of the profile in us */
+static void printProfileGroup(const JSON* group)
+{
+    const JSON* histogram = NULL;
+    JSONArrayForEach(histogram, group)
+    {
+        printf("  %-40s %8d times, mean %8.1f, p50 %8.1f, p99 %8.1f, p99.9 %8.1f, max %8.1f\n",
+               JSONGetObjectItem(histogram, "Name")->valuestring, JSONGetObjectItem(histogram, "Count")->valueint,
+               JSONGetObjectItem(histogram, "Mean")->valuedouble, JSONGetObjectItem(histogram, "P50")->valuedouble,
+               JSONGetObjectItem(histogram, "P99")->valuedouble, JSONGetObjectItem(histogram, "P99.9")->valuedouble,
+               JSONGetObjectItem(histogram, "Max")->valuedouble);
+    }
+}
+
+/* requests the profile of the Protection Service and prints it, returns 1 if there has been no answer */
+static int printProfile(IPCSocketConnection* ipcsc, unsigned int timeout)
+{
+    int profiles = received.profiles;
+    sendMessageIPC(ipcsc, IPCMSGTYPE_PROTECTIONPROFILE, "", 0);
+    if (waitForState(ipcsc, &received.profiles, profiles + 1, timeout) || received.profile == NULL)
+    {
+        log_error("goldi-loadtest: the Protection Service did not send its profile");
+        return 1;
+    }
+    printf("profile in us:\n");
+    printProfileGroup(JSONGetObjectItem(received.profile, "Phases"));
+    printProfileGroup(JSONGetObjectItem(received.profile, "Stops"));
+    printProfileGroup(JSONGetObjectItem(received.profile, "Rules"));
+    return 0;
+}
+
+/* toggles the actuator and measures the time until the sensor follows */
+static int runLoadTest(IPCSocketConnection* ipcsc, const char* imagePath, LoadTestParameters* parameters)
+{
+    sendMessageIPC(ipcsc, IPCMSGTYPE_INITPROTECTIONSERVICEIMAGE, (char*)imagePath, strlen(imagePath));
+    if (waitForState(ipcsc, &received.initResult, 1, LOADTEST_INIT_TIMEOUT))
+    {
+        log_error("goldi-loadtest: the Protection Service could not load %s", imagePath);
+        return 1;
+    }
+    sendMessageIPC(ipcsc, IPCMSGTYPE_RUNPHYSICALSYSTEM, "", 0);
+
+    LatencyHistogram* latencies = malloc(sizeof(*latencies));
+    pthread_t* loadThreads = calloc(parameters->loadThreads + 1, sizeof(*loadThreads));
+    if (latencies == NULL || loadThreads == NULL)
+    {
+        log_error("goldi-loadtest: malloc error %s", strerror(errno));
+        free(latencies);
+        free(loadThreads);
+        return 1;
+    }
+    loadRunning = 1;
+    unsigned int startedThreads = 0;
+    while (startedThreads < parameters->loadThreads && !pthread_create(&loadThreads[startedThreads], NULL, &generateLoad, NULL))
+    {
+        startedThreads++;
+    }
+
+    resetLatencyHistogram(latencies);
+    int value = received.sensorValue;
+    int error = 0;
+    unsigned long long start = getMonotonicTime();
+    for (unsigned int toggle = 0; toggle < parameters->toggles && !error; toggle++)
+    {
+        value = !value;
+        unsigned long long sent = getMonotonicTime();
+        if (parameters->stops)
+        {
+            error = triggerStop(ipcsc, parameters, toggle);
+        }
+        else
+        {
+            error = sendActuatorValue(ipcsc, parameters->actuatorID, value);
+            if (!error && waitForState(ipcsc, &received.sensorValue, value, parameters->timeout))
+            {
+                log_error("goldi-loadtest: %s did not follow %s within %u ms after %u toggles, is the loopback set?",
+                          parameters->sensorID, parameters->actuatorID, parameters->timeout, toggle);
+                error = 1;
+            }
+        }
+        recordLatency(latencies, getMonotonicTime() - sent);
+    }
+    double seconds = (getMonotonicTime() - start) / 1e9;
+    sendMessageIPC(ipcsc, IPCMSGTYPE_STOPPHYSICALSYSTEM, "", 0);
+    loadRunning = 0;
+    for (unsigned int i = 0; i < startedThreads; i++)
+    {
+        pthread_join(loadThreads[i], NULL);
+    }
+    free(loadThreads);
+
+    printf("loadtest: %llu %s of %s in %.2f s, %.1f per second, %llu sensor data messages, %u load threads\n",
+           latencies->count, parameters->stops ? "stops" : "toggles", parameters->actuatorID, seconds,
+           latencies->count / seconds, received.sensorMessages, startedThreads);
+    printf("latency:  p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+           getLatencyPercentile(latencies, 50) / 1e3, getLatencyPercentile(latencies, 90) / 1e3,
+           getLatencyPercentile(latencies, 99) / 1e3, getLatencyPercentile(latencies, 99.9) / 1e3, latencies->max / 1e3);
+    free(latencies);
+    if (parameters->profile && printProfile(ipcsc, parameters->timeout))
+    {
+        error = 1;
+    }
+    return error;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options] <ExperimentData.img>\n", name);
+    printf("    -a, --actuator <id>         the actuator which is toggled (default y6)\n");
+    printf("    -x, --sensor <id>           the sensor connected to the actuator (default x20)\n");
+    printf("    -n, --toggles <n>           the amount of toggles (default 1000)\n");
+    printf("    -T, --timeout <ms>          the time a toggle may take (default 1000)\n");
+    printf("    -S, --stops                 trigger a protection rule with every toggle and restart the physical system\n");
+    printf("    -L, --load <threads>        threads keeping the cores and the memory busy during the test (default 0)\n");
+    printf("    -p, --profile               print the durations of the phases and rules of the Protection Service\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"actuator",    required_argument,  NULL, 'a'},
+        {"sensor",      required_argument,  NULL, 'x'},
+        {"toggles",     required_argument,  NULL, 'n'},
+        {"timeout",     required_argument,  NULL, 'T'},
+        {"stops",       no_argument,        NULL, 'S'},
+        {"load",        required_argument,  NULL, 'L'},
+        {"profile",     no_argument,        NULL, 'p'},
+        {"help",        no_argument,        NULL, 'h'},
+        {NULL,          0,                  NULL, 0}
+    };
+
+    LoadTestParameters parameters = {"y6", "x20", 1000, 1000, 0, 0, 0};
+    int option;
+    while ((option = getopt_long(argc, argv, "a:x:n:T:SL:ph", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'a':
+                parameters.actuatorID = optarg;
+                break;
+
+            case 'x':
+                parameters.sensorID = optarg;
+                break;
+
+            case 'n':
+                parameters.toggles = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'T':
+                parameters.timeout = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'S':
+                parameters.stops = 1;
+                break;
+
+            case 'L':
+                parameters.loadThreads = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'p':
+                parameters.profile = 1;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || parameters.toggles == 0 || parameters.timeout == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    sensorID = parameters.sensorID;
+
+    IPCSocketConnection* protectionService = connectToIPCSocket(PROTECTION_SERVICE, messageHandlerIPC);
+    if (protectionService == NULL)
+    {
+        log_error("goldi-loadtest: the Protection Service is not running");
+        return 1;
+    }
+    int result = runLoadTest(protectionService, argv[optind], &parameters);
+    closeIPCConnection(protectionService);
+    JSONDelete(received.profile);
+    return result;
+}
\ No newline at end of file
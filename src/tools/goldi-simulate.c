@@ -0,0 +1,508 @@
+/*
+ *  goldi-simulate: runs the initializers of an ExperimentData.json against a plant model instead of the
+ *  physical system, at the speed of the state machine engine instead of real time
+ *
+ *  usage: goldi-simulate [options] <ExperimentData.json>
+ *
+ *  Every initializer is simulated separately, once from the start positions of the model and once more per
+ *  additional run from random positions. The time to the end state, the time spent in every state, the states
+ *  never entered and every run that did not reach the end state are printed:
+ *      no active state -   the transition functions deactivated every state
+ *      livelock        -   the states kept changing without any change of the sensors
+ *      stuck           -   the plant stopped moving before the end state was reached
+ *      timeout         -   the end state was not reached within the time limit while the plant kept moving
+ */
+
+#include "../parsers/StateMachine.h"
+#include "../parsers/json.h"
+#include "../interfaces/SensorsActuators.h"
+#include "../interfaces/PlantModel.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+
+/* the amount of failed runs printed per initializer */
+#define SIMULATION_PRINTED_FAILURES 10
+
+typedef enum
+{
+    RunRunning,
+    RunReachedEnd,
+    RunNoActiveState,
+    RunEvaluationError,
+    RunLivelock,
+    RunStuck,
+    RunTimeout
+} RunResult;
+
+static const char* runResultNames[] = {"running", "reached the end state", "no active state", "evaluation error", "livelock", "stuck", "timeout"};
+
+/*
+ *  the options of a simulation
+ *  runs        -   the amount of runs per initializer, all but the first one start from random positions
+ *  step        -   the time between two steps of the plant model in seconds
+ *  timeout     -   the simulated time after which a run is aborted in seconds
+ *  seed        -   the seed of the random start positions
+ */
+typedef struct
+{
+    unsigned int    runs;
+    double          step;
+    double          timeout;
+    unsigned int    seed;
+} SimulationParameters;
+
+/*
+ *  everything a run needs
+ *  sensors         -   the sensors written by the plant model
+ *  actuators       -   the actuators written by the state machine and read by the plant model
+ *  model           -   the plant model
+ *  parameters      -   the options of the simulation
+ *  timerOverhead   -   the time measured for an empty interval, subtracted from every timed update
+ */
+typedef struct
+{
+    Sensor*                 sensors;
+    unsigned int            sensorCount;
+    Actuator*               actuators;
+    unsigned int            actuatorCount;
+    PlantModel*             model;
+    SimulationParameters    parameters;
+    double                  timerOverhead;
+} Simulation;
+
+/*
+ *  the results of all runs of one initializer
+ *  reached         -   the amount of runs that reached the end state
+ *  minimumTime     -   the shortest time to the end state
+ *  maximumTime     -   the longest time to the end state
+ *  totalTime       -   the sum of the times to the end state
+ *  dwellTimes      -   the time spent in every state summed over all runs
+ *  entries         -   how often every state was entered over all runs
+ *  failures        -   the amount of runs that did not reach the end state
+ *  updates         -   the amount of calls of updateStateMachine
+ *  updateTime      -   the time spent inside of updateStateMachine in nanoseconds
+ *  simulatedTime   -   the simulated time of all runs in seconds
+ */
+typedef struct
+{
+    unsigned int        reached;
+    double              minimumTime;
+    double              maximumTime;
+    double              totalTime;
+    double*             dwellTimes;
+    unsigned int*       entries;
+    unsigned int        failures;
+    unsigned long long  updates;
+    double              updateTime;
+    double              simulatedTime;
+} InitializerStatistics;
+
+/* the lowest time measured between two consecutive calls of getNanoseconds */
+static double measureTimerOverhead(void)
+{
+    double overhead = 1e9;
+    for (int i = 0; i < 1000; i++)
+    {
+        double start = getNanoseconds();
+        double time = getNanoseconds() - start;
+        overhead = time < overhead ? time : overhead;
+    }
+    return overhead;
+}
+
+/* sets the actuators to their stop values overwritten by the outputs of the state, returns 1 if any actuator changed */
+static unsigned int applyOutputs(Simulation* simulation, StateMachineState* state)
+{
+    unsigned int changed = 0;
+    for (int i = 0; i < simulation->actuatorCount; i++)
+    {
+        Actuator* actuator = &simulation->actuators[i];
+        const char* value = actuator->stopValue;
+        for (int k = 0; k < state->outputCount; k++)
+        {
+            if (state->outputs[k].actuatorIndex == i)
+            {
+                value = state->outputs[k].value;
+            }
+        }
+        unsigned int size = getValueSizeOfActuatorType(actuator->type);
+        changed |= memcmp(actuator->value, value, size) != 0;
+        memcpy(actuator->value, value, size);
+    }
+    return changed;
+}
+
+/*
+ *  updates the state machine until neither the states nor the actuators change anymore or the end state is
+ *  reached, as the Initialization Service does after new sensor data arrived
+ */
+static RunResult settleStateMachine(Simulation* simulation, StateMachine* stateMachine, InitializerStatistics* statistics)
+{
+    for (unsigned int iteration = 0; ; iteration++)
+    {
+        if (iteration > stateMachine->statesCount + 1)
+        {
+            return RunLivelock;
+        }
+        double start = getNanoseconds();
+        int result = updateStateMachine(stateMachine);
+        statistics->updateTime += getNanoseconds() - start - simulation->timerOverhead;
+        statistics->updates++;
+        if (!result)
+        {
+            return RunEvaluationError;
+        }
+
+        unsigned int activeStates = 0;
+        for (int i = 0; i < stateMachine->statesCount; i++)
+        {
+            activeStates += stateMachine->states[i].isActive != 0;
+        }
+        if (activeStates == 0)
+        {
+            return RunNoActiveState;
+        }
+        /* the execution ends with the end state, its transition function does not have to keep it active */
+        unsigned int outputsChanged = applyOutputs(simulation, stateMachine->activeState);
+        if (stateMachine->activeState == stateMachine->endState || (!outputsChanged && stateMachine->changedStates == 0))
+        {
+            return RunRunning;
+        }
+    }
+}
+
+/*
+ *  simulates one initialization from the current positions of the plant
+ *  time    -   the simulated time when the run ended
+ */
+static RunResult simulateRun(Simulation* simulation, StateMachine* stateMachine, InitializerStatistics* statistics, double* time)
+{
+    resetStateMachine(stateMachine);
+    applyOutputs(simulation, stateMachine->activeState);
+    statistics->entries[stateMachine->activeState - stateMachine->states]++;
+    *time = 0;
+
+    RunResult result = settleStateMachine(simulation, stateMachine, statistics);
+    StateMachineState* state = stateMachine->activeState;
+    while (result == RunRunning)
+    {
+        if (stateMachine->activeState != state)
+        {
+            state = stateMachine->activeState;
+            statistics->entries[state - stateMachine->states]++;
+        }
+        if (state == stateMachine->endState)
+        {
+            return RunReachedEnd;
+        }
+        if (*time >= simulation->parameters.timeout)
+        {
+            return RunTimeout;
+        }
+
+        /* the state machine only gets new inputs if a sensor changed */
+        unsigned int changed = stepPlantModel(simulation->model, simulation->parameters.step);
+        statistics->dwellTimes[state - stateMachine->states] += simulation->parameters.step;
+        *time += simulation->parameters.step;
+        if (changed)
+        {
+            result = settleStateMachine(simulation, stateMachine, statistics);
+        }
+        else if (simulation->model->movingAxes == 0)
+        {
+            result = RunStuck;
+        }
+    }
+    return result;
+}
+
+/* moves every axis of the plant to its start position for the first run and to a random position otherwise */
+static void placePlant(PlantModel* model, unsigned int run)
+{
+    resetPlantModel(model);
+    for (int i = 0; i < model->axisCount && run > 0; i++)
+    {
+        setPlantAxisPosition(model, i, model->axes[i].length * rand() / RAND_MAX);
+    }
+}
+
+/* writes where the axes of the plant are into the buffer */
+static void formatPlantPositions(PlantModel* model, char* buffer, unsigned int size)
+{
+    unsigned int length = 0;
+    buffer[0] = 0;
+    for (int i = 0; i < model->axisCount && length < size; i++)
+    {
+        length += snprintf(buffer + length, size - length, "%s%s=%.1f", i > 0 ? ", " : "", model->axes[i].name, model->axes[i].position);
+    }
+}
+
+/* runs an initializer from all start positions and prints its statistics, returns 1 if any run failed */
+static int simulateInitializer(Simulation* simulation, StateMachine* stateMachine)
+{
+    InitializerStatistics statistics = {0, 0, 0, 0, NULL, NULL, 0, 0, 0, 0};
+    statistics.dwellTimes = calloc(stateMachine->statesCount, sizeof(*statistics.dwellTimes));
+    statistics.entries = calloc(stateMachine->statesCount, sizeof(*statistics.entries));
+    if (statistics.dwellTimes == NULL || statistics.entries == NULL)
+    {
+        log_error("goldi-simulate: malloc error %s", strerror(errno));
+        free(statistics.dwellTimes);
+        free(statistics.entries);
+        return 1;
+    }
+    printf("%s: %u states, end state %s, next state table with %u entries\n", stateMachine->name, stateMachine->statesCount,
+           stateMachine->endState->name, getNextStateTableSize(stateMachine));
+
+    unsigned long long tableFallbacks = stateMachine->tableFallbacks;
+    double start = getNanoseconds();
+    for (unsigned int run = 0; run < simulation->parameters.runs; run++)
+    {
+        placePlant(simulation->model, run);
+        char startPositions[256];
+        formatPlantPositions(simulation->model, startPositions, sizeof(startPositions));
+
+        double time;
+        RunResult result = simulateRun(simulation, stateMachine, &statistics, &time);
+        statistics.simulatedTime += time;
+        if (result == RunReachedEnd)
+        {
+            statistics.minimumTime = statistics.reached == 0 || time < statistics.minimumTime ? time : statistics.minimumTime;
+            statistics.maximumTime = time > statistics.maximumTime ? time : statistics.maximumTime;
+            statistics.totalTime += time;
+            statistics.reached++;
+            continue;
+        }
+        if (statistics.failures++ < SIMULATION_PRINTED_FAILURES)
+        {
+            char endPositions[256];
+            formatPlantPositions(simulation->model, endPositions, sizeof(endPositions));
+            printf("    run %-4u %-18s after %s at %.3f s, started at %s, ended at %s\n", run, runResultNames[result],
+                   stateMachine->activeState->name, time, startPositions, endPositions);
+        }
+    }
+    double wallTime = getNanoseconds() - start;
+    if (statistics.failures > SIMULATION_PRINTED_FAILURES)
+    {
+        printf("    ... and %u more failed runs\n", statistics.failures - SIMULATION_PRINTED_FAILURES);
+    }
+
+    printf("    %-24s %u of %u runs\n", "reached the end state", statistics.reached, simulation->parameters.runs);
+    if (statistics.reached > 0)
+    {
+        printf("    %-24s min %.3f s, avg %.3f s, max %.3f s\n", "time to end state", statistics.minimumTime,
+               statistics.totalTime / statistics.reached, statistics.maximumTime);
+    }
+    unsigned int unreachable = 0;
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        printf("    state %-18s avg %.3f s per run, entered %u times\n", stateMachine->states[i].name,
+               statistics.dwellTimes[i] / simulation->parameters.runs, statistics.entries[i]);
+        unreachable += statistics.entries[i] == 0;
+    }
+    printf("    %-24s", "unreachable states");
+    for (int i = 0; i < stateMachine->statesCount; i++)
+    {
+        if (statistics.entries[i] == 0)
+        {
+            printf(" %s", stateMachine->states[i].name);
+        }
+    }
+    printf("%s\n", unreachable == 0 ? " none" : "");
+    if (stateMachine->nextStateTable != NULL)
+    {
+        tableFallbacks = stateMachine->tableFallbacks - tableFallbacks;
+        printf("    %-24s %llu of %llu updates, the transition functions decided the others\n", "decided by the table",
+               statistics.updates - tableFallbacks, statistics.updates);
+    }
+    printf("    %-24s %llu updates, %.1f ns per update, %.1f s simulated in %.1f ms (%.0fx real time)\n", "engine", statistics.updates,
+           statistics.updates > 0 ? statistics.updateTime / statistics.updates : 0, statistics.simulatedTime, wallTime / 1e6,
+           wallTime > 0 ? statistics.simulatedTime * 1e9 / wallTime : 0);
+
+    free(statistics.dwellTimes);
+    free(statistics.entries);
+    return statistics.failures > 0;
+}
+
+/* returns 1 if the initializer was selected on the command line or nothing was selected */
+static int isSelected(const char* name, char** selected, unsigned int selectedCount)
+{
+    for (int i = 0; i < selectedCount; i++)
+    {
+        if (!strcmp(name, selected[i]))
+        {
+            return 1;
+        }
+    }
+    return selectedCount == 0;
+}
+
+/* the plant model next to the experiment, used if none is given */
+static char* getDefaultModelPath(const char* experimentPath)
+{
+    const char* separator = strrchr(experimentPath, '/');
+    unsigned int directoryLength = separator == NULL ? 0 : separator - experimentPath + 1;
+    char* path = malloc(directoryLength + sizeof("PlantModel.json"));
+    if (path == NULL)
+    {
+        log_error("goldi-simulate: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    memcpy(path, experimentPath, directoryLength);
+    strcpy(path + directoryLength, "PlantModel.json");
+    return path;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options] <ExperimentData.json>\n", name);
+    printf("    -m, --model <file>          the plant model (default: PlantModel.json next to the experiment)\n");
+    printf("    -i, --initializer <name>    only simulate the given initializer, may be repeated\n");
+    printf("    -r, --runs <n>              runs per initializer, all but the first from random positions (default 1)\n");
+    printf("    -t, --step <ms>             the time step of the plant model (default 1)\n");
+    printf("    -T, --timeout <s>           the simulated time after which a run is aborted (default 300)\n");
+    printf("    -S, --seed <n>              the seed of the random start positions (default 1)\n");
+    printf("    -h, --help                  print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"model",       required_argument,  NULL, 'm'},
+        {"initializer", required_argument,  NULL, 'i'},
+        {"runs",        required_argument,  NULL, 'r'},
+        {"step",        required_argument,  NULL, 't'},
+        {"timeout",     required_argument,  NULL, 'T'},
+        {"seed",        required_argument,  NULL, 'S'},
+        {"help",        no_argument,        NULL, 'h'},
+        {NULL,          0,                  NULL, 0}
+    };
+
+    SimulationParameters parameters = {1, 0.001, 300, 1};
+    const char* modelPath = NULL;
+    char* selected[argc];
+    unsigned int selectedCount = 0;
+    int option;
+    while ((option = getopt_long(argc, argv, "m:i:r:t:T:S:h", options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'm':
+                modelPath = optarg;
+                break;
+
+            case 'i':
+                selected[selectedCount++] = optarg;
+                break;
+
+            case 'r':
+                parameters.runs = strtoul(optarg, NULL, 10);
+                break;
+
+            case 't':
+                parameters.step = strtod(optarg, NULL) / 1000;
+                break;
+
+            case 'T':
+                parameters.timeout = strtod(optarg, NULL);
+                break;
+
+            case 'S':
+                parameters.seed = strtoul(optarg, NULL, 10);
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || parameters.runs == 0 || parameters.step <= 0 || parameters.timeout <= 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    srand(parameters.seed);
+
+    char* experimentString = readFile(argv[optind], NULL);
+    if (experimentString == NULL)
+    {
+        log_error("goldi-simulate: %s could not be read", argv[optind]);
+        return 1;
+    }
+    JSON* experimentJSON = JSONParse(experimentString);
+    free(experimentString);
+    if (experimentJSON == NULL)
+    {
+        log_error("goldi-simulate: %s does not contain valid json", argv[optind]);
+        return 1;
+    }
+
+    char* sensorsString = JSONPrint(JSONGetObjectItem(experimentJSON, "Sensors"));
+    char* actuatorsString = JSONPrint(JSONGetObjectItem(experimentJSON, "Actuators"));
+    char* initializersString = JSONPrint(JSONGetObjectItem(experimentJSON, "Initializers"));
+    JSONDelete(experimentJSON);
+    Simulation simulation = {NULL, 0, NULL, 0, NULL, parameters, measureTimerOverhead()};
+    simulation.sensors = sensorsString == NULL ? NULL : parseSensors(sensorsString, strlen(sensorsString), &simulation.sensorCount);
+    simulation.actuators = actuatorsString == NULL ? NULL : parseActuators(actuatorsString, strlen(actuatorsString), &simulation.actuatorCount, simulation.sensorCount);
+    free(sensorsString);
+    free(actuatorsString);
+    if (simulation.sensors == NULL || simulation.actuators == NULL || initializersString == NULL)
+    {
+        log_error("goldi-simulate: sensors, actuators and initializers could not be parsed");
+        free(initializersString);
+        return 1;
+    }
+
+    char* defaultModelPath = modelPath == NULL ? getDefaultModelPath(argv[optind]) : NULL;
+    char* modelString = readFile(modelPath != NULL ? (char*)modelPath : defaultModelPath, NULL);
+    if (modelString == NULL)
+    {
+        log_error("goldi-simulate: the plant model %s could not be read", modelPath != NULL ? modelPath : defaultModelPath);
+    }
+    else
+    {
+        simulation.model = parsePlantModel(modelString, strlen(modelString), simulation.sensors, simulation.sensorCount, simulation.actuators, simulation.actuatorCount);
+    }
+    free(modelString);
+    free(defaultModelPath);
+
+    Variable* variables = createSensorActuatorVariables(simulation.sensors, simulation.sensorCount, simulation.actuators, simulation.actuatorCount);
+    ExpressionStore* expressions = createExpressionStore();
+    unsigned int stateMachineCount = 0;
+    StateMachine* stateMachines = NULL;
+    if (simulation.model != NULL && variables != NULL && expressions != NULL)
+    {
+        stateMachines = parseStateMachines(initializersString, strlen(initializersString), variables, simulation.sensorCount + simulation.actuatorCount,
+                                           expressions, &stateMachineCount);
+    }
+    free(initializersString);
+
+    int result = 1;
+    if (stateMachines != NULL && !prepareStateMachineOutputs(stateMachines, stateMachineCount, simulation.actuators, simulation.actuatorCount))
+    {
+        result = 0;
+        for (int i = 0; i < stateMachineCount; i++)
+        {
+            if (isSelected(stateMachines[i].name, selected, selectedCount))
+            {
+                result |= simulateInitializer(&simulation, &stateMachines[i]);
+            }
+        }
+        if (simulation.model->opposingDrives > 0)
+        {
+            printf("both drives of an axis were set in %llu steps\n", simulation.model->opposingDrives);
+        }
+    }
+
+    if (stateMachines != NULL)
+    {
+        destroyStateMachines(stateMachines, stateMachineCount);
+    }
+    destroyExpressionStore(expressions);
+    destroyPlantModel(simulation.model);
+    free(variables);
+    destroySensors(simulation.sensors, simulation.sensorCount);
+    destroyActuators(simulation.actuators, simulation.actuatorCount);
+    return result;
+}
\ No newline at end of file
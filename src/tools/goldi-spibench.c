@@ -0,0 +1,323 @@
+/*
+ *  goldi-spibench: compares the SPI transfers of the Protection Service, one transfer per command against one
+ *  frame per cycle, on the software FPGA so it runs on any machine
+ *
+ *  usage: goldi-spibench [options]
+ *      every cycle reads all binary sensors and writes the actuators like the control loop does. The
+ *      per-command mode writes every actuator every cycle, the frame mode writes only the changed ones. The
+ *      latencies of the software FPGA model the bcm2835 at 3.9 MHz by default. For both modes the time, the
+ *      transfers and bytes per cycle and the amount of wrong values read or written are printed.
+ */
+
+#include "../interfaces/spi.h"
+#include "../interfaces/SoftwareFPGA.h"
+#include "../interfaces/ProcessImage.h"
+#include "../utils/utils.h"
+#include "../logging/log.h"
+#include <getopt.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the amount of different random sensor and actuator values the cycles go through */
+#define SPIBENCH_INPUTS 256
+
+/*
+ *  the parameters of the benchmark
+ *  sensorCount     -   the amount of binary sensors, on the pins 0 to sensorCount - 1
+ *  actuatorCount   -   the amount of binary actuators, on the pins 0 to actuatorCount - 1
+ *  changes         -   the chance of every sensor and actuator to change per cycle in percent
+ *  cycles          -   the amount of cycles every mode is timed with
+ *  transferLatency -   the time every transfer takes in ns
+ *  byteLatency     -   the time every byte takes in ns
+ *  seed            -   the seed of the random generator
+ */
+typedef struct
+{
+    unsigned int        sensorCount;
+    unsigned int        actuatorCount;
+    unsigned int        changes;
+    unsigned int        cycles;
+    unsigned long long  transferLatency;
+    unsigned long long  byteLatency;
+    unsigned int        seed;
+} SPIBenchParameters;
+
+/*
+ *  the simulated sensors and actuators
+ *  sensors         -   the sensors
+ *  actuators       -   the actuators
+ *  values          -   the storage of the values of all sensors and actuators
+ *  sensorInputs    -   SPIBENCH_INPUTS consecutive values of the sensor pins
+ *  actuatorInputs  -   SPIBENCH_INPUTS consecutive values of the actuators
+ */
+typedef struct
+{
+    Sensor*     sensors;
+    Actuator*   actuators;
+    char*       values;
+    char*       sensorInputs;
+    char*       actuatorInputs;
+} SPIBench;
+
+/* fills the inputs with a random walk, every value changes with the given chance from one input to the next */
+static void generateInputs(char* inputs, unsigned int count, unsigned int changes)
+{
+    for (int input = 0; input < SPIBENCH_INPUTS; input++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            char previous = input > 0 ? inputs[(input - 1) * count + i] : rand() & 1;
+            inputs[input * count + i] = rand() % 100 < changes ? !previous : previous;
+        }
+    }
+}
+
+static int createSPIBench(SPIBench* bench, SPIBenchParameters* parameters)
+{
+    bench->sensors = calloc(parameters->sensorCount + 1, sizeof(*bench->sensors));
+    bench->actuators = calloc(parameters->actuatorCount + 1, sizeof(*bench->actuators));
+    bench->values = calloc(parameters->sensorCount + parameters->actuatorCount + 1, 1);
+    bench->sensorInputs = malloc((size_t)SPIBENCH_INPUTS * parameters->sensorCount + 1);
+    bench->actuatorInputs = malloc((size_t)SPIBENCH_INPUTS * parameters->actuatorCount + 1);
+    if (bench->sensors == NULL || bench->actuators == NULL || bench->values == NULL || bench->sensorInputs == NULL || bench->actuatorInputs == NULL)
+    {
+        log_error("goldi-spibench: malloc error %s", strerror(errno));
+        return 1;
+    }
+    for (int i = 0; i < parameters->sensorCount; i++)
+    {
+        bench->sensors[i] = (Sensor){NULL, SensorTypeBinary, bench->values + i, i, 0};
+    }
+    for (int i = 0; i < parameters->actuatorCount; i++)
+    {
+        bench->actuators[i] = (Actuator){NULL, ActuatorTypeBinary, bench->values + parameters->sensorCount + i, i, NULL};
+    }
+    generateInputs(bench->sensorInputs, parameters->sensorCount, parameters->changes);
+    generateInputs(bench->actuatorInputs, parameters->actuatorCount, parameters->changes);
+    return 0;
+}
+
+static void destroySPIBench(SPIBench* bench)
+{
+    free(bench->sensors);
+    free(bench->actuators);
+    free(bench->values);
+    free(bench->sensorInputs);
+    free(bench->actuatorInputs);
+}
+
+/* sets the sensor pins of the software FPGA and the values of the actuators to the ones of the given cycle */
+static void applyInputs(SPIBench* bench, SPIBenchParameters* parameters, unsigned int cycle)
+{
+    unsigned int input = cycle % SPIBENCH_INPUTS;
+    memcpy(softwareFPGA.inputs, bench->sensorInputs + input * parameters->sensorCount, parameters->sensorCount);
+    for (int i = 0; i < parameters->actuatorCount; i++)
+    {
+        bench->actuators[i].value[0] = bench->actuatorInputs[input * parameters->actuatorCount + i];
+    }
+}
+
+/* returns the amount of sensors whose value differs from their pin */
+static unsigned int countWrongSensors(SPIBench* bench, SPIBenchParameters* parameters)
+{
+    unsigned int wrong = 0;
+    for (int i = 0; i < parameters->sensorCount; i++)
+    {
+        wrong += bench->sensors[i].value[0] != softwareFPGA.inputs[i];
+    }
+    return wrong;
+}
+
+/* returns the amount of actuator pins which differ from the value of their actuator */
+static unsigned int countWrongActuators(SPIBench* bench, SPIBenchParameters* parameters)
+{
+    unsigned int wrong = 0;
+    for (int i = 0; i < parameters->actuatorCount; i++)
+    {
+        wrong += bench->actuators[i].value[0] != softwareFPGA.outputs[i];
+    }
+    return wrong;
+}
+
+/* prints the time and the transfers of one mode */
+static void printResult(const char* name, double time, SPIBenchParameters* parameters, unsigned long long wrongValues)
+{
+    printf("%-12s %9.2f us per cycle, %7.1f transfers, %7.1f bytes, %7.1f commands per cycle, %llu wrong values\n",
+           name, time / parameters->cycles / 1e3, (double)softwareFPGA.transfers / parameters->cycles,
+           (double)softwareFPGA.bytes / parameters->cycles, (double)softwareFPGA.commands / parameters->cycles, wrongValues);
+}
+
+/* one transfer per sensor read and actuator write, as the control loop did before the frames */
+static double benchmarkPerCommand(SPIBench* bench, SPIBenchParameters* parameters, pthread_mutex_t* mutex)
+{
+    unsigned long long wrongValues = 0;
+    resetSoftwareFPGA();
+    double start = getNanoseconds();
+    for (unsigned int cycle = 0; cycle < parameters->cycles; cycle++)
+    {
+        applyInputs(bench, parameters, cycle);
+        for (int i = 0; i < parameters->sensorCount; i++)
+        {
+            SPIReadSensor(&bench->sensors[i], mutex);
+        }
+        for (int i = 0; i < parameters->actuatorCount; i++)
+        {
+            SPIWriteActuator(&bench->actuators[i], mutex);
+        }
+        wrongValues += countWrongSensors(bench, parameters) + countWrongActuators(bench, parameters);
+    }
+    double time = getNanoseconds() - start;
+    printResult("per-command", time, parameters, wrongValues);
+    return time;
+}
+
+/*
+ *  one frame per cycle, the actuators that changed in a cycle are written with the reads of the next one like
+ *  the control loop does with --bulk-spi
+ */
+static double benchmarkFrame(SPIBench* bench, SPIBenchParameters* parameters, pthread_mutex_t* mutex)
+{
+    ProcessImage* image = createProcessImage(bench->sensors, parameters->sensorCount, bench->actuators, parameters->actuatorCount);
+    SPIFrame* frame = createSPIFrame(bench->sensors, parameters->sensorCount, bench->actuators, parameters->actuatorCount);
+    if (image == NULL || frame == NULL)
+    {
+        destroySPIFrame(frame);
+        destroyProcessImage(image, bench->sensors, bench->actuators);
+        return -1;
+    }
+
+    /* the first frame writes every actuator, as they are unknown to the FPGA so far */
+    for (int i = 0; i < parameters->actuatorCount; i++)
+    {
+        stageSPIFrameWrite(frame, &bench->actuators[i]);
+    }
+    unsigned long long wrongValues = 0;
+    resetSoftwareFPGA();
+    double start = getNanoseconds();
+    for (unsigned int cycle = 0; cycle < parameters->cycles; cycle++)
+    {
+        applyInputs(bench, parameters, cycle);
+        transferSPIFrame(frame, mutex);
+        wrongValues += countWrongSensors(bench, parameters);
+        commitSensorChanges(image);
+        commitActuatorChanges(image);
+        for (int i = 0; i < image->changedActuatorCount; i++)
+        {
+            stageSPIFrameWrite(frame, &bench->actuators[image->changedActuators[i]]);
+        }
+    }
+    /* the writes of the last cycle are sent with the next frame */
+    transferSPIFrame(frame, mutex);
+    double time = getNanoseconds() - start;
+    wrongValues += countWrongActuators(bench, parameters);
+    printResult("frame", time, parameters, wrongValues);
+
+    destroySPIFrame(frame);
+    destroyProcessImage(image, bench->sensors, bench->actuators);
+    return time;
+}
+
+static void printUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("    -s, --sensors <n>               the amount of binary sensors (default 42)\n");
+    printf("    -a, --actuators <n>             the amount of binary actuators (default 7)\n");
+    printf("    -p, --changes <percent>         the chance of every value to change per cycle (default 5)\n");
+    printf("    -c, --cycles <n>                the amount of cycles every mode is timed with (default 10000)\n");
+    printf("    -t, --transfer-latency <ns>     the time every transfer takes (default 5000)\n");
+    printf("    -b, --byte-latency <ns>         the time every byte takes (default 2051)\n");
+    printf("    -S, --seed <n>                  the seed of the random generator (default 1)\n");
+    printf("    -h, --help                      print this help\n");
+}
+
+int main(int argc, char* argv[])
+{
+    static const struct option options[] =
+    {
+        {"sensors",             required_argument,  NULL, 's'},
+        {"actuators",           required_argument,  NULL, 'a'},
+        {"changes",             required_argument,  NULL, 'p'},
+        {"cycles",              required_argument,  NULL, 'c'},
+        {"transfer-latency",    required_argument,  NULL, 't'},
+        {"byte-latency",        required_argument,  NULL, 'b'},
+        {"seed",                required_argument,  NULL, 'S'},
+        {"help",                no_argument,        NULL, 'h'},
+        {NULL,                  0,                  NULL, 0}
+    };
+
+    SPIBenchParameters parameters = {42, 7, 5, 10000, 5000, 2051, 1};
+    int option;
+    while ((option = getopt_long(argc, argv, "s:a:p:c:t:b:S:h", options, NULL)) != -1)
+    {
+        unsigned long long value = optarg != NULL ? strtoull(optarg, NULL, 10) : 0;
+        switch (option)
+        {
+            case 's':
+                parameters.sensorCount = value;
+                break;
+
+            case 'a':
+                parameters.actuatorCount = value;
+                break;
+
+            case 'p':
+                parameters.changes = value;
+                break;
+
+            case 'c':
+                parameters.cycles = value;
+                break;
+
+            case 't':
+                parameters.transferLatency = value;
+                break;
+
+            case 'b':
+                parameters.byteLatency = value;
+                break;
+
+            case 'S':
+                parameters.seed = value;
+                break;
+
+            default:
+                printUsage(argv[0]);
+                return 1;
+        }
+    }
+    /* the pin mapping is a single byte */
+    if (optind != argc || parameters.sensorCount > 256 || parameters.actuatorCount > 256 || parameters.changes > 100 || parameters.cycles == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    srand(parameters.seed);
+    SPIBench bench;
+    if (createSPIBench(&bench, &parameters))
+    {
+        destroySPIBench(&bench);
+        return 1;
+    }
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    setSPIBackend(&softwareFPGABackend);
+    setupSPIInterface();
+    softwareFPGA.transferLatency = parameters.transferLatency;
+    softwareFPGA.byteLatency = parameters.byteLatency;
+    printf("spi: %u sensors, %u actuators, %u%% changes per cycle, %llu ns per transfer, %llu ns per byte\n",
+           parameters.sensorCount, parameters.actuatorCount, parameters.changes, parameters.transferLatency, parameters.byteLatency);
+
+    double perCommandTime = benchmarkPerCommand(&bench, &parameters, &mutex);
+    double frameTime = benchmarkFrame(&bench, &parameters, &mutex);
+    if (frameTime > 0)
+    {
+        printf("the frames are %.1f times faster\n", perCommandTime / frameTime);
+    }
+
+    closeSPIInterface();
+    pthread_mutex_destroy(&mutex);
+    destroySPIBench(&bench);
+    return frameTime < 0;
+}
\ No newline at end of file
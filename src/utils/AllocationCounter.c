@@ -0,0 +1,40 @@
+#include "AllocationCounter.h"
+#include "../parsers/json.h"
+#include <stdlib.h>
+
+static __thread unsigned long long allocationCount = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocationCount++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    allocationCount++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size)
+{
+    allocationCount++;
+    return __real_realloc(pointer, size);
+}
+
+/* returns the amount of allocations done by the calling thread so far */
+unsigned long long getThreadAllocations(void)
+{
+    return allocationCount;
+}
+
+/* lets cJSON allocate through the counted malloc */
+void countJSONAllocations(void)
+{
+    cJSON_Hooks hooks = {__wrap_malloc, free};
+    cJSON_InitHooks(&hooks);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/*
+ *  counts the allocations of every thread, malloc, calloc and realloc are wrapped at link time
+ *  (-Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc). The allocations of cJSON are only
+ *  counted after countJSONAllocations, as it is linked as a shared library.
+ */
+unsigned long long getThreadAllocations(void);
+void countJSONAllocations(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "CycleProfile.h"
+#include "CycleTimer.h"
+#include "../logging/log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+ *  creates a profile with a histogram for every name, the names are copied
+ *  returns NULL on error
+ */
+CycleProfile* createCycleProfile(const char* const* names, unsigned int count)
+{
+    CycleProfile* profile = calloc(1, sizeof(*profile));
+    if (profile == NULL)
+    {
+        log_error("CycleProfile: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    profile->count = count;
+    profile->names = calloc(count + 1, sizeof(*profile->names));
+    profile->histograms = malloc(sizeof(*profile->histograms) * (count + 1));
+    profile->pending = calloc(count + 1, sizeof(*profile->pending));
+    profile->touched = malloc(sizeof(*profile->touched) * (count + 1));
+    if (profile->names == NULL || profile->histograms == NULL || profile->pending == NULL || profile->touched == NULL)
+    {
+        log_error("CycleProfile: malloc error %s", strerror(errno));
+        destroyCycleProfile(profile);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        profile->names[i] = strdup(names[i]);
+        if (profile->names[i] == NULL)
+        {
+            log_error("CycleProfile: malloc error %s", strerror(errno));
+            destroyCycleProfile(profile);
+            return NULL;
+        }
+        resetLatencyHistogram(&profile->histograms[i]);
+    }
+    atomic_init(&profile->sequence, 0);
+    atomic_init(&profile->resetRequested, 0);
+    return profile;
+}
+
+/* starts the first phase of a cycle, returns the current time */
+unsigned long long startProfilePhase(CycleProfile* profile)
+{
+    profile->mark = getMonotonicTime();
+    return profile->mark;
+}
+
+/*
+ *  adds the time since the end of the last phase to the given histogram and starts the next phase, a histogram
+ *  ended several times in a cycle gets the sum of its durations
+ *  returns the current time
+ */
+unsigned long long endProfilePhase(CycleProfile* profile, unsigned int histogram)
+{
+    unsigned long long now = getMonotonicTime();
+    addProfileDuration(profile, histogram, now - profile->mark);
+    profile->mark = now;
+    return now;
+}
+
+/* adds a duration in ns measured by the caller to the given histogram in the current cycle, NULL is ignored */
+void addProfileDuration(CycleProfile* profile, unsigned int histogram, unsigned long long duration)
+{
+    if (profile == NULL || histogram >= profile->count)
+    {
+        return;
+    }
+    if (profile->pending[histogram] == 0)
+    {
+        profile->touched[profile->touchedCount++] = histogram;
+    }
+    /* a duration of 0 ns still counts as a recorded phase */
+    profile->pending[histogram] += duration > 0 ? duration : 1;
+}
+
+/* records the durations of the current cycle into the histograms, called at the end of every cycle, NULL is ignored */
+void commitCycleProfile(CycleProfile* profile)
+{
+    if (profile == NULL)
+    {
+        return;
+    }
+    unsigned int reset = atomic_exchange_explicit(&profile->resetRequested, 0, memory_order_relaxed);
+    if (profile->touchedCount == 0 && !reset)
+    {
+        return;
+    }
+    unsigned int sequence = atomic_load_explicit(&profile->sequence, memory_order_relaxed);
+    atomic_store_explicit(&profile->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int i = 0; i < profile->count && reset; i++)
+    {
+        resetLatencyHistogram(&profile->histograms[i]);
+    }
+    for (int i = 0; i < profile->touchedCount; i++)
+    {
+        unsigned int histogram = profile->touched[i];
+        recordLatency(&profile->histograms[histogram], profile->pending[histogram]);
+        profile->pending[histogram] = 0;
+    }
+    atomic_store_explicit(&profile->sequence, sequence + 2, memory_order_release);
+    profile->touchedCount = 0;
+}
+
+/* copies a histogram, called by any thread */
+void readProfileHistogram(CycleProfile* profile, unsigned int histogram, LatencyHistogram* copy)
+{
+    while (1)
+    {
+        unsigned int sequence = atomic_load_explicit(&profile->sequence, memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            memcpy(copy, &profile->histograms[histogram], sizeof(*copy));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&profile->sequence, memory_order_relaxed) == sequence)
+            {
+                return;
+            }
+        }
+    }
+}
+
+/* lets the next commit reset all histograms, called by any thread */
+void requestCycleProfileReset(CycleProfile* profile)
+{
+    atomic_store_explicit(&profile->resetRequested, 1, memory_order_relaxed);
+}
+
+/* logs the percentiles of every histogram with recorded durations, called by any thread */
+void logCycleProfile(CycleProfile* profile, const char* name)
+{
+    LatencyHistogram* copy = malloc(sizeof(*copy));
+    if (copy == NULL)
+    {
+        log_error("CycleProfile: malloc error %s", strerror(errno));
+        return;
+    }
+    for (int i = 0; i < profile->count; i++)
+    {
+        readProfileHistogram(profile, i, copy);
+        if (copy->count > 0)
+        {
+            char histogramName[256];
+            snprintf(histogramName, sizeof(histogramName), "%s (%llu times, mean %.1f us)", profile->names[i], copy->count, copy->sum / 1e3 / copy->count);
+            logLatencyPercentiles(name, histogramName, copy);
+        }
+    }
+    free(copy);
+}
+
+void destroyCycleProfile(CycleProfile* profile)
+{
+    if (profile == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < profile->count && profile->names != NULL; i++)
+    {
+        free(profile->names[i]);
+    }
+    free(profile->names);
+    free(profile->histograms);
+    free(profile->pending);
+    free(profile->touched);
+    free(profile);
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef CYCLEPROFILE_H
+#define CYCLEPROFILE_H
+
+#include "LatencyHistogram.h"
+#include <stdatomic.h>
+
+/*
+ *  Latency histograms of the phases of a cycle (or of any other named durations), written by the thread running
+ *  the cycles and read by any other thread without locks. The durations of a cycle are collected first and
+ *  recorded into the histograms at the end of the cycle in one short seqlock write, so a reader copying a
+ *  histogram only retries if it overlapped with that write and never sees a partial cycle.
+ *  count           -   the amount of histograms
+ *  names           -   the name of every histogram
+ *  histograms      -   the durations of every histogram in ns
+ *  pending         -   the duration of every histogram in the current cycle
+ *  touched         -   the indexes of the histograms with a duration in the current cycle
+ *  touchedCount    -   the amount of touched histograms
+ *  mark            -   the end of the last phase, the start of the next one
+ *  sequence        -   the sequence of the histograms, odd while the durations of a cycle are recorded
+ *  resetRequested  -   set by a reader, the histograms are reset by the next commit
+ */
+typedef struct
+{
+    unsigned int        count;
+    char**              names;
+    LatencyHistogram*   histograms;
+    unsigned long long* pending;
+    unsigned int*       touched;
+    unsigned int        touchedCount;
+    unsigned long long  mark;
+    atomic_uint         sequence;
+    atomic_uint         resetRequested;
+} CycleProfile;
+
+CycleProfile* createCycleProfile(const char* const* names, unsigned int count);
+unsigned long long startProfilePhase(CycleProfile* profile);
+unsigned long long endProfilePhase(CycleProfile* profile, unsigned int histogram);
+void addProfileDuration(CycleProfile* profile, unsigned int histogram, unsigned long long duration);
+void commitCycleProfile(CycleProfile* profile);
+void readProfileHistogram(CycleProfile* profile, unsigned int histogram, LatencyHistogram* copy);
+void requestCycleProfileReset(CycleProfile* profile);
+void logCycleProfile(CycleProfile* profile, const char* name);
+void destroyCycleProfile(CycleProfile* profile);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "CycleTimer.h"
+#include "../logging/log.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define NSEC_PER_SEC 1000000000ULL
+
+/* returns the current time of CLOCK_MONOTONIC in ns */
+unsigned long long getMonotonicTime(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+static struct timespec toTimespec(unsigned long long time)
+{
+    return (struct timespec){time / NSEC_PER_SEC, time % NSEC_PER_SEC};
+}
+
+/*
+ *  creates a timer whose first deadline is one period from now
+ *  period  -   the period of the cycles in ns
+ *  returns NULL if the timerfd could not be created
+ */
+CycleTimer* createCycleTimer(unsigned long long period)
+{
+    if (period == 0)
+    {
+        log_error("CycleTimer: the period has to be larger than 0");
+        return NULL;
+    }
+    CycleTimer* timer = malloc(sizeof(*timer));
+    if (timer == NULL)
+    {
+        log_error("CycleTimer: malloc error %s", strerror(errno));
+        return NULL;
+    }
+    timer->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer->fd < 0)
+    {
+        log_error("CycleTimer: timerfd could not be created: %s", strerror(errno));
+        free(timer);
+        return NULL;
+    }
+    timer->period = period;
+    timer->deadline = getMonotonicTime() + period;
+    struct itimerspec deadlines = {toTimespec(period), toTimespec(timer->deadline)};
+    if (timerfd_settime(timer->fd, TFD_TIMER_ABSTIME, &deadlines, NULL) < 0)
+    {
+        log_error("CycleTimer: timerfd could not be started: %s", strerror(errno));
+        close(timer->fd);
+        free(timer);
+        return NULL;
+    }
+    /* the first wait moves the deadline forward by one period */
+    timer->deadline -= period;
+    atomic_init(&timer->sequence, 0);
+    atomic_init(&timer->resetRequested, 0);
+    resetCycleStatistics(timer);
+    return timer;
+}
+
+/* starts a seqlock write of the statistics, the write ends by storing the returned sequence + 2 */
+static unsigned int beginStatisticsWrite(CycleTimer* timer)
+{
+    unsigned int sequence = atomic_load_explicit(&timer->sequence, memory_order_relaxed);
+    atomic_store_explicit(&timer->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return sequence;
+}
+
+/*
+ *  sleeps until the deadline of the next cycle and records the wakeup latency. If deadlines passed while
+ *  the previous cycle was executing, the cycle starts at the latest one immediately and the others are skipped.
+ *  returns the amount of skipped deadlines
+ */
+unsigned int waitForNextCycle(CycleTimer* timer)
+{
+    uint64_t expirations = 0;
+    while (read(timer->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        if (errno != EINTR)
+        {
+            log_error("CycleTimer: timerfd could not be read: %s", strerror(errno));
+            expirations = 1;
+            break;
+        }
+    }
+    timer->wakeup = getMonotonicTime();
+    timer->deadline += expirations * timer->period;
+    unsigned int sequence = beginStatisticsWrite(timer);
+    if (atomic_exchange_explicit(&timer->resetRequested, 0, memory_order_relaxed))
+    {
+        resetCycleStatistics(timer);
+    }
+    timer->statistics.cycles++;
+    timer->statistics.missedDeadlines += expirations - 1;
+    recordLatency(&timer->statistics.wakeupLatency, timer->wakeup > timer->deadline ? timer->wakeup - timer->deadline : 0);
+    atomic_store_explicit(&timer->sequence, sequence + 2, memory_order_release);
+    return expirations - 1;
+}
+
+/* records the execution time of the current cycle */
+void endCycle(CycleTimer* timer)
+{
+    unsigned long long executionTime = getMonotonicTime() - timer->wakeup;
+    unsigned int sequence = beginStatisticsWrite(timer);
+    recordLatency(&timer->statistics.executionTime, executionTime);
+    atomic_store_explicit(&timer->sequence, sequence + 2, memory_order_release);
+}
+
+/* resets the statistics, only called by the thread running the cycles, the others use requestCycleStatisticsReset */
+void resetCycleStatistics(CycleTimer* timer)
+{
+    resetLatencyHistogram(&timer->statistics.executionTime);
+    resetLatencyHistogram(&timer->statistics.wakeupLatency);
+    timer->statistics.cycles = 0;
+    timer->statistics.missedDeadlines = 0;
+    timer->statistics.start = getMonotonicTime();
+}
+
+/* copies the statistics, called by any thread */
+void readCycleStatistics(CycleTimer* timer, CycleStatistics* copy)
+{
+    while (1)
+    {
+        unsigned int sequence = atomic_load_explicit(&timer->sequence, memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            memcpy(copy, &timer->statistics, sizeof(*copy));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&timer->sequence, memory_order_relaxed) == sequence)
+            {
+                return;
+            }
+        }
+    }
+}
+
+/* lets the next cycle reset the statistics, called by any thread */
+void requestCycleStatisticsReset(CycleTimer* timer)
+{
+    atomic_store_explicit(&timer->resetRequested, 1, memory_order_relaxed);
+}
+
+/*
+ *  logs the cycles, deadline misses and percentiles of the execution time and wakeup latency since the last reset,
+ *  called by any thread
+ */
+void logCycleStatistics(CycleTimer* timer, const char* name)
+{
+    CycleStatistics* statistics = malloc(sizeof(*statistics));
+    if (statistics == NULL)
+    {
+        log_error("CycleTimer: malloc error %s", strerror(errno));
+        return;
+    }
+    readCycleStatistics(timer, statistics);
+    log_info("%s: %llu cycles of %.1f us in %.1f s, %llu missed deadlines", name, statistics->cycles, timer->period / 1e3,
+             (getMonotonicTime() - statistics->start) / 1e9, statistics->missedDeadlines);
+    logLatencyPercentiles(name, "cycle time", &statistics->executionTime);
+    logLatencyPercentiles(name, "wakeup latency", &statistics->wakeupLatency);
+    free(statistics);
+}
+
+void destroyCycleTimer(CycleTimer* timer)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+    close(timer->fd);
+    free(timer);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef CYCLETIMER_H
+#define CYCLETIMER_H
+
+#include "LatencyHistogram.h"
+#include <stdatomic.h>
+
+/*
+ *  the timing of all cycles since the last reset
+ *  executionTime   -   the time from the wakeup of a cycle until endCycle in ns
+ *  wakeupLatency   -   the time from the deadline of a cycle until its wakeup in ns
+ *  cycles          -   the amount of executed cycles
+ *  missedDeadlines -   the amount of deadlines that passed while the previous cycle was still executing
+ *  start           -   the time of the last reset
+ */
+typedef struct
+{
+    LatencyHistogram    executionTime;
+    LatencyHistogram    wakeupLatency;
+    unsigned long long  cycles;
+    unsigned long long  missedDeadlines;
+    unsigned long long  start;
+} CycleStatistics;
+
+/*
+ *  Runs a loop at a fixed period, every cycle starts at an absolute deadline of a timerfd, so the
+ *  execution time of a cycle does not shift the following ones. The statistics are written by the loop in
+ *  short seqlock writes, other threads copy them with readCycleStatistics and never block the loop.
+ *  fd              -   the timerfd, it expires at every deadline
+ *  period          -   the period in ns
+ *  deadline        -   the deadline of the current cycle (CLOCK_MONOTONIC in ns)
+ *  wakeup          -   the time the current cycle has been started at
+ *  statistics      -   the timing of the cycles since the last reset
+ *  sequence        -   the sequence of statistics, odd while the loop writes them
+ *  resetRequested  -   set by another thread, the statistics are reset at the start of the next cycle
+ */
+typedef struct
+{
+    int                 fd;
+    unsigned long long  period;
+    unsigned long long  deadline;
+    unsigned long long  wakeup;
+    CycleStatistics     statistics;
+    atomic_uint         sequence;
+    atomic_uint         resetRequested;
+} CycleTimer;
+
+unsigned long long getMonotonicTime(void);
+CycleTimer* createCycleTimer(unsigned long long period);
+unsigned int waitForNextCycle(CycleTimer* timer);
+void endCycle(CycleTimer* timer);
+void resetCycleStatistics(CycleTimer* timer);
+void readCycleStatistics(CycleTimer* timer, CycleStatistics* copy);
+void requestCycleStatisticsReset(CycleTimer* timer);
+void logCycleStatistics(CycleTimer* timer, const char* name);
+void destroyCycleTimer(CycleTimer* timer);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "LatencyHistogram.h"
+#include "../logging/log.h"
+#include <string.h>
+
+/* returns the bucket of a value, values below LATENCY_HISTOGRAM_SUB_BUCKETS have a bucket of their own */
+static unsigned int getLatencyBucket(unsigned long long value)
+{
+    if (value < LATENCY_HISTOGRAM_SUB_BUCKETS)
+    {
+        return value;
+    }
+    unsigned int exponent = 63 - __builtin_clzll(value);
+    unsigned int shift = exponent - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS + ((value >> shift) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/* returns the largest value of a bucket */
+static unsigned long long getLatencyBucketLimit(unsigned int bucket)
+{
+    if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    unsigned int shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long long first = (unsigned long long)(LATENCY_HISTOGRAM_SUB_BUCKETS + bucket % LATENCY_HISTOGRAM_SUB_BUCKETS) << shift;
+    return first + ((1ULL << shift) - 1);
+}
+
+void resetLatencyHistogram(LatencyHistogram* histogram)
+{
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->min = ~0ULL;
+}
+
+void recordLatency(LatencyHistogram* histogram, unsigned long long value)
+{
+    histogram->buckets[getLatencyBucket(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if (value < histogram->min)
+    {
+        histogram->min = value;
+    }
+    if (value > histogram->max)
+    {
+        histogram->max = value;
+    }
+}
+
+/*
+ *  returns the smallest value that is larger or equal to the given percentage (0 - 100) of the recorded values,
+ *  rounded up to the end of its bucket but never above the largest value. Returns 0 if nothing has been recorded.
+ */
+unsigned long long getLatencyPercentile(const LatencyHistogram* histogram, double percentile)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+    unsigned long long rank = (unsigned long long)(percentile / 100.0 * histogram->count + 0.5);
+    rank = rank < 1 ? 1 : rank > histogram->count ? histogram->count : rank;
+    unsigned long long seen = 0;
+    for (unsigned int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+        {
+            unsigned long long limit = getLatencyBucketLimit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/* logs the percentiles of a histogram in us */
+void logLatencyPercentiles(const char* name, const char* histogramName, const LatencyHistogram* histogram)
+{
+    log_info("%s: %s p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us", name, histogramName,
+             getLatencyPercentile(histogram, 50) / 1e3, getLatencyPercentile(histogram, 90) / 1e3,
+             getLatencyPercentile(histogram, 99) / 1e3, getLatencyPercentile(histogram, 99.9) / 1e3, histogram->max / 1e3);
+}
\ No newline at end of file
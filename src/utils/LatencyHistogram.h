@@ -0,0 +1,31 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+/* every power of two is split into 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS buckets, so a bucket is at most ~3% wide */
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS ((64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+/*
+ *  A log-linear histogram of durations in ns like a HDR histogram, recording a value never allocates
+ *  count   -   the amount of recorded values
+ *  sum     -   the sum of all recorded values
+ *  min     -   the smallest recorded value
+ *  max     -   the largest recorded value
+ *  buckets -   the amount of recorded values per bucket
+ */
+typedef struct
+{
+    unsigned long long  count;
+    unsigned long long  sum;
+    unsigned long long  min;
+    unsigned long long  max;
+    unsigned int        buckets[LATENCY_HISTOGRAM_BUCKETS];
+} LatencyHistogram;
+
+void resetLatencyHistogram(LatencyHistogram* histogram);
+void recordLatency(LatencyHistogram* histogram, unsigned long long value);
+unsigned long long getLatencyPercentile(const LatencyHistogram* histogram, double percentile);
+void logLatencyPercentiles(const char* name, const char* histogramName, const LatencyHistogram* histogram);
+
+#endif
\ No newline at end of file
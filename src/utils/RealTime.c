@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include "RealTime.h"
+#include "../logging/log.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* returns the last online core, the one usually isolated for real-time threads */
+int getLastCPU(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count - 1 : 0;
+}
+
+/*
+ *  touches every page of the given amount of stack below the caller, so the stack never faults afterwards
+ *  returns the first touched byte, reading it back keeps the writes from being unused
+ */
+static char __attribute__((noinline)) prefaultStack(size_t size)
+{
+    volatile char stack[size + 1];
+    for (size_t i = 0; i <= size; i += sysconf(_SC_PAGESIZE))
+    {
+        stack[i] = 0;
+    }
+    return stack[0];
+}
+
+/* touches the given amount of heap and gives it back to malloc, which keeps it as trimming has been turned off */
+static int prefaultHeap(size_t size)
+{
+    char* heap = malloc(size);
+    if (heap == NULL)
+    {
+        log_error("RealTime: malloc error %s", strerror(errno));
+        return 1;
+    }
+    memset(heap, 0, size);
+    free(heap);
+    return 0;
+}
+
+/*
+ *  turns the calling thread into a real-time thread: all memory of the process is locked, the heap and the stack
+ *  are prefaulted and the thread is pinned to its core and scheduled with SCHED_FIFO. Requires CAP_SYS_NICE and
+ *  CAP_IPC_LOCK (or root). Memory allocated afterwards is locked as well, but faults once when it is touched
+ *  the first time, so everything the thread needs should be allocated before.
+ *  returns 1 on error, the steps done before the error are kept
+ */
+int enterRealTimeMode(const RealTimeParameters* parameters)
+{
+    /* freed memory has to stay mapped, otherwise every allocation may fault again */
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE))
+    {
+        log_error("RealTime: the memory could not be locked: %s", strerror(errno));
+        return 1;
+    }
+    if (prefaultHeap(parameters->heapReserve))
+    {
+        return 1;
+    }
+    prefaultStack(parameters->stackReserve);
+
+    if (parameters->cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(parameters->cpu, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error)
+        {
+            log_error("RealTime: the thread could not be pinned to core %d: %s", parameters->cpu, strerror(error));
+            return 1;
+        }
+    }
+    struct sched_param scheduling = {.sched_priority = parameters->priority};
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &scheduling);
+    if (error)
+    {
+        log_error("RealTime: SCHED_FIFO with priority %d could not be set: %s", parameters->priority, strerror(error));
+        return 1;
+    }
+    log_info("RealTime: running with SCHED_FIFO priority %d on core %d, %zu kB heap and %zu kB stack prefaulted",
+             parameters->priority, parameters->cpu, parameters->heapReserve / 1024, parameters->stackReserve / 1024);
+    return 0;
+}
+
+/*
+ *  lets a thread run on every core but the given one, used to keep the other threads of a process off the core
+ *  of its real-time thread
+ *  returns 1 on error
+ */
+int keepThreadOffCPU(pthread_t thread, int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int i = 0; i <= getLastCPU(); i++)
+    {
+        if (i != cpu)
+        {
+            CPU_SET(i, &cpus);
+        }
+    }
+    if (cpu < 0 || CPU_COUNT(&cpus) == 0)
+    {
+        return 0;
+    }
+    int error = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (error)
+    {
+        log_error("RealTime: the thread could not be moved off core %d: %s", cpu, strerror(error));
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+ *  the parameters of the real-time mode of a thread
+ *  priority        -   the SCHED_FIFO priority, 1 (lowest) to 99
+ *  cpu             -   the core the thread is pinned to, it should be isolated (isolcpus), -1 to keep the affinity
+ *  heapReserve     -   the amount of heap that is touched and kept mapped in bytes
+ *  stackReserve    -   the amount of stack that is touched in bytes
+ */
+typedef struct
+{
+    int     priority;
+    int     cpu;
+    size_t  heapReserve;
+    size_t  stackReserve;
+} RealTimeParameters;
+
+int getLastCPU(void);
+int enterRealTimeMode(const RealTimeParameters* parameters);
+int keepThreadOffCPU(pthread_t thread, int cpu);
+
+#endif
\ No newline at end of file
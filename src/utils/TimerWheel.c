@@ -0,0 +1,153 @@
+#include "TimerWheel.h"
+#include <string.h>
+
+/* the amount of ticks a slot of the given level spans */
+#define TIMER_WHEEL_SPAN(level) (1ULL << ((level) * TIMER_WHEEL_SLOT_BITS))
+
+/*
+ *  initializes an empty wheel
+ *  start       -   the current time in ns
+ *  tickLength  -   the resolution of the timers in ns
+ */
+void initTimerWheel(TimerWheel* wheel, unsigned long long start, unsigned long long tickLength)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->start = start;
+    wheel->tickLength = tickLength > 0 ? tickLength : 1;
+}
+
+/* links the timer into the slot of its expiry, timers beyond the highest level wait in its last slot */
+static void insertTimer(TimerWheel* wheel, Timer* timer)
+{
+    unsigned long long delta = timer->expiry - wheel->tick;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= TIMER_WHEEL_SPAN(level + 1))
+    {
+        level++;
+    }
+    unsigned long long expiry = timer->expiry;
+    if (delta >= TIMER_WHEEL_SPAN(TIMER_WHEEL_LEVELS))
+    {
+        expiry = wheel->tick + TIMER_WHEEL_SPAN(TIMER_WHEEL_LEVELS) - 1;
+    }
+    Timer** slot = &wheel->slots[level][(expiry >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1)];
+    timer->next = *slot;
+    timer->previous = slot;
+    if (*slot != NULL)
+    {
+        (*slot)->previous = &timer->next;
+    }
+    *slot = timer;
+}
+
+static void unlinkTimer(Timer* timer)
+{
+    *timer->previous = timer->next;
+    if (timer->next != NULL)
+    {
+        timer->next->previous = timer->previous;
+    }
+    timer->next = NULL;
+    timer->previous = NULL;
+}
+
+/*
+ *  adds a timer which expires at the given time in ns, it expires at the first tick at or after it. A timer
+ *  that has been added already is moved.
+ */
+void addTimer(TimerWheel* wheel, Timer* timer, unsigned long long time)
+{
+    if (isTimerAdded(timer))
+    {
+        removeTimer(wheel, timer);
+    }
+    unsigned long long expiry = time > wheel->start ? (time - wheel->start + wheel->tickLength - 1) / wheel->tickLength : 0;
+    /* the slot of the current tick has been expired already */
+    timer->expiry = expiry > wheel->tick ? expiry : wheel->tick + 1;
+    insertTimer(wheel, timer);
+    wheel->count++;
+}
+
+void removeTimer(TimerWheel* wheel, Timer* timer)
+{
+    if (isTimerAdded(timer))
+    {
+        unlinkTimer(timer);
+        wheel->count--;
+    }
+}
+
+unsigned int isTimerAdded(const Timer* timer)
+{
+    return timer->previous != NULL;
+}
+
+/* moves the timers of the current slot of a level into the levels below */
+static void cascadeTimers(TimerWheel* wheel, int level)
+{
+    Timer** slot = &wheel->slots[level][(wheel->tick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1)];
+    Timer* timer = *slot;
+    *slot = NULL;
+    while (timer != NULL)
+    {
+        Timer* next = timer->next;
+        insertTimer(wheel, timer);
+        timer = next;
+    }
+}
+
+/*
+ *  expires all timers up to the given time in ns, the callback may add and remove timers
+ *  returns the amount of expired timers
+ */
+unsigned int advanceTimerWheel(TimerWheel* wheel, unsigned long long now, TimerCallback callback)
+{
+    unsigned long long target = now > wheel->start ? (now - wheel->start) / wheel->tickLength : 0;
+    unsigned int expired = 0;
+    while (wheel->tick < target)
+    {
+        if (wheel->count == 0)
+        {
+            wheel->tick = target;
+            break;
+        }
+        wheel->tick++;
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if ((wheel->tick & (TIMER_WHEEL_SPAN(level) - 1)) == 0)
+            {
+                cascadeTimers(wheel, level);
+            }
+        }
+        Timer** slot = &wheel->slots[0][wheel->tick & (TIMER_WHEEL_SLOTS - 1)];
+        while (*slot != NULL)
+        {
+            Timer* timer = *slot;
+            unlinkTimer(timer);
+            wheel->count--;
+            expired++;
+            callback(timer, timer->context);
+        }
+    }
+    return expired;
+}
+
+/*
+ *  returns the next tick a timer may expire at, at the latest the next tick timers of a higher level are moved
+ *  down at. Returns 0 if there is no timer.
+ */
+unsigned long long getNextTimerWheelTick(const TimerWheel* wheel)
+{
+    if (wheel->count == 0)
+    {
+        return 0;
+    }
+    for (unsigned long long tick = wheel->tick + 1; tick <= (wheel->tick | (TIMER_WHEEL_SLOTS - 1)); tick++)
+    {
+        if (wheel->slots[0][tick & (TIMER_WHEEL_SLOTS - 1)] != NULL)
+        {
+            return tick;
+        }
+    }
+    return (wheel->tick | (TIMER_WHEEL_SLOTS - 1)) + 1;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+/* every level has 2^TIMER_WHEEL_SLOT_BITS slots, a slot of a level spans all slots of the level below */
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+/*
+ *  A timer of a TimerWheel, it is embedded into the data it belongs to so adding it never allocates
+ *  expiry      -   the tick the timer expires at
+ *  next        -   the next timer of the same slot
+ *  previous    -   the pointer to this timer in the slot or in the previous timer, NULL if the timer is not added
+ *  context     -   passed to the callback when the timer expires
+ */
+typedef struct Timer_s
+{
+    unsigned long long  expiry;
+    struct Timer_s*     next;
+    struct Timer_s**    previous;
+    void*               context;
+} Timer;
+
+typedef void (*TimerCallback)(Timer* timer, void* context);
+
+/*
+ *  A hierarchical timer wheel: adding, removing and expiring a timer are O(1), timers far in the future are
+ *  moved down a level when the wheel reaches their slot of the higher level
+ *  start       -   the time of tick 0 in ns
+ *  tickLength  -   the length of a tick in ns
+ *  tick        -   the last tick whose timers have been expired
+ *  count       -   the amount of added timers
+ *  slots       -   the timers of every slot of every level
+ */
+typedef struct
+{
+    unsigned long long  start;
+    unsigned long long  tickLength;
+    unsigned long long  tick;
+    unsigned int        count;
+    Timer*              slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} TimerWheel;
+
+void initTimerWheel(TimerWheel* wheel, unsigned long long start, unsigned long long tickLength);
+void addTimer(TimerWheel* wheel, Timer* timer, unsigned long long time);
+void removeTimer(TimerWheel* wheel, Timer* timer);
+unsigned int isTimerAdded(const Timer* timer);
+unsigned int advanceTimerWheel(TimerWheel* wheel, unsigned long long now, TimerCallback callback);
+unsigned long long getNextTimerWheelTick(const TimerWheel* wheel);
+
+#endif
\ No newline at end of file
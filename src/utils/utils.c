@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "utils.h"
 
@@ -176,4 +177,12 @@ int deserializeInt(unsigned char* str)
     result = (result << 8) + str[2];
     result = (result << 8) + str[3];
     return result;
+}
+
+/* the time of the monotonic clock in nanoseconds, used to measure durations */
+double getNanoseconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e9 + time.tv_nsec;
 }
\ No newline at end of file
@@ -6,5 +6,6 @@ char* encodeBase64(char* string, unsigned int lengthString);
 char* decodeBase64(char* string, unsigned int* length);
 char* serializeInt(int num);
 int deserializeInt(unsigned char* str);
+double getNanoseconds(void);
 
 #endif
\ No newline at end of file